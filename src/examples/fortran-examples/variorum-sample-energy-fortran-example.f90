@@ -0,0 +1,82 @@
+! Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+! Variorum Project Developers. See the top-level LICENSE file for details.
+!
+! SPDX-License-Identifier: MIT
+
+program main
+  use, intrinsic :: iso_c_binding
+  use variorum
+  implicit none
+  integer, parameter :: max_sockets = 8, max_cores = 1024
+  real(c_double) :: cpu_joules(max_sockets), mem_joules(max_sockets)
+  real(c_double) :: cpu_watts(max_sockets), mem_watts(max_sockets)
+  real(c_double) :: avg_mhz(max_cores)
+  type(variorum_region_energy) :: region
+  character(kind=c_char, len=4096) :: json
+  integer :: nsockets, ncores, step, r, ret
+
+  ! The first call only records the counters that power is measured from.
+  r = variorum_sample_socket_power(cpu_watts, mem_watts, nsockets)
+
+  do step = 1, 3
+    r = variorum_region_begin("compute")
+    if (r .ne. 0) then
+      print*, "Variorum region begin failed."
+    end if
+
+    ret = do_work(step)
+
+    r = variorum_region_end("compute")
+    if (r .ne. 0) then
+      print*, "Variorum region end failed."
+    end if
+
+    r = variorum_sample_socket_power(cpu_watts, mem_watts, nsockets)
+    if (r .eq. 0) then
+      print '(a,i0,a,*(f10.2))', "Step ", step, " CPU power (W):", &
+        cpu_watts(1:min(nsockets, max_sockets))
+    end if
+    r = variorum_sample_core_frequency(avg_mhz, ncores)
+    if (r .eq. 0) then
+      print '(a,i0,a,f10.2)', "Step ", step, " core 0 frequency (MHz):", &
+        avg_mhz(1)
+    end if
+  end do
+
+  r = variorum_sample_socket_energy(cpu_joules, mem_joules, nsockets)
+  if (r .eq. 0) then
+    print '(a,*(f14.2))', "CPU energy counters (J):", &
+      cpu_joules(1:min(nsockets, max_sockets))
+  end if
+
+  ! Format the same counters as JSON into a buffer owned by this program.
+  r = variorum_get_energy_json_buf(json, int(len(json), c_size_t), &
+                                   VARIORUM_JSON_COMPACT)
+  if (r .ge. 0 .and. r .lt. len(json)) then
+    print '(a)', json(1:r)
+  end if
+
+  r = variorum_get_region_energy("compute", region)
+  if (r .ne. 0) then
+    print*, "Variorum get region energy failed."
+  else
+    print '(a,i0,a,f10.4,a,f10.2)', "Region compute: ", region%count, &
+      " instances, ", region%seconds, " s, CPU energy (J): ", region%cpu_joules
+  end if
+
+contains
+
+  function do_work(val) result(res)
+    implicit none
+    integer, INTENT(in) :: val ! input
+    integer :: i ! iterator
+    integer :: res ! output
+
+    res = val
+
+    do i = 1, 10000000
+        res = res + mod(val * i, 7)
+    end do
+  end function do_work
+
+end program main
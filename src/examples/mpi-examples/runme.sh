@@ -8,4 +8,9 @@ srun -N 2 -n 8 ./variorum-print-power-mpi-example
 # node will set a cap of 100W.
 srun -N 2 -n 8 ./variorum-cap-socket-power-limit-mpi-example -l 100
 
+# Launch 8 tasks, 4 tasks per node using Slurm. One rank per node samples the
+# node, rank 0 prints job-wide energy and power every second, and the per-node
+# timelines are written to job_energy.csv.
+srun -N 2 -n 8 ./variorum-job-energy-mpi-example -n 10 -o job_energy.csv
+
 #
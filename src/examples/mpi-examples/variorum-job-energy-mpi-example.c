@@ -0,0 +1,106 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <getopt.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <variorum.h>
+#include <variorum_mpi.h>
+
+int main(int argc, char **argv)
+{
+    static const char *domains[VARIORUM_MPI_NUM_DOMAINS] =
+    {
+        "cpu", "mem", "gpu", "node"
+    };
+    struct variorum_mpi *vm;
+    struct variorum_mpi_job_power job;
+    const char *usage = "Usage: %s [-h] [-v] [-n samples] [-o file]\n";
+    const char *outfile = "job_energy.csv";
+    int nsamples = 10;
+    int rank = 0;
+    int ret = 0;
+    int opt;
+    int i;
+    int d;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    while ((opt = getopt(argc, argv, "hvn:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'h':
+                if (rank == 0)
+                {
+                    printf(usage, argv[0]);
+                }
+                MPI_Finalize();
+                return 0;
+            case 'v':
+                if (rank == 0)
+                {
+                    printf("%s\n", variorum_get_current_version());
+                }
+                MPI_Finalize();
+                return 0;
+            case 'n':
+                nsamples = atoi(optarg);
+                break;
+            case 'o':
+                outfile = optarg;
+                break;
+            default:
+                if (rank == 0)
+                {
+                    fprintf(stderr, usage, argv[0]);
+                }
+                MPI_Finalize();
+                return -1;
+        }
+    }
+
+    // Only one rank per node reads the hardware.
+    if (variorum_mpi_open(MPI_COMM_WORLD, &vm) != 0)
+    {
+        printf("MPI session open failed!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (i = 0; i < nsamples; i++)
+    {
+        sleep(1);
+        if (variorum_mpi_sample(vm) != 0)
+        {
+            ret = -1;
+        }
+        // The application could compute here while the reduction completes.
+        variorum_mpi_wait(vm, &job);
+        if (rank == 0 && job.nnodes > 0)
+        {
+            printf("t=%.1fs nodes=%d", job.seconds, job.nnodes);
+            for (d = 0; d < VARIORUM_MPI_NUM_DOMAINS; d++)
+            {
+                printf(" %s=%.1fJ/%.1fW(min %.1f max %.1f)", domains[d],
+                       job.energy_joules[d].sum, job.power_watts[d].sum,
+                       job.power_watts[d].min, job.power_watts[d].max);
+            }
+            printf("\n");
+        }
+    }
+
+    if (variorum_mpi_write_timelines(vm, outfile) != 0)
+    {
+        printf("Writing node timelines failed!\n");
+        ret = -1;
+    }
+    variorum_mpi_close(&vm);
+    MPI_Finalize();
+    return ret;
+}
@@ -4,4 +4,9 @@
 # the power usage from thread 0.
 OMP_NUM_THREADS=4 srun -N 1 ./variorum-print-power-openmp-example
 
+# Launch 4 threads on a single node using Slurm. Thread 0 prints per-core
+# frequency and temperature while the other threads compute; -r reads each
+# CPU's MSRs from a thread pinned to that CPU.
+OMP_NUM_THREADS=4 srun -N 1 ./variorum-print-core-data-local-read-openmp-example -r
+
 #
@@ -0,0 +1,88 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <getopt.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <variorum.h>
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+    int tid = 0;
+    int i = 0;
+    int nsamples = 5;
+    double x = 0.0;
+
+    const char *usage = "Usage: %s [-h] [-v] [-r] [-n samples]\n";
+    int opt;
+    while ((opt = getopt(argc, argv, "hvrn:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'h':
+                printf(usage, argv[0]);
+                return 0;
+            case 'v':
+                printf("%s\n", variorum_get_current_version());
+                return 0;
+            case 'r':
+                // Read per-core MSRs from threads pinned to each CPU instead
+                // of from this thread through cross-CPU calls.
+                setenv("VARIORUM_MSR_LOCAL_READ", "1", 1);
+                break;
+            case 'n':
+                nsamples = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, usage, argv[0]);
+                return -1;
+        }
+    }
+
+    #pragma omp parallel private(tid, i) reduction(+:x)
+    {
+        tid = omp_get_thread_num();
+
+        // higher-level software must check for thread and process safety
+        // we assume thread 0 is responsible for monitor and control, while
+        // the other threads keep computing
+        if (tid == 0)
+        {
+            // Hold a session so the local-read threads are started once and
+            // kept across samples.
+            if (variorum_open() != 0)
+            {
+                printf("Open session failed!\n");
+            }
+            for (i = 0; i < nsamples; i++)
+            {
+                ret = variorum_print_verbose_frequency();
+                if (ret != 0)
+                {
+                    printf("Print frequency failed!\n");
+                }
+                ret = variorum_print_verbose_thermals();
+                if (ret != 0)
+                {
+                    printf("Print thermals failed!\n");
+                }
+            }
+            variorum_close();
+        }
+        else
+        {
+            for (i = 0; i < 100000000; i++)
+            {
+                x += i * 0.5;
+            }
+        }
+    }
+
+    printf("%f\n", x);
+    return ret;
+}
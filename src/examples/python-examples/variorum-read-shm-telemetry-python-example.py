@@ -0,0 +1,21 @@
+#!/usr/bin/env python
+#
+# Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+# Variorum Project Developers. See the top-level LICENSE file for details.
+#
+# SPDX-License-Identifier: MIT
+
+# Start a publisher first, e.g.: var_monitor -s /variorum -a "sleep 60"
+
+from pyVariorum import variorum_shm
+
+if __name__ == "__main__":
+    seg = variorum_shm.variorum_shm("/variorum")
+    print("\n=== Reading Variorum shared memory telemetry from %s:" % seg.hostname)
+    sample = seg.read()
+    if sample is None:
+        print("No samples published yet.")
+    else:
+        for name, value in sorted(sample.items()):
+            print("%s: %s" % (name, value))
+    seg.close()
@@ -0,0 +1,27 @@
+#!/usr/bin/env python
+#
+# Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+# Variorum Project Developers. See the top-level LICENSE file for details.
+#
+# SPDX-License-Identifier: MIT
+
+import time
+
+from pyVariorum import variorum_session
+
+if __name__ == "__main__":
+    # Variorum stays initialized while the session is open, so each sample
+    # only pays for its own reads.
+    with variorum_session.Session() as s:
+        prev = s.node_energy()
+        for i in range(5):
+            time.sleep(1)
+            cur = s.node_energy()
+            interval = cur["timestamp"] - prev["timestamp"]
+            for domain in ("cpu", "mem", "gpu"):
+                key = domain + "_joules"
+                print(
+                    "%s power: %.1f W" % (domain, (cur[key] - prev[key]) / interval)
+                )
+            print()
+            prev = cur
@@ -0,0 +1,71 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <variorum.h>
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+    int ngpus = 0;
+    int *gpu_power_limits = NULL;
+    int i;
+
+    const char *usage = "Usage: %s [-h] [-v] gpu0_watts [gpu1_watts ...]\n"
+                        "  A limit of 0 leaves that GPU unchanged.\n";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hv")) != -1)
+    {
+        switch (opt)
+        {
+            case 'h':
+                printf(usage, argv[0]);
+                return 0;
+            case 'v':
+                printf("%s\n", variorum_get_current_version());
+                return 0;
+            default:
+                printf(usage, argv[0]);
+                return -1;
+        }
+    }
+    ngpus = argc - optind;
+    if (ngpus == 0)
+    {
+        printf(usage, argv[0]);
+        return -1;
+    }
+
+    gpu_power_limits = (int *) malloc(ngpus * sizeof(int));
+    if (gpu_power_limits == NULL)
+    {
+        return -1;
+    }
+    for (i = 0; i < ngpus; i++)
+    {
+        gpu_power_limits[i] = atoi(argv[optind + i]);
+        printf("Capping GPU %d power limit to %dW\n", i, gpu_power_limits[i]);
+    }
+
+    ret = variorum_cap_gpu_power_limits(ngpus, gpu_power_limits);
+    free(gpu_power_limits);
+    if (ret != 0)
+    {
+        printf("Cap GPU power limits failed, previous limits restored!\n");
+        return ret;
+    }
+    printf("\n");
+    ret = variorum_print_verbose_power_limit();
+    if (ret != 0)
+    {
+        printf("Print power limits failed!\n");
+        return ret;
+    }
+    return ret;
+}
@@ -0,0 +1,245 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/* Stand-in for libnvidia-ml that reports fixed readings for a few fake GPUs,
+ * so the NVIDIA sampler can be tested on systems without GPUs.
+ * */
+
+#include <nvml.h>
+#include <string.h>
+
+#include "nvml_stub.h"
+
+struct nvmlDevice_st
+{
+    unsigned index;
+};
+
+static struct nvmlDevice_st g_devices[NVML_STUB_NDEVICES];
+static int g_fail_field_values[NVML_STUB_NDEVICES];
+static unsigned long long g_throttle_reasons[NVML_STUB_NDEVICES];
+static struct nvml_stub_calls g_calls;
+
+/* The sampler may query devices from several threads. */
+#define COUNT_CALL(counter) __sync_fetch_and_add(&g_calls.counter, 1)
+
+static unsigned stub_power(nvmlDevice_t device)
+{
+    return 100000 + 1000 * device->index;
+}
+
+static unsigned long long stub_energy(nvmlDevice_t device)
+{
+    return 1000000ULL * (device->index + 1);
+}
+
+void nvml_stub_reset_calls(struct nvml_stub_calls *calls)
+{
+    *calls = g_calls;
+    memset(&g_calls, 0, sizeof(g_calls));
+}
+
+void nvml_stub_fail_field_values(unsigned device, int fail)
+{
+    g_fail_field_values[device] = fail;
+}
+
+void nvml_stub_set_throttle_reasons(unsigned device, unsigned long long reasons)
+{
+    g_throttle_reasons[device] = reasons;
+}
+
+nvmlReturn_t nvmlInit(void)
+{
+    unsigned d;
+
+    for (d = 0; d < NVML_STUB_NDEVICES; d++)
+    {
+        g_devices[d].index = d;
+    }
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlShutdown(void)
+{
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCount(unsigned *count)
+{
+    *count = NVML_STUB_NDEVICES;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex(unsigned index, nvmlDevice_t *device)
+{
+    if (index >= NVML_STUB_NDEVICES)
+    {
+        return NVML_ERROR_NOT_SUPPORTED;
+    }
+    *device = &g_devices[index];
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetFieldValues(nvmlDevice_t device, int count,
+                                      nvmlFieldValue_t *values)
+{
+    int i;
+
+    COUNT_CALL(field_values);
+    for (i = 0; i < count; i++)
+    {
+        values[i].nvmlReturn = NVML_ERROR_NOT_SUPPORTED;
+        if (g_fail_field_values[device->index])
+        {
+            continue;
+        }
+        switch (values[i].fieldId)
+        {
+#ifdef NVML_FI_DEV_POWER_INSTANT
+            case NVML_FI_DEV_POWER_INSTANT:
+                values[i].valueType = NVML_VALUE_TYPE_UNSIGNED_INT;
+                values[i].value.uiVal = stub_power(device);
+                values[i].nvmlReturn = NVML_SUCCESS;
+                break;
+#endif
+#ifdef NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION
+            case NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION:
+                values[i].valueType = NVML_VALUE_TYPE_UNSIGNED_LONG_LONG;
+                values[i].value.ullVal = stub_energy(device);
+                values[i].nvmlReturn = NVML_SUCCESS;
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device, unsigned *power)
+{
+    COUNT_CALL(power_usage);
+    *power = stub_power(device);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(nvmlDevice_t device,
+        unsigned long long *energy)
+{
+    COUNT_CALL(energy);
+    *energy = stub_energy(device);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTemperature(nvmlDevice_t device,
+                                      nvmlTemperatureSensors_t sensor, unsigned *temp)
+{
+    (void)sensor;
+    COUNT_CALL(temperature);
+    *temp = 50 + device->index;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetClock(nvmlDevice_t device, nvmlClockType_t type,
+                                nvmlClockId_t id, unsigned *clock)
+{
+    (void)device;
+    (void)id;
+    COUNT_CALL(clock);
+    *clock = type == NVML_CLOCK_MEM ? 877 : 1380;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetUtilizationRates(nvmlDevice_t device,
+        nvmlUtilization_t *util)
+{
+    COUNT_CALL(utilization);
+    util->gpu = 10 * device->index;
+    util->memory = 5 * device->index;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCurrentClocksThrottleReasons(nvmlDevice_t device,
+        unsigned long long *reasons)
+{
+    COUNT_CALL(throttle_reasons);
+    *reasons = g_throttle_reasons[device->index];
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetEnforcedPowerLimit(nvmlDevice_t device,
+        unsigned *limit)
+{
+    (void)device;
+    COUNT_CALL(power_limit);
+    *limit = 250000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerManagementLimit(nvmlDevice_t device,
+        unsigned *limit)
+{
+    (void)device;
+    *limit = 250000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceSetPowerManagementLimit(nvmlDevice_t device,
+        unsigned limit)
+{
+    (void)device;
+    (void)limit;
+    return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetViolationStatus(nvmlDevice_t device,
+        nvmlPerfPolicyType_t policy, nvmlViolationTime_t *violation)
+{
+    (void)device;
+    violation->referenceTime = 0;
+    violation->violationTime = policy == NVML_PERF_POLICY_POWER ? 2000000000ULL :
+                               0;
+    return NVML_SUCCESS;
+}
+
+/* Events are not supported, so the throttle monitor polls. */
+nvmlReturn_t nvmlDeviceGetSupportedEventTypes(nvmlDevice_t device,
+        unsigned long long *types)
+{
+    (void)device;
+    *types = 0;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceRegisterEvents(nvmlDevice_t device,
+                                      unsigned long long types, nvmlEventSet_t set)
+{
+    (void)device;
+    (void)types;
+    (void)set;
+    return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlEventSetCreate(nvmlEventSet_t *set)
+{
+    *set = NULL;
+    return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlEventSetFree(nvmlEventSet_t set)
+{
+    (void)set;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlEventSetWait(nvmlEventSet_t set, nvmlEventData_t *data,
+                              unsigned timeout_ms)
+{
+    (void)set;
+    (void)data;
+    (void)timeout_ms;
+    return NVML_ERROR_NOT_SUPPORTED;
+}
@@ -0,0 +1,50 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef NVML_STUB_H_INCLUDE
+#define NVML_STUB_H_INCLUDE
+
+/// @brief Number of GPUs reported by the stub NVML library.
+#define NVML_STUB_NDEVICES 4
+
+/// @brief Calls made into the stub NVML library since the last reset.
+struct nvml_stub_calls
+{
+    int field_values;
+    int power_usage;
+    int energy;
+    int temperature;
+    int clock;
+    int utilization;
+    int throttle_reasons;
+    int power_limit;
+};
+
+/// @brief Return the call counters and set them to zero.
+///
+/// @param [out] calls Calls made since the previous reset.
+void nvml_stub_reset_calls(
+    struct nvml_stub_calls *calls
+);
+
+/// @brief Make nvmlDeviceGetFieldValues() fail every field of one device.
+///
+/// @param [in] device Device index.
+/// @param [in] fail Non-zero to fail the fields, zero to report them again.
+void nvml_stub_fail_field_values(
+    unsigned device,
+    int fail
+);
+
+/// @brief Set the throttle reasons reported for one device.
+///
+/// @param [in] device Device index.
+/// @param [in] reasons Bitmask of nvmlClocksThrottleReason* values.
+void nvml_stub_set_throttle_reasons(
+    unsigned device,
+    unsigned long long reasons
+);
+
+#endif
@@ -0,0 +1,36 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_cap_gpu_power_limits, test_leave_unchanged)
+{
+    struct variorum_gpu_energy energy;
+
+    ASSERT_EQ(0, variorum_get_gpu_energy(&energy));
+    // A limit of 0 leaves a GPU as it is, so this needs no privileges.
+    std::vector<int> limits(energy.ngpus, 0);
+    EXPECT_EQ(0, variorum_cap_gpu_power_limits(energy.ngpus, limits.data()));
+}
+
+TEST(variorum_cap_gpu_power_limits, test_invalid_limits)
+{
+    int limit = -1;
+
+    EXPECT_EQ(-1, variorum_cap_gpu_power_limits(1, NULL));
+    EXPECT_EQ(-1, variorum_cap_gpu_power_limits(1, &limit));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
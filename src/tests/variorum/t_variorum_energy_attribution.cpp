@@ -0,0 +1,62 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_energy_attribution, test_get_energy_attribution)
+{
+    char target[32];
+    struct variorum_energy_attribution attr[1];
+
+    snprintf(target, sizeof(target), "%d", getpid());
+    // The first call establishes the baseline for the interval.
+    EXPECT_EQ(0, variorum_get_energy_attribution(target, attr, 1));
+    EXPECT_EQ(0, variorum_get_energy_attribution(target, attr, 1));
+    EXPECT_GE(attr[0].nthreads, 1);
+    EXPECT_GE(attr[0].energy_joules, 0.0);
+    EXPECT_LE(attr[0].energy_joules, attr[0].total_energy_joules);
+}
+
+TEST(variorum_energy_attribution, test_too_many_targets)
+{
+    struct variorum_energy_attribution attr[1];
+
+    EXPECT_EQ(-1, variorum_get_energy_attribution("1,2", attr, 1));
+}
+
+TEST(variorum_energy_attribution, test_get_energy_attribution_json)
+{
+    char target[32];
+    char *s = NULL;
+
+    snprintf(target, sizeof(target), "%d", getpid());
+    EXPECT_EQ(0, variorum_get_energy_attribution_json(target, &s));
+    free(s);
+}
+
+TEST(variorum_energy_attribution, test_get_energy_attribution_json_no_targets)
+{
+    char *s = NULL;
+
+    EXPECT_EQ(0, variorum_get_energy_attribution_json("", &s));
+    ASSERT_NE((char *)NULL, s);
+    EXPECT_NE((char *)NULL, strstr(s, "energy_attribution"));
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
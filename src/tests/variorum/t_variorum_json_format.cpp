@@ -0,0 +1,147 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+#include <variorum_json.h>
+}
+
+TEST(variorum_json_format, test_set_json_format)
+{
+    EXPECT_EQ(-1, variorum_set_json_format(42));
+    EXPECT_EQ(0, variorum_set_json_format(VARIORUM_JSON_COMPACT));
+    EXPECT_EQ(0, variorum_set_json_format(VARIORUM_JSON_PRETTY));
+    variorum_free_json(NULL);
+}
+
+TEST(variorum_json_format, test_compact_json_string)
+{
+    char *s = NULL;
+
+    EXPECT_EQ(0, variorum_set_json_format(VARIORUM_JSON_COMPACT));
+    EXPECT_EQ(0, variorum_region_begin("compact"));
+    EXPECT_EQ(0, variorum_region_end("compact"));
+    EXPECT_EQ(0, variorum_get_region_energy_json(&s));
+    ASSERT_NE(nullptr, s);
+    EXPECT_EQ(nullptr, strchr(s, '\n'));
+    EXPECT_NE(nullptr, strstr(s, "\"compact\":{"));
+    variorum_free_json(s);
+    EXPECT_EQ(0, variorum_set_json_format(VARIORUM_JSON_PRETTY));
+}
+
+TEST(variorum_json_format, test_writer_escapes_like_jansson)
+{
+    const char *key = "a\"b\\c\bd\fe\nf\rg\th\x01i\x1fj";
+    struct variorum_json_writer w;
+    char buf[256];
+    json_t *obj;
+    char *expected;
+
+    variorum_json_writer_init(&w, buf, sizeof(buf), VARIORUM_JSON_COMPACT);
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_integer(&w, key, 1);
+    variorum_json_end_object(&w);
+
+    obj = json_object();
+    json_object_set_new(obj, key, json_integer(1));
+    expected = json_dumps(obj, JSON_COMPACT);
+    ASSERT_NE(nullptr, expected);
+    EXPECT_STREQ(expected, buf);
+    free(expected);
+    json_decref(obj);
+}
+
+TEST(variorum_json_format, test_get_energy_json_buf)
+{
+    char buf[4096];
+    char small[16];
+    int len;
+
+    // Measure first, as with snprintf.
+    len = variorum_get_energy_json_buf(NULL, 0, VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    ASSERT_LT(len, (int)sizeof(buf));
+
+    len = variorum_get_energy_json_buf(buf, sizeof(buf), VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    EXPECT_EQ((size_t)len, strlen(buf));
+    EXPECT_EQ(nullptr, strchr(buf, '\n'));
+    EXPECT_NE(nullptr, strstr(buf, "\"socket_0\":{\"energy_cpu_joules\":"));
+    EXPECT_NE(nullptr, strstr(buf, "\"energy_node_joules\":"));
+
+    len = variorum_get_energy_json_buf(buf, sizeof(buf), VARIORUM_JSON_PRETTY);
+    ASSERT_GT(len, 0);
+    EXPECT_NE(nullptr, strchr(buf, '\n'));
+
+    // Output that does not fit is truncated but still terminated.
+    len = variorum_get_energy_json_buf(small, sizeof(small), VARIORUM_JSON_COMPACT);
+    EXPECT_GE(len, (int)sizeof(small));
+    EXPECT_EQ(sizeof(small) - 1, strlen(small));
+
+    EXPECT_EQ(-1, variorum_get_energy_json_buf(buf, sizeof(buf), 42));
+}
+
+TEST(variorum_json_format, test_get_power_json_buf)
+{
+    char buf[4096];
+    int len;
+
+    // The first call has no interval yet.
+    len = variorum_get_power_json_buf(buf, sizeof(buf), VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    ASSERT_LT(len, (int)sizeof(buf));
+    EXPECT_NE(nullptr, strstr(buf, "\"socket_0\":{\"power_cpu_watts\":0.0,"));
+
+    len = variorum_get_power_json_buf(buf, sizeof(buf), VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    EXPECT_EQ((size_t)len, strlen(buf));
+    EXPECT_EQ(nullptr, strchr(buf, '\n'));
+    EXPECT_NE(nullptr, strstr(buf, "\"power_node_watts\":"));
+
+    EXPECT_EQ(-1, variorum_get_power_json_buf(NULL, sizeof(buf),
+              VARIORUM_JSON_COMPACT));
+}
+
+TEST(variorum_json_format, test_get_thermals_json_buf)
+{
+    char buf[16384];
+    int len;
+
+    len = variorum_get_thermals_json_buf(NULL, 0, VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    ASSERT_LT(len, (int)sizeof(buf));
+
+    len = variorum_get_thermals_json_buf(buf, sizeof(buf), VARIORUM_JSON_PRETTY);
+    ASSERT_GT(len, 0);
+    EXPECT_EQ((size_t)len, strlen(buf));
+    EXPECT_NE(nullptr, strstr(buf, "\"socket_0\": {"));
+
+    EXPECT_EQ(-1, variorum_get_thermals_json_buf(buf, sizeof(buf), 42));
+}
+
+TEST(variorum_json_format, test_get_frequency_json_buf)
+{
+    char buf[16384];
+    int len;
+
+    len = variorum_get_frequency_json_buf(buf, sizeof(buf), VARIORUM_JSON_COMPACT);
+    ASSERT_GT(len, 0);
+    ASSERT_LT(len, (int)sizeof(buf));
+    EXPECT_EQ((size_t)len, strlen(buf));
+    EXPECT_NE(nullptr, strstr(buf, "\"socket_0\":{"));
+
+    EXPECT_EQ(-1, variorum_get_frequency_json_buf(buf, sizeof(buf), 42));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <nvidia_gpu_power_features.h>
+#include <nvidia_gpu_sampler.h>
+#include "nvml_stub.h"
+}
+
+class variorum_nvidia_gpu_sampler : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            struct nvml_stub_calls calls;
+
+            unsetenv("VARIORUM_NVIDIA_GPU_THREADS");
+            initNVML();
+            nvml_stub_reset_calls(&calls);
+        }
+
+        void TearDown() override
+        {
+            unsigned d;
+
+            for (d = 0; d < NVML_STUB_NDEVICES; d++)
+            {
+                nvml_stub_fail_field_values(d, 0);
+                nvml_stub_set_throttle_reasons(d, 0);
+            }
+            shutdownNVML();
+        }
+};
+
+TEST_F(variorum_nvidia_gpu_sampler, test_power_and_energy_in_one_call)
+{
+    struct nvidia_gpu_snapshot *snap = NULL;
+    struct nvml_stub_calls calls;
+    unsigned d;
+
+    ASSERT_EQ(nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_POWER |
+                                NVIDIA_GPU_SAMPLE_ENERGY, &snap), 0);
+    ASSERT_EQ(snap->ndevices, (unsigned)NVML_STUB_NDEVICES);
+    for (d = 0; d < snap->ndevices; d++)
+    {
+        ASSERT_EQ(snap->device[d].power_ret, NVML_SUCCESS);
+        EXPECT_EQ(snap->device[d].power, 100000 + 1000 * d);
+        ASSERT_EQ(snap->device[d].energy_ret, NVML_SUCCESS);
+        EXPECT_EQ(snap->device[d].energy, 1000000ULL * (d + 1));
+    }
+
+    nvml_stub_reset_calls(&calls);
+    EXPECT_EQ(calls.field_values, NVML_STUB_NDEVICES);
+    EXPECT_EQ(calls.power_usage, 0);
+    EXPECT_EQ(calls.energy, 0);
+    EXPECT_EQ(calls.temperature, 0);
+}
+
+TEST_F(variorum_nvidia_gpu_sampler, test_failed_fields_fall_back)
+{
+    struct nvidia_gpu_snapshot *snap = NULL;
+    struct nvml_stub_calls calls;
+
+    nvml_stub_fail_field_values(1, 1);
+    ASSERT_EQ(nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_POWER |
+                                NVIDIA_GPU_SAMPLE_ENERGY, &snap), 0);
+    ASSERT_EQ(snap->device[1].power_ret, NVML_SUCCESS);
+    EXPECT_EQ(snap->device[1].power, 101000u);
+    ASSERT_EQ(snap->device[1].energy_ret, NVML_SUCCESS);
+    EXPECT_EQ(snap->device[1].energy, 2000000ULL);
+
+    // Only the failing device is read field by field.
+    nvml_stub_reset_calls(&calls);
+    EXPECT_EQ(calls.power_usage, 1);
+    EXPECT_EQ(calls.energy, 1);
+}
+
+TEST_F(variorum_nvidia_gpu_sampler, test_only_requested_fields)
+{
+    struct nvidia_gpu_snapshot *snap = NULL;
+    struct nvml_stub_calls calls;
+
+    ASSERT_EQ(nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_CLOCKS, &snap), 0);
+    EXPECT_EQ(snap->device[0].sm_clock, 1380u);
+    EXPECT_EQ(snap->device[0].mem_clock, 877u);
+
+    nvml_stub_reset_calls(&calls);
+    EXPECT_EQ(calls.clock, 2 * NVML_STUB_NDEVICES);
+    EXPECT_EQ(calls.field_values, 0);
+    EXPECT_EQ(calls.utilization, 0);
+    EXPECT_EQ(calls.power_limit, 0);
+}
+
+TEST_F(variorum_nvidia_gpu_sampler, test_device_threads)
+{
+    struct nvidia_gpu_snapshot *snap = NULL;
+    struct nvml_stub_calls calls;
+    unsigned d;
+
+    setenv("VARIORUM_NVIDIA_GPU_THREADS", "1", 1);
+    ASSERT_EQ(nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_TEMPERATURE |
+                                NVIDIA_GPU_SAMPLE_UTILIZATION, &snap), 0);
+    for (d = 0; d < snap->ndevices; d++)
+    {
+        EXPECT_EQ(snap->device[d].temp_gpu, 50 + d);
+        EXPECT_EQ(snap->device[d].util.gpu, 10 * d);
+    }
+
+    nvml_stub_reset_calls(&calls);
+    EXPECT_EQ(calls.temperature, NVML_STUB_NDEVICES);
+    EXPECT_EQ(calls.utilization, NVML_STUB_NDEVICES);
+}
+
+TEST_F(variorum_nvidia_gpu_sampler, test_throttle_events_from_snapshot)
+{
+    struct variorum_gpu_throttle_event events[NVML_STUB_NDEVICES];
+    struct nvml_stub_calls calls;
+    int nevents;
+
+    nvml_stub_set_throttle_reasons(2, nvmlClocksThrottleReasonSwPowerCap);
+    nevents = nvidia_gpu_get_throttle_events(0, events, NVML_STUB_NDEVICES);
+    ASSERT_EQ(nevents, 1);
+    EXPECT_EQ(events[0].gpu, 2);
+    EXPECT_EQ(events[0].previous_reasons, 0u);
+    EXPECT_EQ(events[0].reasons, (unsigned)VARIORUM_GPU_THROTTLE_POWER_CAP);
+    EXPECT_DOUBLE_EQ(events[0].power_violation_s, 2.0);
+
+    // One scan reads the reasons of every device once.
+    nvml_stub_reset_calls(&calls);
+    EXPECT_EQ(calls.throttle_reasons, NVML_STUB_NDEVICES);
+}
+
+TEST_F(variorum_nvidia_gpu_sampler, test_thermals_and_clocks_from_snapshot)
+{
+    struct nvidia_gpu_snapshot *snap = NULL;
+    struct variorum_gpu_thermals thermals;
+    struct variorum_gpu_clocks clocks;
+    int d;
+
+    ASSERT_EQ(nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_TEMPERATURE |
+                                NVIDIA_GPU_SAMPLE_CLOCKS, &snap), 0);
+    ASSERT_EQ(nvidia_gpu_get_gpu_thermals(snap, &thermals), 0);
+    ASSERT_EQ(nvidia_gpu_get_gpu_clocks(snap, &clocks), 0);
+    ASSERT_EQ(thermals.ngpus, NVML_STUB_NDEVICES);
+    ASSERT_EQ(clocks.ngpus, NVML_STUB_NDEVICES);
+    for (d = 0; d < NVML_STUB_NDEVICES; d++)
+    {
+        EXPECT_DOUBLE_EQ(thermals.celsius[d], 50.0 + d);
+        EXPECT_DOUBLE_EQ(clocks.sm_mhz[d], 1380.0);
+        EXPECT_DOUBLE_EQ(clocks.mem_mhz[d], 877.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,42 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_query_core_energy, test_get_core_energy)
+{
+    struct variorum_core_energy energy;
+    int i;
+
+    // The first call establishes the baseline for the interval.
+    ASSERT_EQ(0, variorum_get_core_energy(&energy));
+    ASSERT_EQ(0, variorum_get_core_energy(&energy));
+    EXPECT_GE(energy.ncores, 1);
+    EXPECT_GE(energy.nccds, 1);
+    for (i = 0; i < energy.ncores; i++)
+    {
+        EXPECT_GE(energy.core_watts[i], 0.0);
+    }
+}
+
+TEST(variorum_query_core_energy, test_get_core_energy_json)
+{
+    char *s = NULL;
+
+    EXPECT_EQ(0, variorum_get_core_energy_json(&s));
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
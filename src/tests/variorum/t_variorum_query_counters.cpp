@@ -19,6 +19,47 @@ TEST(variorum_queries, test_print_counters)
     EXPECT_EQ(0, variorum_print_counters());
 }
 
+TEST(variorum_queries, test_get_thread_counters)
+{
+    struct variorum_thread_counters_sample sample;
+    int i;
+
+    ASSERT_EQ(0, variorum_get_thread_counters(&sample));
+    ASSERT_EQ(0, variorum_get_thread_counters(&sample));
+    EXPECT_GE(sample.nthreads, 1);
+    EXPECT_GE(sample.nevents, 1);
+    EXPECT_GT(sample.interval, 0.0);
+    for (i = 0; i < sample.nthreads; i++)
+    {
+        EXPECT_GE(sample.threads[i].ipc, 0.0);
+        EXPECT_GE(sample.threads[i].freq_mhz, 0.0);
+        EXPECT_GE(sample.threads[i].mem_bound_ratio, 0.0);
+    }
+}
+
+TEST(variorum_queries, test_set_counter_events)
+{
+    EXPECT_EQ(-1, variorum_set_counter_events("NOT_AN_EVENT"));
+    EXPECT_EQ(0, variorum_set_counter_events(NULL));
+}
+
+TEST(variorum_queries, test_get_uncore_counters)
+{
+    struct variorum_uncore_sample sample;
+    int i;
+
+    ASSERT_EQ(0, variorum_get_uncore_counters(&sample));
+    ASSERT_EQ(0, variorum_get_uncore_counters(&sample));
+    EXPECT_GE(sample.nsockets, 1);
+    EXPECT_GT(sample.interval, 0.0);
+    for (i = 0; i < sample.nsockets; i++)
+    {
+        EXPECT_GE(sample.sockets[i].uncore_freq_mhz, 0.0);
+        EXPECT_GE(sample.sockets[i].band_residency[0], 0.0);
+        EXPECT_GE(sample.sockets[i].mem_read_bytes_per_sec, 0.0);
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
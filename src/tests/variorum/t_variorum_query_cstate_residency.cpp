@@ -0,0 +1,64 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_query_cstate_residency, test_get_cstate_residency)
+{
+    struct variorum_cstate_sample sample;
+    int i, k;
+
+    // The first sample has no interval to report on.
+    ASSERT_EQ(0, variorum_get_cstate_residency(&sample));
+    EXPECT_EQ(0.0, sample.interval);
+    for (i = 0; i < sample.nsockets; i++)
+    {
+        for (k = 0; k < sample.npkg_cstates; k++)
+        {
+            EXPECT_EQ(0.0, sample.sockets[i].percent[k]);
+        }
+    }
+
+    ASSERT_EQ(0, variorum_get_cstate_residency(&sample));
+    EXPECT_GE(sample.nsockets, 1);
+    EXPECT_GE(sample.ncores, sample.nsockets);
+    EXPECT_GT(sample.interval, 0.0);
+    for (i = 0; i < sample.nsockets; i++)
+    {
+        for (k = 0; k < sample.npkg_cstates; k++)
+        {
+            EXPECT_GE(sample.sockets[i].percent[k], 0.0);
+            EXPECT_LE(sample.sockets[i].percent[k], 100.0);
+        }
+    }
+    for (i = 0; i < sample.ncores; i++)
+    {
+        for (k = 0; k < sample.ncore_cstates; k++)
+        {
+            EXPECT_GE(sample.cores[i].percent[k], 0.0);
+            EXPECT_LE(sample.cores[i].percent[k], 100.0);
+        }
+    }
+}
+
+TEST(variorum_query_cstate_residency, test_get_cstate_residency_json)
+{
+    char *s = NULL;
+
+    ASSERT_EQ(0, variorum_get_cstate_residency_json(&s));
+    ASSERT_NE((char *)NULL, s);
+    EXPECT_NE((char *)NULL, strstr(s, "Socket_0"));
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -19,6 +19,21 @@ TEST(variorum_queries, test_print_frequency)
     EXPECT_EQ(0, variorum_print_frequency());
 }
 
+TEST(variorum_queries, test_get_core_frequency)
+{
+    struct variorum_core_frequency freq;
+    int i;
+
+    ASSERT_EQ(0, variorum_get_core_frequency(&freq));
+    ASSERT_EQ(0, variorum_get_core_frequency(&freq));
+    EXPECT_GE(freq.ncores, 1);
+    EXPECT_GT(freq.interval, 0.0);
+    for (i = 0; i < freq.ncores; i++)
+    {
+        EXPECT_GE(freq.avg_mhz[i], 0.0);
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,41 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_query_gpu_energy, test_get_gpu_energy)
+{
+    struct variorum_gpu_energy energy = {};
+    std::vector<double> first;
+    int i;
+
+    ASSERT_EQ(0, variorum_get_gpu_energy(&energy));
+    ASSERT_GE(energy.ngpus, 1);
+    first.resize(energy.ngpus);
+    for (i = 0; i < energy.ngpus; i++)
+    {
+        first[i] = energy.gpu_joules[i];
+    }
+
+    // The counters never go backwards between two reads.
+    ASSERT_EQ(0, variorum_get_gpu_energy(&energy));
+    ASSERT_EQ(first.size(), (size_t)energy.ngpus);
+    for (i = 0; i < energy.ngpus; i++)
+    {
+        EXPECT_GE(energy.gpu_joules[i], first[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,39 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_query_gpu_throttle, test_get_gpu_throttle_events)
+{
+    struct variorum_gpu_throttle_event events[64];
+    int nevents;
+    int i;
+
+    nevents = variorum_get_gpu_throttle_events(0, events, 64);
+    ASSERT_GE(nevents, 0);
+    for (i = 0; i < nevents; i++)
+    {
+        EXPECT_GE(events[i].gpu, 0);
+        EXPECT_NE(events[i].previous_reasons, events[i].reasons);
+    }
+
+    // Changes are only reported once.
+    nevents = variorum_get_gpu_throttle_events(100, events, 64);
+    ASSERT_GE(nevents, 0);
+    for (i = 0; i < nevents; i++)
+    {
+        EXPECT_NE(events[i].previous_reasons, events[i].reasons);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
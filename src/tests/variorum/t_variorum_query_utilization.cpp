@@ -0,0 +1,38 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_queries, test_get_utilization_json)
+{
+    char *s = NULL;
+
+    // The first call establishes the baseline for the interval.
+    EXPECT_EQ(0, variorum_get_utilization_json(&s));
+    free(s);
+    s = NULL;
+    EXPECT_EQ(0, variorum_get_utilization_json(&s));
+    ASSERT_TRUE(s != NULL);
+    EXPECT_TRUE(strstr(s, "\"per_cpu\"") != NULL);
+    EXPECT_TRUE(strstr(s, "\"per_numa_node\"") != NULL);
+    EXPECT_TRUE(strstr(s, "\"Node_0\"") != NULL);
+    EXPECT_TRUE(strstr(s, "\"per_socket\"") != NULL);
+    EXPECT_TRUE(strstr(s, "\"iowait_util%\"") != NULL);
+    EXPECT_TRUE(strstr(s, "\"steal_util%\"") != NULL);
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_region_energy, test_nested_regions)
+{
+    struct variorum_region_energy outer;
+    struct variorum_region_energy inner;
+
+    EXPECT_EQ(0, variorum_region_begin("outer"));
+    EXPECT_EQ(0, variorum_region_begin("inner"));
+    EXPECT_EQ(0, variorum_region_end("inner"));
+    EXPECT_EQ(0, variorum_region_end("outer"));
+
+    EXPECT_EQ(0, variorum_get_region_energy("outer", &outer));
+    EXPECT_EQ(0, variorum_get_region_energy("inner", &inner));
+    EXPECT_EQ(1u, outer.count);
+    EXPECT_EQ(1u, inner.count);
+    EXPECT_GE(outer.seconds, inner.seconds);
+    EXPECT_GE(outer.cpu_joules, inner.cpu_joules);
+}
+
+TEST(variorum_region_energy, test_recursive_region_counted_once)
+{
+    struct variorum_region_energy energy;
+
+    EXPECT_EQ(0, variorum_region_begin("recursive"));
+    EXPECT_EQ(0, variorum_region_begin("recursive"));
+    EXPECT_EQ(0, variorum_region_end("recursive"));
+    EXPECT_EQ(0, variorum_region_end("recursive"));
+
+    EXPECT_EQ(0, variorum_get_region_energy("recursive", &energy));
+    EXPECT_EQ(1u, energy.count);
+}
+
+TEST(variorum_region_energy, test_overlapping_threads_each_counted)
+{
+    struct variorum_region_energy energy;
+
+    // The main thread keeps the region open while another thread runs a
+    // complete instance of it.
+    EXPECT_EQ(0, variorum_region_begin("shared"));
+    std::thread worker([]()
+    {
+        EXPECT_EQ(0, variorum_region_begin("shared"));
+        EXPECT_EQ(0, variorum_region_end("shared"));
+    });
+    worker.join();
+    EXPECT_EQ(0, variorum_region_end("shared"));
+
+    EXPECT_EQ(0, variorum_get_region_energy("shared", &energy));
+    EXPECT_EQ(2u, energy.count);
+}
+
+TEST(variorum_region_energy, test_mismatched_end)
+{
+    EXPECT_EQ(-1, variorum_region_end("never_opened"));
+
+    EXPECT_EQ(0, variorum_region_begin("a"));
+    EXPECT_EQ(-1, variorum_region_end("b"));
+    EXPECT_EQ(0, variorum_region_end("a"));
+}
+
+TEST(variorum_region_energy, test_get_region_energy_json)
+{
+    char *s = NULL;
+
+    EXPECT_EQ(0, variorum_region_begin("json"));
+    EXPECT_EQ(0, variorum_region_end("json"));
+    EXPECT_EQ(0, variorum_get_region_energy_json(&s));
+    ASSERT_NE(nullptr, s);
+    EXPECT_NE(nullptr, strstr(s, "\"json\""));
+    free(s);
+}
+
+TEST(variorum_region_energy, test_close_does_not_drop_region_hold)
+{
+    // The regions keep their own hold on the platform, so a close without a
+    // matching open is still an error rather than a teardown.
+    EXPECT_EQ(0, variorum_region_begin("held"));
+    EXPECT_NE(0, variorum_close());
+    EXPECT_EQ(0, variorum_region_end("held"));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,46 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum.h>
+}
+
+TEST(variorum_session, test_open_close)
+{
+    EXPECT_EQ(0, variorum_open());
+    // Sessions nest; only the outermost close releases the libraries.
+    EXPECT_EQ(0, variorum_open());
+    EXPECT_EQ(0, variorum_close());
+    EXPECT_EQ(0, variorum_close());
+}
+
+TEST(variorum_session, test_calls_inside_session)
+{
+    struct variorum_node_energy first;
+    struct variorum_node_energy second;
+
+    // Calls inside a session reuse the platform state set up by the first.
+    EXPECT_EQ(0, variorum_open());
+    EXPECT_EQ(0, variorum_get_node_energy(&first));
+    EXPECT_EQ(0, variorum_get_node_energy(&second));
+    EXPECT_GE(second.cpu_joules, first.cpu_joules);
+    EXPECT_EQ(0, variorum_close());
+
+    // After the last close, the next call sets the platform up again.
+    EXPECT_EQ(0, variorum_get_node_energy(&first));
+}
+
+TEST(variorum_session, test_close_without_open)
+{
+    EXPECT_NE(0, variorum_close());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
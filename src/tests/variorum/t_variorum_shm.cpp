@@ -0,0 +1,53 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <variorum_shm.h>
+}
+
+TEST(variorum_shm, test_attach_missing_segment)
+{
+    const struct variorum_shm_layout *seg = NULL;
+    EXPECT_EQ(-1, variorum_shm_attach("/variorum_gtest_missing", &seg));
+}
+
+TEST(variorum_shm, test_publish_existing_segment)
+{
+    int fd;
+
+    // A segment this process did not create is left alone.
+    fd = shm_open("/variorum_gtest_existing", O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    EXPECT_EQ(-1, variorum_shm_publish("/variorum_gtest_existing"));
+    EXPECT_EQ(0, shm_unlink("/variorum_gtest_existing"));
+}
+
+TEST(variorum_shm, test_publish_and_read)
+{
+    const struct variorum_shm_layout *seg = NULL;
+    struct variorum_shm_sample sample;
+
+    // Remove a segment left behind by an earlier run that failed.
+    shm_unlink("/variorum_gtest");
+    ASSERT_EQ(0, variorum_shm_publish("/variorum_gtest"));
+    ASSERT_EQ(0, variorum_shm_attach("/variorum_gtest", &seg));
+    EXPECT_EQ(0, variorum_shm_read_latest(seg, &sample, NULL));
+    EXPECT_EQ(1, variorum_shm_read_history(seg, &sample, 1));
+    EXPECT_EQ(0, variorum_shm_detach(seg));
+    EXPECT_EQ(0, variorum_shm_close());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 
 #include <variorum.h>
+#include <variorum_shm.h>
 #include <variorum_topology.h>
 #include <variorum_timers.h>
 #include <jansson.h>
@@ -16,6 +17,9 @@ struct thread_args
     bool measure_all;
     unsigned long sample_interval;
     bool power_with_util;
+    char *shm_name;
+    char *energy_targets;
+    bool gpu_throttle;
 };
 
 int init_data(void)
@@ -257,23 +261,29 @@ void parse_json_util_obj(char *util_str, int num_sockets)
     sys_util = json_real_value(json_object_get(cpu_util_obj, "system_util%"));
     user_util = json_real_value(json_object_get(cpu_util_obj, "user_util%"));
 
+    json_t *cpu_socket_obj = json_object_get(cpu_util_obj, "per_socket");
+
     // On a cpu-only build, this will be NULL.
     json_t *gpu_obj = json_object_get(host_obj, "GPU");
 
     if (write_util_header == true)
     {
         fprintf(utilfile, "%s, %s,", "Hostname", "Timestamp (ms)");
+        fprintf(utilfile, "%s,%s,%s,%s", "Memory_Util (%)",
+                "CPU_Util (%)", "User_Util (%)", "System_Util (%)");
+        for (i = 0; i < num_sockets; ++i)
+        {
+            fprintf(utilfile, ",Socket_%d_CPU_Util (%%)", i);
+        }
 
         if (gpu_obj == NULL)
         {
-            fprintf(utilfile, "%s,%s,%s,%s", "Memory_Util (%)",
-                    "CPU_Util (%)", "User_Util (%)", "System_Util (%)\n");
+            fprintf(utilfile, "\n");
             write_util_header = false;
         }
         else
         {
-            fprintf(utilfile, "%s,%s,%s,%s,", "Memory_Util (%)",
-                    "CPU_Util (%)", "User_Util (%)", "System_Util (%)");
+            fprintf(utilfile, ",");
 
 
             for (i = 0; i < num_sockets; ++i)
@@ -302,16 +312,23 @@ void parse_json_util_obj(char *util_str, int num_sockets)
     }
 
     fprintf(utilfile, "%s,%ld,", hostname, timestamp);
+    fprintf(utilfile, "%lf,%lf,%lf,%lf", mem_util, cpu_util, user_util,
+            sys_util);
+    for (i = 0; i < num_sockets; ++i)
+    {
+        sprintf(socket_num, "Socket_%d", i);
+        json_t *cpu_sock = json_object_get(cpu_socket_obj, socket_num);
+        fprintf(utilfile, ",%lf",
+                json_real_value(json_object_get(cpu_sock, "total_util%")));
+    }
 
     if (gpu_obj == NULL)
     {
-        fprintf(utilfile, "%lf,%lf,%lf,%lf\n", mem_util, cpu_util, user_util,
-                sys_util);
+        fprintf(utilfile, "\n");
     }
     else
     {
-        fprintf(utilfile, "%lf,%lf,%lf,%lf,", mem_util, cpu_util, user_util,
-                sys_util);
+        fprintf(utilfile, ",");
 
         for (i = 0; i < num_sockets; ++i)
         {
@@ -341,7 +358,131 @@ void parse_json_util_obj(char *util_str, int num_sockets)
     json_decref(util_obj);
 }
 
-void take_measurement(bool measure_all, bool power_with_util)
+void parse_json_energy_attribution_obj(char *attr_str)
+{
+    const char *hostname = NULL;
+    const char *target = NULL;
+    static bool write_energy_header = true;
+    uint64_t timestamp;
+    double interval;
+
+    json_t *attr_obj = json_loads(attr_str, JSON_DECODE_ANY, NULL);
+    void *iter = json_object_iter(attr_obj);
+    json_t *host_obj = NULL;
+    json_t *target_obj = NULL;
+
+    /* The hostname is the only key at the first level. */
+    while (iter)
+    {
+        hostname = json_object_iter_key(iter);
+        host_obj = json_object_iter_value(iter);
+        if (host_obj == NULL)
+        {
+            printf("JSON object not found");
+            exit(0);
+        }
+        iter = json_object_iter_next(attr_obj, iter);
+    }
+
+    timestamp = json_integer_value(json_object_get(host_obj, "timestamp"));
+    interval = json_real_value(json_object_get(host_obj, "interval_seconds"));
+    json_t *targets_obj = json_object_get(host_obj, "energy_attribution");
+
+    if (write_energy_header == true)
+    {
+        fprintf(energyfile, "%s,%s,%s,%s,%s,%s,%s,%s,%s\n", "Hostname",
+                "Timestamp (us)", "Interval (s)", "Target", "Threads", "CPU (s)",
+                "Energy (J)", "Total Energy (J)", "Power (W)");
+        write_energy_header = false;
+    }
+
+    json_object_foreach(targets_obj, target, target_obj)
+    {
+        fprintf(energyfile, "%s,%lu,%lf,%s,%ld,%lf,%lf,%lf,%lf\n", hostname,
+                timestamp, interval, target,
+                (long)json_integer_value(json_object_get(target_obj, "num_threads")),
+                json_real_value(json_object_get(target_obj, "cpu_seconds")),
+                json_real_value(json_object_get(target_obj, "energy_joules")),
+                json_real_value(json_object_get(target_obj, "total_energy_joules")),
+                json_real_value(json_object_get(target_obj, "power_watts")));
+    }
+
+    json_decref(attr_obj);
+}
+
+static const char *gpu_throttle_str(unsigned int reasons, char *buf,
+                                    size_t len)
+{
+    static const struct
+    {
+        unsigned int bit;
+        const char *name;
+    } names[] =
+    {
+        {VARIORUM_GPU_THROTTLE_IDLE, "idle"},
+        {VARIORUM_GPU_THROTTLE_APP_CLOCKS, "app_clocks"},
+        {VARIORUM_GPU_THROTTLE_POWER_CAP, "power_cap"},
+        {VARIORUM_GPU_THROTTLE_HW_SLOWDOWN, "hw_slowdown"},
+        {VARIORUM_GPU_THROTTLE_SW_THERMAL, "sw_thermal"},
+        {VARIORUM_GPU_THROTTLE_HW_THERMAL, "hw_thermal"},
+        {VARIORUM_GPU_THROTTLE_HW_POWER_BRAKE, "hw_power_brake"},
+        {VARIORUM_GPU_THROTTLE_OTHER, "other"},
+    };
+    size_t used = 0;
+    size_t i;
+
+    buf[0] = '\0';
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (reasons & names[i].bit)
+        {
+            used += snprintf(buf + used, used < len ? len - used : 0, "%s%s",
+                             used ? "|" : "", names[i].name);
+        }
+    }
+    return used ? buf : "none";
+}
+
+void write_gpu_throttle_events(void)
+{
+    struct variorum_gpu_throttle_event events[64];
+    static bool write_throttle_header = true;
+    char hostname[64];
+    char before[128];
+    char after[128];
+    int nevents;
+    int i;
+
+    // Only transitions are recorded, so this is cheap at any interval.
+    nevents = variorum_get_gpu_throttle_events(0, events,
+              sizeof(events) / sizeof(events[0]));
+    if (nevents < 0)
+    {
+        printf("Get GPU throttle events failed. Exiting.\n");
+        exit(-1);
+    }
+
+    gethostname(hostname, sizeof(hostname));
+    if (write_throttle_header == true)
+    {
+        fprintf(throttlefile, "%s,%s,%s,%s,%s,%s,%s\n", "Hostname",
+                "Timestamp (us)", "GPU", "Previous Reasons", "Reasons",
+                "Power Violation (s)", "Thermal Violation (s)");
+        write_throttle_header = false;
+    }
+    for (i = 0; i < nevents; i++)
+    {
+        fprintf(throttlefile, "%s,%llu,%d,%s,%s,%lf,%lf\n", hostname,
+                events[i].timestamp_us, events[i].gpu,
+                gpu_throttle_str(events[i].previous_reasons, before, sizeof(before)),
+                gpu_throttle_str(events[i].reasons, after, sizeof(after)),
+                events[i].power_violation_s, events[i].thermal_violation_s);
+    }
+}
+
+void take_measurement(bool measure_all, bool power_with_util,
+                      const char *shm_name, const char *energy_targets,
+                      bool gpu_throttle)
 {
 #if 0
     uint64_t instr0 = 0;
@@ -402,6 +543,33 @@ void take_measurement(bool measure_all, bool power_with_util)
         variorum_monitoring(logfile);
     }
 
+    // Apportion package energy of this interval to the requested targets
+    if (energy_targets != NULL)
+    {
+        char *attr_str = NULL;
+
+        if (variorum_get_energy_attribution_json(energy_targets, &attr_str) != 0)
+        {
+            printf("JSON get energy attribution failed. Exiting.\n");
+            free(attr_str);
+            exit(-1);
+        }
+        parse_json_energy_attribution_obj(attr_str);
+        free(attr_str);
+    }
+
+    // Record GPUs whose throttle reasons changed since the last sample
+    if (gpu_throttle == true)
+    {
+        write_gpu_throttle_events();
+    }
+
+    // Share the latest sample with other readers on the node
+    if (shm_name != NULL && variorum_shm_publish(shm_name) != 0)
+    {
+        printf("Publishing to shared memory segment %s failed.\n", shm_name);
+    }
+
 #if 0
     total_joules += rapl_data[0] + rapl_data[1];
     limit_joules += rapl_data[2] + rapl_data[3];
@@ -435,6 +603,9 @@ void *power_measurement(void *arg)
     th_args.sample_interval = (*(struct thread_args *)arg).sample_interval;
     th_args.measure_all = (*(struct thread_args *)arg).measure_all;
     th_args.power_with_util = (*(struct thread_args *)arg).power_with_util;
+    th_args.shm_name = (*(struct thread_args *)arg).shm_name;
+    th_args.energy_targets = (*(struct thread_args *)arg).energy_targets;
+    th_args.gpu_throttle = (*(struct thread_args *)arg).gpu_throttle;
 
     // According to the Intel docs, the counter wraps at most once per second.
     // 50 ms should be short enough to always get good information (this is
@@ -447,7 +618,9 @@ void *power_measurement(void *arg)
     timer_sleep(&timer);
     while (running)
     {
-        take_measurement(th_args.measure_all, th_args.power_with_util);
+        take_measurement(th_args.measure_all, th_args.power_with_util,
+                         th_args.shm_name, th_args.energy_targets,
+                         th_args.gpu_throttle);
         timer_sleep(&timer);
     }
     return arg;
@@ -41,6 +41,10 @@ static FILE *summaryfile = NULL;
 static int watt_cap = 0;
 static volatile int poll_dir = 5;
 static FILE *utilfile = NULL;
+// Per-target energy attribution samples, only used by var_monitor
+static FILE *energyfile = NULL;
+// GPU throttle transitions, only used by var_monitor
+static FILE *throttlefile = NULL;
 
 static pthread_mutex_t mlock;
 static int *shmseg;
@@ -70,7 +74,7 @@ void *power_set_measurement(void *arg)
         // This is intel-specific.
         // Preseve the original behavior with variorum_monitoring for now, by
         // providing `true` as input value for the take_measurement function.
-        take_measurement(true, false);
+        take_measurement(true, false, NULL, NULL, false);
         if (poll_num % 5 == 0)
         {
             if (watts >= watt_cap)
@@ -270,7 +274,7 @@ int main(int argc, char **argv)
         // This is intel-specific.
         // Preseve the original behavior with variorum_monitoring for now, by
         // providing `true` as input value for the take_measurement function.
-        take_measurement(true, false);
+        take_measurement(true, false, NULL, NULL, false);
         end = now_ms();
 
         /* Output summary data. */
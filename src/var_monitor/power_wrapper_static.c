@@ -40,6 +40,10 @@ static FILE *logfile = NULL;
 static FILE *summaryfile = NULL;
 static int watt_cap = 0;
 static FILE *utilfile = NULL;
+// Per-target energy attribution samples, only used by var_monitor
+static FILE *energyfile = NULL;
+// GPU throttle transitions, only used by var_monitor
+static FILE *throttlefile = NULL;
 
 static pthread_mutex_t mlock;
 static int *shmseg;
@@ -226,7 +230,7 @@ int main(int argc, char **argv)
         // This is intel-specific.
         // Preseve the original behavior with variorum_monitoring for now, by
         // providing `true` as input value for the take_measurement function.
-        take_measurement(true, false);
+        take_measurement(true, false, NULL, NULL, false);
         end = now_ms();
 
         /* Output summary data. */
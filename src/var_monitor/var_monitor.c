@@ -43,6 +43,10 @@ static FILE *logfile = NULL;
 // Create another file for logging utilization samples
 // At some point, we want this to be a condition/macro
 static FILE *utilfile = NULL;
+// Per-target energy attribution samples
+static FILE *energyfile = NULL;
+// GPU throttle transitions
+static FILE *throttlefile = NULL;
 
 static pthread_mutex_t mlock;
 static int *shmseg;
@@ -87,6 +91,18 @@ int main(int argc, char **argv)
                         "\n"
                         "    -u\n"
                         "        Sampling and printing node utilization \n"
+                        "\n"
+                        "    -s segment_name\n"
+                        "        Also publish each sample to a shared memory segment\n"
+                        "        (e.g., /variorum) for other readers on the node.\n"
+                        "\n"
+                        "    -e targets\n"
+                        "        Apportion package energy each interval to a comma-separated\n"
+                        "        list of PIDs or cgroup directories (e.g., 1234,/sys/fs/cgroup/job).\n"
+                        "\n"
+                        "    -g\n"
+                        "        Record every change in the GPU throttle reasons, with power and\n"
+                        "        thermal violation time, to a separate file.\n"
                         "\n";
 
     if (argc == 1 || (argc > 1 && (
@@ -107,8 +123,11 @@ int main(int argc, char **argv)
     th_args.sample_interval = FASTEST_SAMPLE_INTERVAL_MS;
     th_args.measure_all = false;
     th_args.power_with_util = false;
+    th_args.shm_name = NULL;
+    th_args.energy_targets = NULL;
+    th_args.gpu_throttle = false;
 
-    while ((opt = getopt(argc, argv, "ca:p:i:v:u")) != -1)
+    while ((opt = getopt(argc, argv, "ca:p:i:v:us:e:g")) != -1)
     {
         switch (opt)
         {
@@ -138,6 +157,15 @@ int main(int argc, char **argv)
             case 'u':
                 th_args.power_with_util = true;
                 break;
+            case 's':
+                th_args.shm_name = strdup(optarg);
+                break;
+            case 'e':
+                th_args.energy_targets = strdup(optarg);
+                break;
+            case 'g':
+                th_args.gpu_throttle = true;
+                break;
             case '?':
                 if (optopt == 'a')
                 {
@@ -191,6 +219,8 @@ int main(int argc, char **argv)
 
     char *fname_dat = NULL;
     char *fname_util = NULL;
+    char *fname_energy = NULL;
+    char *fname_throttle = NULL;
     char *fname_summary = NULL;
     int rc;
 
@@ -199,6 +229,8 @@ int main(int argc, char **argv)
         /* Start the log file. */
         int logfd;
         int logfd_util;
+        int logfd_energy;
+        int logfd_throttle;
         char hostname[64];
         gethostname(hostname, 64);
 
@@ -225,6 +257,30 @@ int main(int argc, char **argv)
                             __FILE__, __LINE__);
                 }
             }
+
+            if (th_args.energy_targets)
+            {
+                rc = asprintf(&fname_energy, "%s/%s.energy_attribution.dat", logpath,
+                              hostname);
+                if (rc == -1)
+                {
+                    fprintf(stderr,
+                            "%s:%d asprintf failed, perhaps out of memory.\n",
+                            __FILE__, __LINE__);
+                }
+            }
+
+            if (th_args.gpu_throttle)
+            {
+                rc = asprintf(&fname_throttle, "%s/%s.gpu_throttle.dat", logpath,
+                              hostname);
+                if (rc == -1)
+                {
+                    fprintf(stderr,
+                            "%s:%d asprintf failed, perhaps out of memory.\n",
+                            __FILE__, __LINE__);
+                }
+            }
         }
         else
         {
@@ -249,6 +305,28 @@ int main(int argc, char **argv)
                             __FILE__, __LINE__);
                 }
             }
+
+            if (th_args.energy_targets)
+            {
+                rc = asprintf(&fname_energy, "%s.energy_attribution.dat", hostname);
+                if (rc == -1)
+                {
+                    fprintf(stderr,
+                            "%s:%d asprintf failed, perhaps out of memory.\n",
+                            __FILE__, __LINE__);
+                }
+            }
+
+            if (th_args.gpu_throttle)
+            {
+                rc = asprintf(&fname_throttle, "%s.gpu_throttle.dat", hostname);
+                if (rc == -1)
+                {
+                    fprintf(stderr,
+                            "%s:%d asprintf failed, perhaps out of memory.\n",
+                            __FILE__, __LINE__);
+                }
+            }
         }
 
         logfd = open(fname_dat, O_WRONLY | O_CREAT | O_EXCL | O_NOATIME | O_NDELAY,
@@ -292,6 +370,52 @@ int main(int argc, char **argv)
             }
         }
 
+        // Open the energy attribution file if the option is selected.
+        if (th_args.energy_targets)
+        {
+            logfd_energy = open(fname_energy,
+                                O_WRONLY | O_CREAT | O_EXCL | O_NOATIME | O_NDELAY,
+                                S_IRUSR | S_IWUSR);
+            if (logfd_energy < 0)
+            {
+                fprintf(stderr,
+                        "Fatal Error: %s on %s cannot open the appropriate fd for %s -- %s.\n", argv[0],
+                        hostname, fname_energy, strerror(errno));
+                return 1;
+            }
+            energyfile = fdopen(logfd_energy, "w");
+
+            if (energyfile == NULL)
+            {
+                fprintf(stderr, "Fatal Error: %s on %s fdopen failed for %s -- %s.\n", argv[0],
+                        hostname, fname_energy, strerror(errno));
+                return 1;
+            }
+        }
+
+        // Open the GPU throttle file if the option is selected.
+        if (th_args.gpu_throttle)
+        {
+            logfd_throttle = open(fname_throttle,
+                                  O_WRONLY | O_CREAT | O_EXCL | O_NOATIME | O_NDELAY,
+                                  S_IRUSR | S_IWUSR);
+            if (logfd_throttle < 0)
+            {
+                fprintf(stderr,
+                        "Fatal Error: %s on %s cannot open the appropriate fd for %s -- %s.\n", argv[0],
+                        hostname, fname_throttle, strerror(errno));
+                return 1;
+            }
+            throttlefile = fdopen(logfd_throttle, "w");
+
+            if (throttlefile == NULL)
+            {
+                fprintf(stderr, "Fatal Error: %s on %s fdopen failed for %s -- %s.\n", argv[0],
+                        hostname, fname_throttle, strerror(errno));
+                return 1;
+            }
+        }
+
         if (logpath)
         {
             printf("Trace and summary files will be dumped in %s/\n", logpath);
@@ -333,7 +457,9 @@ int main(int argc, char **argv)
 
         /* Stop power measurement thread. */
         running = 0;
-        take_measurement(th_args.measure_all, th_args.power_with_util);
+        take_measurement(th_args.measure_all, th_args.power_with_util,
+                         th_args.shm_name, th_args.energy_targets,
+                         th_args.gpu_throttle);
         end = now_ms();
 
         if (logpath)
@@ -397,6 +523,21 @@ int main(int argc, char **argv)
         shmctl(shmid, IPC_RMID, NULL);
         shmdt(shmseg);
 
+        if (th_args.shm_name != NULL)
+        {
+            variorum_shm_close();
+        }
+
+        if (energyfile != NULL)
+        {
+            fclose(energyfile);
+        }
+
+        if (throttlefile != NULL)
+        {
+            fclose(throttlefile);
+        }
+
         pthread_attr_destroy(&mattr);
     }
     else
@@ -429,10 +570,22 @@ int main(int argc, char **argv)
                "  %s\n"
                "  %s\n\n", fname_dat, fname_summary);
     }
+    if (fname_energy != NULL)
+    {
+        printf("  %s\n\n", fname_energy);
+    }
+    if (fname_throttle != NULL)
+    {
+        printf("  %s\n\n", fname_throttle);
+    }
 
     highlander_clean();
     free(fname_dat);
     free(fname_util);
     free(fname_summary);
+    free(fname_energy);
+    free(fname_throttle);
+    free(th_args.shm_name);
+    free(th_args.energy_targets);
     return 0;
 }
@@ -6,11 +6,13 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <config_architecture.h>
 #include <variorum_error.h>
+#include <variorum_topology.h>
 
 #include "msr_core.h"
 #include "amd_power_features.h"
@@ -19,148 +21,227 @@
 #include <cprintf.h>
 #endif
 
-static void create_rapl_data_batch(struct rapl_data *rapl,
-                                   off_t msr_core_energy_status)
+static struct amd_core_energy_data g_core_energy;
+
+/* Map each physical core to its CCD, taken to be the L3 cache that holds it.
+ * Cores that hwloc cannot place are put on CCD 0. */
+static void map_core_ccds(struct amd_core_energy_data *ce)
 {
-    unsigned ncores;
-#ifdef VARIORUM_WITH_AMD_CPU
-    variorum_get_topology(NULL, &ncores, NULL, P_AMD_CPU_IDX);
-#endif
+    hwloc_obj_t core;
+    hwloc_obj_t l3;
+    unsigned i;
 
-    allocate_batch(RAPL_DATA, 2UL * ncores);
+    ce->nccds = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_L3CACHE);
+    if (ce->nccds == 0)
+    {
+        ce->nccds = 1;
+    }
+    for (i = 0; i < ce->ncores; i++)
+    {
+        ce->core_ccd[i] = 0;
+        core = hwloc_get_obj_by_type(topology, HWLOC_OBJ_CORE, i);
+        if (core == NULL)
+        {
+            continue;
+        }
+        l3 = hwloc_get_ancestor_obj_by_type(topology, HWLOC_OBJ_L3CACHE, core);
+        if (l3 != NULL && l3->logical_index < ce->nccds)
+        {
+            ce->core_ccd[i] = l3->logical_index;
+        }
+    }
+}
 
-    rapl->core_bits = (uint64_t **) calloc(ncores, sizeof(uint64_t *));
-    rapl->core_joules = (double *) calloc(ncores, sizeof(double));
-    load_thread_batch(msr_core_energy_status, rapl->core_bits, RAPL_DATA);
+/* Undo a partial init_core_energy() so that a later call starts over. */
+static void reset_core_energy(struct amd_core_energy_data *ce, int batched)
+{
+    if (batched)
+    {
+        free_batch(RAPL_DATA);
+    }
+    free(ce->core_ccd);
+    free(ce->core_bits);
+    free(ce->last_raw);
+    free(ce->raw_acc);
+    free(ce->core_joules);
+    free(ce->core_watts);
+    free(ce->ccd_joules);
+    free(ce->ccd_watts);
+    memset(ce, 0, sizeof(*ce));
 }
 
-static int rapl_storage(struct rapl_data **data)
+static int init_core_energy(off_t msr_rapl_unit, off_t msr_core_energy_status)
 {
-    static struct rapl_data *rapl = NULL;
-    static unsigned ncores = 0;
-    static int init = 0;
+    struct amd_core_energy_data *ce = &g_core_energy;
+    hwloc_obj_t core;
+    uint64_t unit = 0;
+    unsigned cpu;
+    unsigned i;
+    int first;
 
-    if (!init)
-    {
-        init = 1;
 #ifdef VARIORUM_WITH_AMD_CPU
-        variorum_get_topology(NULL, &ncores, NULL, P_AMD_CPU_IDX);
+    variorum_get_topology(NULL, &ce->ncores, NULL, P_AMD_CPU_IDX);
 #endif
+    if (ce->ncores == 0)
+    {
+        return -1;
+    }
 
-        rapl = (struct rapl_data *) malloc(ncores * sizeof(struct rapl_data));
+    /* The energy status unit is the same on every core and does not change,
+     * so it is read once. */
+    if (read_msr_by_coord(0, 0, 0, msr_rapl_unit, &unit) != 0)
+    {
+        return -1;
+    }
+    ce->joules_per_unit = 1.0 / (double)(1 << MASK_VAL(unit, 12, 8));
+
+    ce->core_ccd = (int *) calloc(ce->ncores, sizeof(int));
+    ce->core_bits = (uint64_t **) calloc(ce->ncores, sizeof(uint64_t *));
+    ce->last_raw = (uint32_t *) calloc(ce->ncores, sizeof(uint32_t));
+    ce->raw_acc = (uint64_t *) calloc(ce->ncores, sizeof(uint64_t));
+    ce->core_joules = (double *) calloc(ce->ncores, sizeof(double));
+    ce->core_watts = (double *) calloc(ce->ncores, sizeof(double));
+    ce->ccd_joules = (double *) calloc(ce->ncores, sizeof(double));
+    ce->ccd_watts = (double *) calloc(ce->ncores, sizeof(double));
+    if (ce->core_ccd == NULL || ce->core_bits == NULL || ce->last_raw == NULL ||
+        ce->raw_acc == NULL || ce->core_joules == NULL || ce->core_watts == NULL ||
+        ce->ccd_joules == NULL || ce->ccd_watts == NULL)
+    {
+        reset_core_energy(ce, 0);
+        return -1;
+    }
+    map_core_ccds(ce);
+    if (ce->nccds > ce->ncores)
+    {
+        ce->nccds = ce->ncores;
+    }
 
-        if (data != NULL)
+    /* Core energy is a per-core MSR, so read it once per core from the first
+     * hardware thread of that core rather than once per thread. */
+    if (allocate_batch(RAPL_DATA, ce->ncores) != 0)
+    {
+        reset_core_energy(ce, 0);
+        return -1;
+    }
+    for (i = 0; i < ce->ncores; i++)
+    {
+        core = hwloc_get_obj_by_type(topology, HWLOC_OBJ_CORE, i);
+        // hwloc_bitmap_first() returns -1 for an empty cpuset.
+        first = core != NULL ? hwloc_bitmap_first(core->cpuset) : -1;
+        cpu = first >= 0 ? (unsigned)first : i;
+        if (create_batch_op(msr_core_energy_status, cpu, &ce->core_bits[i],
+                            RAPL_DATA) != 0)
         {
-            *data = rapl;
+            reset_core_energy(ce, 1);
+            return -1;
         }
-#ifdef VARIORUM_DEBUG
-        fprintf(stderr, "%s %s::%d DEBUG: (storage) initialized rapl data at %p\n",
-                getenv("HOSTNAME"), __FILE__, __LINE__, rapl);
-        fprintf(stderr, "DEBUG: socket 0 has pkg_bits at %p\n",
-                &rapl[0].core_bits);
-#endif
-        return 0;
     }
-    if (data != NULL)
+    if (read_batch(RAPL_DATA) != 0)
     {
-        *data = rapl;
+        reset_core_energy(ce, 1);
+        return -1;
     }
+    for (i = 0; i < ce->ncores; i++)
+    {
+        ce->last_raw[i] = (uint32_t) * ce->core_bits[i];
+        ce->raw_acc[i] = ce->last_raw[i];
+    }
+    gettimeofday(&ce->last, NULL);
     return 0;
 }
 
-static int read_rapl_data(off_t msr_core_energy_status)
+int get_core_energy_data(off_t msr_rapl_unit, off_t msr_core_energy_status,
+                         struct variorum_core_energy *energy)
 {
-    static struct rapl_data *rapl = NULL;
     static int init = 0;
-    static unsigned ncores = 0;
-    int i;
+    struct amd_core_energy_data *ce = &g_core_energy;
+    struct timeval now;
+    uint32_t raw;
+    double interval;
+    double delta;
+    unsigned i;
 
     if (!init)
     {
-#ifdef VARIORUM_WITH_AMD_CPU
-        variorum_get_topology(NULL, &ncores, NULL, P_AMD_CPU_IDX);
-#endif
-        if (rapl_storage(&rapl))
+        if (init_core_energy(msr_rapl_unit, msr_core_energy_status) != 0)
+        {
+            return -1;
+        }
+        init = 1;
+        interval = 0.0;
+    }
+    else
+    {
+        if (read_batch(RAPL_DATA) != 0)
         {
             return -1;
         }
-        create_rapl_data_batch(rapl, msr_core_energy_status);
-        for (i = 0; i < (int)ncores; i++)
+        gettimeofday(&now, NULL);
+        interval = (now.tv_sec - ce->last.tv_sec) +
+                   (now.tv_usec - ce->last.tv_usec) / 1000000.0;
+        ce->last = now;
+
+        for (i = 0; i < ce->ncores; i++)
         {
-            rapl->core_joules[i] = 0;
+            /* The counter is 32 bits wide and wraps within minutes under
+             * load; the unsigned difference absorbs a single wrap. */
+            raw = (uint32_t) * ce->core_bits[i];
+            ce->raw_acc[i] += (uint32_t)(raw - ce->last_raw[i]);
+            ce->last_raw[i] = raw;
         }
     }
-    read_batch(RAPL_DATA);
-    init = 1;
-    return 0;
-}
 
-static int get_rapl_unit(off_t msr_rapl_unit, double *energy_val)
-{
-    static struct rapl_units *ru = NULL;
-    static uint64_t **val = NULL;
-
-    ru = (struct rapl_units *) malloc(1 * sizeof(struct rapl_units));
-    val = (uint64_t **) malloc(1 * sizeof(uint64_t *));
-    allocate_batch(RAPL_UNIT, 1);
-    load_socket_batch(msr_rapl_unit, val, RAPL_UNIT);
-    read_batch(RAPL_UNIT);
-    ru[1].msr_rapl_power_unit = *val[1];
-    ru[1].joules = (double)(1 << (MASK_VAL(ru[1].msr_rapl_power_unit, 12, 8)));
-    *energy_val = (1 / ru[1].joules);
-
-    free(ru);
-    ru = NULL;
-    free(val);
-    val = NULL;
+    for (i = 0; i < ce->nccds; i++)
+    {
+        ce->ccd_joules[i] = 0.0;
+        ce->ccd_watts[i] = 0.0;
+    }
+    for (i = 0; i < ce->ncores; i++)
+    {
+        delta = ce->raw_acc[i] * ce->joules_per_unit - ce->core_joules[i];
+        ce->core_joules[i] = ce->raw_acc[i] * ce->joules_per_unit;
+        ce->core_watts[i] = interval > 0.0 ? delta / interval : 0.0;
+        ce->ccd_joules[ce->core_ccd[i]] += ce->core_joules[i];
+        ce->ccd_watts[ce->core_ccd[i]] += ce->core_watts[i];
+    }
+
+    energy->ncores = ce->ncores;
+    energy->nccds = ce->nccds;
+    energy->interval = interval;
+    energy->core_joules = ce->core_joules;
+    energy->core_watts = ce->core_watts;
+    energy->ccd_joules = ce->ccd_joules;
+    energy->ccd_watts = ce->ccd_watts;
     return 0;
 }
 
 int print_energy_data(FILE *writedest, off_t msr_rapl_unit,
                       off_t msr_core_energy_status)
 {
-    static struct rapl_data *rapl = NULL;
-    static int init = 0;
-    unsigned ncores = 0;
     // TODO: We can't test this API yet due to privilege issues. We need to
     // update the printing format here to include hostname and prefix
     // _AMDENERGY once we have ability to test.
     // char hostname[1024];
-    int i, batchfd;
-    double val;
-
-    if ((batchfd = open(MSR_BATCH_PATH, O_RDWR)) < 0)
-    {
-        perror(MSR_BATCH_PATH);
-        return batchfd;
-    }
-
-#ifdef VARIORUM_WITH_AMD_CPU
-    variorum_get_topology(NULL, &ncores, NULL, P_AMD_CPU_IDX);
-#endif
-
-    read_rapl_data(msr_core_energy_status);
+    struct variorum_core_energy energy;
+    int i;
 
-    if (!init)
+    if (get_core_energy_data(msr_rapl_unit, msr_core_energy_status, &energy) != 0)
     {
-        rapl_storage(&rapl);
-        init = 1;
+        return -1;
     }
 
-    get_rapl_unit(msr_rapl_unit, &val);
-
 #ifdef LIBJUSTIFY_FOUND
     cfprintf(writedest, "%s  | %s  |\n", "Core", "Energy (J)");
 #else
     fprintf(writedest, " Core   | Energy (J)   |\n");
 #endif
 
-    for (i = 0; i < (int)ncores; i++)
+    for (i = 0; i < energy.ncores; i++)
     {
 #ifdef LIBJUSTIFY_FOUND
-        cprintf(writedest, "%d  | %f  |\n", i, (*rapl->core_bits[i]) * val);
+        cprintf(writedest, "%d  | %f  |\n", i, energy.core_joules[i]);
 #else
-        fprintf(writedest, "%6d  | %10f  |\n", i, (*rapl->core_bits[i]) * val);
+        fprintf(writedest, "%6d  | %10f  |\n", i, energy.core_joules[i]);
 #endif
     }
 
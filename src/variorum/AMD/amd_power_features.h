@@ -8,16 +8,11 @@
 
 #include <linux/types.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
-struct rapl_units
-{
-    /// @brief Raw 64-bit value stored in MSR_RAPL_POWER_UNIT.
-    uint64_t msr_rapl_power_unit;
-    /// @brief Energy status units (ESU) based on the multiplier 1/(2^ESU) (in
-    /// Joules). ESU is encoded in bits 12:8 of MSR_RAPL_POWER_UNIT.
-    double joules;
-};
+#include <variorum.h>
 
 struct EPYC_19h_offsets
 {
@@ -26,12 +21,39 @@ struct EPYC_19h_offsets
     const off_t msr_pkg_energy_stat;
 };
 
-struct rapl_data
+/// @brief State of the per-core energy engine. The batch of core energy
+/// MSRs is built once and re-read on every sample.
+struct amd_core_energy_data
 {
+    /// @brief Number of physical cores.
+    unsigned ncores;
+    /// @brief Number of CCDs (L3 cache domains).
+    unsigned nccds;
+    /// @brief CCD of each core.
+    int *core_ccd;
+    /// @brief Batch destinations of the 32-bit core energy counters.
     uint64_t **core_bits;
+    /// @brief Counter value at the previous sample.
+    uint32_t *last_raw;
+    /// @brief Counter extended to 64 bits across wraps.
+    uint64_t *raw_acc;
+    /// @brief Energy per counter unit (in Joules), from MSR_RAPL_POWER_UNIT.
+    double joules_per_unit;
+    /// @brief Time of the previous sample.
+    struct timeval last;
+    /// @brief Output arrays, indexed by core or CCD.
     double *core_joules;
+    double *core_watts;
+    double *ccd_joules;
+    double *ccd_watts;
 };
 
+int get_core_energy_data(
+    off_t msr_rapl_unit,
+    off_t msr_core_energy_status,
+    struct variorum_core_energy *energy
+);
+
 int print_energy_data(
     FILE *writedest,
     off_t msr_rapl_unit,
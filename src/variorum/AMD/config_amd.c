@@ -10,6 +10,7 @@
 #include <config_amd.h>
 #include <config_architecture.h>
 #include <epyc.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
 
 uint64_t *detect_amd_arch(void)
@@ -60,7 +61,7 @@ int set_amd_func_ptrs(int idx)
     }
 
     /* smi monitor initialization */
-    ret = esmi_init();
+    ret = variorum_context_get(VARIORUM_CONTEXT_ESMI);
     switch (ret)
     {
         case 0:
@@ -71,6 +72,8 @@ int set_amd_func_ptrs(int idx)
             g_platform[idx].variorum_cap_best_effort_node_power_limit =
                 amd_cpu_epyc_set_and_verify_best_effort_node_power_limit;
             g_platform[idx].variorum_print_energy = amd_cpu_epyc_print_energy;
+            g_platform[idx].variorum_get_core_energy = amd_cpu_epyc_get_core_energy;
+            g_platform[idx].variorum_get_socket_energy = amd_cpu_epyc_get_socket_energy;
             g_platform[idx].variorum_print_frequency = amd_cpu_epyc_print_boostlimit;
             g_platform[idx].variorum_cap_each_core_frequency_limit =
                 amd_cpu_epyc_set_each_core_boostlimit;
@@ -85,6 +88,7 @@ int set_amd_func_ptrs(int idx)
             fprintf(stdout, "ESMI not initialized, drivers not found. "
                     "Msg[%d]: %s\n", ret, esmi_get_err_msg(ret));
             g_platform[idx].variorum_print_energy = amd_cpu_epyc_print_energy;
+            g_platform[idx].variorum_get_core_energy = amd_cpu_epyc_get_core_energy;
             ret = 0;
     }
     return ret;
@@ -11,11 +11,14 @@
 
 #include <config_architecture.h>
 #include <epyc.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
+#include <variorum_json.h>
 #include <e_smi/e_smi.h>
 
 #include "msr_core.h"
 #include "amd_power_features.h"
+#include "epyc_telemetry.h"
 
 #ifdef LIBJUSTIFY_FOUND
 #include <cprintf.h>
@@ -31,6 +34,7 @@ int amd_cpu_epyc_get_power(int long_ver)
 
     int i, ret;
     uint32_t current_power;
+    struct epyc_telemetry *snap;
 
     static int initial = 0;
     static struct timeval start;
@@ -39,10 +43,16 @@ int amd_cpu_epyc_get_power(int long_ver)
 
     gethostname(hostname, 1024);
 
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER, &snap) != 0)
+    {
+        return -1;
+    }
+    now = snap->timestamp;
+
     if (!initial)
     {
         initial = 1;
-        gettimeofday(&start, NULL);
+        start = now;
         if (long_ver == 0)
         {
 #ifdef LIBJUSTIFY_FOUND
@@ -60,10 +70,8 @@ int amd_cpu_epyc_get_power(int long_ver)
     for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
 #endif
     {
-        gettimeofday(&now, NULL);
-
-        current_power = 0;
-        ret = esmi_socket_power_get(i, &current_power);
+        current_power = snap->socket[i].power;
+        ret = snap->socket[i].power_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWER, "
@@ -120,6 +128,7 @@ int amd_cpu_epyc_get_power_limits(int long_ver)
 
     int i, ret;
     uint32_t power, pcap_current, pcap_max;
+    struct epyc_telemetry *snap;
 
     static int initial = 0;
     static struct timeval start;
@@ -128,10 +137,17 @@ int amd_cpu_epyc_get_power_limits(int long_ver)
 
     gethostname(hostname, 1024);
 
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER | EPYC_TELEMETRY_POWER_CAP |
+                               EPYC_TELEMETRY_POWER_CAP_MAX, &snap) != 0)
+    {
+        return -1;
+    }
+    now = snap->timestamp;
+
     if (!initial)
     {
         initial = 1;
-        gettimeofday(&start, NULL);
+        start = now;
         if (long_ver == 0)
         {
             fprintf(stdout,
@@ -145,26 +161,24 @@ int amd_cpu_epyc_get_power_limits(int long_ver)
     for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
 #endif
     {
-        gettimeofday(&now, NULL);
-
-        power = 0;
-        pcap_current = 0;
-        pcap_max = 0;
-        ret = esmi_socket_power_get(i, &power);
+        power = snap->socket[i].power;
+        pcap_current = snap->socket[i].power_cap;
+        pcap_max = snap->socket[i].power_cap_max;
+        ret = snap->socket[i].power_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWER, Err[%d]:%s\n",
                     i, ret, esmi_get_err_msg(ret));
             return ret;
         }
-        ret = esmi_socket_power_cap_get(i, &pcap_current);
+        ret = snap->socket[i].power_cap_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWERCAP, Err[%d]:%s\n",
                     i, ret, esmi_get_err_msg(ret));
             return ret;
         }
-        ret = esmi_socket_power_cap_max_get(i, &pcap_max);
+        ret = snap->socket[i].power_cap_max_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWERCAPMAX, Err[%d]:%s\n",
@@ -228,6 +242,8 @@ int amd_cpu_epyc_set_and_verify_best_effort_node_power_limit(int pcap_new)
     int i, ret;
     uint32_t pcap_test;
     uint32_t max_power = 0;
+    int nsockets = 0;
+    struct epyc_telemetry *snap;
 
     /*
      * Convert the pcap value to mWatt as library takes
@@ -237,12 +253,16 @@ int amd_cpu_epyc_set_and_verify_best_effort_node_power_limit(int pcap_new)
      */
     pcap_new = (pcap_new / 2) * 1000;
 
-#ifdef VARIORUM_WITH_AMD_CPU
-    for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
-#endif
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER_CAP_MAX, &snap) != 0)
     {
-        pcap_test = 0;
-        ret = esmi_socket_power_cap_max_get(i, &max_power);
+        return -1;
+    }
+    nsockets = snap->nsockets;
+
+    for (i = 0; i < nsockets; i++)
+    {
+        max_power = snap->socket[i].power_cap_max;
+        ret = snap->socket[i].power_cap_max_ret;
         if ((ret == 0) && (pcap_new > (int)max_power))
         {
             printf("Input power is more than max limit,"
@@ -264,9 +284,21 @@ int amd_cpu_epyc_set_and_verify_best_effort_node_power_limit(int pcap_new)
             }
             return ret;
         }
-        usleep(100000);
+    }
+
+    /* Wait once for all sockets and verify them from a single pass rather
+     * than sleeping after each socket. */
+    usleep(100000);
+
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER_CAP, &snap) != 0)
+    {
+        return -1;
+    }
 
-        ret = esmi_socket_power_cap_get(i, &pcap_test);
+    for (i = 0; i < nsockets; i++)
+    {
+        pcap_test = snap->socket[i].power_cap;
+        ret = snap->socket[i].power_cap_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWERCAP, Err[%d]:%s\n",
@@ -304,6 +336,7 @@ int amd_cpu_epyc_set_socket_power_limit(int pcap_new)
 
     int i, ret;
     uint32_t max_power = 0;
+    struct epyc_telemetry *snap;
 
     /*
      * Convert the pcap value to mWatt as library takes
@@ -311,6 +344,11 @@ int amd_cpu_epyc_set_socket_power_limit(int pcap_new)
      */
     pcap_new = pcap_new * 1000;
 
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER_CAP_MAX, &snap) != 0)
+    {
+        return -1;
+    }
+
 #ifdef LIBJUSTIFY_FOUND
     cfprintf(stdout, "%s |  %s  |\n", "Socket", "Powercap(Watts)");
 #else
@@ -321,7 +359,8 @@ int amd_cpu_epyc_set_socket_power_limit(int pcap_new)
     for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
 #endif
     {
-        ret = esmi_socket_power_cap_max_get(i, &max_power);
+        max_power = snap->socket[i].power_cap_max;
+        ret = snap->socket[i].power_cap_max_ret;
         if ((ret == 0) && (pcap_new > (int)max_power))
         {
             printf("Input power is more than max limit,"
@@ -377,7 +416,9 @@ int amd_cpu_epyc_print_energy(int long_ver)
     }
 
     int ret;
-    if (!esmi_init() && long_ver == 0)
+    struct epyc_telemetry *snap;
+    if (!variorum_context_get(VARIORUM_CONTEXT_ESMI) && long_ver == 0 &&
+        epyc_telemetry_collect(EPYC_TELEMETRY_ENERGY, &snap) == 0)
     {
         int i;
         uint64_t energy;
@@ -393,8 +434,8 @@ int amd_cpu_epyc_print_energy(int long_ver)
         for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
 #endif
         {
-            energy = 0;
-            ret = esmi_socket_energy_get(i, &energy);
+            energy = snap->socket[i].energy;
+            ret = snap->socket[i].energy_ret;
             if (ret != 0)
             {
                 fprintf(stdout, "Failed to get socket[%d] _SOCKENERGY, Err[%d]:%s\n",
@@ -454,6 +495,69 @@ energy_batch:
     return ret;
 }
 
+int amd_cpu_epyc_get_core_energy(struct variorum_core_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_core_energy_data(msrs.msr_rapl_power_unit,
+                                msrs.msr_core_energy_stat, energy);
+}
+
+int amd_cpu_epyc_get_socket_energy(struct variorum_socket_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    static double *cpu_joules = NULL;
+    static double *zero_joules = NULL;
+    static int nsockets = 0;
+    struct epyc_telemetry *snap;
+    int i;
+
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_ENERGY, &snap) != 0)
+    {
+        return -1;
+    }
+    if (cpu_joules == NULL || nsockets != snap->nsockets)
+    {
+        free(cpu_joules);
+        free(zero_joules);
+        cpu_joules = (double *) calloc(snap->nsockets, sizeof(double));
+        // E-SMI reports no memory or GPU energy.
+        zero_joules = (double *) calloc(snap->nsockets, sizeof(double));
+        if (cpu_joules == NULL || zero_joules == NULL)
+        {
+            nsockets = 0;
+            return -1;
+        }
+        nsockets = snap->nsockets;
+    }
+    for (i = 0; i < nsockets; i++)
+    {
+        if (snap->socket[i].energy_ret != 0)
+        {
+            variorum_error_handler("Could not read socket energy",
+                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        cpu_joules[i] = (double)snap->socket[i].energy / 1000000;
+    }
+
+    energy->nsockets = nsockets;
+    energy->cpu_joules = cpu_joules;
+    energy->mem_joules = zero_joules;
+    energy->gpu_joules = zero_joules;
+    return 0;
+}
+
 int amd_cpu_epyc_print_boostlimit(int long_ver)
 {
     char *val = getenv("VARIORUM_LOG");
@@ -686,6 +790,12 @@ int amd_cpu_epyc_get_power_json(json_t *get_power_obj)
     int i, ret = 0;
     int sockID_len = 12;
     char sockID[sockID_len];
+    struct epyc_telemetry *snap;
+
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER, &snap) != 0)
+    {
+        return -1;
+    }
 
 #ifdef VARIORUM_WITH_AMD_CPU
     for (i = 0; i < g_platform[P_AMD_CPU_IDX].num_sockets; i++)
@@ -695,8 +805,8 @@ int amd_cpu_epyc_get_power_json(json_t *get_power_obj)
         json_t *socket_obj = json_object();
         json_object_set_new(get_power_obj, sockID, socket_obj);
 
-        current_power = 0;
-        ret = esmi_socket_power_get(i, &current_power);
+        current_power = snap->socket[i].power;
+        ret = snap->socket[i].power_ret;
         if (ret != 0)
         {
             fprintf(stdout, "Failed to get socket[%d] _POWER, "
@@ -734,12 +844,18 @@ int amd_cpu_epyc_get_node_power_domain_info_json(char **get_domain_obj_str)
     uint64_t ts;
     int ret = 0;
     uint32_t max_power = 0;
-    json_t *get_domain_obj = json_object();
+    struct epyc_telemetry *snap;
 
     //Get max power from E-SMI from socket 0, same for both sockets.
     //E-SMI doesn't expose minimum yet, something we need AMD to help with.
     //Assuming minimum is 50 W.
-    ret = esmi_socket_power_cap_max_get(0, &max_power);
+    if (epyc_telemetry_collect(EPYC_TELEMETRY_POWER_CAP_MAX, &snap) != 0 ||
+        snap->nsockets == 0)
+    {
+        return -1;
+    }
+    max_power = snap->socket[0].power_cap_max;
+    ret = snap->socket[0].power_cap_max_ret;
 
     if (ret != 0)
     {
@@ -750,6 +866,8 @@ int amd_cpu_epyc_get_node_power_domain_info_json(char **get_domain_obj_str)
     // Convert to Watts
     max_power = max_power / 1000;
 
+    json_t *get_domain_obj = json_object();
+
     gethostname(hostname, 1024);
     gettimeofday(&tv, NULL);
     ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
@@ -780,7 +898,7 @@ int amd_cpu_epyc_get_node_power_domain_info_json(char **get_domain_obj_str)
     json_object_set_new(measurement_obj, "power_cpu", measurement_cpu_obj);
     json_object_set_new(measurement_cpu_obj, "units", json_string("Watts"));
 
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
 
     return 0;
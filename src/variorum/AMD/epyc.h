@@ -8,6 +8,8 @@
 
 #include <jansson.h>
 
+#include <variorum.h>
+
 int amd_cpu_epyc_get_power(
     int long_ver
 );
@@ -25,7 +27,15 @@ int amd_cpu_epyc_set_and_verify_best_effort_node_power_limit(
 );
 
 int amd_cpu_epyc_print_energy(
-    void
+    int long_ver
+);
+
+int amd_cpu_epyc_get_core_energy(
+    struct variorum_core_energy *energy
+);
+
+int amd_cpu_epyc_get_socket_energy(
+    struct variorum_socket_energy *energy
 );
 
 int amd_cpu_epyc_print_boostlimit(
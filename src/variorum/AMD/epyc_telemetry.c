@@ -0,0 +1,152 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <config_architecture.h>
+#include <e_smi/e_smi.h>
+
+#include "epyc_telemetry.h"
+
+struct socket_query
+{
+    int socket;
+    unsigned fields;
+    struct epyc_socket_telemetry *data;
+};
+
+static struct epyc_telemetry g_snap;
+static int g_cap_max_valid = 0;
+
+static void query_socket(int socket, unsigned fields,
+                         struct epyc_socket_telemetry *data)
+{
+    if (fields & EPYC_TELEMETRY_POWER)
+    {
+        data->power = 0;
+        data->power_ret = esmi_socket_power_get(socket, &data->power);
+    }
+    if (fields & EPYC_TELEMETRY_POWER_CAP)
+    {
+        data->power_cap = 0;
+        data->power_cap_ret = esmi_socket_power_cap_get(socket, &data->power_cap);
+    }
+    if (fields & EPYC_TELEMETRY_POWER_CAP_MAX)
+    {
+        data->power_cap_max = 0;
+        data->power_cap_max_ret = esmi_socket_power_cap_max_get(socket,
+                                  &data->power_cap_max);
+    }
+    if (fields & EPYC_TELEMETRY_ENERGY)
+    {
+        data->energy = 0;
+        data->energy_ret = esmi_socket_energy_get(socket, &data->energy);
+    }
+}
+
+static void *query_socket_thread(void *arg)
+{
+    struct socket_query *q = (struct socket_query *)arg;
+
+    query_socket(q->socket, q->fields, q->data);
+    return NULL;
+}
+
+static int use_socket_threads(void)
+{
+    char *val = getenv("VARIORUM_EPYC_SOCKET_THREADS");
+
+    return val != NULL && atoi(val) == 1;
+}
+
+int epyc_telemetry_collect(unsigned fields, struct epyc_telemetry **snap)
+{
+    struct socket_query *queries;
+    pthread_t *threads;
+    int nsockets = 0;
+    int i;
+
+#ifdef VARIORUM_WITH_AMD_CPU
+    nsockets = g_platform[P_AMD_CPU_IDX].num_sockets;
+#endif
+
+    if (g_snap.socket == NULL || g_snap.nsockets != nsockets)
+    {
+        free(g_snap.socket);
+        g_snap.socket = (struct epyc_socket_telemetry *) calloc(nsockets,
+                        sizeof(struct epyc_socket_telemetry));
+        if (g_snap.socket == NULL)
+        {
+            g_snap.nsockets = 0;
+            return -1;
+        }
+        g_snap.nsockets = nsockets;
+        g_cap_max_valid = 0;
+    }
+
+    if (g_cap_max_valid)
+    {
+        fields &= ~EPYC_TELEMETRY_POWER_CAP_MAX;
+    }
+
+    gettimeofday(&g_snap.timestamp, NULL);
+
+    if (nsockets > 1 && use_socket_threads())
+    {
+        queries = (struct socket_query *) malloc(nsockets * sizeof(struct socket_query));
+        threads = (pthread_t *) malloc(nsockets * sizeof(pthread_t));
+        if (queries == NULL || threads == NULL)
+        {
+            free(queries);
+            free(threads);
+            return -1;
+        }
+        for (i = 0; i < nsockets; i++)
+        {
+            queries[i].socket = i;
+            queries[i].fields = fields;
+            queries[i].data = &g_snap.socket[i];
+            if (pthread_create(&threads[i], NULL, query_socket_thread, &queries[i]) != 0)
+            {
+                // Query this socket inline if no thread is available.
+                query_socket(i, fields, &g_snap.socket[i]);
+                threads[i] = pthread_self();
+            }
+        }
+        for (i = 0; i < nsockets; i++)
+        {
+            if (!pthread_equal(threads[i], pthread_self()))
+            {
+                pthread_join(threads[i], NULL);
+            }
+        }
+        free(queries);
+        free(threads);
+    }
+    else
+    {
+        for (i = 0; i < nsockets; i++)
+        {
+            query_socket(i, fields, &g_snap.socket[i]);
+        }
+    }
+
+    if (fields & EPYC_TELEMETRY_POWER_CAP_MAX)
+    {
+        g_cap_max_valid = 1;
+        for (i = 0; i < nsockets; i++)
+        {
+            if (g_snap.socket[i].power_cap_max_ret != 0)
+            {
+                g_cap_max_valid = 0;
+            }
+        }
+    }
+
+    *snap = &g_snap;
+    return 0;
+}
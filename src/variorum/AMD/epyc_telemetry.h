@@ -0,0 +1,67 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef EPYC_TELEMETRY_H_INCLUDE
+#define EPYC_TELEMETRY_H_INCLUDE
+
+#include <stdint.h>
+#include <sys/time.h>
+
+/// @brief Fields that can be requested from epyc_telemetry_collect().
+#define EPYC_TELEMETRY_POWER         0x1
+#define EPYC_TELEMETRY_POWER_CAP     0x2
+#define EPYC_TELEMETRY_POWER_CAP_MAX 0x4
+#define EPYC_TELEMETRY_ENERGY        0x8
+
+/// @brief E-SMI readings of one socket. Each value has the E-SMI status of
+/// the query that produced it; a value is only meaningful if its status is 0.
+struct epyc_socket_telemetry
+{
+    /// @brief Socket power (in milliwatts).
+    uint32_t power;
+    int power_ret;
+    /// @brief Current socket power cap (in milliwatts).
+    uint32_t power_cap;
+    int power_cap_ret;
+    /// @brief Maximum socket power cap (in milliwatts).
+    uint32_t power_cap_max;
+    int power_cap_max_ret;
+    /// @brief Socket energy counter (in microjoules).
+    uint64_t energy;
+    int energy_ret;
+};
+
+/// @brief Readings of all sockets from one collection pass.
+struct epyc_telemetry
+{
+    /// @brief Time at which the pass started.
+    struct timeval timestamp;
+    /// @brief Number of entries in socket.
+    int nsockets;
+    /// @brief Per-socket readings.
+    struct epyc_socket_telemetry *socket;
+};
+
+/// @brief Query the requested fields on every socket in one pass.
+///
+/// Every HSMP request is a mailbox round trip of up to a few milliseconds,
+/// so the collector issues each query at most once per pass and shares the
+/// result between the print, JSON and capping paths. The maximum power cap
+/// does not change at runtime and is only queried on the first pass. If
+/// VARIORUM_EPYC_SOCKET_THREADS=1 is set and the node has more than one
+/// socket, each socket is queried on its own thread so that the mailboxes
+/// are serviced in parallel.
+///
+/// @param [in] fields Bitmask of EPYC_TELEMETRY_* fields.
+/// @param [out] snap Set to the collector's snapshot, which stays valid until
+/// the next call.
+///
+/// @return 0 if successful, otherwise -1
+int epyc_telemetry_collect(
+    unsigned fields,
+    struct epyc_telemetry **snap
+);
+
+#endif
@@ -10,6 +10,8 @@
 #include <amd_gpu_power_features.h>
 #include <config_architecture.h>
 #include <variorum_error.h>
+#include <variorum_gpu_cap.h>
+#include <variorum_gpu_throttle.h>
 #include <variorum_timers.h>
 #include <sys/time.h>
 
@@ -29,16 +31,6 @@ void get_power_data(int chipid, int total_sockets, int verbose, FILE *output)
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -130,15 +122,6 @@ void get_power_data(int chipid, int total_sockets, int verbose, FILE *output)
 #ifdef LIBJUSTIFY_FOUND
     cflush();
 #endif
-
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_power_limit_data(int chipid, int total_sockets, int verbose,
@@ -154,16 +137,6 @@ void get_power_limit_data(int chipid, int total_sockets, int verbose,
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -264,15 +237,6 @@ void get_power_limit_data(int chipid, int total_sockets, int verbose,
 #ifdef LIBJUSTIFY_FOUND
     cflush();
 #endif
-
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_thermals_data(int chipid, int total_sockets, int verbose, FILE *output)
@@ -288,16 +252,6 @@ void get_thermals_data(int chipid, int total_sockets, int verbose, FILE *output)
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -380,14 +334,6 @@ void get_thermals_data(int chipid, int total_sockets, int verbose, FILE *output)
 #ifdef LIBJUSTIFY_FOUND
     cflush();
 #endif
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_thermals_json(int chipid, int total_sockets, json_t *output)
@@ -399,16 +345,6 @@ void get_thermals_json(int chipid, int total_sockets, json_t *output)
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -458,16 +394,6 @@ void get_thermals_json(int chipid, int total_sockets, json_t *output)
         snprintf(gpuid, 32, "temp_celsius_gpu_%d", i);
         json_object_set_new(gpu_obj, gpuid, json_real(temp_val_flt));
     }
-
-    ret = rsmi_shut_down();
-
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_clocks_data(int chipid, int total_sockets, int verbose, FILE *output)
@@ -482,16 +408,6 @@ void get_clocks_data(int chipid, int total_sockets, int verbose, FILE *output)
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -580,14 +496,6 @@ void get_clocks_data(int chipid, int total_sockets, int verbose, FILE *output)
 #ifdef LIBJUSTIFY_FOUND
     cflush();
 #endif
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_clocks_json(int chipid, int total_sockets, json_t *output)
@@ -599,15 +507,6 @@ void get_clocks_json(int chipid, int total_sockets, json_t *output)
 
     snprintf(socketID, 16, "socket_%d", chipid);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -665,15 +564,6 @@ void get_clocks_json(int chipid, int total_sockets, json_t *output)
         json_object_set_new(gpu_obj, gpu_clock_string, json_integer(f_sys_val));
         json_object_set_new(gpu_obj, gpu_mem_clock_string, json_integer(f_mem_val));
     }
-
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_gpu_utilization_data(int chipid, int total_sockets, int verbose,
@@ -689,16 +579,6 @@ void get_gpu_utilization_data(int chipid, int total_sockets, int verbose,
 
     gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -773,53 +653,25 @@ void get_gpu_utilization_data(int chipid, int total_sockets, int verbose,
 #ifdef LIBJUSTIFY_FOUND
     cflush();
 #endif
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
 }
 
 void get_gpu_utilization_data_json(int chipid, int total_sockets,
-                                   json_t *get_gpu_util_obj)
+                                   json_t *get_util_obj)
 {
     rsmi_status_t ret;
     uint32_t num_devices;
     int gpus_per_socket;
     char socket_id[12];
-    char hostname[1024];
     char device_id[12];
     static int init = 0;
     static struct timeval start;
     struct timeval now;
-    struct timeval tv;
-    uint64_t ts;
-
-    gethostname(hostname, 1024);
-    gettimeofday(&tv, NULL);
-    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
 
-    json_t *get_host_util_obj = json_object_get(get_gpu_util_obj, hostname);
-    if (get_host_util_obj == NULL)
-    {
-        get_host_util_obj = json_object();
-        json_object_set_new(get_gpu_util_obj, hostname, get_host_util_obj);
-    }
-
-    json_t *timestamp_obj = json_object_get(get_host_util_obj, "timestamp");
-    if (timestamp_obj == NULL)
-    {
-        json_object_set_new(get_host_util_obj, "timestamp", json_integer(ts));
-    }
-
-    json_t *gpu_obj = json_object_get(get_host_util_obj, "GPU");
+    json_t *gpu_obj = json_object_get(get_util_obj, "GPU");
     if (gpu_obj == NULL)
     {
         gpu_obj = json_object();
-        json_object_set_new(get_host_util_obj, "GPU", gpu_obj);
+        json_object_set_new(get_util_obj, "GPU", gpu_obj);
     }
     snprintf(socket_id, 12, "Socket_%d", chipid);
 
@@ -830,15 +682,6 @@ void get_gpu_utilization_data_json(int chipid, int total_sockets,
         json_object_set_new(gpu_obj, socket_id, socket_obj);
     }
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -871,90 +714,90 @@ void get_gpu_utilization_data_json(int chipid, int total_sockets,
         snprintf(device_id, 12, "GPU%d_util%%", i);
         json_object_set_new(socket_obj, device_id, json_integer(utilpercent));
     }
+}
 
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
+static int amd_gpu_get_power_limit(int gpu, unsigned int *limit_mw)
+{
+    uint64_t cap_uwatts = 0;
+
+    if (rsmi_dev_power_cap_get(gpu, 0, &cap_uwatts) != RSMI_STATUS_SUCCESS)
     {
-        variorum_error_handler("Could not shutdown RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
+        return -1;
     }
+    *limit_mw = (unsigned int)(cap_uwatts / 1000);
+    return 0;
 }
 
-void cap_each_gpu_power_limit(int chipid, int total_sockets,
-                              unsigned int powerlimit)
+static int amd_gpu_set_power_limit(int gpu, unsigned int limit_mw)
 {
     rsmi_status_t ret;
-    uint32_t num_devices;
-    int gpus_per_socket;
-    char hostname[1024];
-    static int init = 0;
-    static struct timeval start;
-    struct timeval now;
-    unsigned int powerlimit_uwatts = powerlimit * 1000000;
-
-    gethostname(hostname, 1024);
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
+    ret = rsmi_dev_power_cap_set(gpu, 0, (uint64_t)limit_mw * 1000);
+    if (ret == RSMI_STATUS_PERMISSION)
     {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
+        variorum_error_handler("Insufficient permissions to set the GPU power limit",
+                               VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
     }
+    return ret == RSMI_STATUS_SUCCESS ? 0 : -1;
+}
 
-    ret = rsmi_num_monitor_devices(&num_devices);
-    if (ret != RSMI_STATUS_SUCCESS)
+int cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    static const struct variorum_gpu_cap_ops ops =
+    {
+        amd_gpu_get_power_limit,
+        amd_gpu_set_power_limit,
+        // The SMU keeps the power cap in whole watts.
+        1000
+    };
+    uint32_t num_devices;
+
+    if (rsmi_num_monitor_devices(&num_devices) != RSMI_STATUS_SUCCESS)
     {
         variorum_error_handler("Could not get number of GPU devices",
                                VARIORUM_ERROR_PLATFORM_ENV,
                                getenv("HOSTNAME"), __FILE__, __FUNCTION__,
                                __LINE__);
+        return -1;
     }
-
-    gpus_per_socket = num_devices / total_sockets;
-
-    if (!init)
+    if (ngpus != (int)num_devices)
     {
-        init = 1;
-        gettimeofday(&start, NULL);
+        variorum_error_handler("Number of GPU power limits does not match the number of GPUs",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
     }
+    return variorum_gpu_cap_apply(&ops, ngpus, gpu_power_limits);
+}
 
-    gettimeofday(&now, NULL);
+int cap_each_gpu_power_limit(unsigned int powerlimit)
+{
+    uint32_t num_devices;
+    uint32_t i;
+    int *limits;
+    int ret;
 
-    int i;
-    for (i = chipid * gpus_per_socket; i < (chipid + 1) * gpus_per_socket; i++)
-    {
-        ret = rsmi_dev_power_cap_set(i, 0, powerlimit_uwatts);
-        if (ret != RSMI_STATUS_SUCCESS)
-        {
-            if (ret == RSMI_STATUS_PERMISSION)
-            {
-                variorum_error_handler(
-                    "Insufficient permissions to set the GPU power limit",
-                    VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"),
-                    __FILE__, __FUNCTION__, __LINE__);
-            }
-            else
-            {
-                variorum_error_handler(
-                    "Could not set the specified GPU power limit",
-                    VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"),
-                    __FILE__, __FUNCTION__, __LINE__);
-            }
-        }
-    }
-    ret = rsmi_shut_down();
-    if (ret != RSMI_STATUS_SUCCESS)
+    if (rsmi_num_monitor_devices(&num_devices) != RSMI_STATUS_SUCCESS)
     {
-        variorum_error_handler("Could not shutdown RSMI",
+        variorum_error_handler("Could not get number of GPU devices",
                                VARIORUM_ERROR_PLATFORM_ENV,
                                getenv("HOSTNAME"), __FILE__, __FUNCTION__,
                                __LINE__);
+        return -1;
+    }
+    limits = (int *) malloc(num_devices * sizeof(int));
+    if (limits == NULL)
+    {
+        return -1;
+    }
+    for (i = 0; i < num_devices; i++)
+    {
+        limits[i] = (int)powerlimit;
     }
+    ret = cap_gpu_power_limits((int)num_devices, limits);
+    free(limits);
+    return ret;
 }
 
 void get_json_power_data(json_t *get_power_obj, int total_sockets)
@@ -973,16 +816,6 @@ void get_json_power_data(json_t *get_power_obj, int total_sockets)
     char devID[devIDlen];
     char socketID[24];
 
-    ret = rsmi_init(0);
-    if (ret != RSMI_STATUS_SUCCESS)
-    {
-        variorum_error_handler("Could not initialize RSMI",
-                               VARIORUM_ERROR_PLATFORM_ENV,
-                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                               __LINE__);
-        exit(-1);
-    }
-
     ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
@@ -1046,15 +879,176 @@ void get_json_power_data(json_t *get_power_obj, int total_sockets)
         json_object_set(get_power_obj, "power_node_watts",
                         json_real(power_node + total_gpu_power));
     }
+}
 
+int get_gpu_energy_data(int total_sockets, struct variorum_gpu_energy *energy)
+{
+    static uint64_t *last_count = NULL;
+    static uint64_t *count = NULL;
+    static double *gpu_joules = NULL;
+    static uint32_t ngpus = 0;
+    rsmi_status_t ret;
+    uint32_t num_devices;
+    uint32_t d;
+    int err = 0;
 
-    ret = rsmi_shut_down();
+    ret = rsmi_num_monitor_devices(&num_devices);
     if (ret != RSMI_STATUS_SUCCESS)
     {
-        variorum_error_handler("Could not shutdown RSMI",
+        variorum_error_handler("Could not get number of GPU devices",
                                VARIORUM_ERROR_PLATFORM_ENV,
                                getenv("HOSTNAME"), __FILE__, __FUNCTION__,
                                __LINE__);
+        return -1;
     }
 
+    if (gpu_joules == NULL || ngpus != num_devices)
+    {
+        free(last_count);
+        free(count);
+        free(gpu_joules);
+        last_count = (uint64_t *) calloc(num_devices, sizeof(uint64_t));
+        count = (uint64_t *) calloc(num_devices, sizeof(uint64_t));
+        gpu_joules = (double *) calloc(num_devices, sizeof(double));
+        ngpus = num_devices;
+        if (last_count == NULL || count == NULL || gpu_joules == NULL)
+        {
+            ngpus = 0;
+            return -1;
+        }
+        for (d = 0; d < ngpus; d++)
+        {
+            // Mark every device as not read yet.
+            last_count[d] = UINT64_MAX;
+        }
+    }
+
+    for (d = 0; d < ngpus; d++)
+    {
+        uint64_t raw = 0;
+        uint64_t timestamp;
+        float resolution = 0.0;
+
+        ret = rsmi_dev_energy_count_get(d, &raw, &resolution, &timestamp);
+        if (ret != RSMI_STATUS_SUCCESS)
+        {
+            variorum_error_handler("Could not query GPU energy",
+                                   VARIORUM_ERROR_PLATFORM_ENV,
+                                   getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                                   __LINE__);
+            err = -1;
+            continue;
+        }
+
+        /* The firmware accumulator is 32 bits wide on some Instinct parts.
+         * Extend it across wraps; a drop from a value above 32 bits can only
+         * be a reset (e.g., a driver reload), so counting restarts there.
+         */
+        if (last_count[d] == UINT64_MAX)
+        {
+            count[d] = raw;
+        }
+        else if (raw >= last_count[d])
+        {
+            count[d] += raw - last_count[d];
+        }
+        else if (last_count[d] <= UINT32_MAX)
+        {
+            count[d] += raw + ((uint64_t)1 << 32) - last_count[d];
+        }
+        else
+        {
+            count[d] += raw;
+        }
+        last_count[d] = raw;
+
+        // The counter ticks in units of resolution microjoules.
+        gpu_joules[d] = (double)count[d] * resolution / 1000000.0;
+    }
+
+    energy->ngpus = (int)ngpus;
+    energy->gpus_per_socket = (int)ngpus / total_sockets;
+    energy->gpu_joules = gpu_joules;
+    return err;
+}
+
+/* Map the ASIC-independent throttler bits reported in GPU metrics v1.3 and
+ * later: power limits in bits 0-15, current and EDC limits in bits 16-31,
+ * temperature limits in bits 32-55, PROCHOT in bits 56-57.
+ * */
+static unsigned int amd_gpu_throttle_reasons(uint64_t indep)
+{
+    unsigned int reasons = 0;
+
+    if (indep & 0xFFFFULL)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_POWER_CAP;
+    }
+    if (indep & 0xFFFF0000ULL)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_HW_SLOWDOWN;
+    }
+    if (indep & 0x00FFFFFF00000000ULL)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_SW_THERMAL;
+    }
+    if (indep & 0x0300000000000000ULL)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_HW_THERMAL;
+    }
+    if (indep & 0xFC00000000000000ULL)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_OTHER;
+    }
+    return reasons;
+}
+
+static int amd_gpu_read_throttle(int gpu, unsigned int *reasons,
+                                 double *power_violation_s,
+                                 double *thermal_violation_s)
+{
+    rsmi_gpu_metrics_t metrics;
+
+    if (rsmi_dev_gpu_metrics_info_get(gpu, &metrics) != RSMI_STATUS_SUCCESS)
+    {
+        return -1;
+    }
+    if (metrics.common_header.format_revision == 1 &&
+        metrics.common_header.content_revision >= 3)
+    {
+        *reasons = amd_gpu_throttle_reasons(metrics.indep_throttle_status);
+    }
+    else
+    {
+        // Older tables only carry the ASIC-specific throttle_status.
+        *reasons = metrics.throttle_status != 0 ? VARIORUM_GPU_THROTTLE_OTHER : 0;
+    }
+    // ROCm SMI does not report violation time.
+    *power_violation_s = -1.0;
+    *thermal_violation_s = -1.0;
+    return 0;
+}
+
+int get_gpu_throttle_events(int timeout_ms,
+                            struct variorum_gpu_throttle_event *events,
+                            int max_events)
+{
+    static struct variorum_gpu_throttle_tracker tracker = {0, NULL};
+    static const struct variorum_gpu_throttle_ops ops =
+    {
+        amd_gpu_read_throttle,
+        NULL
+    };
+    uint32_t num_devices;
+
+    if (rsmi_num_monitor_devices(&num_devices) != RSMI_STATUS_SUCCESS)
+    {
+        variorum_error_handler("Could not get number of GPU devices",
+                               VARIORUM_ERROR_PLATFORM_ENV,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                               __LINE__);
+        return -1;
+    }
+    return variorum_gpu_throttle_poll(&tracker, &ops, (int)num_devices,
+                                      timeout_ms, events, max_events);
 }
@@ -12,6 +12,8 @@
 
 #include <rocm_smi/rocm_smi.h>
 
+#include <variorum.h>
+
 void get_power_data(
     int chipid,
     int total_sockets,
@@ -47,12 +49,15 @@ void get_gpu_utilization_data(
     FILE *output
 );
 
-void cap_each_gpu_power_limit(
-    int chipid,
-    int total_sockets,
+int cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+int cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 void get_thermals_json(
     int chipid,
     int total_sockets,
@@ -73,7 +78,18 @@ void get_clocks_json(
 void get_gpu_utilization_data_json(
     int chipid,
     int total_sockets,
-    json_t *get_gpu_util_obj
+    json_t *get_util_obj
+);
+
+int get_gpu_energy_data(
+    int total_sockets,
+    struct variorum_gpu_energy *energy
+);
+
+int get_gpu_throttle_events(
+    int timeout_ms,
+    struct variorum_gpu_throttle_event *events,
+    int max_events
 );
 
 #endif
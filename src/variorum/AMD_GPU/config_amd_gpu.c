@@ -10,6 +10,7 @@
 #include <config_architecture.h>
 #include <amd_gpu_power_features.h>
 #include <instinctGPU.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
 
 uint64_t *detect_amd_gpu_arch(void)
@@ -26,6 +27,15 @@ int set_amd_gpu_func_ptrs(int idx)
 
     if (*g_platform[idx].arch_id == AMD_INSTINCT)
     {
+        /* ROCm SMI stays initialized across API calls */
+        if (variorum_context_get(VARIORUM_CONTEXT_RSMI) != 0)
+        {
+            variorum_error_handler("Could not initialize RSMI",
+                                   VARIORUM_ERROR_PLATFORM_ENV,
+                                   getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                                   __LINE__);
+            return VARIORUM_ERROR_PLATFORM_ENV;
+        }
         /* Initialize monitoring interfaces */
         g_platform[idx].variorum_print_power = amd_gpu_instinct_get_power;
         g_platform[idx].variorum_print_thermals = amd_gpu_instinct_get_thermals;
@@ -40,8 +50,13 @@ int set_amd_gpu_func_ptrs(int idx)
         /* Initialize control interfaces */
         g_platform[idx].variorum_cap_each_gpu_power_limit =
             amd_gpu_instinct_cap_each_gpu_power_limit;
+        g_platform[idx].variorum_cap_gpu_power_limits =
+            amd_gpu_instinct_cap_gpu_power_limits;
         /* Initialize JSON interfaces */
         g_platform[idx].variorum_get_power_json = amd_gpu_instinct_get_power_json;
+        g_platform[idx].variorum_get_gpu_energy = amd_gpu_instinct_get_gpu_energy;
+        g_platform[idx].variorum_get_gpu_throttle_events =
+            amd_gpu_instinct_get_gpu_throttle_events;
     }
     else
     {
@@ -164,7 +164,7 @@ int amd_gpu_instinct_get_gpu_utilization(int verbose)
     return 0;
 }
 
-int amd_gpu_instinct_get_gpu_utilization_json(char **get_gpu_util_obj_str)
+int amd_gpu_instinct_get_gpu_utilization_json(json_t *get_util_obj)
 {
     char *val = getenv("VARIORUM_LOG");
     if (val != NULL && atoi(val) == 1)
@@ -172,7 +172,6 @@ int amd_gpu_instinct_get_gpu_utilization_json(char **get_gpu_util_obj_str)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    json_t *get_util_obj = json_object();
     unsigned iter = 0;
     unsigned nsockets;
 
@@ -184,9 +183,6 @@ int amd_gpu_instinct_get_gpu_utilization_json(char **get_gpu_util_obj_str)
     {
         get_gpu_utilization_data_json(iter, nsockets, get_util_obj);
     }
-
-    *get_gpu_util_obj_str = json_dumps(get_util_obj, JSON_INDENT(4));
-    json_decref(get_util_obj);
     return 0;
 }
 
@@ -198,16 +194,19 @@ int amd_gpu_instinct_cap_each_gpu_power_limit(unsigned int powerlimit)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    unsigned iter = 0;
-    unsigned nsockets;
-#ifdef VARIORUM_WITH_AMD_GPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_AMD_GPU_IDX);
-#endif
-    for (iter = 0; iter < nsockets; iter++)
+    return cap_each_gpu_power_limit(powerlimit);
+}
+
+int amd_gpu_instinct_cap_gpu_power_limits(int ngpus,
+        const int *gpu_power_limits)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
     {
-        cap_each_gpu_power_limit(iter, nsockets, powerlimit);
+        printf("Running %s\n", __FUNCTION__);
     }
-    return 0;
+
+    return cap_gpu_power_limits(ngpus, gpu_power_limits);
 }
 
 int amd_gpu_instinct_get_power_json(json_t *get_power_obj)
@@ -228,3 +227,32 @@ int amd_gpu_instinct_get_power_json(json_t *get_power_obj)
 
     return 0;
 }
+
+int amd_gpu_instinct_get_gpu_energy(struct variorum_gpu_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    unsigned nsockets;
+
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+#ifdef VARIORUM_WITH_AMD_GPU
+    variorum_get_topology(&nsockets, NULL, NULL, P_AMD_GPU_IDX);
+#endif
+
+    return get_gpu_energy_data(nsockets, energy);
+}
+
+int amd_gpu_instinct_get_gpu_throttle_events(int timeout_ms,
+        struct variorum_gpu_throttle_event *events, int max_events)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_gpu_throttle_events(timeout_ms, events, max_events);
+}
@@ -9,6 +9,8 @@
 #include <jansson.h>
 #include <sys/time.h>
 
+#include <variorum.h>
+
 int amd_gpu_instinct_get_power(
     int verbose
 );
@@ -37,6 +39,11 @@ int amd_gpu_instinct_cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+int amd_gpu_instinct_cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 int amd_gpu_instinct_get_thermals_json(
     json_t *get_thermal_obj
 );
@@ -46,7 +53,17 @@ int amd_gpu_instinct_get_clocks_json(
 );
 
 int amd_gpu_instinct_get_gpu_utilization_json(
-    char **get_gpu_util_obj_str
+    json_t *get_util_obj
+);
+
+int amd_gpu_instinct_get_gpu_energy(
+    struct variorum_gpu_energy *energy
+);
+
+int amd_gpu_instinct_get_gpu_throttle_events(
+    int timeout_ms,
+    struct variorum_gpu_throttle_event *events,
+    int max_events
 );
 
 #endif
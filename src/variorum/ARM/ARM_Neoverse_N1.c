@@ -13,6 +13,7 @@
 #include <ARM_Neoverse_N1.h>
 #include <config_architecture.h>
 #include <variorum_error.h>
+#include <variorum_json.h>
 #include "neoverse_N1_power_features.h"
 
 int arm_neoverse_n1_get_power(int long_ver)
@@ -121,7 +122,7 @@ int arm_neoverse_n1_get_power_domain_info_json(char **get_domain_obj_str)
 
     ret = arm_cpu_neoverse_n1_json_get_power_domain_info(get_domain_obj);
 
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
 
     return ret;
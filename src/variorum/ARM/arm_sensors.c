@@ -0,0 +1,285 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arm_sensors.h"
+
+#define HWMON_PATH "/sys/class/hwmon"
+
+struct arm_sensor
+{
+    int fd;
+    char hwmon_name[32];
+    int fallback_index;
+    char attr[32];
+    int64_t value;
+};
+
+static struct arm_sensor g_sensors[ARM_SENSOR_MAX];
+static int g_nsensors = 0;
+static pthread_mutex_t g_sensor_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t g_sampler;
+static volatile int g_sampler_running = 0;
+static int g_sampler_valid = 0;
+
+/* hwmon attributes are signed decimal numbers, e.g. a temperature below
+ * 0 C is reported as negative millidegrees. */
+static int pread_i64(int fd, int64_t *val)
+{
+    char buf[32];
+    ssize_t n;
+    int64_t v = 0;
+    int neg = 0;
+    int i = 0;
+
+    do
+    {
+        n = pread(fd, buf, sizeof(buf) - 1, 0);
+    }
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+    {
+        return -1;
+    }
+    if (buf[0] == '-')
+    {
+        neg = 1;
+        i++;
+    }
+    for (; i < n && buf[i] >= '0' && buf[i] <= '9'; i++)
+    {
+        v = v * 10 + (buf[i] - '0');
+    }
+    *val = neg ? -v : v;
+    return 0;
+}
+
+/* Return the N of the hwmonN directory whose name file matches, or -1. */
+static int find_hwmon(const char *hwmon_name)
+{
+    DIR *dir;
+    struct dirent *ent;
+    char path[512];
+    char name[64];
+    int fd;
+    int idx = -1;
+    ssize_t n;
+
+    dir = opendir(HWMON_PATH);
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    while (idx < 0 && (ent = readdir(dir)) != NULL)
+    {
+        if (strncmp(ent->d_name, "hwmon", 5) != 0)
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s/name", HWMON_PATH, ent->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            continue;
+        }
+        n = read(fd, name, sizeof(name) - 1);
+        close(fd);
+        if (n <= 0)
+        {
+            continue;
+        }
+        name[n] = '\0';
+        name[strcspn(name, "\n")] = '\0';
+        if (strcmp(name, hwmon_name) == 0)
+        {
+            idx = atoi(ent->d_name + 5);
+        }
+    }
+    closedir(dir);
+    return idx;
+}
+
+int arm_sensor_open(const char *hwmon_name, int fallback_index,
+                    const char *attr)
+{
+    int i;
+    int hwmon = -1;
+    int id = -1;
+    char path[512];
+    struct arm_sensor *sensor;
+
+    if (hwmon_name == NULL)
+    {
+        hwmon_name = "";
+    }
+
+    pthread_mutex_lock(&g_sensor_lock);
+    for (i = 0; i < g_nsensors; i++)
+    {
+        if (g_sensors[i].fallback_index == fallback_index &&
+            strcmp(g_sensors[i].hwmon_name, hwmon_name) == 0 &&
+            strcmp(g_sensors[i].attr, attr) == 0)
+        {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && g_nsensors < ARM_SENSOR_MAX)
+    {
+        if (hwmon_name[0] != '\0')
+        {
+            hwmon = find_hwmon(hwmon_name);
+        }
+        if (hwmon < 0)
+        {
+            hwmon = fallback_index;
+        }
+        sensor = &g_sensors[g_nsensors];
+        snprintf(path, sizeof(path), "%s/hwmon%d/%s", HWMON_PATH, hwmon, attr);
+        sensor->fd = open(path, O_RDONLY);
+        if (sensor->fd >= 0)
+        {
+            snprintf(sensor->hwmon_name, sizeof(sensor->hwmon_name), "%s", hwmon_name);
+            sensor->fallback_index = fallback_index;
+            snprintf(sensor->attr, sizeof(sensor->attr), "%s", attr);
+            sensor->value = 0;
+            id = g_nsensors++;
+            // The sampler has not read the new sensor yet.
+            g_sampler_valid = 0;
+        }
+    }
+    pthread_mutex_unlock(&g_sensor_lock);
+    return id;
+}
+
+int arm_sensor_read(int id, int64_t *val)
+{
+    return arm_sensors_read(&id, 1, val);
+}
+
+int arm_sensors_read(const int *ids, int n, int64_t *vals)
+{
+    int i;
+    int ret = 0;
+
+    pthread_mutex_lock(&g_sensor_lock);
+    for (i = 0; i < n; i++)
+    {
+        if (ids[i] < 0 || ids[i] >= g_nsensors)
+        {
+            ret = -1;
+            break;
+        }
+        if (g_sampler_running && g_sampler_valid)
+        {
+            vals[i] = g_sensors[ids[i]].value;
+        }
+        else if (pread_i64(g_sensors[ids[i]].fd, &vals[i]) != 0)
+        {
+            ret = -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_sensor_lock);
+    return ret;
+}
+
+static void *sampler_loop(void *arg)
+{
+    int i;
+    int n;
+    int ok;
+    int64_t vals[ARM_SENSOR_MAX];
+
+    (void)arg;
+    while (g_sampler_running)
+    {
+        // Read outside the lock so that callers are never blocked on sysfs.
+        pthread_mutex_lock(&g_sensor_lock);
+        n = g_nsensors;
+        pthread_mutex_unlock(&g_sensor_lock);
+
+        ok = 1;
+        for (i = 0; i < n; i++)
+        {
+            if (pread_i64(g_sensors[i].fd, &vals[i]) != 0)
+            {
+                ok = 0;
+            }
+        }
+
+        pthread_mutex_lock(&g_sensor_lock);
+        for (i = 0; i < n; i++)
+        {
+            g_sensors[i].value = vals[i];
+        }
+        g_sampler_valid = ok && n == g_nsensors;
+        pthread_mutex_unlock(&g_sensor_lock);
+
+        usleep(ARM_SENSOR_SAMPLER_INTERVAL_US);
+    }
+    return NULL;
+}
+
+int arm_sensors_start_sampler(int cpu)
+{
+    cpu_set_t set;
+
+    if (g_sampler_running)
+    {
+        return 0;
+    }
+    g_sampler_valid = 0;
+    g_sampler_running = 1;
+    if (pthread_create(&g_sampler, NULL, sampler_loop, NULL) != 0)
+    {
+        g_sampler_running = 0;
+        return -1;
+    }
+    if (cpu >= 0)
+    {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(g_sampler, sizeof(set), &set);
+    }
+    return 0;
+}
+
+void arm_sensors_stop_sampler(void)
+{
+    if (!g_sampler_running)
+    {
+        return;
+    }
+    g_sampler_running = 0;
+    pthread_join(g_sampler, NULL);
+    g_sampler_valid = 0;
+}
+
+void arm_sensors_close(void)
+{
+    int i;
+
+    arm_sensors_stop_sampler();
+    pthread_mutex_lock(&g_sensor_lock);
+    for (i = 0; i < g_nsensors; i++)
+    {
+        close(g_sensors[i].fd);
+    }
+    g_nsensors = 0;
+    pthread_mutex_unlock(&g_sensor_lock);
+}
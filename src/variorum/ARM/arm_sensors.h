@@ -0,0 +1,83 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef ARM_SENSORS_H_INCLUDE
+#define ARM_SENSORS_H_INCLUDE
+
+#include <stdint.h>
+
+/// @brief Maximum number of hwmon attributes held open at once.
+#define ARM_SENSOR_MAX 64
+
+/// @brief Period of the optional sampler thread, in microseconds.
+#define ARM_SENSOR_SAMPLER_INTERVAL_US 10000
+
+/// @brief Open (once) a hwmon attribute such as power1_input and return its
+/// sensor ID.
+///
+/// The hwmon device is found by the contents of its name file, so the
+/// kernel's hwmonN numbering does not matter. If no device has that name
+/// (or hwmon_name is NULL), /sys/class/hwmon/hwmon<fallback_index> is used.
+/// Later calls with the same arguments return the cached ID.
+///
+/// @param [in] hwmon_name Expected contents of the device's name file.
+/// @param [in] fallback_index hwmon device number used if the name is not
+/// found.
+/// @param [in] attr Attribute file within the device directory.
+///
+/// @return Sensor ID, otherwise -1
+int arm_sensor_open(
+    const char *hwmon_name,
+    int fallback_index,
+    const char *attr
+);
+
+/// @brief Read one sensor with pread() at offset 0. If the sampler thread is
+/// running, its latest reading is returned instead.
+///
+/// @param [in] id Sensor ID from arm_sensor_open().
+/// @param [out] val Raw signed value (microwatts, millidegrees C, ...).
+///
+/// @return 0 if successful, otherwise -1
+int arm_sensor_read(
+    int id,
+    int64_t *val
+);
+
+/// @brief Read several sensors at once.
+///
+/// @param [in] ids Sensor IDs from arm_sensor_open().
+/// @param [in] n Number of IDs.
+/// @param [out] vals Array of n raw values.
+///
+/// @return 0 if successful, otherwise -1
+int arm_sensors_read(
+    const int *ids,
+    int n,
+    int64_t *vals
+);
+
+/// @brief Start a helper thread, pinned to the given CPU, that reads every
+/// open sensor each ARM_SENSOR_SAMPLER_INTERVAL_US. Callers then get the
+/// cached values without issuing any syscalls.
+///
+/// @param [in] cpu Logical CPU to pin the thread to, or -1 to not pin it.
+///
+/// @return 0 if successful, otherwise -1
+int arm_sensors_start_sampler(
+    int cpu
+);
+
+/// @brief Stop the sampler thread, if it is running.
+void arm_sensors_stop_sampler(
+    void
+);
+
+/// @brief Stop the sampler and close all sensors.
+void arm_sensors_close(
+    void
+);
+
+#endif
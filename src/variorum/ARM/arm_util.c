@@ -13,6 +13,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "arm_sensors.h"
 #include "arm_util.h"
 #include <variorum_error.h>
 #include <variorum_timers.h>
@@ -82,9 +83,17 @@ void init_arm(void)
 
     /* Save hostname */
     gethostname(m_hostname, 1024);
+
+    /* Optionally read all hwmon sensors from a helper thread pinned to the
+     * given CPU, so that sampling does not issue syscalls on the caller. */
+    char *sensor_cpu = getenv("VARIORUM_ARM_SENSOR_CPU");
+    if (sensor_cpu != NULL)
+    {
+        arm_sensors_start_sampler(atoi(sensor_cpu));
+    }
 }
 
 void shutdown_arm(void)
 {
-    printf("Shutdown ARM\n");
+    arm_sensors_close();
 }
@@ -13,6 +13,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "arm_sensors.h"
 #include "juno_r2_power_features.h"
 #include <variorum_error.h>
 #include <variorum_timers.h>
@@ -21,6 +22,33 @@
 #include <cprintf.h>
 #endif
 
+/* On Juno r2 the SCP sensors are exported by the scpi-hwmon driver. */
+#define JUNO_R2_HWMON_NAME "scpi_sensors"
+#define JUNO_R2_HWMON_INDEX 0
+
+/* Read the Sys, Big, Little and GPU sensors of one type ("power" or "temp"),
+ * in that order. */
+static int juno_r2_read_sensors(const char *type, int64_t *vals)
+{
+    int i;
+    int ids[4];
+    char attr[32];
+
+    for (i = 0; i < 4; i++)
+    {
+        snprintf(attr, sizeof(attr), "%s%d_input", type, i + 1);
+        ids[i] = arm_sensor_open(JUNO_R2_HWMON_NAME, JUNO_R2_HWMON_INDEX, attr);
+    }
+    if (arm_sensors_read(ids, 4, vals) != 0)
+    {
+        variorum_error_handler("Error encountered in accessing hwmon interface",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    return 0;
+}
+
 int arm_cpu_juno_r2_get_power_data(int verbose, FILE *output)
 {
     static int init_output = 0;
@@ -40,43 +68,16 @@ int arm_cpu_juno_r2_get_power_data(int verbose, FILE *output)
      * ARM hardware implementation-specific interfaces.
      */
 
-    char *sys_power_fname = "/sys/class/hwmon/hwmon0/power1_input";
-    char *big_power_fname = "/sys/class/hwmon/hwmon0/power2_input";
-    char *little_power_fname = "/sys/class/hwmon/hwmon0/power3_input";
-    char *gpu_power_fname = "/sys/class/hwmon/hwmon0/power4_input";
-
-    int sys_power_fd = open(sys_power_fname, O_RDONLY);
-    int big_power_fd = open(big_power_fname, O_RDONLY);
-    int little_power_fd = open(little_power_fname, O_RDONLY);
-    int gpu_power_fd = open(gpu_power_fname, O_RDONLY);
+    int64_t vals[4];
 
-    if (!sys_power_fd || !big_power_fd || !little_power_fd || !gpu_power_fd)
+    if (juno_r2_read_sensors("power", vals) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
-
-    /* Power values are reported in micro Watts */
-
-    int sys_bytes = read_file_ui64(sys_power_fd, &sys_power_val);
-    int big_bytes = read_file_ui64(big_power_fd, &big_power_val);
-    int lil_bytes = read_file_ui64(little_power_fd, &little_power_val);
-    int gpu_bytes = read_file_ui64(gpu_power_fd, &gpu_power_val);
-
-    if (!sys_bytes || !big_bytes || !lil_bytes || !gpu_bytes)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
-
-    close(sys_power_fd);
-    close(big_power_fd);
-    close(little_power_fd);
-    close(gpu_power_fd);
+    sys_power_val = (uint64_t)vals[0];
+    big_power_val = (uint64_t)vals[1];
+    little_power_val = (uint64_t)vals[2];
+    gpu_power_val = (uint64_t)vals[3];
 
     /* The power telemetry obtained from the power registers is in
      * microwatts. To improve readability of verbose output, Variorum
@@ -142,46 +143,21 @@ int arm_cpu_juno_r2_get_power_data(int verbose, FILE *output)
 int arm_cpu_juno_r2_get_thermal_data(int verbose, FILE *output)
 {
     static int init_output = 0;
-    uint64_t sys_therm_val;
-    uint64_t big_therm_val;
-    uint64_t little_therm_val;
-    uint64_t gpu_therm_val;
-
-    char *sys_therm_fname = "/sys/class/hwmon/hwmon0/temp1_input";
-    char *big_therm_fname = "/sys/class/hwmon/hwmon0/temp2_input";
-    char *little_therm_fname = "/sys/class/hwmon/hwmon0/temp3_input";
-    char *gpu_therm_fname = "/sys/class/hwmon/hwmon0/temp4_input";
-
-    int sys_therm_fd = open(sys_therm_fname, O_RDONLY);
-    int big_therm_fd = open(big_therm_fname, O_RDONLY);
-    int little_therm_fd = open(little_therm_fname, O_RDONLY);
-    int gpu_therm_fd = open(gpu_therm_fname, O_RDONLY);
-
-    if (!sys_therm_fd || !big_therm_fd || !little_therm_fd || !gpu_therm_fd)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
+    int64_t sys_therm_val;
+    int64_t big_therm_val;
+    int64_t little_therm_val;
+    int64_t gpu_therm_val;
 
-    int sys_bytes = read_file_ui64(sys_therm_fd, &sys_therm_val);
-    int big_bytes = read_file_ui64(big_therm_fd, &big_therm_val);
-    int lil_bytes = read_file_ui64(little_therm_fd, &little_therm_val);
-    int gpu_bytes = read_file_ui64(gpu_therm_fd, &gpu_therm_val);
+    int64_t vals[4];
 
-    if (!sys_bytes || !big_bytes || !lil_bytes || !gpu_bytes)
+    if (juno_r2_read_sensors("temp", vals) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
-
-    close(sys_therm_fd);
-    close(big_therm_fd);
-    close(little_therm_fd);
-    close(gpu_therm_fd);
+    sys_therm_val = vals[0];
+    big_therm_val = vals[1];
+    little_therm_val = vals[2];
+    gpu_therm_val = vals[3];
 
     if (verbose)
     {
@@ -391,43 +367,16 @@ int arm_cpu_juno_r2_json_get_power_data(json_t *get_power_obj)
     /* Read power data from hwmon interfaces, similar to the get_power_data()
        function, defined previously. */
 
-    char *sys_power_fname = "/sys/class/hwmon/hwmon0/power1_input";
-    char *big_power_fname = "/sys/class/hwmon/hwmon0/power2_input";
-    char *little_power_fname = "/sys/class/hwmon/hwmon0/power3_input";
-    char *gpu_power_fname = "/sys/class/hwmon/hwmon0/power4_input";
-
-    int sys_power_fd = open(sys_power_fname, O_RDONLY);
-    int big_power_fd = open(big_power_fname, O_RDONLY);
-    int little_power_fd = open(little_power_fname, O_RDONLY);
-    int gpu_power_fd = open(gpu_power_fname, O_RDONLY);
+    int64_t vals[4];
 
-    if (!sys_power_fd || !big_power_fd || !little_power_fd || !gpu_power_fd)
+    if (juno_r2_read_sensors("power", vals) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
-
-    /* Power values are reported in micro Watts */
-
-    int sys_bytes = read_file_ui64(sys_power_fd, &sys_power_val);
-    int big_bytes = read_file_ui64(big_power_fd, &big_power_val);
-    int lil_bytes = read_file_ui64(little_power_fd, &little_power_val);
-    int gpu_bytes = read_file_ui64(gpu_power_fd, &gpu_power_val);
-
-    if (!sys_bytes || !big_bytes || !lil_bytes || !gpu_bytes)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
-
-    close(sys_power_fd);
-    close(big_power_fd);
-    close(little_power_fd);
-    close(gpu_power_fd);
+    sys_power_val = (uint64_t)vals[0];
+    big_power_val = (uint64_t)vals[1];
+    little_power_val = (uint64_t)vals[2];
+    gpu_power_val = (uint64_t)vals[3];
 
     /* Initialize GPU and memory to -1 first, as there is no memory power,
        and GPU power exists only on socket 0.
@@ -13,6 +13,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "arm_sensors.h"
 #include "neoverse_N1_power_features.h"
 #include <variorum_error.h>
 #include <variorum_timers.h>
@@ -21,6 +22,44 @@
 #include <cprintf.h>
 #endif
 
+/* CPU and I/O power and the SoC temperature come from the SoC's hwmon
+ * device (xgene-hwmon). The Ethernet controller temperature has no stable
+ * driver name, so it is always read from hwmon0. */
+#define NEOVERSE_N1_SOC_HWMON_NAME "apm_xgene"
+#define NEOVERSE_N1_SOC_HWMON_INDEX 1
+#define NEOVERSE_N1_ETH_HWMON_INDEX 0
+
+static int neoverse_n1_read_sensors(const int *ids, int n, int64_t *vals)
+{
+    if (arm_sensors_read(ids, n, vals) != 0)
+    {
+        variorum_error_handler("Error encountered in accessing hwmon interface",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    return 0;
+}
+
+static int neoverse_n1_read_power(uint64_t *cpu_power_val,
+                                  uint64_t *io_power_val)
+{
+    int ids[2];
+    int64_t vals[2];
+
+    ids[0] = arm_sensor_open(NEOVERSE_N1_SOC_HWMON_NAME,
+                             NEOVERSE_N1_SOC_HWMON_INDEX, "power1_input");
+    ids[1] = arm_sensor_open(NEOVERSE_N1_SOC_HWMON_NAME,
+                             NEOVERSE_N1_SOC_HWMON_INDEX, "power2_input");
+    if (neoverse_n1_read_sensors(ids, 2, vals) != 0)
+    {
+        return -1;
+    }
+    *cpu_power_val = (uint64_t)vals[0];
+    *io_power_val = (uint64_t)vals[1];
+    return 0;
+}
+
 int arm_cpu_neoverse_n1_get_power_data(int verbose, FILE *output)
 {
     static int init_output = 0;
@@ -35,36 +74,11 @@ int arm_cpu_neoverse_n1_get_power_data(int verbose, FILE *output)
      * https://developer.arm.com/documentation/100616/latest.
      */
 
-    char *cpu_power_fname = "/sys/class/hwmon/hwmon1/power1_input";
-    char *io_power_fname = "/sys/class/hwmon/hwmon1/power2_input";
-
-    int cpu_power_fd = open(cpu_power_fname, O_RDONLY);
-    int io_power_fd = open(io_power_fname, O_RDONLY);
-
-    if (!cpu_power_fd || !io_power_fd)
+    if (neoverse_n1_read_power(&cpu_power_val, &io_power_val) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
 
-    /* Power values are reported in micro Watts */
-
-    int cpu_bytes = read_file_ui64(cpu_power_fd, &cpu_power_val);
-    int io_bytes = read_file_ui64(io_power_fd, &io_power_val);
-
-    if (!cpu_bytes || !io_bytes)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
-
-    close(cpu_power_fd);
-    close(io_power_fd);
-
     /* The power telemetry obtained from the power registers is in
      * microwatts. To improve readability of verbose output, Variorum
      * converts power into milliwatts before reporting.
@@ -118,36 +132,21 @@ int arm_cpu_neoverse_n1_get_power_data(int verbose, FILE *output)
 int arm_cpu_neoverse_n1_get_thermal_data(int verbose, FILE *output)
 {
     static int init_output = 0;
-    uint64_t loc1_therm_val;
-    uint64_t soc_therm_val;
+    int64_t loc1_therm_val;
+    int64_t soc_therm_val;
 
-    char *loc1_therm_fname = "/sys/class/hwmon/hwmon0/temp1_input";
-    char *soc_therm_fname = "/sys/class/hwmon/hwmon1/temp1_input";
+    int ids[2];
+    int64_t vals[2];
 
-    int loc1_therm_fd = open(loc1_therm_fname, O_RDONLY);
-    int soc_therm_fd = open(soc_therm_fname, O_RDONLY);
-
-    if (!loc1_therm_fd || !soc_therm_fd)
+    ids[0] = arm_sensor_open(NULL, NEOVERSE_N1_ETH_HWMON_INDEX, "temp1_input");
+    ids[1] = arm_sensor_open(NEOVERSE_N1_SOC_HWMON_NAME,
+                             NEOVERSE_N1_SOC_HWMON_INDEX, "temp1_input");
+    if (neoverse_n1_read_sensors(ids, 2, vals) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
-
-    int loc1_bytes = read_file_ui64(loc1_therm_fd, &loc1_therm_val);
-    int soc_bytes = read_file_ui64(soc_therm_fd, &soc_therm_val);
-
-    if (!loc1_bytes || !soc_bytes)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
-
-    close(loc1_therm_fd);
-    close(soc_therm_fd);
+    loc1_therm_val = vals[0];
+    soc_therm_val = vals[1];
 
     if (verbose)
     {
@@ -314,36 +313,11 @@ int arm_cpu_neoverse_n1_json_get_power_data(json_t *get_power_obj)
     /* Read power data from hwmon interfaces, similar to the get_power_data()
        function, defined previously. */
 
-    char *cpu_power_fname = "/sys/class/hwmon/hwmon1/power1_input";
-    char *io_power_fname = "/sys/class/hwmon/hwmon1/power2_input";
-
-    int cpu_power_fd = open(cpu_power_fname, O_RDONLY);
-    int io_power_fd = open(io_power_fname, O_RDONLY);
-
-    if (!cpu_power_fd || !io_power_fd)
+    if (neoverse_n1_read_power(&cpu_power_val, &io_power_val) != 0)
     {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
         return -1;
     }
 
-    /* Power values are reported in micro Watts */
-
-    int cpu_bytes = read_file_ui64(cpu_power_fd, &cpu_power_val);
-    int io_bytes = read_file_ui64(io_power_fd, &io_power_val);
-
-    if (!cpu_bytes || !io_bytes)
-    {
-        variorum_error_handler("Error encountered in accessing hwmon interface",
-                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
-                               __FILE__, __FUNCTION__, __LINE__);
-        return -1;
-    }
-
-    close(cpu_power_fd);
-    close(io_power_fd);
-
     /* Initialize GPU and memory to -1 first, as there is no memory power,
        and GPU power exists only on socket 0.
        The value for m_num_package has been obtained in the init_arm() call. */
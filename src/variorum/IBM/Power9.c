@@ -11,19 +11,54 @@
 #include <Power9.h>
 #include <ibm_power_features.h>
 #include <variorum_error.h>
+#include <variorum_json.h>
 
 #ifdef LIBJUSTIFY_FOUND
 #include <cprintf.h>
 #endif
 
-/* Figure out the right spot for this at some point */
-pthread_mutex_t mlock;
-struct thread_args th_args;
-pthread_attr_t mattr;
-pthread_t mthread;
+/* Energy per socket and domain since the first energy call. */
+static struct occ_energy_counter g_occ_energy[MAX_OCCS][OCC_ENERGY_DOMAINS];
 
-/* For the get_energy sampling thread */
-static int active_sampling = 0;
+/* Sensor IDs handed out by ibm_cpu_p9_get_sensor_id() pack the socket and
+ * the position of the sensor in that socket's names block. */
+#define SENSOR_ID(socket, pos) (((socket) << 16) | (pos))
+#define SENSOR_ID_SOCKET(id)   ((id) >> 16)
+#define SENSOR_ID_POS(id)      ((id) & 0xffff)
+
+/* Snapshot of every socket's OCC data block, see read_occ_sensor_blocks(). */
+static int read_all_sockets(const void **buf, unsigned *nsockets)
+{
+    *nsockets = 0;
+
+#ifdef VARIORUM_WITH_IBM_CPU
+    variorum_get_topology(nsockets, NULL, NULL, P_IBM_CPU_IDX);
+#endif
+
+    if (read_occ_sensor_blocks(*nsockets, buf) != 0)
+    {
+        printf("Failed to read occ_inband_sensors file\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Fold the accumulators of the current snapshot into g_occ_energy. */
+static int update_energy(unsigned *nsockets)
+{
+    const void *buf;
+    unsigned iter;
+
+    if (read_all_sockets(&buf, nsockets) != 0)
+    {
+        return -1;
+    }
+    for (iter = 0; iter < *nsockets; iter++)
+    {
+        update_occ_energy(iter, OCC_SENSOR_BLOCK(buf, iter), g_occ_energy[iter]);
+    }
+    return 0;
+}
 
 int ibm_cpu_p9_get_power(int long_ver)
 {
@@ -33,57 +68,19 @@ int ibm_cpu_p9_get_power(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int fd;
-    int rc;
-    int bytes;
+    const void *buf;
     unsigned iter = 0;
     unsigned nsockets = 0;
 
-#ifdef VARIORUM_WITH_IBM_CPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_IBM_CPU_IDX);
-#endif
-
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (read_all_sockets(&buf, &nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
         return -1;
     }
 
     for (iter = 0; iter < nsockets; iter++)
     {
-        lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-        buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
-
-        if (!buf)
-        {
-            printf("Failed to allocate\n");
-            return -1;
-        }
-
-        for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
-        {
-            rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-
-            if (!rc || rc < 0)
-            {
-                break;
-            }
-        }
-
-        if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-        {
-            printf("Failed to read data\n");
-            free(buf);
-            return -1;
-        }
-
-        print_power_sensors(iter, long_ver, stdout, buf);
-        free(buf);
+        print_power_sensors(iter, long_ver, stdout, OCC_SENSOR_BLOCK(buf, iter));
     }
-    close(fd);
     return 0;
 }
 
@@ -325,64 +322,26 @@ int ibm_cpu_p9_monitoring(FILE *output)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int fd;
-    int rc;
-    int bytes;
+    const void *buf;
     unsigned iter = 0;
     unsigned nsockets = 0;
     static unsigned count = 0;
 
-#ifdef VARIORUM_WITH_IBM_CPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_IBM_CPU_IDX);
-#endif
-
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (read_all_sockets(&buf, &nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
         return -1;
     }
 
     for (iter = 0; iter < nsockets; iter++)
     {
-        lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-        buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
-
-        if (!buf)
-        {
-            printf("Failed to allocate\n");
-            return -1;
-        }
-
-        for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
-        {
-            rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-
-            if (!rc || rc < 0)
-            {
-                break;
-            }
-        }
-
-        if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-        {
-            printf("Failed to read data\n");
-            free(buf);
-            return -1;
-        }
-
         if (count < nsockets)
         {
-            print_all_sensors_header(iter, output, buf);
+            print_all_sensors_header(iter, output, OCC_SENSOR_BLOCK(buf, iter));
             count++;
         }
 
-        print_all_sensors(iter, output, buf);
-        free(buf);
+        print_all_sensors(iter, output, OCC_SENSOR_BLOCK(buf, iter));
     }
-    close(fd);
     return 0;
 }
 
@@ -410,58 +369,19 @@ int ibm_cpu_p9_get_power_json(json_t *get_power_obj)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int fd;
-    int rc;
-    int bytes;
+    const void *buf;
     unsigned iter = 0;
     unsigned nsockets = 0;
 
-#ifdef VARIORUM_WITH_IBM_CPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_IBM_CPU_IDX);
-#endif
-
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (read_all_sockets(&buf, &nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
         return -1;
     }
 
     for (iter = 0; iter < nsockets; iter++)
     {
-        lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-        buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
-
-        if (!buf)
-        {
-            printf("Failed to allocate\n");
-            return -1;
-        }
-
-        for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
-        {
-            rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-
-            if (!rc || rc < 0)
-            {
-                break;
-            }
-        }
-
-        if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-        {
-            printf("Failed to read data\n");
-            free(buf);
-            return -1;
-        }
-
-        json_get_power_sensors(iter, get_power_obj, buf);
-        free(buf);
+        json_get_power_sensors(iter, get_power_obj, OCC_SENSOR_BLOCK(buf, iter));
     }
-
-    close(fd);
     return 0;
 }
 
@@ -473,57 +393,19 @@ int ibm_cpu_p9_get_node_thermal_json(json_t *get_thermal_obj)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int fd;
-    int rc;
-    int bytes;
+    const void *buf;
     unsigned iter = 0;
     unsigned nsockets = 0;
 
-#ifdef VARIORUM_WITH_IBM_CPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_IBM_CPU_IDX);
-#endif
-
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (read_all_sockets(&buf, &nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
         return -1;
     }
 
     for (iter = 0; iter < nsockets; iter++)
     {
-        lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-        buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
-        if (!buf)
-        {
-            printf("Failed to allocate\n");
-            return -1;
-        }
-
-        for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
-        {
-            rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-
-            if (!rc || rc < 0)
-            {
-                break;
-            }
-        }
-
-        if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-        {
-            printf("Failed to read data\n");
-            free(buf);
-            return -1;
-        }
-
-        json_get_thermal_sensors(iter, get_thermal_obj, buf);
-        free(buf);
+        json_get_thermal_sensors(iter, get_thermal_obj, OCC_SENSOR_BLOCK(buf, iter));
     }
-
-    close(fd);
     return 0;
 }
 
@@ -587,7 +469,7 @@ int ibm_cpu_p9_get_node_power_domain_info_json(char **get_domain_obj_str)
     json_object_set_new(measurement_gpu_obj, "units", json_string("Watts"));
 
     // Export JSON object as a string for returning.
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
 
     return 0;
@@ -601,72 +483,49 @@ int ibm_cpu_p9_get_node_frequency_json(json_t *get_frequency_obj_json)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int fd;
-    int rc;
-    int bytes;
+    const void *buf;
     unsigned iter = 0;
     unsigned nsockets = 0;
 
-#ifdef VARIORUM_WITH_IBM_CPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_IBM_CPU_IDX);
-#endif
-
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (read_all_sockets(&buf, &nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
         return -1;
     }
 
     for (iter = 0; iter < nsockets; iter++)
     {
-        lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-        buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
-        if (!buf)
-        {
-            printf("Failed to allocate\n");
-            return -1;
-        }
-
-        for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
-        {
-            rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-
-            if (!rc || rc < 0)
-            {
-                break;
-            }
-        }
-
-        if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-        {
-            printf("Failed to read data\n");
-            free(buf);
-            return -1;
-        }
-        json_get_frequency_sensors(iter, get_frequency_obj_json, buf);
-        free(buf);
+        json_get_frequency_sensors(iter, get_frequency_obj_json,
+                                   OCC_SENSOR_BLOCK(buf, iter));
     }
-
-    close(fd);
     return 0;
 }
 
 int ibm_cpu_p9_get_energy(int long_ver)
 {
+    char *val = ("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
     static int init = 0;
     char hostname[1024];
     static struct timeval start;
     struct timeval now;
+    unsigned nsockets = 0;
 
     gethostname(hostname, 1024);
 
+    if (update_energy(&nsockets) != 0)
+    {
+        return -1;
+    }
+    gettimeofday(&now, NULL);
+
     if (!init)
     {
         init = 1;
-        gettimeofday(&start, NULL);
+        start = now;
 
         if (long_ver == 0)
         {
@@ -674,182 +533,164 @@ int ibm_cpu_p9_get_energy(int long_ver)
         }
     }
 
-    /* Enter the function the first time */
-    if (active_sampling == 0)
+    /* Socket 0 (the master OCC) reports total system energy. The first call
+     * sets the baseline and prints zero. */
+    if (long_ver)
     {
-        active_sampling = 1;
-
-        gettimeofday(&now, NULL);
-
-        /* Sampling interval is hardcoded at 250ms */
-        th_args.sample_interval = 250;
-        th_args.energy_acc = 0;
-
-        if (long_ver)
-        {
-            printf("_IBMENERGY Host: %s, Accumulated Energy: %lu J, Timestamp: %lf sec\n",
-                   hostname, th_args.energy_acc,
-                   now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
-        }
-        else
-        {
-            /* The first call should print zero as energy. */
-            printf("%s %s %lu %lf\n",
-                   "_IBMENERGY", hostname, th_args.energy_acc,
-                   now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
-        }
-
-        /* Start power measurement thread. */
-        pthread_attr_init(&mattr);
-        pthread_attr_setdetachstate(&mattr, PTHREAD_CREATE_DETACHED);
-        pthread_mutex_init(&mlock, NULL);
-        pthread_create(&mthread, &mattr, power_measurement, NULL);
+        printf("_IBMENERGY Host: %s, Accumulated Energy: %lf J, Timestamp: %lf sec\n",
+               hostname, g_occ_energy[0][OCC_ENERGY_SYS].joules,
+               now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
     }
     else
     {
-        /* Stop power measurement thread. */
-        active_sampling = 0;
-
-        gettimeofday(&now, NULL);
-
-        pthread_attr_destroy(&mattr);
-
-        pthread_mutex_lock(&mlock);
-        if (long_ver)
-        {
-            printf("_IBMENERGY Host: %s, Accumulated Energy: %lu J, Timestamp: %lf sec\n",
-                   hostname, th_args.energy_acc,
-                   now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
-        }
-        else
-        {
-            printf("%s %s %lu %lf\n",
-                   "_IBMENERGY", hostname, th_args.energy_acc,
-                   now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
-        }
-        pthread_mutex_unlock(&mlock);
+        printf("%s %s %lf %lf\n",
+               "_IBMENERGY", hostname, g_occ_energy[0][OCC_ENERGY_SYS].joules,
+               now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1000000.0);
     }
 
     return 0;
 }
 
-unsigned long take_measurement(int fd)
+int ibm_cpu_p9_get_node_energy_json(json_t *get_energy_obj)
 {
-    unsigned long power_sample = 0;
-
     char *val = ("VARIORUM_LOG");
     if (val != NULL && atoi(val) == 1)
     {
         printf("Running %s\n", __FUNCTION__);
     }
 
-    void *buf;
-    int rc;
-    int bytes;
-    unsigned iter = 0;
-
-    /* We assume that socket 0 on IBM Power9 reports total system power */
-    lseek(fd, iter * OCC_SENSOR_DATA_BLOCK_SIZE, SEEK_SET);
-
-    buf = malloc(OCC_SENSOR_DATA_BLOCK_SIZE);
+    unsigned nsockets = 0;
+    unsigned iter;
 
-    if (!buf)
+    if (update_energy(&nsockets) != 0)
     {
-        printf("Failed to allocate\n");
         return -1;
     }
 
-    for (rc = bytes = 0; bytes < OCC_SENSOR_DATA_BLOCK_SIZE; bytes += rc)
+    for (iter = 0; iter < nsockets; iter++)
     {
-        rc = read(fd, buf + bytes, OCC_SENSOR_DATA_BLOCK_SIZE - bytes);
-        if (!rc || rc < 0)
-        {
-            break;
-        }
-    }
+        char socketid[12];
+        snprintf(socketid, 12, "socket_%d", iter);
 
-    if (bytes != OCC_SENSOR_DATA_BLOCK_SIZE)
-    {
-        printf("Failed to read data\n");
-        free(buf);
-        return -1;
+        json_t *socket_obj = json_object();
+        json_object_set_new(get_energy_obj, socketid, socket_obj);
+
+        json_object_set_new(socket_obj, "energy_cpu_joules",
+                            json_real(g_occ_energy[iter][OCC_ENERGY_PROC].joules));
+        json_object_set_new(socket_obj, "energy_mem_joules",
+                            json_real(g_occ_energy[iter][OCC_ENERGY_MEM].joules));
+        json_object_set_new(socket_obj, "energy_gpu_joules",
+                            json_real(g_occ_energy[iter][OCC_ENERGY_GPU].joules));
     }
 
-    power_sample = get_node_power(buf);
+    json_object_set_new(get_energy_obj, "energy_node_joules",
+                        json_real(g_occ_energy[0][OCC_ENERGY_SYS].joules));
 
-    free(buf);
-    return power_sample;
+    return 0;
 }
 
-void *power_measurement(void *arg)
+int ibm_cpu_p9_get_socket_energy(struct variorum_socket_energy *energy)
 {
-    struct mstimer timer;
-    unsigned long curr_measurement;
-    int fd;
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    static double cpu_joules[MAX_OCCS];
+    static double mem_joules[MAX_OCCS];
+    static double gpu_joules[MAX_OCCS];
+    unsigned nsockets = 0;
+    unsigned iter;
 
-    /* Open inband_sensors file */
-    fd = open("/sys/firmware/opal/exports/occ_inband_sensors", O_RDONLY);
-    if (fd < 0)
+    if (update_energy(&nsockets) != 0)
     {
-        printf("Failed to open occ_inband_sensors file\n");
+        return -1;
     }
-    else
+    for (iter = 0; iter < nsockets; iter++)
     {
-        init_msTimer(&timer, th_args.sample_interval);
-
-        timer_sleep(&timer);
-        while (active_sampling)
-        {
-            /* Accummulate energy */
-            pthread_mutex_lock(&mlock);
-            curr_measurement = take_measurement(fd);
-            th_args.energy_acc += curr_measurement * th_args.sample_interval;
-            pthread_mutex_unlock(&mlock);
-            timer_sleep(&timer);
-        }
-        /* Close inband_sensors file */
-        close(fd);
+        cpu_joules[iter] = g_occ_energy[iter][OCC_ENERGY_PROC].joules;
+        mem_joules[iter] = g_occ_energy[iter][OCC_ENERGY_MEM].joules;
+        gpu_joules[iter] = g_occ_energy[iter][OCC_ENERGY_GPU].joules;
     }
-    return arg;
+
+    energy->nsockets = (int)nsockets;
+    energy->cpu_joules = cpu_joules;
+    energy->mem_joules = mem_joules;
+    energy->gpu_joules = gpu_joules;
+    return 0;
 }
 
-int ibm_cpu_p9_get_node_energy_json(json_t *get_energy_obj)
+int ibm_cpu_p9_get_sensor_id(int socket, const char *name)
 {
-    /* Enter the function the first time */
-    if (active_sampling == 0)
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
     {
-        active_sampling = 1;
-
-        /* Sampling interval is hardcoded at 250ms */
-        th_args.sample_interval = 250;
-        th_args.energy_acc = 0;
+        printf("Running %s\n", __FUNCTION__);
+    }
 
-        /* Only set node_energy for now */
-        json_object_set_new(get_energy_obj, "energy_node_joules",
-                            json_integer(th_args.energy_acc));
+    const struct occ_sensor_index *index;
+    const void *buf;
+    unsigned nsockets = 0;
+    int pos;
 
-        /* Start power measurement thread. */
-        pthread_attr_init(&mattr);
-        pthread_attr_setdetachstate(&mattr, PTHREAD_CREATE_DETACHED);
-        pthread_mutex_init(&mlock, NULL);
-        pthread_create(&mthread, &mattr, power_measurement, NULL);
+    if (read_all_sockets(&buf, &nsockets) != 0)
+    {
+        return -1;
     }
-    else
+    if (socket < 0 || (unsigned)socket >= nsockets || name == NULL)
     {
-        /* Stop power measurement thread. */
-        active_sampling = 0;
+        return -1;
+    }
 
-        /* Commenting out for now, results in invalid pointer and stack trace */
-        pthread_attr_destroy(&mattr);
+    index = get_occ_sensor_index(socket, OCC_SENSOR_BLOCK(buf, socket));
+    if (index == NULL)
+    {
+        return -1;
+    }
+    pos = find_occ_sensor(index, name);
+    return pos < 0 ? -1 : SENSOR_ID(socket, pos);
+}
 
-        pthread_mutex_lock(&mlock);
+int ibm_cpu_p9_read_sensors(const int *ids, int n, double *out)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
 
-        /* Only set node_energy for now */
-        json_object_set_new(get_energy_obj, "energy_node_joules",
-                            json_integer(th_args.energy_acc));
+    const struct occ_sensor_index *index;
+    const void *buf;
+    unsigned nsockets = 0;
+    unsigned socket;
+    int pos;
+    int i;
 
-        pthread_mutex_unlock(&mlock);
+    /* One snapshot serves every ID, so all values share a timestamp. */
+    if (read_all_sockets(&buf, &nsockets) != 0)
+    {
+        return -1;
     }
 
+    for (i = 0; i < n; i++)
+    {
+        if (ids[i] < 0)
+        {
+            return -1;
+        }
+        socket = SENSOR_ID_SOCKET(ids[i]);
+        pos = SENSOR_ID_POS(ids[i]);
+        if (socket >= nsockets)
+        {
+            return -1;
+        }
+        index = get_occ_sensor_index(socket, OCC_SENSOR_BLOCK(buf, socket));
+        if (index == NULL || pos >= index->nr_sensors)
+        {
+            return -1;
+        }
+        out[i] = read_occ_sensor(OCC_SENSOR_BLOCK(buf, socket), &index->sensors[pos]);
+    }
     return 0;
 }
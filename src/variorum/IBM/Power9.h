@@ -7,15 +7,8 @@
 #define POWER9_H_INCLUDE
 
 #include <jansson.h>
-#include <pthread.h>
 
-#include <variorum_timers.h>
-
-struct thread_args
-{
-    unsigned long sample_interval;
-    unsigned long energy_acc;
-};
+#include <variorum.h>
 
 int ibm_cpu_p9_get_power(
     int long_ver
@@ -61,17 +54,23 @@ int ibm_cpu_p9_get_node_frequency_json(
     json_t *get_frequency_obj_json
 );
 
-/* Sampling functions for get_energy thread implementation */
-void *power_measurement(
-    void *arg
+int ibm_cpu_p9_get_node_energy_json(
+    json_t *get_energy_obj
 );
 
-unsigned long take_measurement(
-    int fd
+int ibm_cpu_p9_get_socket_energy(
+    struct variorum_socket_energy *energy
 );
 
-int ibm_cpu_p9_get_node_energy_json(
-    json_t *get_energy_obj
+int ibm_cpu_p9_get_sensor_id(
+    int socket,
+    const char *name
+);
+
+int ibm_cpu_p9_read_sensors(
+    const int *ids,
+    int n,
+    double *out
 );
 
 #endif
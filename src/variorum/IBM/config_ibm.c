@@ -41,6 +41,9 @@ int set_ibm_func_ptrs(int idx)
         g_platform[idx].variorum_get_frequency_json =
             ibm_cpu_p9_get_node_frequency_json;
         g_platform[idx].variorum_get_energy_json = ibm_cpu_p9_get_node_energy_json;
+        g_platform[idx].variorum_get_socket_energy = ibm_cpu_p9_get_socket_energy;
+        g_platform[idx].variorum_get_sensor_id = ibm_cpu_p9_get_sensor_id;
+        g_platform[idx].variorum_read_sensors = ibm_cpu_p9_read_sensors;
     }
     else
     {
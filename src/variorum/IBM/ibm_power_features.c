@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 
 #include <ibm_power_features.h>
@@ -106,43 +107,387 @@ unsigned long read_sensor(const struct occ_sensor_data_header *hb,
     return 0;
 }
 
-uint64_t get_node_power(const void *buf)
+/* The inband sensors file stays open for the life of the process. When the
+ * kernel allows it, the data blocks are mapped so a snapshot costs no
+ * syscall; otherwise all sockets are copied with one pread() into a single
+ * page-aligned buffer that is reused across calls. Either way, every socket
+ * of a snapshot shares one timestamp.
+ * */
+static int g_occ_fd = -1;
+static void *g_occ_map = NULL;
+static void *g_occ_buf = NULL;
+static unsigned g_occ_nblocks = 0;
+static int g_occ_mmap_failed = 0;
+static struct timeval g_occ_snapshot_time;
+
+int read_occ_sensor_blocks(unsigned nsockets, const void **buf)
+{
+    size_t len = (size_t)nsockets * OCC_SENSOR_DATA_BLOCK_SIZE;
+    size_t bytes;
+    ssize_t rc;
+    void *tmp;
+
+    if (nsockets == 0 || nsockets > MAX_OCCS)
+    {
+        return -1;
+    }
+    if (g_occ_fd < 0)
+    {
+        g_occ_fd = open(OCC_INBAND_SENSORS_FILE, O_RDONLY);
+        if (g_occ_fd < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (g_occ_nblocks < nsockets)
+    {
+        if (g_occ_map != NULL)
+        {
+            munmap(g_occ_map, (size_t)g_occ_nblocks * OCC_SENSOR_DATA_BLOCK_SIZE);
+            g_occ_map = NULL;
+        }
+        free(g_occ_buf);
+        g_occ_buf = NULL;
+        g_occ_nblocks = 0;
+
+        if (!g_occ_mmap_failed)
+        {
+            tmp = mmap(NULL, len, PROT_READ, MAP_SHARED, g_occ_fd, 0);
+            if (tmp == MAP_FAILED)
+            {
+                g_occ_mmap_failed = 1;
+            }
+            else
+            {
+                g_occ_map = tmp;
+            }
+        }
+        if (g_occ_map == NULL)
+        {
+            if (posix_memalign(&tmp, sysconf(_SC_PAGESIZE), len) != 0)
+            {
+                return -1;
+            }
+            g_occ_buf = tmp;
+        }
+        g_occ_nblocks = nsockets;
+    }
+
+    if (g_occ_map != NULL)
+    {
+        gettimeofday(&g_occ_snapshot_time, NULL);
+        *buf = g_occ_map;
+        return 0;
+    }
+
+    for (bytes = 0; bytes < len; bytes += rc)
+    {
+        rc = pread(g_occ_fd, (char *)g_occ_buf + bytes, len - bytes, bytes);
+        if (rc <= 0)
+        {
+            return -1;
+        }
+    }
+    gettimeofday(&g_occ_snapshot_time, NULL);
+    *buf = g_occ_buf;
+    return 0;
+}
+
+void close_occ_sensor_blocks(void)
+{
+    if (g_occ_map != NULL)
+    {
+        munmap(g_occ_map, (size_t)g_occ_nblocks * OCC_SENSOR_DATA_BLOCK_SIZE);
+        g_occ_map = NULL;
+    }
+    free(g_occ_buf);
+    g_occ_buf = NULL;
+    g_occ_nblocks = 0;
+    if (g_occ_fd >= 0)
+    {
+        close(g_occ_fd);
+        g_occ_fd = -1;
+    }
+}
+
+/* Time of the last snapshot, so that all sockets print the same timestamp. */
+static void get_occ_snapshot_time(struct timeval *now)
+{
+    if (timerisset(&g_occ_snapshot_time))
+    {
+        *now = g_occ_snapshot_time;
+    }
+    else
+    {
+        gettimeofday(now, NULL);
+    }
+}
+
+static struct occ_sensor_index g_sensor_index[MAX_OCCS];
+static int g_sensor_index_valid[MAX_OCCS];
+
+static int add_occ_sensor_position(int **positions, int **ids, int *count,
+                                   int position, int id)
+{
+    int *tmp;
+
+    tmp = (int *) realloc(*positions, (*count + 1) * sizeof(int));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    *positions = tmp;
+    tmp = (int *) realloc(*ids, (*count + 1) * sizeof(int));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    *ids = tmp;
+    (*positions)[*count] = position;
+    (*ids)[*count] = id;
+    (*count)++;
+    return 0;
+}
+
+/* Free a partly built index so that the next call builds it again. */
+static void free_occ_sensor_index(struct occ_sensor_index *index)
+{
+    free(index->sensors);
+    free(index->core_temps);
+    free(index->core_temp_ids);
+    free(index->dimm_temps);
+    free(index->dimm_temp_ids);
+    memset(index, 0, sizeof(struct occ_sensor_index));
+}
+
+const struct occ_sensor_index *get_occ_sensor_index(int chipid,
+        const void *buf)
 {
-    int i;
     struct occ_sensor_data_header *hb;
     struct occ_sensor_name *md;
-    // Power in watts.
-    uint64_t pwrsys = 0;
+    struct occ_sensor_index *index;
+    struct occ_sensor_info *info;
+    int err = 0;
+    int i;
+
+    if (chipid < 0 || chipid >= MAX_OCCS)
+    {
+        return NULL;
+    }
+    if (g_sensor_index_valid[chipid])
+    {
+        return &g_sensor_index[chipid];
+    }
 
     hb = (struct occ_sensor_data_header *)(uint64_t)buf;
     md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
+    index = &g_sensor_index[chipid];
 
-    for (i = 0; i < be16toh(hb->nr_sensors); i++)
+    index->nr_sensors = be16toh(hb->nr_sensors);
+    index->sensors = (struct occ_sensor_info *) calloc(index->nr_sensors,
+                     sizeof(struct occ_sensor_info));
+    if (index->sensors == NULL)
     {
-        uint32_t offset = be32toh(md[i].reading_offset);
-        uint32_t scale = be32toh(md[i].scale_factor);
-        uint64_t sample = 0;
+        return NULL;
+    }
+    index->pwrsys = -1;
+    index->pwrproc = -1;
+    index->pwrmem = -1;
+    index->pwrgpu = -1;
+    index->freqa = -1;
 
-        // We are not reading counters here because power data doesn't need counter.
-        if (md[i].structure_type == OCC_SENSOR_READING_FULL)
+    for (i = 0; i < index->nr_sensors && !err; i++)
+    {
+        info = &index->sensors[i];
+        memcpy(info->name, md[i].name, MAX_CHARS_SENSOR_NAME);
+        info->name[MAX_CHARS_SENSOR_NAME] = '\0';
+        info->type = be16toh(md[i].type);
+        info->structure_type = md[i].structure_type;
+        info->reading_offset = be32toh(md[i].reading_offset);
+        info->scale = TO_FP(be32toh(md[i].scale_factor));
+        info->freq = TO_FP(be32toh(md[i].freq));
+
+        if (strcmp(info->name, "PWRSYS") == 0)
         {
-            sample = read_sensor(hb, offset, SENSOR_SAMPLE);
+            index->pwrsys = i;
+        }
+        else if (strcmp(info->name, "PWRPROC") == 0)
+        {
+            index->pwrproc = i;
+        }
+        else if (strcmp(info->name, "PWRMEM") == 0)
+        {
+            index->pwrmem = i;
+        }
+        else if (strcmp(info->name, "PWRGPU") == 0)
+        {
+            index->pwrgpu = i;
+        }
+        else if (strcmp(info->name, "FREQA") == 0)
+        {
+            index->freqa = i;
         }
+        else if (strncmp(info->name, "TEMPPROCTHRMC", 13) == 0)
+        {
+            err = add_occ_sensor_position(&index->core_temps,
+                                          &index->core_temp_ids, &index->ncore_temps, i,
+                                          atoi(info->name + 13));
+        }
+        else if (strncmp(info->name, "TEMPDIMM", 8) == 0)
+        {
+            err = add_occ_sensor_position(&index->dimm_temps,
+                                          &index->dimm_temp_ids, &index->ndimm_temps, i,
+                                          atoi(info->name + 8));
+        }
+    }
+    if (err)
+    {
+        free_occ_sensor_index(index);
+        return NULL;
+    }
 
-        if (strcmp(md[i].name, "PWRSYS") == 0)
+    g_sensor_index_valid[chipid] = 1;
+    return index;
+}
+
+int find_occ_sensor(const struct occ_sensor_index *index, const char *name)
+{
+    int i;
+
+    for (i = 0; i < index->nr_sensors; i++)
+    {
+        if (strcmp(index->sensors[i].name, name) == 0)
         {
-            pwrsys = (uint64_t)(sample * TO_FP(scale));
+            return i;
         }
     }
-    return (pwrsys);
+    return -1;
+}
+
+double read_occ_sensor(const void *buf, const struct occ_sensor_info *sensor)
+{
+    const struct occ_sensor_data_header *hb = buf;
+
+    if (sensor->structure_type == OCC_SENSOR_READING_FULL)
+    {
+        return read_sensor(hb, sensor->reading_offset, SENSOR_SAMPLE) * sensor->scale;
+    }
+    return read_counter(hb, sensor->reading_offset) * sensor->scale;
+}
+
+int read_occ_accumulator(const void *buf, const struct occ_sensor_info *sensor,
+                         uint64_t *acc, uint32_t *tag)
+{
+    const struct occ_sensor_data_header *hb = buf;
+    const struct occ_sensor_record *sping;
+    const struct occ_sensor_record *spong;
+    const struct occ_sensor_record *record;
+    const uint8_t *ping;
+    const uint8_t *pong;
+
+    if (sensor->structure_type != OCC_SENSOR_READING_FULL)
+    {
+        // Counter records have no update tag.
+        *acc = read_counter(hb, sensor->reading_offset);
+        *tag = 0;
+        return 0;
+    }
+
+    /* The accumulator and the update tag have to come from the same record,
+     * so pick the newer of ping and pong here rather than calling
+     * read_sensor() twice. */
+    ping = (const uint8_t *)hb + be32toh(hb->reading_ping_offset);
+    pong = (const uint8_t *)hb + be32toh(hb->reading_pong_offset);
+    sping = (const struct occ_sensor_record *)(ping + sensor->reading_offset);
+    spong = (const struct occ_sensor_record *)(pong + sensor->reading_offset);
+
+    if (*ping && *pong)
+    {
+        record = be64toh(sping->timestamp) > be64toh(spong->timestamp) ? sping : spong;
+    }
+    else if (*ping)
+    {
+        record = sping;
+    }
+    else if (*pong)
+    {
+        record = spong;
+    }
+    else
+    {
+        return -1;
+    }
+
+    *acc = be64toh(record->accumulator);
+    *tag = be32toh(record->update_tag);
+    return 0;
+}
+
+void update_occ_energy(int chipid, const void *buf,
+                       struct occ_energy_counter *counters)
+{
+    const struct occ_sensor_index *index;
+    const struct occ_sensor_info *sensor;
+    struct occ_energy_counter *c;
+    int pos[OCC_ENERGY_DOMAINS];
+    uint64_t acc;
+    uint32_t tag;
+    int d;
+
+    index = get_occ_sensor_index(chipid, buf);
+    if (index == NULL)
+    {
+        return;
+    }
+    pos[OCC_ENERGY_SYS] = index->pwrsys;
+    pos[OCC_ENERGY_PROC] = index->pwrproc;
+    pos[OCC_ENERGY_MEM] = index->pwrmem;
+    pos[OCC_ENERGY_GPU] = index->pwrgpu;
+
+    for (d = 0; d < OCC_ENERGY_DOMAINS; d++)
+    {
+        if (pos[d] < 0)
+        {
+            continue;
+        }
+        sensor = &index->sensors[pos[d]];
+        c = &counters[d];
+        if (read_occ_accumulator(buf, sensor, &acc, &tag) != 0)
+        {
+            continue;
+        }
+        /* A smaller accumulator together with a smaller tag means the OCC
+         * was reset, so start a new baseline. A smaller value in only one of
+         * them is a wrap, which the unsigned differences below absorb. */
+        if (c->valid && !(acc < c->last_acc && tag < c->last_tag) &&
+            sensor->freq > 0.0)
+        {
+            c->updates += (uint32_t)(tag - c->last_tag);
+            c->joules += (double)(acc - c->last_acc) * sensor->scale / sensor->freq;
+        }
+        c->valid = 1;
+        c->last_acc = acc;
+        c->last_tag = tag;
+    }
+}
+
+/* Scaled sample of the sensor at the given index position, 0 if the socket
+ * does not report it. Power values are truncated to whole watts as before. */
+static uint64_t read_indexed_power(const void *buf,
+                                   const struct occ_sensor_index *index, int pos)
+{
+    if (pos < 0)
+    {
+        return 0;
+    }
+    return (uint64_t)read_occ_sensor(buf, &index->sensors[pos]);
 }
 
 void print_power_sensors(int chipid, int long_ver, FILE *output,
                          const void *buf)
 {
-    struct occ_sensor_data_header *hb;
-    struct occ_sensor_name *md;
-    int i = 0;
+    const struct occ_sensor_index *index;
     static int init = 0;
     char hostname[1024];
     static struct timeval start;
@@ -153,19 +498,13 @@ void print_power_sensors(int chipid, int long_ver, FILE *output,
     uint64_t pwrmem = 0;
     uint64_t pwrgpu = 0;
 
-    /* Note that the timestamps here will be different for each socket.
-     * We don't have the equivalent of batching yet, if we read the whole
-     * buffer at once, we can't easily separate out the sockets and we will
-     * have to identify OCC_DATA_BLOCK boundaries in the code (which we want to
-     * avoid).
-     * */
-
     gethostname(hostname, 1024);
+    get_occ_snapshot_time(&now);
 
     if (!init)
     {
         init = 1;
-        gettimeofday(&start, NULL);
+        start = now;
         if (long_ver == 0)
         {
 #ifdef LIBJUSTIFY_FOUND
@@ -180,50 +519,13 @@ void print_power_sensors(int chipid, int long_ver, FILE *output,
         }
     }
 
-    gettimeofday(&now, NULL);
-
-    hb = (struct occ_sensor_data_header *)(uint64_t)buf;
-    md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
-
-    for (i = 0; i < be16toh(hb->nr_sensors); i++)
+    index = get_occ_sensor_index(chipid, buf);
+    if (index != NULL)
     {
-        uint32_t offset = be32toh(md[i].reading_offset);
-        uint32_t scale = be32toh(md[i].scale_factor);
-        uint64_t sample = 0;
-
-        // We are not reading counters here because power data doesn't need counter.
-        if (md[i].structure_type == OCC_SENSOR_READING_FULL)
-        {
-            sample = read_sensor(hb, offset, SENSOR_SAMPLE);
-        }
-
-        /* Ideally, we don't want to use strcmp and use offsets instead.
-         * But this was not clear to us at the time of the implementation.
-         * OCC_DATA_BLOCK contents are different because of master-slave design
-         * across different processor sockets. So the same offset can refer to
-         * a different sensor depending on the socket.
-         *
-         * Note that we're not capturing timestamp here, the common timestamp
-         * printed is the one from the end of the loop, where all 336 sensors
-         * have been scanned on P9.
-         * */
-
-        if (strcmp(md[i].name, "PWRSYS") == 0)
-        {
-            pwrsys = (uint64_t)(sample * TO_FP(scale));
-        }
-        if (strcmp(md[i].name, "PWRPROC") == 0)
-        {
-            pwrproc = (uint64_t)(sample * TO_FP(scale));
-        }
-        if (strcmp(md[i].name, "PWRMEM") == 0)
-        {
-            pwrmem = (uint64_t)(sample * TO_FP(scale));
-        }
-        if (strcmp(md[i].name, "PWRGPU") == 0)
-        {
-            pwrgpu = (uint64_t)(sample * TO_FP(scale));
-        }
+        pwrsys = read_indexed_power(buf, index, index->pwrsys);
+        pwrproc = read_indexed_power(buf, index, index->pwrproc);
+        pwrmem = read_indexed_power(buf, index, index->pwrmem);
+        pwrgpu = read_indexed_power(buf, index, index->pwrgpu);
     }
 
     if (long_ver == 0)
@@ -329,20 +631,14 @@ void print_all_sensors(int chipid, FILE *output, const void *buf)
     struct timeval now;
     int energy_offset = 0;
 
-    /* Note that the timestamps here will be different for each socket. We
-     * don't have the equivalent of batching yet, if we read the whole buffer
-     * at once, we can't easily separate out the sockets and we will have to
-     * identify OCC_DATA_BLOCK boundaries in the code (which we want to avoid).
-     * */
-
     gethostname(hostname, 1024);
+    get_occ_snapshot_time(&now);
 
     if (!init)
     {
         init = 1;
-        gettimeofday(&start, NULL);
+        start = now;
     }
-    gettimeofday(&now, NULL);
 
     hb = (struct occ_sensor_data_header *)(uint64_t)buf;
     md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
@@ -414,9 +710,7 @@ void print_all_sensors(int chipid, FILE *output, const void *buf)
 
 void json_get_power_sensors(int chipid, json_t *node_obj, const void *buf)
 {
-    struct occ_sensor_data_header *hb;
-    struct occ_sensor_name *md;
-    int i = 0;
+    const struct occ_sensor_index *index;
     // Power in watts.
     uint64_t pwrsys = 0;
     uint64_t pwrproc = 0;
@@ -425,44 +719,12 @@ void json_get_power_sensors(int chipid, json_t *node_obj, const void *buf)
 
     sprintf(socketID, "socket_%d", chipid);
 
-    hb = (struct occ_sensor_data_header *)(uint64_t)buf;
-    md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
-
-    for (i = 0; i < be16toh(hb->nr_sensors); i++)
+    index = get_occ_sensor_index(chipid, buf);
+    if (index != NULL)
     {
-        uint32_t offset = be32toh(md[i].reading_offset);
-        uint32_t scale = be32toh(md[i].scale_factor);
-        uint64_t sample = 0;
-
-        // We are not reading counters here because power data doesn't need counter.
-        if (md[i].structure_type == OCC_SENSOR_READING_FULL)
-        {
-            sample = read_sensor(hb, offset, SENSOR_SAMPLE);
-        }
-
-        /* Ideally, we don't want to use strcmp and use offsets instead.
-         * But this was not clear to us at the time of the implementation.
-         * OCC_DATA_BLOCK contents are different because of master-slave design
-         * across different processor sockets. So the same offset can refer to
-         * a different sensor depending on the socket.
-         *
-         * Note that we're not capturing timestamp here, the common timestamp
-         * printed is the one from the end of the loop, where all 336 sensors
-         * have been scanned on P9.
-         * */
-
-        if (strcmp(md[i].name, "PWRSYS") == 0)
-        {
-            pwrsys = (uint64_t)(sample * TO_FP(scale));
-        }
-        if (strcmp(md[i].name, "PWRPROC") == 0)
-        {
-            pwrproc = (uint64_t)(sample * TO_FP(scale));
-        }
-        if (strcmp(md[i].name, "PWRMEM") == 0)
-        {
-            pwrmem = (uint64_t)(sample * TO_FP(scale));
-        }
+        pwrsys = read_indexed_power(buf, index, index->pwrsys);
+        pwrproc = read_indexed_power(buf, index, index->pwrproc);
+        pwrmem = read_indexed_power(buf, index, index->pwrmem);
     }
 
     if (chipid == 0)
@@ -479,12 +741,14 @@ void json_get_power_sensors(int chipid, json_t *node_obj, const void *buf)
 
 void json_get_thermal_sensors(int chipid, json_t *node_obj, const void *buf)
 {
-    struct occ_sensor_data_header *hb;
-    struct occ_sensor_name *md;
+    const struct occ_sensor_index *index;
     int i;
 
-    hb = (struct occ_sensor_data_header *)(uint64_t)buf;
-    md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
+    index = get_occ_sensor_index(chipid, buf);
+    if (index == NULL)
+    {
+        return;
+    }
 
     char socketid[12];
     snprintf(socketid, 12, "socket_%d", chipid);
@@ -505,48 +769,34 @@ void json_get_thermal_sensors(int chipid, json_t *node_obj, const void *buf)
     json_t *mem_obj = json_object();
     json_object_set_new(cpu_obj, "Mem", mem_obj);
 
-    for (i = 0; i < be16toh(hb->nr_sensors); i++)
+    for (i = 0; i < index->ncore_temps; i++)
     {
-        uint32_t offset = be32toh(md[i].reading_offset);
-        uint32_t scale = be32toh(md[i].scale_factor);
-        uint64_t sample = 0;
-
-        if (md[i].structure_type == OCC_SENSOR_READING_FULL)
-        {
-            sample = read_sensor(hb, offset, SENSOR_SAMPLE);
-        }
-
-        if (strncmp(md[i].name, "TEMPPROCTHRMC", 13) == 0)
-        {
-            char core_temp[32];
-            char core_temp_value[5];
-            strncpy(core_temp_value, md[i].name + 13, 5);
-            int core_temp_int = atoi(core_temp_value);
-            snprintf(core_temp, 32, "temp_celsius_core_%d", core_temp_int);
-
-            json_object_set_new(core_obj, core_temp, json_integer(sample * TO_FP(scale)));
-        }
-        else if (strncmp(md[i].name, "TEMPDIMM", 8) == 0)
-        {
-            char mem_temp[32];
-            char mem_temp_value[5];
-            strncpy(mem_temp_value, md[i].name + 8, 5);
-            int mem_temp_int = atoi(mem_temp_value);
-            snprintf(mem_temp, 32, "temp_celsius_dimm_%d", mem_temp_int);
+        char core_temp[32];
+        snprintf(core_temp, 32, "temp_celsius_core_%d", index->core_temp_ids[i]);
+        json_object_set_new(core_obj, core_temp,
+                            json_integer(read_occ_sensor(buf,
+                                         &index->sensors[index->core_temps[i]])));
+    }
 
-            json_object_set_new(mem_obj, mem_temp, json_integer(sample * TO_FP(scale)));
-        }
+    for (i = 0; i < index->ndimm_temps; i++)
+    {
+        char mem_temp[32];
+        snprintf(mem_temp, 32, "temp_celsius_dimm_%d", index->dimm_temp_ids[i]);
+        json_object_set_new(mem_obj, mem_temp,
+                            json_integer(read_occ_sensor(buf,
+                                         &index->sensors[index->dimm_temps[i]])));
     }
 }
 
 void json_get_frequency_sensors(int chipid, json_t *node_obj, const void *buf)
 {
-    struct occ_sensor_data_header *hb;
-    struct occ_sensor_name *md;
-    int i = 0;
+    const struct occ_sensor_index *index;
 
-    hb = (struct occ_sensor_data_header *)(uint64_t)buf;
-    md = (struct occ_sensor_name *)((uint64_t)hb + be32toh(hb->names_offset));
+    index = get_occ_sensor_index(chipid, buf);
+    if (index == NULL)
+    {
+        return;
+    }
 
     char socketID[12];
     snprintf(socketID, 12, "socket_%d", chipid);
@@ -561,19 +811,11 @@ void json_get_frequency_sensors(int chipid, json_t *node_obj, const void *buf)
     json_t *cpu_obj = json_object();
     json_object_set_new(socket_obj, "CPU", cpu_obj);
 
-    for (i = 0; i < be16toh(hb->nr_sensors); i++)
+    if (index->freqa >= 0)
     {
-        uint32_t offset = be32toh(md[i].reading_offset);
-        uint64_t sample = 0;
-
-        if (md[i].structure_type == OCC_SENSOR_READING_FULL)
-        {
-            sample = read_sensor(hb, offset, SENSOR_SAMPLE);
-        }
-
-        if (strcmp(md[i].name, "FREQA") == 0)
-        {
-            json_object_set_new(cpu_obj, "cpu_avg_freq_mhz", json_integer(sample));
-        }
+        // The frequency sensor is unscaled (MHz).
+        const struct occ_sensor_info *freqa = &index->sensors[index->freqa];
+        json_object_set_new(cpu_obj, "cpu_avg_freq_mhz",
+                            json_integer(read_sensor(buf, freqa->reading_offset, SENSOR_SAMPLE)));
     }
 }
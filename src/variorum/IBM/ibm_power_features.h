@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -32,6 +33,12 @@
 #define OCC_SENSOR_DATA_BLOCK_OFFSET 0x00580000
 #define OCC_SENSOR_DATA_BLOCK_SIZE   0x00025800
 
+#define OCC_INBAND_SENSORS_FILE "/sys/firmware/opal/exports/occ_inband_sensors"
+
+/* Data block of one socket within a buffer from read_occ_sensor_blocks(). */
+#define OCC_SENSOR_BLOCK(buf, chipid) \
+    ((const void *)((const char *)(buf) + (chipid) * OCC_SENSOR_DATA_BLOCK_SIZE))
+
 #define TO_FP(f)  ((f >> 8) * pow(10, ((int8_t)(f & 0xFF))))
 
 enum occ_sensor_type
@@ -129,6 +136,101 @@ struct occ_sensor_counter
     uint8_t  pad[5];
 } __attribute__((__packed__));
 
+/* Decoded copy of one entry of the names block of an OCC data block. */
+struct occ_sensor_info
+{
+    char     name[MAX_CHARS_SENSOR_NAME + 1];
+    uint16_t type;
+    uint8_t  structure_type;
+    uint32_t reading_offset;
+    double   scale;
+    double   freq;
+};
+
+/* Per-socket index of the names block. The names block of a socket does not
+ * change while the system is up, but the master and slave OCCs list sensors
+ * in a different order, so every socket has its own index. Sensors the
+ * power, thermal and frequency APIs need are resolved to positions once;
+ * -1 means the socket does not report that sensor.
+ * */
+struct occ_sensor_index
+{
+    int nr_sensors;
+    struct occ_sensor_info *sensors;
+    int pwrsys;
+    int pwrproc;
+    int pwrmem;
+    int pwrgpu;
+    int freqa;
+    int ncore_temps;
+    int *core_temps;
+    int *core_temp_ids;
+    int ndimm_temps;
+    int *dimm_temps;
+    int *dimm_temp_ids;
+};
+
+int read_occ_sensor_blocks(
+    unsigned nsockets,
+    const void **buf
+);
+
+void close_occ_sensor_blocks(
+    void
+);
+
+/* Power domains whose OCC accumulators are turned into energy. */
+enum occ_energy_domain
+{
+    OCC_ENERGY_SYS,
+    OCC_ENERGY_PROC,
+    OCC_ENERGY_MEM,
+    OCC_ENERGY_GPU,
+    OCC_ENERGY_DOMAINS,
+};
+
+/* Energy of one power sensor since its first reading. The OCC adds every
+ * power sample to a 64-bit accumulator and bumps a 32-bit update tag, so
+ * energy is the accumulator delta scaled to watts and divided by the update
+ * frequency, independent of how often it is read.
+ * */
+struct occ_energy_counter
+{
+    int valid;
+    uint64_t last_acc;
+    uint32_t last_tag;
+    uint64_t updates;
+    double joules;
+};
+
+const struct occ_sensor_index *get_occ_sensor_index(
+    int chipid,
+    const void *buf
+);
+
+int find_occ_sensor(
+    const struct occ_sensor_index *index,
+    const char *name
+);
+
+double read_occ_sensor(
+    const void *buf,
+    const struct occ_sensor_info *sensor
+);
+
+int read_occ_accumulator(
+    const void *buf,
+    const struct occ_sensor_info *sensor,
+    uint64_t *acc,
+    uint32_t *tag
+);
+
+void update_occ_energy(
+    int chipid,
+    const void *buf,
+    struct occ_energy_counter *counters
+);
+
 void print_power_sensors(
     int chipid,
     int long_ver,
@@ -177,8 +279,4 @@ void json_get_frequency_sensors(
     const void *buf
 );
 
-uint64_t get_node_power(
-    const void *buf
-);
-
 #endif
@@ -9,6 +9,9 @@
 #include <jansson.h>
 #include <sys/types.h>
 
+#include <config_architecture.h>
+#include <variorum.h>
+
 /// @brief List of unique addresses for Sandy Bridge Family/Model 2AH.
 struct sandybridge_2a_offsets
 {
@@ -76,6 +79,10 @@ struct sandybridge_2a_offsets
     off_t ia32_perfevtsel_counters[8];
     /// @brief Array of unique addresses for pmon evtsel.
     off_t msrs_pcu_pmon_evtsel[4];
+    /// @brief Array of unique addresses for package C-state residency.
+    off_t msrs_pkg_cstate_residency[4];
+    /// @brief Array of unique addresses for core C-state residency.
+    off_t msrs_core_cstate_residency[3];
 };
 
 int intel_cpu_fm_06_2a_get_power_limits(
@@ -154,8 +161,20 @@ int intel_cpu_fm_06_2a_get_clocks_json(
     json_t *get_clock_obj_json
 );
 
+int intel_cpu_fm_06_2a_get_core_frequency(
+    struct variorum_core_frequency *freq
+);
+
+int intel_cpu_fm_06_2a_get_socket_thermals(
+    struct variorum_socket_thermals *thermals
+);
+
 int intel_cpu_fm_06_2a_get_energy_json(
     json_t *get_energy_obj
 );
 
+int intel_cpu_fm_06_2a_get_cstate_residency(
+    struct variorum_cstate_sample *sample
+);
+
 #endif
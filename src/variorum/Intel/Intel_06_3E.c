@@ -10,10 +10,12 @@
 #include <clocks_features.h>
 #include <config_architecture.h>
 #include <counters_features.h>
+#include <cstate_features.h>
 #include <misc_features.h>
 #include <intel_power_features.h>
 #include <thermal_features.h>
 #include <variorum_error.h>
+#include <variorum_json.h>
 
 static struct ivybridge_3e_offsets msrs =
 {
@@ -68,9 +70,22 @@ static struct ivybridge_3e_offsets msrs =
     .msrs_pcu_pmon_evtsel[0]      = 0xC30,
     .msrs_pcu_pmon_evtsel[1]      = 0xC31,
     .msrs_pcu_pmon_evtsel[2]      = 0xC32,
-    .msrs_pcu_pmon_evtsel[3]      = 0xC33
+    .msrs_pcu_pmon_evtsel[3]      = 0xC33,
+    .msrs_pkg_cstate_residency[0] = 0x60D,
+    .msrs_pkg_cstate_residency[1] = 0x3F8,
+    .msrs_pkg_cstate_residency[2] = 0x3F9,
+    .msrs_pkg_cstate_residency[3] = 0x3FA,
+    .msrs_core_cstate_residency[0] = 0x3FC,
+    .msrs_core_cstate_residency[1] = 0x3FD,
+    .msrs_core_cstate_residency[2] = 0x3FE,
 };
 
+/* C-state number of each entry in msrs_pkg_cstate_residency and
+ * msrs_core_cstate_residency.
+ * */
+static int pkg_cstates[] = { 2, 3, 6, 7 };
+static int core_cstates[] = { 3, 6, 7 };
+
 int intel_cpu_fm_06_3e_get_power_limits(int long_ver)
 {
     unsigned socket;
@@ -362,6 +377,33 @@ int intel_cpu_fm_06_3e_get_clocks_json(json_t *get_clock_obj_json)
     return 0;
 }
 
+int intel_cpu_fm_06_3e_get_core_frequency(struct variorum_core_frequency *freq)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_core_frequency_data(msrs.ia32_aperf, msrs.ia32_mperf,
+                                   msrs.ia32_time_stamp_counter, msrs.msr_platform_info,
+                                   freq);
+}
+
+int intel_cpu_fm_06_3e_get_socket_thermals(struct variorum_socket_thermals
+        *thermals)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_socket_thermals_data(thermals, msrs.ia32_therm_status,
+                                    msrs.ia32_package_therm_status,
+                                    msrs.msr_temperature_target);
+}
+
 int intel_cpu_fm_06_3e_get_power(int long_ver)
 {
     char *val = getenv("VARIORUM_LOG");
@@ -483,7 +525,7 @@ int intel_cpu_fm_06_3e_get_node_power_domain_info_json(char
                                msrs.msr_dram_power_info, msrs.msr_rapl_power_unit,
                                msrs.msr_pkg_power_limit);
 
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
     return 0;
 }
@@ -615,3 +657,19 @@ int intel_cpu_fm_06_3e_get_energy_json(json_t *get_energy_obj)
 
     return 0;
 }
+
+int intel_cpu_fm_06_3e_get_cstate_residency(struct variorum_cstate_sample
+        *sample)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_cstate_residency_data(sample, msrs.msrs_pkg_cstate_residency,
+                                     pkg_cstates, sizeof(pkg_cstates) / sizeof(pkg_cstates[0]),
+                                     msrs.msrs_core_cstate_residency, core_cstates,
+                                     sizeof(core_cstates) / sizeof(core_cstates[0]),
+                                     msrs.ia32_time_stamp_counter);
+}
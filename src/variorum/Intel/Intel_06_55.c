@@ -7,11 +7,16 @@
 #include <stdlib.h>
 
 #include <Intel_06_55.h>
+#include <attribution_features.h>
 #include <clocks_features.h>
 #include <config_architecture.h>
 #include <counters_features.h>
+#include <cstate_features.h>
 #include <intel_power_features.h>
+#include <pmc_features.h>
 #include <thermal_features.h>
+#include <uncore_features.h>
+#include <variorum_json.h>
 
 static struct skylake_55_offsets msrs =
 {
@@ -65,6 +70,67 @@ static struct skylake_55_offsets msrs =
     .ia32_perfevtsel_counters[5]  = 0x18B,
     .ia32_perfevtsel_counters[6]  = 0x18C,
     .ia32_perfevtsel_counters[7]  = 0x18D,
+    .msrs_pcu_pmon_evtsel[0]      = 0x711,
+    .msrs_pcu_pmon_evtsel[1]      = 0x712,
+    .msrs_pcu_pmon_evtsel[2]      = 0x713,
+    .msrs_pcu_pmon_evtsel[3]      = 0x714,
+    .msrs_pcu_pmon_ctrs[0]        = 0x717,
+    .msrs_pcu_pmon_ctrs[1]        = 0x718,
+    .msrs_pcu_pmon_ctrs[2]        = 0x719,
+    .msrs_pcu_pmon_ctrs[3]        = 0x71A,
+    .msr_pcu_pmon_box_filter      = 0x715,
+    .msr_ubox_pmon_fixed_ctl      = 0x703,
+    .msr_ubox_pmon_fixed_ctr      = 0x704,
+    .msr_cha_pmon_ctl0            = 0xE01,
+    .msr_cha_pmon_ctr0            = 0xE08,
+    .msrs_pkg_cstate_residency[0] = 0x60D,
+    .msrs_pkg_cstate_residency[1] = 0x3F9,
+    .msrs_core_cstate_residency[0] = 0x3FD,
+};
+
+/* C-state number of each entry in msrs_pkg_cstate_residency and
+ * msrs_core_cstate_residency.
+ * */
+static int pkg_cstates[] = { 2, 6 };
+static int core_cstates[] = { 6 };
+
+/* Events accepted by variorum_set_counter_events(), with their encodings
+ * from the Intel SDM Vol. 3B, Chapter 19.
+ * */
+static struct pmc_event pmc_events[] =
+{
+    { "BR_INST_RETIRED.ALL_BRANCHES",  0xC4, 0x00, 0,  0x00 },
+    { "BR_MISP_RETIRED.ALL_BRANCHES",  0xC5, 0x00, 0,  0x00 },
+    { "CYCLE_ACTIVITY.STALLS_L3_MISS", 0xA3, 0x06, 6,  0x00 },
+    { "CYCLE_ACTIVITY.STALLS_MEM_ANY", 0xA3, 0x14, 20, 0x00 },
+    { "CYCLE_ACTIVITY.STALLS_TOTAL",   0xA3, 0x04, 4,  0x00 },
+    { "L2_RQSTS.MISS",                 0x24, 0x3F, 0,  0x00 },
+    { "LONGEST_LAT_CACHE.MISS",        0x2E, 0x41, 0,  0x00 },
+    { "LONGEST_LAT_CACHE.REFERENCE",   0x2E, 0x4F, 0,  0x00 },
+    { "MEM_INST_RETIRED.ALL_LOADS",    0xD0, 0x81, 0,  0x00 },
+    { "MEM_INST_RETIRED.ALL_STORES",   0xD0, 0x82, 0,  0x00 },
+    { "MEM_LOAD_RETIRED.L3_MISS",      0xD1, 0x20, 0,  0x00 },
+    { "UOPS_ISSUED.ANY",               0x0E, 0x01, 0,  0x00 },
+    { "UOPS_ISSUED.STALL_CYCLES",      0x0E, 0x01, 1,  0x80 },
+};
+
+/* Cycles with a load or store outstanding and nothing executing. */
+static const char *pmc_stall_event = "CYCLE_ACTIVITY.STALLS_MEM_ANY";
+
+/* PCU, U-box and CHA events sampled by variorum_get_uncore_counters(), from
+ * the Skylake-SP uncore performance monitoring guide.
+ * */
+static struct uncore_event unc_events[UNC_NUM_EVENTS] =
+{
+    [UNC_PCU_CLOCKTICKS]       = { "UNC_P_CLOCKTICKS",                    0x00, 0x00 },
+    [UNC_PCU_FREQ_BAND0]       = { "UNC_P_FREQ_BAND0_CYCLES",             0x0B, 0x00 },
+    [UNC_PCU_FREQ_BAND1]       = { "UNC_P_FREQ_BAND1_CYCLES",             0x0C, 0x00 },
+    [UNC_PCU_FREQ_BAND2]       = { "UNC_P_FREQ_BAND2_CYCLES",             0x0D, 0x00 },
+    [UNC_PCU_FREQ_BAND3]       = { "UNC_P_FREQ_BAND3_CYCLES",             0x0E, 0x00 },
+    [UNC_PCU_FREQ_MAX_POWER]   = { "UNC_P_FREQ_MAX_POWER_CYCLES",         0x05, 0x00 },
+    [UNC_PCU_FREQ_MAX_THERMAL] = { "UNC_P_FREQ_MAX_LIMIT_THERMAL_CYCLES", 0x04, 0x00 },
+    [UNC_CHA_READS]            = { "UNC_CHA_REQUESTS.READS",              0x50, 0x03 },
+    [UNC_CHA_WRITES]           = { "UNC_CHA_REQUESTS.WRITES",             0x50, 0x0C },
 };
 
 int intel_cpu_fm_06_55_get_power_limits(int long_ver)
@@ -288,13 +354,13 @@ int intel_cpu_fm_06_55_get_counters(int long_ver)
     {
         print_all_counter_data(stdout, msrs.ia32_fixed_counters,
                                msrs.ia32_perfevtsel_counters, msrs.ia32_perfmon_counters,
-                               msrs.msrs_pcu_pmon_evtsel, msrs.ia32_perfevtsel_counters);
+                               msrs.msrs_pcu_pmon_evtsel, msrs.msrs_pcu_pmon_ctrs);
     }
     else if (long_ver == 1)
     {
         print_verbose_all_counter_data(stdout, msrs.ia32_fixed_counters,
                                        msrs.ia32_perfevtsel_counters, msrs.ia32_perfmon_counters,
-                                       msrs.msrs_pcu_pmon_evtsel, msrs.ia32_perfevtsel_counters);
+                                       msrs.msrs_pcu_pmon_evtsel, msrs.msrs_pcu_pmon_ctrs);
     }
     return 0;
 }
@@ -336,6 +402,33 @@ int intel_cpu_fm_06_55_get_clocks_json(json_t *get_clock_obj_json)
     return 0;
 }
 
+int intel_cpu_fm_06_55_get_core_frequency(struct variorum_core_frequency *freq)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_core_frequency_data(msrs.ia32_aperf, msrs.ia32_mperf,
+                                   msrs.ia32_time_stamp_counter, msrs.msr_platform_info,
+                                   freq);
+}
+
+int intel_cpu_fm_06_55_get_socket_thermals(struct variorum_socket_thermals
+        *thermals)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_socket_thermals_data(thermals, msrs.ia32_therm_status,
+                                    msrs.ia32_package_therm_status,
+                                    msrs.msr_temperature_target);
+}
+
 int intel_cpu_fm_06_55_get_power(int long_ver)
 {
     char *val = getenv("VARIORUM_LOG");
@@ -417,7 +510,7 @@ int intel_cpu_fm_06_55_get_node_power_domain_info_json(char
                                msrs.msr_dram_power_info, msrs.msr_rapl_power_unit,
                                msrs.msr_pkg_power_limit);
 
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
 
     return 0;
@@ -539,3 +632,94 @@ int intel_cpu_fm_06_55_get_energy_json(json_t *get_energy_obj)
 
     return 0;
 }
+
+int intel_cpu_fm_06_55_get_socket_energy(struct variorum_socket_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_socket_energy_data(msrs.msr_rapl_power_unit,
+                                  msrs.msr_pkg_energy_status, msrs.msr_dram_energy_status,
+                                  energy);
+}
+
+int intel_cpu_fm_06_55_get_energy_attribution(const char **targets,
+        int ntargets, struct variorum_energy_attribution *attr)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_energy_attribution(targets, ntargets, attr,
+                                  msrs.msr_rapl_power_unit, msrs.msr_pkg_energy_status,
+                                  msrs.msr_dram_energy_status, msrs.ia32_fixed_counters,
+                                  msrs.ia32_perf_global_ctrl, msrs.ia32_fixed_ctr_ctrl, msrs.ia32_aperf,
+                                  msrs.ia32_mperf, msrs.ia32_time_stamp_counter,
+                                  msrs.msr_platform_info);
+}
+
+int intel_cpu_fm_06_55_set_counter_events(const char **events, int nevents)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return set_counter_events(events, nevents, pmc_events,
+                              sizeof(pmc_events) / sizeof(pmc_events[0]), pmc_stall_event);
+}
+
+int intel_cpu_fm_06_55_get_thread_counters(struct
+        variorum_thread_counters_sample *sample)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_thread_counters_data(sample, pmc_events,
+                                    sizeof(pmc_events) / sizeof(pmc_events[0]), pmc_stall_event,
+                                    msrs.ia32_fixed_counters, msrs.ia32_perf_global_ctrl,
+                                    msrs.ia32_fixed_ctr_ctrl, msrs.ia32_perfevtsel_counters,
+                                    msrs.ia32_perfmon_counters, msrs.msr_platform_info);
+}
+
+int intel_cpu_fm_06_55_get_uncore_counters(struct variorum_uncore_sample
+        *sample)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_uncore_counters_data(sample, unc_events,
+                                    msrs.msrs_pcu_pmon_evtsel, msrs.msrs_pcu_pmon_ctrs,
+                                    msrs.msr_pcu_pmon_box_filter, msrs.msr_ubox_pmon_fixed_ctl,
+                                    msrs.msr_ubox_pmon_fixed_ctr, msrs.msr_cha_pmon_ctl0,
+                                    msrs.msr_cha_pmon_ctr0,
+                                    msrs.msr_platform_info);
+}
+
+int intel_cpu_fm_06_55_get_cstate_residency(struct variorum_cstate_sample
+        *sample)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_cstate_residency_data(sample, msrs.msrs_pkg_cstate_residency,
+                                     pkg_cstates, sizeof(pkg_cstates) / sizeof(pkg_cstates[0]),
+                                     msrs.msrs_core_cstate_residency, core_cstates,
+                                     sizeof(core_cstates) / sizeof(core_cstates[0]),
+                                     msrs.ia32_time_stamp_counter);
+}
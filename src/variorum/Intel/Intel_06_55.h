@@ -9,6 +9,9 @@
 #include <jansson.h>
 #include <sys/types.h>
 
+#include <config_architecture.h>
+#include <variorum.h>
+
 /// @brief List of unique addresses for Skylake Family/Model 55H.
 struct skylake_55_offsets
 {
@@ -78,9 +81,25 @@ struct skylake_55_offsets
     off_t ia32_perfevtsel_counters[8];
     /// @brief Array of unique addresses for pmon evtsel.
     off_t msrs_pcu_pmon_evtsel[4];
+    /// @brief Array of unique addresses for pmon counters.
+    off_t msrs_pcu_pmon_ctrs[4];
+    /// @brief Address for PCU_MSR_PMON_BOX_FILTER.
+    off_t msr_pcu_pmon_box_filter;
+    /// @brief Address for U_MSR_PMON_UCLK_FIXED_CTL.
+    off_t msr_ubox_pmon_fixed_ctl;
+    /// @brief Address for U_MSR_PMON_UCLK_FIXED_CTR.
+    off_t msr_ubox_pmon_fixed_ctr;
+    /// @brief Address for CHA 0 PMON_CTL0.
+    off_t msr_cha_pmon_ctl0;
+    /// @brief Address for CHA 0 PMON_CTR0.
+    off_t msr_cha_pmon_ctr0;
     off_t msr_config_tdp_level1;
     off_t msr_config_tdp_level2;
     off_t msr_config_tdp_nominal;
+    /// @brief Array of unique addresses for package C-state residency.
+    off_t msrs_pkg_cstate_residency[2];
+    /// @brief Array of unique addresses for core C-state residency.
+    off_t msrs_core_cstate_residency[1];
 };
 
 int intel_cpu_fm_06_55_get_power_limits(
@@ -150,8 +169,43 @@ int intel_cpu_fm_06_55_get_clocks_json(
     json_t *get_clock_obj_json
 );
 
+int intel_cpu_fm_06_55_get_core_frequency(
+    struct variorum_core_frequency *freq
+);
+
+int intel_cpu_fm_06_55_get_socket_thermals(
+    struct variorum_socket_thermals *thermals
+);
+
 int intel_cpu_fm_06_55_get_energy_json(
     json_t *get_energy_obj
 );
 
+int intel_cpu_fm_06_55_get_energy_attribution(
+    const char **targets,
+    int ntargets,
+    struct variorum_energy_attribution *attr
+);
+
+int intel_cpu_fm_06_55_get_socket_energy(
+    struct variorum_socket_energy *energy
+);
+
+int intel_cpu_fm_06_55_set_counter_events(
+    const char **events,
+    int nevents
+);
+
+int intel_cpu_fm_06_55_get_thread_counters(
+    struct variorum_thread_counters_sample *sample
+);
+
+int intel_cpu_fm_06_55_get_uncore_counters(
+    struct variorum_uncore_sample *sample
+);
+
+int intel_cpu_fm_06_55_get_cstate_residency(
+    struct variorum_cstate_sample *sample
+);
+
 #endif
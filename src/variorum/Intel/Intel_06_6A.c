@@ -12,6 +12,7 @@
 #include <counters_features.h>
 #include <intel_power_features.h>
 #include <thermal_features.h>
+#include <variorum_json.h>
 
 static struct icelake_6a_offsets msrs =
 {
@@ -158,7 +159,7 @@ int intel_cpu_fm_06_6a_get_node_power_domain_info_json(char
                                msrs.msr_dram_power_info, msrs.msr_rapl_power_unit,
                                msrs.msr_pkg_power_limit);
 
-    *get_domain_obj_str = json_dumps(get_domain_obj, JSON_INDENT(4));
+    *get_domain_obj_str = variorum_json_dumps(get_domain_obj);
     json_decref(get_domain_obj);
 
     return 0;
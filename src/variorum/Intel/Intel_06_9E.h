@@ -9,6 +9,9 @@
 #include <jansson.h>
 #include <sys/types.h>
 
+#include <config_architecture.h>
+#include <variorum.h>
+
 /// @brief List of unique addresses for Kaby Lake Family/Model 9EH.
 struct kabylake_9e_offsets
 {
@@ -81,6 +84,10 @@ struct kabylake_9e_offsets
     off_t msr_config_tdp_level1;
     off_t msr_config_tdp_level2;
     off_t msr_config_tdp_nominal;
+    /// @brief Array of unique addresses for package C-state residency.
+    off_t msrs_pkg_cstate_residency[7];
+    /// @brief Array of unique addresses for core C-state residency.
+    off_t msrs_core_cstate_residency[3];
 };
 
 int intel_cpu_fm_06_9e_get_power_limits(
@@ -147,8 +154,20 @@ int intel_cpu_fm_06_9e_get_clocks_json(
     json_t *get_clock_obj_json
 );
 
+int intel_cpu_fm_06_9e_get_core_frequency(
+    struct variorum_core_frequency *freq
+);
+
+int intel_cpu_fm_06_9e_get_socket_thermals(
+    struct variorum_socket_thermals *thermals
+);
+
 int intel_cpu_fm_06_9e_get_energy_json(
     json_t *get_energy_obj
 );
 
+int intel_cpu_fm_06_9e_get_cstate_residency(
+    struct variorum_cstate_sample *sample
+);
+
 #endif
@@ -0,0 +1,572 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <hwloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <attribution_features.h>
+#include <clocks_features.h>
+#include <config_architecture.h>
+#include <counters_features.h>
+#include <intel_power_features.h>
+#include <misc_features.h>
+#include <msr_core.h>
+#include <variorum_error.h>
+#include <variorum_topology.h>
+
+/* Fixed-function counters are 48 bits wide. */
+#define FIXED_CTR_MASK ((1ULL << 48) - 1)
+/* MSR_PKG_ENERGY_STATUS holds 32 bits. */
+#define PKG_ENERGY_MASK 0xFFFFFFFFULL
+
+/* CPU time of one thread at the end of the previous interval. */
+struct tid_ticks
+{
+    pid_t tid;
+    uint64_t ticks;
+    uint64_t starttime;
+    /* Open /proc/<tid>/stat, reread on every call, or -1. */
+    int fd;
+};
+
+/* Per-target state carried between calls. */
+struct attribution_target
+{
+    char name[VARIORUM_ATTRIBUTION_TARGET_LEN];
+    struct tid_ticks *tids;
+    int ntids;
+    double total_joules;
+};
+
+/* Per-thread state read from /proc/<tid>/stat. */
+struct tid_stat
+{
+    uint64_t ticks;
+    uint64_t starttime;
+    int processor;
+};
+
+static int cmp_tid_ticks(const void *a, const void *b)
+{
+    pid_t x = ((const struct tid_ticks *)a)->tid;
+    pid_t y = ((const struct tid_ticks *)b)->tid;
+    return (x > y) - (x < y);
+}
+
+static int open_tid_stat(pid_t tid)
+{
+    char path[64];
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)tid);
+    return open(path, O_RDONLY);
+}
+
+/* Reread a stat file opened with open_tid_stat(). This fails once the thread
+ * has exited, even if its tid has been reused. */
+static int read_tid_stat(int fd, struct tid_stat *st)
+{
+    char buf[1024];
+    char *p;
+    ssize_t n;
+    int field;
+    unsigned long long utime = 0, stime = 0, starttime = 0;
+    int processor = -1;
+
+    n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0)
+    {
+        return -1;
+    }
+    buf[n] = '\0';
+
+    /* The command name may contain spaces, so start after its closing paren. */
+    p = strrchr(buf, ')');
+    if (p == NULL)
+    {
+        return -1;
+    }
+    p++;
+    for (field = 3; *p != '\0' && field <= 39; field++)
+    {
+        while (*p == ' ')
+        {
+            p++;
+        }
+        switch (field)
+        {
+            case 14:
+                utime = strtoull(p, NULL, 10);
+                break;
+            case 15:
+                stime = strtoull(p, NULL, 10);
+                break;
+            case 22:
+                starttime = strtoull(p, NULL, 10);
+                break;
+            case 39:
+                processor = atoi(p);
+                break;
+            default:
+                break;
+        }
+        while (*p != ' ' && *p != '\0')
+        {
+            p++;
+        }
+    }
+    if (processor < 0)
+    {
+        return -1;
+    }
+    st->ticks = utime + stime;
+    st->starttime = starttime;
+    st->processor = processor;
+    return 0;
+}
+
+static int append_tid(pid_t **tids, int *ntids, int *cap, pid_t tid)
+{
+    pid_t *tmp;
+
+    if (*ntids == *cap)
+    {
+        *cap = *cap ? *cap * 2 : 64;
+        tmp = (pid_t *) realloc(*tids, *cap * sizeof(pid_t));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        *tids = tmp;
+    }
+    (*tids)[(*ntids)++] = tid;
+    return 0;
+}
+
+/* A target is a PID (all of its threads) or a cgroup directory (the threads
+ * listed in cgroup.threads for v2, or tasks for v1). */
+static int list_target_tids(const char *target, pid_t **tids, int *ntids)
+{
+    char path[VARIORUM_ATTRIBUTION_TARGET_LEN + 32];
+    int cap = 0;
+    FILE *fp;
+    DIR *dir;
+    struct dirent *ent;
+    long tid;
+
+    *tids = NULL;
+    *ntids = 0;
+
+    if (target[0] == '/')
+    {
+        snprintf(path, sizeof(path), "%s/cgroup.threads", target);
+        fp = fopen(path, "r");
+        if (fp == NULL)
+        {
+            snprintf(path, sizeof(path), "%s/tasks", target);
+            fp = fopen(path, "r");
+        }
+        if (fp == NULL)
+        {
+            return -1;
+        }
+        while (fscanf(fp, "%ld", &tid) == 1)
+        {
+            if (append_tid(tids, ntids, &cap, (pid_t)tid))
+            {
+                fclose(fp);
+                return -1;
+            }
+        }
+        fclose(fp);
+        return 0;
+    }
+
+    snprintf(path, sizeof(path), "/proc/%s/task", target);
+    dir = opendir(path);
+    if (dir == NULL)
+    {
+        /* The process has exited; report no threads. */
+        return 0;
+    }
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+        {
+            continue;
+        }
+        if (append_tid(tids, ntids, &cap, (pid_t)atol(ent->d_name)))
+        {
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+/* Targets sampled by the previous call, with their threads and totals. */
+static struct attribution_target *g_targets = NULL;
+static int g_ntargets = 0;
+
+static struct attribution_target *lookup_target(const char *name)
+{
+    struct attribution_target *tmp;
+    int i;
+
+    for (i = 0; i < g_ntargets; i++)
+    {
+        if (strcmp(g_targets[i].name, name) == 0)
+        {
+            return &g_targets[i];
+        }
+    }
+    tmp = (struct attribution_target *) realloc(g_targets,
+            (g_ntargets + 1) * sizeof(struct attribution_target));
+    if (tmp == NULL)
+    {
+        return NULL;
+    }
+    g_targets = tmp;
+    memset(&g_targets[g_ntargets], 0, sizeof(struct attribution_target));
+    snprintf(g_targets[g_ntargets].name, VARIORUM_ATTRIBUTION_TARGET_LEN, "%s",
+             name);
+    return &g_targets[g_ntargets++];
+}
+
+/* Forget the targets that are no longer requested, closing the stat files of
+ * their threads, so that a changing list of pids or cgroups does not
+ * accumulate state. */
+static void prune_targets(const char **targets, int ntargets)
+{
+    int i = 0;
+    int t;
+    int k;
+
+    while (i < g_ntargets)
+    {
+        for (t = 0; t < ntargets; t++)
+        {
+            if (strcmp(g_targets[i].name, targets[t]) == 0)
+            {
+                break;
+            }
+        }
+        if (t < ntargets)
+        {
+            i++;
+            continue;
+        }
+        for (k = 0; k < g_targets[i].ntids; k++)
+        {
+            if (g_targets[i].tids[k].fd >= 0)
+            {
+                close(g_targets[i].tids[k].fd);
+            }
+        }
+        free(g_targets[i].tids);
+        g_targets[i] = g_targets[--g_ntargets];
+    }
+}
+
+static uint64_t boot_ticks(long hz)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * hz + (uint64_t)ts.tv_nsec / (1000000000L / hz);
+}
+
+int get_energy_attribution(const char **targets, int ntargets,
+                           struct variorum_energy_attribution *attr, off_t msr_rapl_unit,
+                           off_t msr_pkg_energy_status, off_t msr_dram_energy_status,
+                           off_t *msrs_fixed_ctrs, off_t msr_perf_global_ctrl,
+                           off_t msr_fixed_counter_ctrl, off_t msr_aperf, off_t msr_mperf,
+                           off_t msr_tsc, off_t msr_platform_info)
+{
+    static int init = 0;
+    static unsigned nsockets, nthreads;
+    static struct rapl_data *rapl = NULL;
+    static struct rapl_units *ru = NULL;
+    static struct fixed_counter *c0, *c1, *c2;
+    static struct clocks_data *cd;
+    static uint64_t *last_aperf, *last_mperf, *last_instr, *last_clk;
+    static uint64_t *last_pkg_bits;
+    static int *cpu_socket;
+    static double base_freq_hz;
+    static uint64_t last_boot_ticks;
+    static struct timeval last_now;
+    long hz = sysconf(_SC_CLK_TCK);
+    struct timeval now;
+    double elapsed;
+    double *freq_hz = NULL;
+    double *ipc = NULL;
+    double *joules_per_cycle = NULL;
+    double *socket_cycles = NULL;
+    uint64_t d_aperf, d_mperf, d_instr, d_clk, d_bits;
+    uint64_t now_boot_ticks;
+    unsigned i;
+    int t, k;
+    int err = 0;
+
+    if (!init)
+    {
+        int ratio = 0;
+        hwloc_obj_t pu, pkg;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+        variorum_get_topology(&nsockets, NULL, &nthreads, P_INTEL_CPU_IDX);
+#endif
+        if (get_max_non_turbo_ratio(msr_platform_info, &ratio))
+        {
+            variorum_error_handler("Error retrieving max non-turbo ratio",
+                                   VARIORUM_ERROR_FUNCTION, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        base_freq_hz = ratio * 100.0e6;
+
+        ru = (struct rapl_units *) malloc(nsockets * sizeof(struct rapl_units));
+        last_pkg_bits = (uint64_t *) malloc(nsockets * sizeof(uint64_t));
+        last_aperf = (uint64_t *) malloc(nthreads * sizeof(uint64_t));
+        last_mperf = (uint64_t *) malloc(nthreads * sizeof(uint64_t));
+        last_instr = (uint64_t *) malloc(nthreads * sizeof(uint64_t));
+        last_clk = (uint64_t *) malloc(nthreads * sizeof(uint64_t));
+        cpu_socket = (int *) malloc(nthreads * sizeof(int));
+        if (!ru || !last_pkg_bits || !last_aperf || !last_mperf || !last_instr ||
+            !last_clk || !cpu_socket)
+        {
+            free(ru);
+            free(last_pkg_bits);
+            free(last_aperf);
+            free(last_mperf);
+            free(last_instr);
+            free(last_clk);
+            free(cpu_socket);
+            ru = NULL;
+            last_pkg_bits = last_aperf = last_mperf = last_instr = last_clk = NULL;
+            cpu_socket = NULL;
+            return -1;
+        }
+        get_rapl_power_unit(ru, msr_rapl_unit);
+
+        /* MSR batches are indexed by OS CPU number. */
+        for (i = 0; i < nthreads; i++)
+        {
+            cpu_socket[i] = 0;
+            pu = hwloc_get_pu_obj_by_os_index(topology, i);
+            pkg = pu ? hwloc_get_ancestor_obj_by_type(topology, HWLOC_OBJ_SOCKET,
+                    pu) : NULL;
+            if (pkg != NULL && pkg->logical_index < nsockets)
+            {
+                cpu_socket[i] = pkg->logical_index;
+            }
+        }
+
+        get_power(msr_rapl_unit, msr_pkg_energy_status, msr_dram_energy_status);
+        rapl_storage(&rapl);
+        fixed_counter_storage(&c0, &c1, &c2, msrs_fixed_ctrs);
+        enable_fixed_counters(msrs_fixed_ctrs, msr_perf_global_ctrl,
+                              msr_fixed_counter_ctrl);
+        clocks_storage(&cd, msr_aperf, msr_mperf, msr_tsc);
+    }
+    else
+    {
+        get_power(msr_rapl_unit, msr_pkg_energy_status, msr_dram_energy_status);
+    }
+    read_batch(FIXED_COUNTERS_DATA);
+    read_batch(CLOCKS_DATA);
+    gettimeofday(&now, NULL);
+    now_boot_ticks = boot_ticks(hz);
+
+    freq_hz = (double *) calloc(nthreads, sizeof(double));
+    ipc = (double *) calloc(nthreads, sizeof(double));
+    joules_per_cycle = (double *) calloc(nsockets, sizeof(double));
+    socket_cycles = (double *) calloc(nsockets, sizeof(double));
+    if (!freq_hz || !ipc || !joules_per_cycle || !socket_cycles)
+    {
+        free(freq_hz);
+        free(ipc);
+        free(joules_per_cycle);
+        free(socket_cycles);
+        return -1;
+    }
+
+    for (i = 0; i < nthreads && init; i++)
+    {
+        d_aperf = *cd->aperf[i] - last_aperf[i];
+        d_mperf = *cd->mperf[i] - last_mperf[i];
+        d_instr = (*c0->value[i] - last_instr[i]) & FIXED_CTR_MASK;
+        d_clk = (*c1->value[i] - last_clk[i]) & FIXED_CTR_MASK;
+        if (d_mperf > 0)
+        {
+            freq_hz[i] = base_freq_hz * (double)d_aperf / (double)d_mperf;
+        }
+        if (d_clk > 0)
+        {
+            ipc[i] = (double)d_instr / (double)d_clk;
+        }
+        socket_cycles[cpu_socket[i]] += (double)d_aperf;
+    }
+    for (i = 0; i < nsockets && init; i++)
+    {
+        d_bits = (*rapl->pkg_bits[i] - last_pkg_bits[i]) & PKG_ENERGY_MASK;
+        if (socket_cycles[i] > 0)
+        {
+            joules_per_cycle[i] = ((double)d_bits / ru[i].joules) / socket_cycles[i];
+        }
+    }
+    elapsed = init ? (now.tv_sec - last_now.tv_sec) +
+              (now.tv_usec - last_now.tv_usec) / 1000000.0 : 0.0;
+
+    prune_targets(targets, ntargets);
+
+    for (t = 0; t < ntargets; t++)
+    {
+        struct attribution_target *tgt = lookup_target(targets[t]);
+        struct tid_ticks *cur = NULL;
+        struct tid_ticks *prev;
+        struct tid_ticks key;
+        struct tid_stat st;
+        pid_t *tids = NULL;
+        int ntids = 0;
+        int ncur = 0;
+        int fd;
+        uint64_t d_ticks;
+        double cycles;
+
+        memset(&attr[t], 0, sizeof(struct variorum_energy_attribution));
+        snprintf(attr[t].target, VARIORUM_ATTRIBUTION_TARGET_LEN, "%s", targets[t]);
+        attr[t].elapsed = elapsed;
+        if (tgt == NULL || list_target_tids(targets[t], &tids, &ntids))
+        {
+            free(tids);
+            err = -1;
+            continue;
+        }
+        if (ntids > 0)
+        {
+            cur = (struct tid_ticks *) malloc(ntids * sizeof(struct tid_ticks));
+            if (cur == NULL)
+            {
+                err = -1;
+            }
+        }
+
+        for (k = 0; k < ntids && cur != NULL; k++)
+        {
+            key.tid = tids[k];
+            prev = tgt->tids ? bsearch(&key, tgt->tids, tgt->ntids,
+                                       sizeof(struct tid_ticks), cmp_tid_ticks) : NULL;
+
+            /* Reuse the stat file kept open from the previous call, and only
+             * open it again if the thread is new or has exited. */
+            fd = prev != NULL ? prev->fd : -1;
+            if (prev != NULL)
+            {
+                prev->fd = -1;
+            }
+            if (fd >= 0 && read_tid_stat(fd, &st))
+            {
+                close(fd);
+                fd = -1;
+            }
+            if (fd < 0)
+            {
+                fd = open_tid_stat(tids[k]);
+                if (fd < 0)
+                {
+                    continue;
+                }
+                if (read_tid_stat(fd, &st))
+                {
+                    close(fd);
+                    continue;
+                }
+            }
+            cur[ncur].tid = tids[k];
+            cur[ncur].ticks = st.ticks;
+            cur[ncur].starttime = st.starttime;
+            cur[ncur].fd = fd;
+            ncur++;
+
+            /* A different start time means the tid was reused by a new
+             * thread, whose ticks restart from zero. */
+            if (prev != NULL && prev->starttime == st.starttime &&
+                st.ticks >= prev->ticks)
+            {
+                d_ticks = st.ticks - prev->ticks;
+            }
+            else if (init && st.starttime >= last_boot_ticks)
+            {
+                /* Thread started during this interval. */
+                d_ticks = st.ticks;
+            }
+            else
+            {
+                /* First time we see it; use as baseline. */
+                d_ticks = 0;
+            }
+            if (st.processor >= (int)nthreads)
+            {
+                continue;
+            }
+
+            cycles = ((double)d_ticks / hz) * freq_hz[st.processor];
+            attr[t].cpu_seconds += (double)d_ticks / hz;
+            attr[t].cycles += cycles;
+            attr[t].instructions += cycles * ipc[st.processor];
+            attr[t].energy_joules += cycles * joules_per_cycle[cpu_socket[st.processor]];
+        }
+        attr[t].nthreads = ncur;
+        tgt->total_joules += attr[t].energy_joules;
+        attr[t].total_energy_joules = tgt->total_joules;
+
+        if (ncur > 0)
+        {
+            qsort(cur, ncur, sizeof(struct tid_ticks), cmp_tid_ticks);
+        }
+        /* Close the stat files of threads that have exited. */
+        for (k = 0; k < tgt->ntids; k++)
+        {
+            if (tgt->tids[k].fd >= 0)
+            {
+                close(tgt->tids[k].fd);
+            }
+        }
+        free(tgt->tids);
+        tgt->tids = cur;
+        tgt->ntids = ncur;
+        free(tids);
+    }
+
+    for (i = 0; i < nthreads; i++)
+    {
+        last_aperf[i] = *cd->aperf[i];
+        last_mperf[i] = *cd->mperf[i];
+        last_instr[i] = *c0->value[i];
+        last_clk[i] = *c1->value[i];
+    }
+    for (i = 0; i < nsockets; i++)
+    {
+        last_pkg_bits[i] = *rapl->pkg_bits[i];
+    }
+    last_now = now;
+    last_boot_ticks = now_boot_ticks;
+    init = 1;
+
+    free(freq_hz);
+    free(ipc);
+    free(joules_per_cycle);
+    free(socket_cycles);
+    return err;
+}
@@ -0,0 +1,61 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef ATTRIBUTION_FEATURES_H_INCLUDE
+#define ATTRIBUTION_FEATURES_H_INCLUDE
+
+#include <sys/types.h>
+
+#include <variorum.h>
+
+/// @brief Apportion package energy consumed since the previous call to a set
+/// of processes or cgroups.
+///
+/// Each logical CPU's share of its package energy is proportional to the
+/// active cycles it ran (IA32_APERF). A target is charged for the CPU time its
+/// threads used (/proc/<tid>/stat), converted to cycles with the effective
+/// frequency (APERF/MPERF) of the CPU the thread last ran on. Instructions are
+/// estimated with that CPU's IPC from the fixed counters. Idle and uncore
+/// energy is therefore spread over active cycles, and energy of a package
+/// without active cycles is left unattributed.
+///
+/// The first call only establishes the baseline and reports zero energy.
+///
+/// @param [in] targets PIDs or cgroup directories.
+/// @param [in] ntargets Number of targets.
+/// @param [out] attr Array of ntargets results, in the order of targets.
+/// @param [in] msr_rapl_unit Unique MSR address for MSR_RAPL_POWER_UNIT.
+/// @param [in] msr_pkg_energy_status Unique MSR address for
+/// MSR_PKG_ENERGY_STATUS.
+/// @param [in] msr_dram_energy_status Unique MSR address for
+/// MSR_DRAM_ENERGY_STATUS.
+/// @param [in] msrs_fixed_ctrs Array of unique addresses for fixed counters.
+/// @param [in] msr_perf_global_ctrl Unique MSR address for
+/// IA32_PERF_GLOBAL_CTRL.
+/// @param [in] msr_fixed_counter_ctrl Unique MSR address for
+/// IA32_FIXED_CTR_CTRL.
+/// @param [in] msr_aperf Unique MSR address for IA32_APERF.
+/// @param [in] msr_mperf Unique MSR address for IA32_MPERF.
+/// @param [in] msr_tsc Unique MSR address for IA32_TIME_STAMP_COUNTER.
+/// @param [in] msr_platform_info Unique MSR address for MSR_PLATFORM_INFO.
+///
+/// @return 0 if successful, otherwise -1
+int get_energy_attribution(
+    const char **targets,
+    int ntargets,
+    struct variorum_energy_attribution *attr,
+    off_t msr_rapl_unit,
+    off_t msr_pkg_energy_status,
+    off_t msr_dram_energy_status,
+    off_t *msrs_fixed_ctrs,
+    off_t msr_perf_global_ctrl,
+    off_t msr_fixed_counter_ctrl,
+    off_t msr_aperf,
+    off_t msr_mperf,
+    off_t msr_tsc,
+    off_t msr_platform_info
+);
+
+#endif
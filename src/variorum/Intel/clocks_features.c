@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <clocks_features.h>
@@ -389,6 +390,95 @@ int get_clocks_data_json(json_t *output, off_t msr_aperf, off_t msr_mperf,
     return 0;
 }
 
+int get_core_frequency_data(off_t msr_aperf, off_t msr_mperf, off_t msr_tsc,
+                            off_t msr_platform_info,
+                            struct variorum_core_frequency *freq)
+{
+    static struct clocks_data *cd = NULL;
+    static uint64_t *prev_aperf = NULL;
+    static uint64_t *prev_mperf = NULL;
+    static double *avg_mhz = NULL;
+    static double prev_seconds = 0.0;
+    unsigned ncores = 0;
+    unsigned nthreads = 0;
+    unsigned i, k;
+    unsigned idx;
+    unsigned active;
+    int max_non_turbo_ratio;
+    uint64_t daperf, dmperf;
+    struct timeval tv;
+    double now;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(NULL, &ncores, &nthreads, P_INTEL_CPU_IDX);
+#endif
+
+    if (get_max_non_turbo_ratio(msr_platform_info, &max_non_turbo_ratio))
+    {
+        variorum_error_handler("Error retrieving max non-turbo ratio",
+                               VARIORUM_ERROR_FUNCTION, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (cd == NULL)
+    {
+        prev_aperf = (uint64_t *) calloc(nthreads, sizeof(uint64_t));
+        prev_mperf = (uint64_t *) calloc(nthreads, sizeof(uint64_t));
+        avg_mhz = (double *) calloc(ncores, sizeof(double));
+        if (prev_aperf == NULL || prev_mperf == NULL || avg_mhz == NULL)
+        {
+            free(prev_aperf);
+            free(prev_mperf);
+            free(avg_mhz);
+            prev_aperf = prev_mperf = NULL;
+            avg_mhz = NULL;
+            return -1;
+        }
+        clocks_storage(&cd, msr_aperf, msr_mperf, msr_tsc);
+    }
+    if (read_batch(CLOCKS_DATA))
+    {
+        variorum_error_handler("Batch read error", VARIORUM_ERROR_MSR_BATCH,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+    // Hardware thread k of core i is logical CPU k * ncores + i. MPERF only
+    // counts while a thread is not halted, so threads that slept through the
+    // interval are left out of their core's average.
+    for (i = 0; i < ncores; i++)
+    {
+        avg_mhz[i] = 0.0;
+        active = 0;
+        for (k = 0; k < nthreads / ncores; k++)
+        {
+            idx = k * ncores + i;
+            daperf = *cd->aperf[idx] - prev_aperf[idx];
+            dmperf = *cd->mperf[idx] - prev_mperf[idx];
+            prev_aperf[idx] = *cd->aperf[idx];
+            prev_mperf[idx] = *cd->mperf[idx];
+            if (dmperf == 0)
+            {
+                continue;
+            }
+            avg_mhz[i] += max_non_turbo_ratio * (daperf / (double)dmperf);
+            active++;
+        }
+        if (active)
+        {
+            avg_mhz[i] /= active;
+        }
+    }
+
+    freq->ncores = (int)ncores;
+    freq->interval = prev_seconds > 0.0 ? now - prev_seconds : 0.0;
+    freq->avg_mhz = avg_mhz;
+    prev_seconds = now;
+    return 0;
+}
+
 //void print_verbose_clocks_data_socket(FILE *writedest, off_t msr_aperf, off_t msr_mperf, off_t msr_tsc, off_t msr_perf_status, off_t msr_platform_info)
 //{
 //    static struct clocks_data *cd;
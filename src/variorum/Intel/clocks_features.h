@@ -160,6 +160,14 @@ int get_clocks_data_json(
     enum ctl_domains_e control_domain
 );
 
+int get_core_frequency_data(
+    off_t msr_aperf,
+    off_t msr_mperf,
+    off_t msr_tsc,
+    off_t msr_platform_info,
+    struct variorum_core_frequency *freq
+);
+
 json_t *make_socket_obj(
     json_t *node_obj,
     int socket_index
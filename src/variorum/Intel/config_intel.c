@@ -100,6 +100,12 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_2a_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_2a_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_2a_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_2a_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_2a_get_cstate_residency;
     }
     else if (*g_platform[idx].arch_id == FM_06_2D)
     {
@@ -132,6 +138,12 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_2d_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_2d_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_2d_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_2d_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_2d_get_cstate_residency;
     }
     // Ivy Bridge 06_3E
     else if (*g_platform[idx].arch_id == FM_06_3E)
@@ -165,6 +177,12 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_3e_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_3e_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_3e_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_3e_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_3e_get_cstate_residency;
     }
     // Haswell 06_3F
     else if (*g_platform[idx].arch_id == FM_06_3F)
@@ -198,6 +216,22 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_3f_get_thermals_json;
         g_platform[idx].variorum_get_energy_json =
             intel_cpu_fm_06_3f_get_energy_json;
+        g_platform[idx].variorum_get_energy_attribution =
+            intel_cpu_fm_06_3f_get_energy_attribution;
+        g_platform[idx].variorum_set_counter_events =
+            intel_cpu_fm_06_3f_set_counter_events;
+        g_platform[idx].variorum_get_thread_counters =
+            intel_cpu_fm_06_3f_get_thread_counters;
+        g_platform[idx].variorum_get_uncore_counters =
+            intel_cpu_fm_06_3f_get_uncore_counters;
+        g_platform[idx].variorum_get_socket_energy =
+            intel_cpu_fm_06_3f_get_socket_energy;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_3f_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_3f_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_3f_get_cstate_residency;
     }
     // Broadwell 06_4F
     else if (*g_platform[idx].arch_id == FM_06_4F)
@@ -231,8 +265,24 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_4f_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_4f_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_4f_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_4f_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_4f_get_cstate_residency;
         g_platform[idx].variorum_get_energy_json =
             intel_cpu_fm_06_4f_get_energy_json;
+        g_platform[idx].variorum_get_energy_attribution =
+            intel_cpu_fm_06_4f_get_energy_attribution;
+        g_platform[idx].variorum_set_counter_events =
+            intel_cpu_fm_06_4f_set_counter_events;
+        g_platform[idx].variorum_get_thread_counters =
+            intel_cpu_fm_06_4f_get_thread_counters;
+        g_platform[idx].variorum_get_uncore_counters =
+            intel_cpu_fm_06_4f_get_uncore_counters;
+        g_platform[idx].variorum_get_socket_energy =
+            intel_cpu_fm_06_4f_get_socket_energy;
     }
     // Skylake 06_55
     else if (*g_platform[idx].arch_id == FM_06_55)
@@ -266,8 +316,24 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_55_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_55_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_55_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_55_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_55_get_cstate_residency;
         g_platform[idx].variorum_get_energy_json =
             intel_cpu_fm_06_55_get_energy_json;
+        g_platform[idx].variorum_get_energy_attribution =
+            intel_cpu_fm_06_55_get_energy_attribution;
+        g_platform[idx].variorum_set_counter_events =
+            intel_cpu_fm_06_55_set_counter_events;
+        g_platform[idx].variorum_get_thread_counters =
+            intel_cpu_fm_06_55_get_thread_counters;
+        g_platform[idx].variorum_get_uncore_counters =
+            intel_cpu_fm_06_55_get_uncore_counters;
+        g_platform[idx].variorum_get_socket_energy =
+            intel_cpu_fm_06_55_get_socket_energy;
     }
     // Kaby Lake 06_9E
     else if (*g_platform[idx].arch_id == FM_06_9E)
@@ -299,6 +365,12 @@ int set_intel_func_ptrs(int idx)
             intel_cpu_fm_06_9e_get_thermals_json;
         g_platform[idx].variorum_get_frequency_json =
             intel_cpu_fm_06_9e_get_clocks_json;
+        g_platform[idx].variorum_get_core_frequency =
+            intel_cpu_fm_06_9e_get_core_frequency;
+        g_platform[idx].variorum_get_socket_thermals =
+            intel_cpu_fm_06_9e_get_socket_thermals;
+        g_platform[idx].variorum_get_cstate_residency =
+            intel_cpu_fm_06_9e_get_cstate_residency;
     }
     // Ice Lake 06_6A
     else if (*g_platform[idx].arch_id == FM_06_6A)
@@ -310,6 +310,10 @@ void print_perfmon_counter_data(FILE *writedest, off_t *msrs_perfevtsel_ctrs,
 
     if (p == NULL && !init)
     {
+        if (claim_pmc(PMC_OWNER_PRINT))
+        {
+            return;
+        }
 #ifdef LIBJUSTIFY_FOUND
         switch (avail)
         {
@@ -549,6 +553,10 @@ void print_verbose_perfmon_counter_data(FILE *writedest,
 
     if (p == NULL && !init)
     {
+        if (claim_pmc(PMC_OWNER_PRINT))
+        {
+            return;
+        }
         set_all_pmc_ctrl(0x0, 0x67, 0x00, 0xC4, 1, msrs_perfevtsel_ctrs);
         set_all_pmc_ctrl(0x0, 0x67, 0x00, 0xC4, 2, msrs_perfevtsel_ctrs);
         enable_pmc(msrs_perfevtsel_ctrs, msrs_perfmon_ctrs);
@@ -1077,6 +1085,24 @@ void clear_all_pmc(off_t *msrs_perfmon_ctrs)
     write_batch(COUNTERS_DATA);
 }
 
+int claim_pmc(enum pmc_owner owner)
+{
+    static enum pmc_owner holder = 0;
+
+    if (holder == 0)
+    {
+        holder = owner;
+    }
+    if (holder != owner)
+    {
+        variorum_error_handler("General-purpose counters are in use by another API",
+                               VARIORUM_ERROR_FEATURE_NOT_AVAILABLE,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    return 0;
+}
+
 ///*************************************/
 ///* Uncore PCU Performance Monitoring */
 ///*************************************/
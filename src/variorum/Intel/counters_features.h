@@ -312,6 +312,28 @@ void clear_all_pmc(
     off_t *msrs_perfmon_ctrs
 );
 
+/// @brief Users of the general-purpose counters.
+enum pmc_owner
+{
+    /// @brief variorum_print_counters() and its verbose variant.
+    PMC_OWNER_PRINT = 1,
+    /// @brief The multiplexed per-thread sampler,
+    /// variorum_get_thread_counters().
+    PMC_OWNER_SAMPLER = 2
+};
+
+/// @brief Claim the general-purpose counters for one user.
+///
+/// Both users program the same IA32_PERFEVTSELx registers, so the first to
+/// claim them keeps them for the rest of the process.
+///
+/// @param [in] owner User asking for the counters.
+///
+/// @return 0 if the counters are free or already held by owner, else -1.
+int claim_pmc(
+    enum pmc_owner owner
+);
+
 /// @brief Structure containing data of uncore performance event select
 /// counters.
 struct unc_perfevtsel
@@ -0,0 +1,205 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <config_architecture.h>
+#include <cstate_features.h>
+#include <msr_core.h>
+#include <variorum_error.h>
+
+static struct
+{
+    int init;
+    unsigned nsockets;
+    unsigned ncores;
+    int npkg;
+    int ncore;
+    /* Batched values, one row per MSR with the time stamp counter last, and
+     * one column per socket or core.
+     * */
+    uint64_t **pkg_val;
+    uint64_t **core_val;
+    /* Values of the previous sample, laid out like pkg_val and core_val. */
+    uint64_t *pkg_prev;
+    uint64_t *core_prev;
+    double prev_seconds;
+    struct variorum_cstate_residency *sockets;
+    struct variorum_cstate_residency *cores;
+} g_cstate;
+
+static int init_cstate(off_t *msrs_pkg_cstate_residency, int npkg_cstates,
+                       off_t *msrs_core_cstate_residency, int ncore_cstates, off_t msr_tsc)
+{
+    unsigned nsockets = 0;
+    unsigned ncores = 0;
+    unsigned i;
+    int j;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(&nsockets, &ncores, NULL, P_INTEL_CPU_IDX);
+#endif
+    if (npkg_cstates > VARIORUM_MAX_CSTATES || ncore_cstates > VARIORUM_MAX_CSTATES)
+    {
+        variorum_error_handler("Too many C-state residency counters",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_cstate.nsockets = nsockets;
+    g_cstate.ncores = ncores;
+    g_cstate.npkg = npkg_cstates;
+    g_cstate.ncore = ncore_cstates;
+
+    g_cstate.pkg_val = (uint64_t **) calloc((npkg_cstates + 1) * nsockets,
+                                            sizeof(uint64_t *));
+    g_cstate.core_val = (uint64_t **) calloc((ncore_cstates + 1) * ncores,
+                        sizeof(uint64_t *));
+    g_cstate.pkg_prev = (uint64_t *) calloc((npkg_cstates + 1) * nsockets,
+                                            sizeof(uint64_t));
+    g_cstate.core_prev = (uint64_t *) calloc((ncore_cstates + 1) * ncores,
+                         sizeof(uint64_t));
+    g_cstate.sockets = (struct variorum_cstate_residency *) calloc(nsockets,
+                       sizeof(struct variorum_cstate_residency));
+    g_cstate.cores = (struct variorum_cstate_residency *) calloc(ncores,
+                     sizeof(struct variorum_cstate_residency));
+    if (g_cstate.pkg_val == NULL || g_cstate.core_val == NULL ||
+        g_cstate.pkg_prev == NULL || g_cstate.core_prev == NULL ||
+        g_cstate.sockets == NULL || g_cstate.cores == NULL)
+    {
+        free(g_cstate.pkg_val);
+        free(g_cstate.core_val);
+        free(g_cstate.pkg_prev);
+        free(g_cstate.core_prev);
+        free(g_cstate.sockets);
+        free(g_cstate.cores);
+        memset(&g_cstate, 0, sizeof(g_cstate));
+        return -1;
+    }
+
+    allocate_batch(PKG_CRESIDENCY, (npkg_cstates + 1) * nsockets);
+    for (j = 0; j < npkg_cstates; j++)
+    {
+        load_socket_batch(msrs_pkg_cstate_residency[j],
+                          &g_cstate.pkg_val[j * nsockets], PKG_CRESIDENCY);
+    }
+    load_socket_batch(msr_tsc, &g_cstate.pkg_val[npkg_cstates * nsockets],
+                      PKG_CRESIDENCY);
+
+    // Core residency is a per-core MSR, so read it once per core from its
+    // first hardware thread, which is logical CPU i for core i.
+    allocate_batch(CORE_CRESIDENCY, (ncore_cstates + 1) * ncores);
+    for (i = 0; i < ncores; i++)
+    {
+        for (j = 0; j < ncore_cstates; j++)
+        {
+            create_batch_op(msrs_core_cstate_residency[j], i,
+                            &g_cstate.core_val[j * ncores + i], CORE_CRESIDENCY);
+        }
+        create_batch_op(msr_tsc, i, &g_cstate.core_val[ncore_cstates * ncores + i],
+                        CORE_CRESIDENCY);
+    }
+
+    for (i = 0; i < nsockets; i++)
+    {
+        g_cstate.sockets[i].id = (int)i;
+    }
+    for (i = 0; i < ncores; i++)
+    {
+        g_cstate.cores[i].id = (int)i;
+    }
+    g_cstate.init = 1;
+    return 0;
+}
+
+/* Turn the deltas of one column of a batch into residency percentages, and
+ * remember the new values for the next sample. Without a previous sample
+ * there is no interval, so the percentages are 0.
+ * */
+static void compute_residency(uint64_t **val, uint64_t *prev, int primed,
+                              unsigned ncols, unsigned col, int nstates,
+                              double *percent)
+{
+    uint64_t dtsc;
+    uint64_t dres;
+    double pct;
+    unsigned idx;
+    int j;
+
+    idx = nstates * ncols + col;
+    dtsc = *val[idx] - prev[idx];
+    prev[idx] = *val[idx];
+    for (j = 0; j < nstates; j++)
+    {
+        idx = j * ncols + col;
+        dres = *val[idx] - prev[idx];
+        prev[idx] = *val[idx];
+        percent[j] = 0.0;
+        if (!primed || dtsc == 0)
+        {
+            continue;
+        }
+        // The counters are not read at the same instant, so clamp the
+        // small overshoot this can cause.
+        pct = 100.0 * (double)dres / (double)dtsc;
+        percent[j] = pct > 100.0 ? 100.0 : pct;
+    }
+}
+
+int get_cstate_residency_data(struct variorum_cstate_sample *sample,
+                              off_t *msrs_pkg_cstate_residency, const int *pkg_cstates,
+                              int npkg_cstates, off_t *msrs_core_cstate_residency,
+                              const int *core_cstates, int ncore_cstates, off_t msr_tsc)
+{
+    struct timeval tv;
+    double now;
+    unsigned i;
+    int primed;
+
+    if (!g_cstate.init && init_cstate(msrs_pkg_cstate_residency, npkg_cstates,
+                                      msrs_core_cstate_residency, ncore_cstates, msr_tsc))
+    {
+        return -1;
+    }
+    if (read_batch(PKG_CRESIDENCY) || read_batch(CORE_CRESIDENCY))
+    {
+        variorum_error_handler("Batch read error", VARIORUM_ERROR_MSR_BATCH,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+    primed = g_cstate.prev_seconds > 0.0;
+    for (i = 0; i < g_cstate.nsockets; i++)
+    {
+        compute_residency(g_cstate.pkg_val, g_cstate.pkg_prev, primed,
+                          g_cstate.nsockets, i, g_cstate.npkg,
+                          g_cstate.sockets[i].percent);
+    }
+    for (i = 0; i < g_cstate.ncores; i++)
+    {
+        compute_residency(g_cstate.core_val, g_cstate.core_prev, primed,
+                          g_cstate.ncores, i, g_cstate.ncore,
+                          g_cstate.cores[i].percent);
+    }
+
+    sample->seconds = now;
+    sample->interval = primed ? now - g_cstate.prev_seconds : 0.0;
+    sample->npkg_cstates = g_cstate.npkg;
+    memcpy(sample->pkg_cstates, pkg_cstates, g_cstate.npkg * sizeof(int));
+    sample->ncore_cstates = g_cstate.ncore;
+    memcpy(sample->core_cstates, core_cstates, g_cstate.ncore * sizeof(int));
+    sample->nsockets = (int)g_cstate.nsockets;
+    sample->sockets = g_cstate.sockets;
+    sample->ncores = (int)g_cstate.ncores;
+    sample->cores = g_cstate.cores;
+    g_cstate.prev_seconds = now;
+    return 0;
+}
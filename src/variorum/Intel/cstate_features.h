@@ -0,0 +1,48 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef CSTATE_FEATURES_H_INCLUDE
+#define CSTATE_FEATURES_H_INCLUDE
+
+#include <sys/types.h>
+
+#include <variorum.h>
+
+/// @brief Sample the package and core C-state residency counters and compute
+/// the percentage of the interval since the previous call spent in each
+/// C-state.
+///
+/// The package counters and the time stamp counter are read from the first
+/// core of each socket in the PKG_CRESIDENCY batch. The core counters and the
+/// time stamp counter are read from the first hardware thread of each core in
+/// the CORE_CRESIDENCY batch.
+///
+/// @param [out] sample Filled with the per-socket and per-core residency.
+/// @param [in] msrs_pkg_cstate_residency Array of unique addresses for
+/// MSR_PKG_Cx_RESIDENCY.
+/// @param [in] pkg_cstates C-state number of each entry in
+/// msrs_pkg_cstate_residency.
+/// @param [in] npkg_cstates Number of entries in msrs_pkg_cstate_residency.
+/// @param [in] msrs_core_cstate_residency Array of unique addresses for
+/// MSR_CORE_Cx_RESIDENCY.
+/// @param [in] core_cstates C-state number of each entry in
+/// msrs_core_cstate_residency.
+/// @param [in] ncore_cstates Number of entries in
+/// msrs_core_cstate_residency.
+/// @param [in] msr_tsc Unique MSR address for IA32_TIME_STAMP_COUNTER.
+///
+/// @return 0 if successful, otherwise -1
+int get_cstate_residency_data(
+    struct variorum_cstate_sample *sample,
+    off_t *msrs_pkg_cstate_residency,
+    const int *pkg_cstates,
+    int npkg_cstates,
+    off_t *msrs_core_cstate_residency,
+    const int *core_cstates,
+    int ncore_cstates,
+    off_t msr_tsc
+);
+
+#endif
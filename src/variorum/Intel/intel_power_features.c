@@ -326,6 +326,7 @@ static void create_rapl_data_batch(struct rapl_data *rapl,
     rapl->pkg_delta_joules = (double *) calloc(nsockets, sizeof(double));
     rapl->pkg_delta_bits = (uint64_t *) calloc(nsockets, sizeof(uint64_t));
     rapl->pkg_watts = (double *) calloc(nsockets, sizeof(double));
+    rapl->pkg_total_joules = (double *) calloc(nsockets, sizeof(double));
     load_socket_batch(msr_pkg_energy_status, rapl->pkg_bits, RAPL_DATA);
 
     rapl->dram_bits = (uint64_t **) calloc(nsockets, sizeof(uint64_t *));
@@ -335,6 +336,7 @@ static void create_rapl_data_batch(struct rapl_data *rapl,
     rapl->dram_delta_joules = (double *) calloc(nsockets, sizeof(double));
     rapl->dram_delta_bits = (uint64_t *) calloc(nsockets, sizeof(uint64_t));
     rapl->dram_watts = (double *) calloc(nsockets, sizeof(double));
+    rapl->dram_total_joules = (double *) calloc(nsockets, sizeof(double));
     load_socket_batch(msr_dram_energy_status, rapl->dram_bits, RAPL_DATA);
 
     //if (*rapl_flags & PKG_PERF_STATUS)
@@ -1014,6 +1016,9 @@ int delta_rapl_data(off_t msr_rapl_unit)
         {
             rapl->pkg_watts[i] = 0.0;
             rapl->dram_watts[i] = 0.0;
+            /* Start the accumulators at the first reading of the counters. */
+            rapl->pkg_total_joules[i] = rapl->pkg_joules[i];
+            rapl->dram_total_joules[i] = rapl->dram_joules[i];
         }
         init = 1;
         rapl->elapsed = 0;
@@ -1083,6 +1088,17 @@ int delta_rapl_data(off_t msr_rapl_unit)
                                    VARIORUM_ERROR_INVAL, getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
         }
 
+        /* The 32-bit counters wrap every few hundred kJ, so accumulate the
+         * corrected deltas into a total that only grows. */
+        if (rapl->pkg_delta_joules[i] > 0)
+        {
+            rapl->pkg_total_joules[i] += rapl->pkg_delta_joules[i];
+        }
+        if (rapl->dram_delta_joules[i] > 0)
+        {
+            rapl->dram_total_joules[i] += rapl->dram_delta_joules[i];
+        }
+
         /* Get watts. */
         if (rapl->elapsed > 0.0L)
         {
@@ -1723,6 +1739,43 @@ void print_verbose_energy_data(FILE *writedest, off_t msr_rapl_unit,
     }
 }
 
+int get_socket_energy_data(off_t msr_rapl_unit, off_t msr_pkg_energy_status,
+                           off_t msr_dram_energy_status,
+                           struct variorum_socket_energy *energy)
+{
+    static struct rapl_data *rapl = NULL;
+    static double *gpu_joules = NULL;
+    unsigned nsockets = 0;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(&nsockets, NULL, NULL, P_INTEL_CPU_IDX);
+#endif
+
+    if (get_power(msr_rapl_unit, msr_pkg_energy_status, msr_dram_energy_status))
+    {
+        return -1;
+    }
+    if (rapl == NULL)
+    {
+        rapl_storage(&rapl);
+    }
+    // RAPL has no GPU domain.
+    if (gpu_joules == NULL)
+    {
+        gpu_joules = (double *) calloc(nsockets, sizeof(double));
+        if (gpu_joules == NULL)
+        {
+            return -1;
+        }
+    }
+
+    energy->nsockets = (int)nsockets;
+    energy->cpu_joules = rapl->pkg_total_joules;
+    energy->mem_joules = rapl->dram_total_joules;
+    energy->gpu_joules = gpu_joules;
+    return 0;
+}
+
 void json_get_energy_data(json_t *get_energy_obj, off_t msr_rapl_unit,
                           off_t msr_pkg_energy_status, off_t msr_dram_energy_status)
 {
@@ -11,7 +11,11 @@
 #include <stdio.h>
 #include <sys/types.h>
 
+#include <variorum.h>
+
+#ifndef UINT_MAX
 #define UINT_MAX 4294967295U // taken from limits.h
+#endif
 #define STD_ENERGY_UNIT 65536.0
 
 /// @brief Enum encompassing unit conversion types.
@@ -141,6 +145,9 @@ struct rapl_data
     /// difference in package-level energy usage by time elapsed between data
     /// measurements.
     double *pkg_watts;
+    /// @brief Package-level energy accumulated from the wrap-corrected
+    /// deltas since the first reading (in Joules).
+    double *pkg_total_joules;
     /// @brief Raw 64-bit value stored in MSR_PKG_PERF_STATUS, a package-level
     /// performance counter reporting cumulative time that the package domain
     /// has throttled due to RAPL power limits.
@@ -163,6 +170,9 @@ struct rapl_data
     /// @brief DRAM power consumption (in Watts) derived by dividing difference
     /// in DRAM energy usage by time elapsed between data measurements.
     double *dram_watts;
+    /// @brief DRAM energy accumulated from the wrap-corrected deltas since
+    /// the first reading (in Joules).
+    double *dram_total_joules;
     /// @brief Raw 64-bit value stored in MSR_DRAM_PERF_STATUS, which counts
     /// how many times DRAM performance was capped due to underlying hardware
     /// constraints.
@@ -379,6 +389,13 @@ void json_get_energy_data(
     off_t msr_dram_energy_status
 );
 
+int get_socket_energy_data(
+    off_t msr_rapl_unit,
+    off_t msr_pkg_energy_status,
+    off_t msr_dram_energy_status,
+    struct variorum_socket_energy *energy
+);
+
 #endif
 
 ///* intel_power_features.h */
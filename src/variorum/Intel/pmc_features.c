@@ -0,0 +1,380 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <config_architecture.h>
+#include <counters_features.h>
+#include <misc_features.h>
+#include <msr_core.h>
+#include <pmc_features.h>
+#include <variorum_error.h>
+
+/* Fixed-function and general-purpose counters are 48 bits wide. */
+#define CTR_MASK ((1ULL << 48) - 1)
+/* IA32_PERFEVTSELx flags: USR, OS and EN. */
+#define PMC_FLAGS_ENABLE 0x43
+
+/* State of the counters engine, shared by set_counter_events() and
+ * get_thread_counters_data().
+ * */
+static struct
+{
+    int init;
+    unsigned nthreads;
+    int navail;
+    int base_mhz;
+
+    /* Selected events; nevents is 0 until the first selection. */
+    int nevents;
+    const struct pmc_event *events[VARIORUM_MAX_COUNTER_EVENTS];
+    const char *names[VARIORUM_MAX_COUNTER_EVENTS];
+    int stall_idx;
+    int ngroups;
+
+    /* Group on the counters since group_start, or -1 if none is
+     * programmed.
+     * */
+    int group;
+    double group_start;
+    /* Length of the last interval each group was counting, 0 if it never
+     * has.
+     * */
+    double window[VARIORUM_MAX_COUNTER_EVENTS];
+
+    /* Per thread: counts of each event in its group's last window, and the
+     * fixed counters at the previous sample.
+     * */
+    double *counts;
+    uint64_t *prev_fixed;
+    double prev_seconds;
+
+    struct variorum_thread_counters *threads;
+    double *values;
+} g_pmc;
+
+static const struct pmc_event *find_event(const struct pmc_event *table,
+        int ntable, const char *name)
+{
+    int i;
+
+    for (i = 0; i < ntable; i++)
+    {
+        if (strcmp(table[i].name, name) == 0)
+        {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+static uint64_t **pmc_slot(struct pmc *p, int slot)
+{
+    switch (slot)
+    {
+        case 0:
+            return p->pmc0;
+        case 1:
+            return p->pmc1;
+        case 2:
+            return p->pmc2;
+        case 3:
+            return p->pmc3;
+        case 4:
+            return p->pmc4;
+        case 5:
+            return p->pmc5;
+        case 6:
+            return p->pmc6;
+        default:
+            return p->pmc7;
+    }
+}
+
+static int num_pmc(void)
+{
+    int avail = cpuid_num_pmc();
+
+    return avail > 8 ? 8 : avail;
+}
+
+int set_counter_events(const char **events, int nevents,
+                       const struct pmc_event *table, int ntable, const char *stall_event)
+{
+    const struct pmc_event *selected[VARIORUM_MAX_COUNTER_EVENTS];
+    int navail = num_pmc();
+    int i;
+
+    if (claim_pmc(PMC_OWNER_SAMPLER))
+    {
+        return -1;
+    }
+    if (navail == 0)
+    {
+        variorum_error_handler("No general-purpose counters available",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (events == NULL || nevents == 0)
+    {
+        events = &stall_event;
+        nevents = 1;
+    }
+    if (nevents > VARIORUM_MAX_COUNTER_EVENTS)
+    {
+        variorum_error_handler("Too many counter events", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < nevents; i++)
+    {
+        selected[i] = find_event(table, ntable, events[i]);
+        if (selected[i] == NULL)
+        {
+            variorum_error_handler("Unknown counter event", VARIORUM_ERROR_INVAL,
+                                   getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+    }
+
+    // Names point into the model's table, so they outlive the caller's list.
+    g_pmc.nevents = nevents;
+    g_pmc.stall_idx = -1;
+    for (i = 0; i < nevents; i++)
+    {
+        g_pmc.events[i] = selected[i];
+        g_pmc.names[i] = selected[i]->name;
+        if (strcmp(selected[i]->name, stall_event) == 0)
+        {
+            g_pmc.stall_idx = i;
+        }
+    }
+    g_pmc.ngroups = (nevents + navail - 1) / navail;
+    g_pmc.group = -1;
+    memset(g_pmc.window, 0, sizeof(g_pmc.window));
+    if (g_pmc.counts != NULL)
+    {
+        memset(g_pmc.counts, 0,
+               g_pmc.nthreads * VARIORUM_MAX_COUNTER_EVENTS * sizeof(double));
+    }
+    return 0;
+}
+
+static int init_engine(off_t *msrs_fixed_ctrs, off_t msr_perf_global_ctrl,
+                       off_t msr_fixed_counter_ctrl, off_t *msrs_perfevtsel_ctrs,
+                       off_t *msrs_perfmon_ctrs, off_t msr_platform_info)
+{
+    uint64_t **perf_global_ctrl = NULL;
+    unsigned nthreads = 0;
+    unsigned i;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(NULL, NULL, &nthreads, P_INTEL_CPU_IDX);
+#endif
+    if (get_max_non_turbo_ratio(msr_platform_info, &g_pmc.base_mhz))
+    {
+        variorum_error_handler("Error retrieving max non-turbo ratio",
+                               VARIORUM_ERROR_FUNCTION, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_pmc.navail = num_pmc();
+    g_pmc.counts = (double *) calloc(nthreads * VARIORUM_MAX_COUNTER_EVENTS,
+                                     sizeof(double));
+    g_pmc.values = (double *) calloc(nthreads * VARIORUM_MAX_COUNTER_EVENTS,
+                                     sizeof(double));
+    g_pmc.prev_fixed = (uint64_t *) calloc(3UL * nthreads, sizeof(uint64_t));
+    g_pmc.threads = (struct variorum_thread_counters *) calloc(nthreads,
+                    sizeof(struct variorum_thread_counters));
+    if (g_pmc.counts == NULL || g_pmc.values == NULL ||
+        g_pmc.prev_fixed == NULL || g_pmc.threads == NULL)
+    {
+        free(g_pmc.counts);
+        free(g_pmc.values);
+        free(g_pmc.prev_fixed);
+        free(g_pmc.threads);
+        g_pmc.counts = g_pmc.values = NULL;
+        g_pmc.prev_fixed = NULL;
+        g_pmc.threads = NULL;
+        return -1;
+    }
+    g_pmc.nthreads = nthreads;
+
+    enable_fixed_counters(msrs_fixed_ctrs, msr_perf_global_ctrl,
+                          msr_fixed_counter_ctrl);
+    perfevtsel_storage(NULL, msrs_perfevtsel_ctrs);
+    pmc_storage(NULL, msrs_perfmon_ctrs);
+
+    // enable_fixed_counters() only sets the fixed-counter bits of
+    // IA32_PERF_GLOBAL_CTRL; the general-purpose ones are bits 0 to n-1.
+    fixed_counter_ctrl_storage(&perf_global_ctrl, NULL, msr_perf_global_ctrl,
+                               msr_fixed_counter_ctrl);
+    read_batch(FIXED_COUNTERS_CTRL_DATA);
+    for (i = 0; i < nthreads; i++)
+    {
+        *perf_global_ctrl[i] |= (1ULL << g_pmc.navail) - 1;
+    }
+    write_batch(FIXED_COUNTERS_CTRL_DATA);
+    g_pmc.init = 1;
+    return 0;
+}
+
+/* Put group g on the counters of every thread and clear them. */
+static void program_group(int g, off_t *msrs_perfevtsel_ctrs,
+                          off_t *msrs_perfmon_ctrs)
+{
+    const struct pmc_event *e;
+    unsigned i;
+    int slot;
+    int idx;
+
+    for (i = 0; i < g_pmc.nthreads; i++)
+    {
+        for (slot = 0; slot < g_pmc.navail; slot++)
+        {
+            idx = g * g_pmc.navail + slot;
+            if (idx >= g_pmc.nevents)
+            {
+                set_pmc_ctrl_flags(0, 0, 0, 0, slot + 1, i, msrs_perfevtsel_ctrs);
+                continue;
+            }
+            e = g_pmc.events[idx];
+            set_pmc_ctrl_flags(e->cmask, PMC_FLAGS_ENABLE | e->flags, e->umask,
+                               e->eventsel, slot + 1, i, msrs_perfevtsel_ctrs);
+        }
+    }
+    write_batch(COUNTERS_CTRL);
+    clear_all_pmc(msrs_perfmon_ctrs);
+    g_pmc.group = g;
+}
+
+int get_thread_counters_data(struct variorum_thread_counters_sample *sample,
+                             const struct pmc_event *table, int ntable, const char *stall_event,
+                             off_t *msrs_fixed_ctrs, off_t msr_perf_global_ctrl,
+                             off_t msr_fixed_counter_ctrl, off_t *msrs_perfevtsel_ctrs,
+                             off_t *msrs_perfmon_ctrs, off_t msr_platform_info)
+{
+    struct fixed_counter *c0, *c1, *c2;
+    struct variorum_thread_counters *t;
+    struct pmc *p;
+    struct timeval tv;
+    double now;
+    double interval;
+    uint64_t d_instr, d_clk, d_ref;
+    unsigned i;
+    int g, slot, idx, e;
+
+    if (claim_pmc(PMC_OWNER_SAMPLER))
+    {
+        return -1;
+    }
+    if (!g_pmc.init && init_engine(msrs_fixed_ctrs, msr_perf_global_ctrl,
+                                   msr_fixed_counter_ctrl, msrs_perfevtsel_ctrs, msrs_perfmon_ctrs,
+                                   msr_platform_info))
+    {
+        return -1;
+    }
+    if (g_pmc.nevents == 0 &&
+        set_counter_events(NULL, 0, table, ntable, stall_event))
+    {
+        return -1;
+    }
+    fixed_counter_storage(&c0, &c1, &c2, msrs_fixed_ctrs);
+    pmc_storage(&p, msrs_perfmon_ctrs);
+
+    if (read_batch(FIXED_COUNTERS_DATA) || read_batch(COUNTERS_DATA))
+    {
+        variorum_error_handler("Batch read error", VARIORUM_ERROR_MSR_BATCH,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1000000.0;
+    interval = g_pmc.prev_seconds > 0.0 ? now - g_pmc.prev_seconds : 0.0;
+
+    // Keep what the group on the counters saw, so that later intervals can
+    // be extrapolated from it while other groups take their turn.
+    g = g_pmc.group;
+    if (g >= 0)
+    {
+        g_pmc.window[g] = now - g_pmc.group_start;
+        for (i = 0; i < g_pmc.nthreads; i++)
+        {
+            for (slot = 0; slot < g_pmc.navail; slot++)
+            {
+                idx = g * g_pmc.navail + slot;
+                if (idx >= g_pmc.nevents)
+                {
+                    break;
+                }
+                g_pmc.counts[i * VARIORUM_MAX_COUNTER_EVENTS + idx] =
+                    (double)(*pmc_slot(p, slot)[i] & CTR_MASK);
+            }
+        }
+    }
+
+    for (i = 0; i < g_pmc.nthreads; i++)
+    {
+        t = &g_pmc.threads[i];
+        memset(t, 0, sizeof(struct variorum_thread_counters));
+        t->cpu = (int)i;
+        t->events = &g_pmc.values[i * VARIORUM_MAX_COUNTER_EVENTS];
+        if (interval > 0.0)
+        {
+            d_instr = (*c0->value[i] - g_pmc.prev_fixed[3 * i]) & CTR_MASK;
+            d_clk = (*c1->value[i] - g_pmc.prev_fixed[3 * i + 1]) & CTR_MASK;
+            d_ref = (*c2->value[i] - g_pmc.prev_fixed[3 * i + 2]) & CTR_MASK;
+            t->instructions = (double)d_instr;
+            t->cycles = (double)d_clk;
+            t->ref_cycles = (double)d_ref;
+            if (d_clk > 0)
+            {
+                t->ipc = (double)d_instr / d_clk;
+            }
+            if (d_ref > 0)
+            {
+                t->freq_mhz = g_pmc.base_mhz * ((double)d_clk / d_ref);
+            }
+        }
+        for (e = 0; e < g_pmc.nevents; e++)
+        {
+            g = e / g_pmc.navail;
+            t->events[e] = 0.0;
+            if (interval > 0.0 && g_pmc.window[g] > 0.0)
+            {
+                t->events[e] = g_pmc.counts[i * VARIORUM_MAX_COUNTER_EVENTS + e] *
+                               (interval / g_pmc.window[g]);
+            }
+        }
+        if (g_pmc.stall_idx >= 0 && t->cycles > 0.0)
+        {
+            t->mem_bound_ratio = t->events[g_pmc.stall_idx] / t->cycles;
+        }
+        g_pmc.prev_fixed[3 * i] = *c0->value[i];
+        g_pmc.prev_fixed[3 * i + 1] = *c1->value[i];
+        g_pmc.prev_fixed[3 * i + 2] = *c2->value[i];
+    }
+
+    // The next group takes over the counters; a single group is simply
+    // cleared so that each window starts from zero.
+    program_group(g_pmc.group < 0 ? 0 : (g_pmc.group + 1) % g_pmc.ngroups,
+                  msrs_perfevtsel_ctrs, msrs_perfmon_ctrs);
+    g_pmc.group_start = now;
+    g_pmc.prev_seconds = now;
+
+    sample->seconds = now;
+    sample->interval = interval;
+    sample->nthreads = (int)g_pmc.nthreads;
+    sample->nevents = g_pmc.nevents;
+    sample->ngroups = g_pmc.ngroups;
+    sample->event_names = g_pmc.names;
+    sample->threads = g_pmc.threads;
+    return 0;
+}
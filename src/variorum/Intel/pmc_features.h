@@ -0,0 +1,90 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef PMC_FEATURES_H_INCLUDE
+#define PMC_FEATURES_H_INCLUDE
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <variorum.h>
+
+/// @brief Encoding of one programmable event in IA32_PERFEVTSELx.
+struct pmc_event
+{
+    /// @brief Event name, as in the Intel SDM.
+    const char *name;
+    /// @brief Event select field [7:0].
+    uint64_t eventsel;
+    /// @brief Unit mask field [15:8].
+    uint64_t umask;
+    /// @brief Counter mask field [31:24].
+    uint64_t cmask;
+    /// @brief Edge detect and invert bits of the flags field [23:16]. The
+    /// USR, OS and EN bits are always set.
+    uint64_t flags;
+};
+
+/// @brief Choose the programmable events sampled by
+/// get_thread_counters_data().
+///
+/// The events only take effect at the next sample, which programs the first
+/// group of events and reports no counts for them.
+///
+/// @param [in] events Event names, or NULL for the default list.
+/// @param [in] nevents Number of event names, 0 for the default list.
+/// @param [in] table Events supported by the model.
+/// @param [in] ntable Number of entries in table.
+/// @param [in] stall_event Name of the event counting cycles stalled on
+/// memory, which is the default list.
+///
+/// @return 0 if successful, otherwise -1
+int set_counter_events(
+    const char **events,
+    int nevents,
+    const struct pmc_event *table,
+    int ntable,
+    const char *stall_event
+);
+
+/// @brief Sample the fixed and programmable counters of every hardware
+/// thread and compute deltas over the interval since the previous call.
+///
+/// The events are split into groups of as many events as there are
+/// general-purpose counters (CPUID.0AH:EAX[15:8]). Each call reads the
+/// group that was counting, then programs the next group and clears the
+/// counters. An event is reported as its count in the last interval its group
+/// was counting, scaled to the length of the current interval.
+///
+/// @param [out] sample Filled with the per-thread counters.
+/// @param [in] table Events supported by the model.
+/// @param [in] ntable Number of entries in table.
+/// @param [in] stall_event Name of the event counting cycles stalled on
+/// memory, used for the memory-bound ratio.
+/// @param [in] msrs_fixed_ctrs Array of unique addresses for fixed counters.
+/// @param [in] msr_perf_global_ctrl Unique MSR address for
+/// IA32_PERF_GLOBAL_CTRL.
+/// @param [in] msr_fixed_counter_ctrl Unique MSR address for
+/// IA32_FIXED_CTR_CTRL.
+/// @param [in] msrs_perfevtsel_ctrs Array of unique addresses for
+/// IA32_PERFEVTSELx.
+/// @param [in] msrs_perfmon_ctrs Array of unique addresses for IA32_PMCx.
+/// @param [in] msr_platform_info Unique MSR address for MSR_PLATFORM_INFO.
+///
+/// @return 0 if successful, otherwise -1
+int get_thread_counters_data(
+    struct variorum_thread_counters_sample *sample,
+    const struct pmc_event *table,
+    int ntable,
+    const char *stall_event,
+    off_t *msrs_fixed_ctrs,
+    off_t msr_perf_global_ctrl,
+    off_t msr_fixed_counter_ctrl,
+    off_t *msrs_perfevtsel_ctrs,
+    off_t *msrs_perfmon_ctrs,
+    off_t msr_platform_info
+);
+
+#endif
@@ -450,6 +450,86 @@ int get_therm_temp_reading_json(json_t *get_thermal_object,
     return 0;
 }
 
+int get_socket_thermals_data(struct variorum_socket_thermals *thermals,
+                             off_t msr_therm_stat, off_t msr_pkg_therm_stat,
+                             off_t msr_temp_target)
+{
+    static struct therm_stat *t_stat = NULL;
+    static struct msr_temp_target *t_target = NULL;
+    static struct pkg_therm_stat *pkg_stat = NULL;
+    static double *pkg_celsius = NULL;
+    static double *core_celsius = NULL;
+    unsigned i, j, k;
+    unsigned nsockets = 0;
+    unsigned ncores = 0;
+    unsigned nthreads = 0;
+    unsigned cores_per_socket;
+    unsigned threads_per_core;
+    unsigned idx;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(&nsockets, &ncores, &nthreads, P_INTEL_CPU_IDX);
+#endif
+    if (nsockets == 0 || ncores == 0)
+    {
+        return -1;
+    }
+    cores_per_socket = ncores / nsockets;
+    threads_per_core = nthreads / ncores;
+
+    if (t_stat == NULL)
+    {
+        t_stat = (struct therm_stat *) malloc(nthreads * sizeof(struct therm_stat));
+        t_target = (struct msr_temp_target *) malloc(nsockets * sizeof(
+                       struct msr_temp_target));
+        pkg_stat = (struct pkg_therm_stat *) malloc(nsockets * sizeof(
+                       struct pkg_therm_stat));
+        pkg_celsius = (double *) malloc(nsockets * sizeof(double));
+        core_celsius = (double *) malloc(ncores * sizeof(double));
+        if (t_stat == NULL || t_target == NULL || pkg_stat == NULL ||
+            pkg_celsius == NULL || core_celsius == NULL)
+        {
+            free(t_stat);
+            free(t_target);
+            free(pkg_stat);
+            free(pkg_celsius);
+            free(core_celsius);
+            t_stat = NULL;
+            t_target = NULL;
+            pkg_stat = NULL;
+            pkg_celsius = NULL;
+            core_celsius = NULL;
+            return -1;
+        }
+    }
+
+    get_pkg_therm_stat(pkg_stat, msr_pkg_therm_stat);
+    get_temp_target(t_target, msr_temp_target);
+    get_therm_stat(t_stat, msr_therm_stat);
+
+    for (i = 0; i < nsockets; i++)
+    {
+        pkg_celsius[i] = (int)t_target[i].temp_target - pkg_stat[i].readout;
+        for (j = 0; j < cores_per_socket; j++)
+        {
+            core_celsius[i * cores_per_socket + j] = 0.0;
+            for (k = 0; k < threads_per_core; k++)
+            {
+                idx = (k * nsockets * cores_per_socket) + (i * cores_per_socket) + j;
+                core_celsius[i * cores_per_socket + j] += (int)t_target[i].temp_target -
+                        t_stat[idx].readout;
+            }
+            core_celsius[i * cores_per_socket + j] /= threads_per_core;
+        }
+    }
+
+    thermals->nsockets = (int)nsockets;
+    thermals->cores_per_socket = (int)cores_per_socket;
+    thermals->pkg_celsius = pkg_celsius;
+    thermals->core_celsius = core_celsius;
+    return 0;
+}
+
 ///// @brief Initialize storage for IA32_THERM_INTERRUPT.
 /////
 ///// @param [out] ti Data for per-core thermal interrupts.
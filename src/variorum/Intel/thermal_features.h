@@ -8,6 +8,8 @@
 
 #include <jansson.h>
 
+#include <config_architecture.h>
+
 /// @brief Structure containing data from MSR_TEMPERATURE_TARGET.
 ///
 /// The scope of this MSR is defined as unique for Sandy Bridge. In our
@@ -296,6 +298,22 @@ int get_therm_temp_reading_json(
     off_t msr_temp_target
 );
 
+/// @brief Read the package temperature of each socket and the temperature of
+/// each core, averaged over its hardware threads.
+///
+/// @param [out] thermals Filled with pointers to the temperatures.
+/// @param [in] msr_therm_stat Unique MSR address for IA32_THERM_STATUS.
+/// @param [in] msr_pkg_therm_stat Unique MSR address for IA32_PACKAGE_THERM_STATUS.
+/// @param [in] msr_temp_target Unique MSR address for TEMPERATURE_TARGET.
+///
+/// @return 0 if successful, otherwise -1
+int get_socket_thermals_data(
+    struct variorum_socket_thermals *thermals,
+    off_t msr_therm_stat,
+    off_t msr_pkg_therm_stat,
+    off_t msr_temp_target
+);
+
 /// @brief Read value of the IA32_PACKAGE_THERM_STATUS register and translate
 /// bit fields to human-readable values.
 ///
@@ -0,0 +1,367 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <config_architecture.h>
+#include <misc_features.h>
+#include <msr_core.h>
+#include <uncore_features.h>
+#include <variorum_error.h>
+
+/* Uncore counters are 48 bits wide. */
+#define UNC_CTR_MASK ((1ULL << 48) - 1)
+/* Enable bit of the PCU, U-box and CHA PMON_CTL registers. */
+#define UNC_CTL_EN (1ULL << 22)
+/* Registers of consecutive CHAs are this far apart. */
+#define CHA_MSR_STRIDE 0x10
+/* Upper bound on the CHAs of one socket. */
+#define CHA_MAX 64
+/* Each CHA request moves one cache line. */
+#define CACHE_LINE_BYTES 64.0
+/* PCU counters left for events once PCU clock cycles take counter 0. */
+#define PCU_EVENTS_PER_GROUP 3
+
+/* Position of each register in the control and data batches. Every entry
+ * holds one value per socket.
+ * */
+#define CTL_FILTER      0
+#define CTL_PCU(k)      (1 + (k))
+#define CTL_UBOX        5
+#define CTL_CHA(i, k)   (6 + 2 * (i) + (k))
+#define DATA_PCU(k)     (k)
+#define DATA_UBOX       4
+#define DATA_CHA(i, k)  (5 + 2 * (i) + (k))
+
+static struct
+{
+    int init;
+    unsigned nsockets;
+    unsigned ncha;
+    unsigned nctl;
+    unsigned ndata;
+    uint64_t **ctl;
+    uint64_t **data;
+
+    /* PCU events other than clock cycles, in the order they are grouped. */
+    int pcu_events[UNC_NUM_EVENTS];
+    int npcu;
+    int ngroups;
+    /* Group on the PCU counters since the previous sample, or -1. */
+    int group;
+    /* Length of the last interval each group was counting. */
+    double window[UNC_NUM_EVENTS];
+    /* Per socket: counts of each event and PCU clock cycles of each group
+     * in the group's last window.
+     * */
+    double *counts;
+    double *clk;
+
+    double band_mhz[VARIORUM_UNCORE_FREQ_BANDS];
+    double prev_seconds;
+    struct variorum_uncore_socket *sockets;
+} g_unc;
+
+static uint64_t *ctl_val(unsigned reg, unsigned socket)
+{
+    return g_unc.ctl[reg * g_unc.nsockets + socket];
+}
+
+static uint64_t data_val(unsigned reg, unsigned socket)
+{
+    return *g_unc.data[reg * g_unc.nsockets + socket] & UNC_CTR_MASK;
+}
+
+/* Number of CHAs per socket. The count is fused per SKU in CAPID6, which is
+ * in PCI configuration space and can differ from the number of cores, so it
+ * is taken from the kernel's uncore PMU, which registers one uncore_cha_<n>
+ * device per CHA. Returns 0 if that driver is not loaded.
+ * */
+static unsigned count_cha(void)
+{
+    char path[64];
+    unsigned n;
+
+    for (n = 0; n < CHA_MAX; n++)
+    {
+        snprintf(path, sizeof(path),
+                 "/sys/bus/event_source/devices/uncore_cha_%u", n);
+        if (access(path, F_OK) != 0)
+        {
+            break;
+        }
+    }
+    return n;
+}
+
+static int init_uncore(const struct uncore_event *events,
+                       off_t *msrs_pcu_pmon_evtsel, off_t *msrs_pcu_pmon_ctrs,
+                       off_t msr_pcu_pmon_box_filter, off_t msr_ubox_pmon_fixed_ctl,
+                       off_t msr_ubox_pmon_fixed_ctr, off_t msr_cha_pmon_ctl0,
+                       off_t msr_cha_pmon_ctr0, off_t msr_platform_info)
+{
+    unsigned nsockets = 0;
+    unsigned i, k;
+    int base_mhz, eff_mhz;
+    int e;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(&nsockets, NULL, NULL, P_INTEL_CPU_IDX);
+#endif
+    if (get_max_non_turbo_ratio(msr_platform_info, &base_mhz) ||
+        get_max_efficiency_ratio(msr_platform_info, &eff_mhz))
+    {
+        variorum_error_handler("Error retrieving frequency ratios",
+                               VARIORUM_ERROR_FUNCTION, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_unc.band_mhz[0] = eff_mhz;
+    g_unc.band_mhz[1] = ((eff_mhz + base_mhz) / 200) * 100;
+    g_unc.band_mhz[2] = base_mhz;
+    g_unc.band_mhz[3] = base_mhz + 100;
+
+    g_unc.nsockets = nsockets;
+    g_unc.ncha = 0;
+    if (nsockets > 0 && msr_cha_pmon_ctl0 != 0 &&
+        events[UNC_CHA_READS].name != NULL)
+    {
+        g_unc.ncha = count_cha();
+    }
+    g_unc.nctl = CTL_CHA(g_unc.ncha, 0);
+    g_unc.ndata = DATA_CHA(g_unc.ncha, 0);
+
+    g_unc.npcu = 0;
+    for (e = UNC_PCU_FREQ_BAND0; e <= UNC_PCU_FREQ_MAX_THERMAL; e++)
+    {
+        if (events[e].name != NULL)
+        {
+            g_unc.pcu_events[g_unc.npcu++] = e;
+        }
+    }
+    g_unc.ngroups = (g_unc.npcu + PCU_EVENTS_PER_GROUP - 1) /
+                    PCU_EVENTS_PER_GROUP;
+    if (g_unc.ngroups == 0)
+    {
+        g_unc.ngroups = 1;
+    }
+    g_unc.group = -1;
+
+    g_unc.ctl = (uint64_t **) calloc(g_unc.nctl * nsockets, sizeof(uint64_t *));
+    g_unc.data = (uint64_t **) calloc(g_unc.ndata * nsockets, sizeof(uint64_t *));
+    g_unc.counts = (double *) calloc(nsockets * UNC_NUM_EVENTS, sizeof(double));
+    g_unc.clk = (double *) calloc(nsockets * UNC_NUM_EVENTS, sizeof(double));
+    g_unc.sockets = (struct variorum_uncore_socket *) calloc(nsockets,
+                    sizeof(struct variorum_uncore_socket));
+    if (g_unc.ctl == NULL || g_unc.data == NULL || g_unc.counts == NULL ||
+        g_unc.clk == NULL || g_unc.sockets == NULL)
+    {
+        free(g_unc.ctl);
+        free(g_unc.data);
+        free(g_unc.counts);
+        free(g_unc.clk);
+        free(g_unc.sockets);
+        memset(&g_unc, 0, sizeof(g_unc));
+        return -1;
+    }
+
+    allocate_batch(UNCORE_PMON_CTRL, g_unc.nctl * nsockets);
+    allocate_batch(UNCORE_PMON_DATA, g_unc.ndata * nsockets);
+    load_socket_batch(msr_pcu_pmon_box_filter, &g_unc.ctl[CTL_FILTER * nsockets],
+                      UNCORE_PMON_CTRL);
+    for (k = 0; k < 4; k++)
+    {
+        load_socket_batch(msrs_pcu_pmon_evtsel[k], &g_unc.ctl[CTL_PCU(k) * nsockets],
+                          UNCORE_PMON_CTRL);
+        load_socket_batch(msrs_pcu_pmon_ctrs[k], &g_unc.data[DATA_PCU(k) * nsockets],
+                          UNCORE_PMON_DATA);
+    }
+    load_socket_batch(msr_ubox_pmon_fixed_ctl, &g_unc.ctl[CTL_UBOX * nsockets],
+                      UNCORE_PMON_CTRL);
+    load_socket_batch(msr_ubox_pmon_fixed_ctr, &g_unc.data[DATA_UBOX * nsockets],
+                      UNCORE_PMON_DATA);
+    for (i = 0; i < g_unc.ncha; i++)
+    {
+        for (k = 0; k < 2; k++)
+        {
+            load_socket_batch(msr_cha_pmon_ctl0 + i * CHA_MSR_STRIDE + k,
+                              &g_unc.ctl[CTL_CHA(i, k) * nsockets], UNCORE_PMON_CTRL);
+            load_socket_batch(msr_cha_pmon_ctr0 + i * CHA_MSR_STRIDE + k,
+                              &g_unc.data[DATA_CHA(i, k) * nsockets], UNCORE_PMON_DATA);
+        }
+    }
+    g_unc.init = 1;
+    return 0;
+}
+
+/* Program PCU group g along with the U-box and CHA counters on every socket,
+ * and clear all counters.
+ * */
+static void program_group(const struct uncore_event *events, int g)
+{
+    const struct uncore_event *e;
+    uint64_t filter = 0;
+    unsigned s, i, k;
+    int idx;
+
+    for (k = 0; k < VARIORUM_UNCORE_FREQ_BANDS; k++)
+    {
+        filter |= ((uint64_t)(g_unc.band_mhz[k] / 100) & 0xFF) << (8 * k);
+    }
+    for (s = 0; s < g_unc.nsockets; s++)
+    {
+        *ctl_val(CTL_FILTER, s) = filter;
+        *ctl_val(CTL_PCU(0), s) = UNC_CTL_EN | events[UNC_PCU_CLOCKTICKS].event;
+        for (k = 1; k < 4; k++)
+        {
+            idx = g * PCU_EVENTS_PER_GROUP + (int)k - 1;
+            *ctl_val(CTL_PCU(k), s) = 0;
+            if (idx < g_unc.npcu)
+            {
+                e = &events[g_unc.pcu_events[idx]];
+                *ctl_val(CTL_PCU(k), s) = UNC_CTL_EN | (e->umask << 8) | e->event;
+            }
+        }
+        *ctl_val(CTL_UBOX, s) = UNC_CTL_EN;
+        for (i = 0; i < g_unc.ncha; i++)
+        {
+            e = &events[UNC_CHA_READS];
+            *ctl_val(CTL_CHA(i, 0), s) = UNC_CTL_EN | (e->umask << 8) | e->event;
+            e = &events[UNC_CHA_WRITES];
+            *ctl_val(CTL_CHA(i, 1), s) = UNC_CTL_EN | (e->umask << 8) | e->event;
+        }
+    }
+    write_batch(UNCORE_PMON_CTRL);
+
+    for (i = 0; i < g_unc.ndata * g_unc.nsockets; i++)
+    {
+        *g_unc.data[i] = 0;
+    }
+    write_batch(UNCORE_PMON_DATA);
+    g_unc.group = g;
+}
+
+int get_uncore_counters_data(struct variorum_uncore_sample *sample,
+                             const struct uncore_event *events, off_t *msrs_pcu_pmon_evtsel,
+                             off_t *msrs_pcu_pmon_ctrs, off_t msr_pcu_pmon_box_filter,
+                             off_t msr_ubox_pmon_fixed_ctl, off_t msr_ubox_pmon_fixed_ctr,
+                             off_t msr_cha_pmon_ctl0, off_t msr_cha_pmon_ctr0,
+                             off_t msr_platform_info)
+{
+    struct variorum_uncore_socket *u;
+    struct timeval tv;
+    double now;
+    double interval;
+    double reads, writes;
+    double scale, clk;
+    unsigned s, i;
+    int g, k, idx, e;
+
+    if (!g_unc.init && init_uncore(events, msrs_pcu_pmon_evtsel,
+                                   msrs_pcu_pmon_ctrs, msr_pcu_pmon_box_filter, msr_ubox_pmon_fixed_ctl,
+                                   msr_ubox_pmon_fixed_ctr, msr_cha_pmon_ctl0, msr_cha_pmon_ctr0,
+                                   msr_platform_info))
+    {
+        return -1;
+    }
+    if (read_batch(UNCORE_PMON_DATA))
+    {
+        variorum_error_handler("Batch read error", VARIORUM_ERROR_MSR_BATCH,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1000000.0;
+    interval = g_unc.prev_seconds > 0.0 ? now - g_unc.prev_seconds : 0.0;
+
+    g = g_unc.group;
+    if (g >= 0)
+    {
+        g_unc.window[g] = interval;
+        for (s = 0; s < g_unc.nsockets; s++)
+        {
+            g_unc.clk[s * UNC_NUM_EVENTS + g] = (double)data_val(DATA_PCU(0), s);
+            for (k = 1; k < 4; k++)
+            {
+                idx = g * PCU_EVENTS_PER_GROUP + k - 1;
+                if (idx < g_unc.npcu)
+                {
+                    g_unc.counts[s * UNC_NUM_EVENTS + g_unc.pcu_events[idx]] =
+                        (double)data_val(DATA_PCU(k), s);
+                }
+            }
+        }
+    }
+
+    for (s = 0; s < g_unc.nsockets; s++)
+    {
+        u = &g_unc.sockets[s];
+        memset(u, 0, sizeof(struct variorum_uncore_socket));
+        memcpy(u->band_mhz, g_unc.band_mhz, sizeof(u->band_mhz));
+        if (g < 0 || interval <= 0.0)
+        {
+            continue;
+        }
+
+        // The U-box and CHA counters count every interval.
+        u->uncore_freq_mhz = data_val(DATA_UBOX, s) / interval / 1000000.0;
+        reads = writes = 0.0;
+        for (i = 0; i < g_unc.ncha; i++)
+        {
+            reads += (double)data_val(DATA_CHA(i, 0), s);
+            writes += (double)data_val(DATA_CHA(i, 1), s);
+        }
+        u->mem_read_bytes_per_sec = reads * CACHE_LINE_BYTES / interval;
+        u->mem_write_bytes_per_sec = writes * CACHE_LINE_BYTES / interval;
+        u->pcu_cycles = g_unc.clk[s * UNC_NUM_EVENTS + g];
+
+        // Residencies are ratios within the window of the event's group;
+        // cycle counts are scaled from that window to this interval.
+        for (idx = 0; idx < g_unc.npcu; idx++)
+        {
+            e = g_unc.pcu_events[idx];
+            k = idx / PCU_EVENTS_PER_GROUP;
+            clk = g_unc.clk[s * UNC_NUM_EVENTS + k];
+            if (g_unc.window[k] <= 0.0 || clk <= 0.0)
+            {
+                continue;
+            }
+            scale = interval / g_unc.window[k];
+            switch (e)
+            {
+                case UNC_PCU_FREQ_BAND0:
+                case UNC_PCU_FREQ_BAND1:
+                case UNC_PCU_FREQ_BAND2:
+                case UNC_PCU_FREQ_BAND3:
+                    u->band_residency[e - UNC_PCU_FREQ_BAND0] =
+                        g_unc.counts[s * UNC_NUM_EVENTS + e] / clk;
+                    break;
+                case UNC_PCU_FREQ_MAX_POWER:
+                    u->power_limit_cycles = g_unc.counts[s * UNC_NUM_EVENTS + e] * scale;
+                    break;
+                case UNC_PCU_FREQ_MAX_THERMAL:
+                    u->thermal_limit_cycles = g_unc.counts[s * UNC_NUM_EVENTS + e] * scale;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    program_group(events, g < 0 ? 0 : (g + 1) % g_unc.ngroups);
+    g_unc.prev_seconds = now;
+
+    sample->seconds = now;
+    sample->interval = interval;
+    sample->nsockets = (int)g_unc.nsockets;
+    sample->ngroups = g_unc.ngroups;
+    sample->sockets = g_unc.sockets;
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef UNCORE_FEATURES_H_INCLUDE
+#define UNCORE_FEATURES_H_INCLUDE
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <variorum.h>
+
+/// @brief Role of each entry in a model's uncore event table.
+enum uncore_event_id
+{
+    /// @brief PCU clock cycles.
+    UNC_PCU_CLOCKTICKS,
+    /// @brief PCU cycles with the cores at or above band 0.
+    UNC_PCU_FREQ_BAND0,
+    /// @brief PCU cycles with the cores at or above band 1.
+    UNC_PCU_FREQ_BAND1,
+    /// @brief PCU cycles with the cores at or above band 2.
+    UNC_PCU_FREQ_BAND2,
+    /// @brief PCU cycles with the cores at or above band 3.
+    UNC_PCU_FREQ_BAND3,
+    /// @brief PCU cycles with the frequency capped by the power limit.
+    UNC_PCU_FREQ_MAX_POWER,
+    /// @brief PCU cycles with the frequency capped by a thermal limit.
+    UNC_PCU_FREQ_MAX_THERMAL,
+    /// @brief Memory read requests seen by a CHA.
+    UNC_CHA_READS,
+    /// @brief Memory write requests seen by a CHA.
+    UNC_CHA_WRITES,
+    /// @brief Number of entries in an uncore event table.
+    UNC_NUM_EVENTS
+};
+
+/// @brief Encoding of one uncore event in its PMON_CTLx register.
+struct uncore_event
+{
+    /// @brief Event name, as in the Intel uncore performance monitoring
+    /// guide, or NULL if the model does not have the event.
+    const char *name;
+    /// @brief Event select field [7:0].
+    uint64_t event;
+    /// @brief Unit mask field [15:8].
+    uint64_t umask;
+};
+
+/// @brief Sample the PCU, U-box and CHA counters of every socket and
+/// compute deltas and derived metrics over the interval since the previous
+/// call.
+///
+/// All sockets are read with one batch. The PCU frequency band, power limit
+/// and thermal limit events share the four PCU counters in groups of three,
+/// each with PCU clock cycles on the first counter; one group counts per
+/// interval and the others are extrapolated from the last interval they
+/// counted.
+///
+/// @param [out] sample Filled with the per-socket uncore activity.
+/// @param [in] events Uncore event table of the model, indexed by enum
+/// uncore_event_id.
+/// @param [in] msrs_pcu_pmon_evtsel Array of unique addresses for
+/// PCU_MSR_PMON_CTLx.
+/// @param [in] msrs_pcu_pmon_ctrs Array of unique addresses for
+/// PCU_MSR_PMON_CTRx.
+/// @param [in] msr_pcu_pmon_box_filter Unique MSR address for
+/// PCU_MSR_PMON_BOX_FILTER.
+/// @param [in] msr_ubox_pmon_fixed_ctl Unique MSR address for
+/// U_MSR_PMON_UCLK_FIXED_CTL.
+/// @param [in] msr_ubox_pmon_fixed_ctr Unique MSR address for
+/// U_MSR_PMON_UCLK_FIXED_CTR.
+/// @param [in] msr_cha_pmon_ctl0 Unique MSR address for CHA 0's
+/// PMON_CTL0, or 0 if the model has no CHA counters in MSR space.
+/// @param [in] msr_cha_pmon_ctr0 Unique MSR address for CHA 0's
+/// PMON_CTR0.
+/// @param [in] msr_platform_info Unique MSR address for MSR_PLATFORM_INFO.
+///
+/// @return 0 if successful, otherwise -1
+int get_uncore_counters_data(
+    struct variorum_uncore_sample *sample,
+    const struct uncore_event *events,
+    off_t *msrs_pcu_pmon_evtsel,
+    off_t *msrs_pcu_pmon_ctrs,
+    off_t msr_pcu_pmon_box_filter,
+    off_t msr_ubox_pmon_fixed_ctl,
+    off_t msr_ubox_pmon_fixed_ctr,
+    off_t msr_cha_pmon_ctl0,
+    off_t msr_cha_pmon_ctr0,
+    off_t msr_platform_info
+);
+
+#endif
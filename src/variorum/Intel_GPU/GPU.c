@@ -71,16 +71,18 @@ int intel_gpu_cap_each_gpu_power_limit(unsigned int powerlimit)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    unsigned iter = 0;
-    unsigned nsockets;
-#ifdef VARIORUM_WITH_INTEL_GPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_INTEL_GPU_IDX);
-#endif
-    for (iter = 0; iter < nsockets; iter++)
+    return cap_each_gpu_power_limit(powerlimit);
+}
+
+int intel_gpu_cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
     {
-        cap_each_gpu_power_limit(iter, powerlimit);
+        printf("Running %s\n", __FUNCTION__);
     }
-    return 0;
+
+    return cap_gpu_power_limits(ngpus, gpu_power_limits);
 }
 
 int intel_gpu_get_power_limit(int long_ver)
@@ -99,3 +101,14 @@ int intel_gpu_get_power_limit(int long_ver)
     }
     return 0;
 }
+
+int intel_gpu_get_gpu_energy(struct variorum_gpu_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return get_gpu_energy_data(energy);
+}
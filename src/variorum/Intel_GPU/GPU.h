@@ -6,6 +6,8 @@
 #ifndef INTEL_GPU_H_INCLUDE
 #define INTEL_GPU_H_INCLUDE
 
+#include <variorum.h>
+
 extern int intel_gpu_get_power(
     int long_ver
 );
@@ -22,8 +24,17 @@ extern int intel_gpu_cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+extern int intel_gpu_cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 extern int intel_gpu_get_power_limit(
     int long_ver
 );
 
+extern int intel_gpu_get_gpu_energy(
+    struct variorum_gpu_energy *energy
+);
+
 #endif
@@ -8,6 +8,7 @@
 
 #include <config_intel_gpu.h>
 #include <config_architecture.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
 
 uint64_t *detect_intel_gpu_arch(void)
@@ -28,13 +29,16 @@ int set_intel_gpu_func_ptrs(int idx)
         g_platform[idx].variorum_print_frequency = intel_gpu_get_clocks;
         g_platform[idx].variorum_cap_each_gpu_power_limit =
             intel_gpu_cap_each_gpu_power_limit;
+        g_platform[idx].variorum_cap_gpu_power_limits =
+            intel_gpu_cap_gpu_power_limits;
         g_platform[idx].variorum_print_power_limit = intel_gpu_get_power_limit;
+        g_platform[idx].variorum_get_gpu_energy = intel_gpu_get_gpu_energy;
     }
     else
     {
         err = VARIORUM_ERROR_UNSUPPORTED_PLATFORM;
     }
 
-    initAPMIDG();
+    variorum_context_get(VARIORUM_CONTEXT_APMIDG);
     return err;
 }
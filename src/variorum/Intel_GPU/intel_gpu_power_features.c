@@ -10,6 +10,7 @@
 #include <intel_gpu_power_features.h>
 #include <config_architecture.h>
 #include <variorum_error.h>
+#include <variorum_gpu_cap.h>
 #include <variorum_timers.h>
 #include <libapmidg.h>
 
@@ -212,27 +213,67 @@ void get_clocks_data(int chipid, int verbose, FILE *output)
 #endif
 }
 
-void cap_each_gpu_power_limit(int chipid, unsigned int powerlimit)
+static int intel_gpu_get_power_limit_mw(int gpu, unsigned int *limit_mw)
 {
-    int powerlimit_mwatts = powerlimit * 1000;
-    int d;
+    int pi = 0; // only report the global power domain
+    int current_powerlimit_mwatts = 0;
 
-    //Iterate over all GPU device handles for this socket and print power
-    for (d = chipid * (int)m_gpus_per_socket;
-         d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
+    apmidg_getpwrlim(gpu, pi, &current_powerlimit_mwatts);
+    if (current_powerlimit_mwatts < 0)
     {
-        int pi = 0; // check the power domain
-        int current_powerlimit_mwatts = 0;
-        apmidg_setpwrlim(d, pi, powerlimit_mwatts);
-        apmidg_getpwrlim(d, pi, &current_powerlimit_mwatts);
+        return -1;
+    }
+    *limit_mw = (unsigned int)current_powerlimit_mwatts;
+    return 0;
+}
 
-        if (powerlimit_mwatts != current_powerlimit_mwatts)
-        {
-            variorum_error_handler("Could not set the specified GPU power limit",
-                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                                   __LINE__);
-        }
+static int intel_gpu_set_power_limit_mw(int gpu, unsigned int limit_mw)
+{
+    int pi = 0; // check the power domain
+
+    // APMIDG does not report errors here; the engine reads the limit back.
+    apmidg_setpwrlim(gpu, pi, (int)limit_mw);
+    return 0;
+}
+
+int cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    static const struct variorum_gpu_cap_ops ops =
+    {
+        intel_gpu_get_power_limit_mw,
+        intel_gpu_set_power_limit_mw,
+        // The limit is held in RAPL power units of 1/8 W.
+        125
+    };
+
+    if (ngpus != (int)m_total_unit_devices)
+    {
+        variorum_error_handler("Number of GPU power limits does not match the number of GPUs",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                               __LINE__);
+        return -1;
+    }
+    return variorum_gpu_cap_apply(&ops, ngpus, gpu_power_limits);
+}
+
+int cap_each_gpu_power_limit(unsigned int powerlimit)
+{
+    int *limits;
+    int ret;
+    unsigned d;
+
+    limits = (int *) malloc(m_total_unit_devices * sizeof(int));
+    if (limits == NULL)
+    {
+        return -1;
+    }
+    for (d = 0; d < m_total_unit_devices; d++)
+    {
+        limits[d] = (int)powerlimit;
     }
+    ret = cap_gpu_power_limits((int)m_total_unit_devices, limits);
+    free(limits);
+    return ret;
 }
 
 void get_power_limit_data(int chipid, int verbose, FILE *output)
@@ -288,3 +329,34 @@ void get_power_limit_data(int chipid, int verbose, FILE *output)
     cflush();
 #endif
 }
+
+int get_gpu_energy_data(struct variorum_gpu_energy *energy)
+{
+    static double *gpu_joules = NULL;
+    unsigned d;
+
+    if (gpu_joules == NULL)
+    {
+        gpu_joules = (double *) calloc(m_total_unit_devices, sizeof(double));
+        if (gpu_joules == NULL)
+        {
+            return -1;
+        }
+    }
+
+    for (d = 0; d < m_total_unit_devices; d++)
+    {
+        int pi = 0; // only report the global power domain now
+        uint64_t energy_uj = 0;
+        uint64_t timestamp_us = 0;
+
+        // Level Zero keeps a 64-bit microjoule counter per power domain.
+        apmidg_readenergy(d, pi, &energy_uj, &timestamp_us);
+        gpu_joules[d] = (double)energy_uj / 1000000.0;
+    }
+
+    energy->ngpus = (int)m_total_unit_devices;
+    energy->gpus_per_socket = (int)m_gpus_per_socket;
+    energy->gpu_joules = gpu_joules;
+    return 0;
+}
@@ -11,6 +11,8 @@
 
 #include <libapmidg.h>
 
+#include <variorum.h>
+
 void initAPMIDG(
     void
 );
@@ -37,15 +39,23 @@ void get_clocks_data(
     FILE *output
 );
 
-void cap_each_gpu_power_limit(
-    int chipid,
+int cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+int cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 void get_power_limit_data(
     int chipid,
     int verbose,
     FILE *output
 );
 
+int get_gpu_energy_data(
+    struct variorum_gpu_energy *energy
+);
+
 #endif
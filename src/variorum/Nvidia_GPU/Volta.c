@@ -11,6 +11,7 @@
 #include <config_architecture.h>
 #include <variorum_error.h>
 #include <nvidia_gpu_power_features.h>
+#include <nvidia_gpu_sampler.h>
 #include <jansson.h>
 
 int volta_get_power(int long_ver)
@@ -21,14 +22,19 @@ int volta_get_power(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_POWER, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_power_data(iter, long_ver, stdout);
+        nvidia_gpu_get_power_data(iter, long_ver, stdout, snap);
     }
     return 0;
 }
@@ -41,14 +47,19 @@ int volta_get_thermals(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_TEMPERATURE, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_thermal_data(iter, long_ver, stdout);
+        nvidia_gpu_get_thermal_data(iter, long_ver, stdout, snap);
     }
     return 0;
 }
@@ -61,13 +72,18 @@ int volta_get_thermals_json(json_t *get_thermal_obj)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets;
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_TEMPERATURE, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_thermal_json(iter, get_thermal_obj);
+        nvidia_gpu_get_thermal_json(iter, get_thermal_obj, snap);
     }
 
     return 0;
@@ -81,14 +97,19 @@ int volta_get_clocks(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_CLOCKS, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_clocks_data(iter, long_ver, stdout);
+        nvidia_gpu_get_clocks_data(iter, long_ver, stdout, snap);
     }
     return 0;
 }
@@ -101,15 +122,20 @@ int volta_get_clocks_json(json_t *get_clock_obj_json)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
 
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_CLOCKS, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_clocks_json(iter, get_clock_obj_json);
+        nvidia_gpu_get_clocks_json(iter, get_clock_obj_json, snap);
     }
     return 0;
 }
@@ -122,14 +148,19 @@ int volta_get_power_limits(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_POWER_LIMIT, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_power_limits_data(iter, long_ver, stdout);
+        nvidia_gpu_get_power_limits_data(iter, long_ver, stdout, snap);
     }
     return 0;
 }
@@ -142,19 +173,24 @@ int volta_get_gpu_utilization(int long_ver)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets = 0;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_UTILIZATION, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_gpu_utilization_data(iter, long_ver, stdout);
+        nvidia_gpu_get_gpu_utilization_data(iter, long_ver, stdout, snap);
     }
     return 0;
 }
 
-int volta_get_gpu_utilization_json(char **get_gpu_util_obj_str)
+int volta_get_gpu_utilization_json(json_t *get_util_obj)
 {
     char *val = getenv("VARIORUM_LOG");
     if (val != NULL && atoi(val) == 1)
@@ -162,19 +198,21 @@ int volta_get_gpu_utilization_json(char **get_gpu_util_obj_str)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    json_t *get_util_obj = json_object();
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets;
 #ifdef VARIORUM_WITH_NVIDIA_GPU
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 #endif
 
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_UTILIZATION, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_get_gpu_utilization_json(iter, get_util_obj);
+        nvidia_get_gpu_utilization_json(iter, get_util_obj, snap);
     }
-    *get_gpu_util_obj_str = json_dumps(get_util_obj, JSON_INDENT(4));
-    json_decref(get_util_obj);
     return 0;
 }
 
@@ -186,16 +224,18 @@ int volta_cap_each_gpu_power_limit(unsigned int powerlimit)
         printf("Running %s\n", __FUNCTION__);
     }
 
-    unsigned iter = 0;
-    unsigned nsockets = 0;
-#ifdef VARIORUM_WITH_NVIDIA_GPU
-    variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
-#endif
-    for (iter = 0; iter < nsockets; iter++)
+    return cap_each_gpu_power_limit(powerlimit);
+}
+
+int volta_cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
     {
-        cap_each_gpu_power_limit(iter, powerlimit);
+        printf("Running %s\n", __FUNCTION__);
     }
-    return 0;
+
+    return cap_gpu_power_limits(ngpus, gpu_power_limits);
 }
 
 int volta_get_power_json(json_t *get_power_obj)
@@ -206,15 +246,83 @@ int volta_get_power_json(json_t *get_power_obj)
         printf("Running %s\n", __FUNCTION__);
     }
 
+    struct nvidia_gpu_snapshot *snap;
     unsigned iter = 0;
     unsigned nsockets;
     variorum_get_topology(&nsockets, NULL, NULL, P_NVIDIA_GPU_IDX);
 
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_POWER, &snap) != 0)
+    {
+        return -1;
+    }
     for (iter = 0; iter < nsockets; iter++)
     {
-        nvidia_gpu_get_power_json(iter, get_power_obj);
+        nvidia_gpu_get_power_json(iter, get_power_obj, snap);
     }
 
     return 0;
 }
 
+int volta_get_gpu_energy(struct variorum_gpu_energy *energy)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    struct nvidia_gpu_snapshot *snap;
+
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_ENERGY, &snap) != 0)
+    {
+        return -1;
+    }
+    return nvidia_gpu_get_energy_data(snap, energy);
+}
+
+int volta_get_gpu_thermals(struct variorum_gpu_thermals *thermals)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    struct nvidia_gpu_snapshot *snap;
+
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_TEMPERATURE, &snap) != 0)
+    {
+        return -1;
+    }
+    return nvidia_gpu_get_gpu_thermals(snap, thermals);
+}
+
+int volta_get_gpu_clocks(struct variorum_gpu_clocks *clocks)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    struct nvidia_gpu_snapshot *snap;
+
+    if (nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_CLOCKS, &snap) != 0)
+    {
+        return -1;
+    }
+    return nvidia_gpu_get_gpu_clocks(snap, clocks);
+}
+
+int volta_get_gpu_throttle_events(int timeout_ms,
+                                  struct variorum_gpu_throttle_event *events,
+                                  int max_events)
+{
+    char *val = getenv("VARIORUM_LOG");
+    if (val != NULL && atoi(val) == 1)
+    {
+        printf("Running %s\n", __FUNCTION__);
+    }
+
+    return nvidia_gpu_get_throttle_events(timeout_ms, events, max_events);
+}
@@ -8,6 +8,9 @@
 
 #include <jansson.h>
 
+#include <config_architecture.h>
+#include <variorum.h>
+
 int volta_get_power(
     int long_ver
 );
@@ -32,6 +35,11 @@ int volta_cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+int volta_cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 int volta_get_power_json(
     json_t *get_power_obj_str
 );
@@ -45,7 +53,25 @@ int volta_get_clocks_json(
 );
 
 int volta_get_gpu_utilization_json(
-    char **get_gpu_util_obj_str
+    json_t *get_util_obj
+);
+
+int volta_get_gpu_energy(
+    struct variorum_gpu_energy *energy
+);
+
+int volta_get_gpu_thermals(
+    struct variorum_gpu_thermals *thermals
+);
+
+int volta_get_gpu_clocks(
+    struct variorum_gpu_clocks *clocks
+);
+
+int volta_get_gpu_throttle_events(
+    int timeout_ms,
+    struct variorum_gpu_throttle_event *events,
+    int max_events
 );
 
 #endif
@@ -8,6 +8,7 @@
 
 #include <config_nvidia.h>
 #include <config_architecture.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
 
 uint64_t *detect_gpu_arch(void)
@@ -37,13 +38,19 @@ int set_nvidia_func_ptrs(int idx)
         /* Initialize control interfaces */
         g_platform[idx].variorum_cap_each_gpu_power_limit =
             volta_cap_each_gpu_power_limit;
+        g_platform[idx].variorum_cap_gpu_power_limits = volta_cap_gpu_power_limits;
         g_platform[idx].variorum_get_power_json = volta_get_power_json;
+        g_platform[idx].variorum_get_gpu_energy = volta_get_gpu_energy;
+        g_platform[idx].variorum_get_gpu_thermals = volta_get_gpu_thermals;
+        g_platform[idx].variorum_get_gpu_clocks = volta_get_gpu_clocks;
+        g_platform[idx].variorum_get_gpu_throttle_events =
+            volta_get_gpu_throttle_events;
     }
     else
     {
         err = VARIORUM_ERROR_UNSUPPORTED_PLATFORM;
     }
 
-    initNVML();
+    variorum_context_get(VARIORUM_CONTEXT_NVML);
     return err;
 }
@@ -10,8 +10,11 @@
 #include <unistd.h>
 
 #include <nvidia_gpu_power_features.h>
+#include <nvidia_gpu_sampler.h>
 #include <config_architecture.h>
 #include <variorum_error.h>
+#include <variorum_gpu_cap.h>
+#include <variorum_gpu_throttle.h>
 #include <variorum_timers.h>
 
 #ifdef LIBJUSTIFY_FOUND
@@ -23,6 +26,10 @@ nvmlDevice_t *m_unit_devices_file_desc;
 unsigned m_gpus_per_socket;
 char m_hostname[1024];
 
+/* Event set that wakes the throttle monitor on clock and P-state changes. */
+static nvmlEventSet_t m_throttle_event_set = NULL;
+static int m_throttle_events_checked = 0;
+
 void initNVML(void)
 {
     unsigned int d;
@@ -64,6 +71,12 @@ void initNVML(void)
 
 void shutdownNVML(void)
 {
+    if (m_throttle_event_set != NULL)
+    {
+        nvmlEventSetFree(m_throttle_event_set);
+        m_throttle_event_set = NULL;
+    }
+    m_throttle_events_checked = 0;
     if (m_unit_devices_file_desc != NULL)
     {
         free(m_unit_devices_file_desc);
@@ -72,9 +85,9 @@ void shutdownNVML(void)
 }
 
 //TODO REALLY TEST THIS ONE FOR LIBJUSTIFY
-void nvidia_gpu_get_power_data(int chipid, int verbose, FILE *output)
+void nvidia_gpu_get_power_data(int chipid, int verbose, FILE *output,
+                               const struct nvidia_gpu_snapshot *snap)
 {
-    unsigned int power;
     double value = 0.0;
     int d;
     static int init_output = 0;
@@ -83,8 +96,7 @@ void nvidia_gpu_get_power_data(int chipid, int verbose, FILE *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetPowerUsage(m_unit_devices_file_desc[d], &power);
-        value = (double)power * 0.001f;
+        value = (double)snap->device[d].power * 0.001f;
 
         if (verbose)
         {
@@ -121,7 +133,8 @@ void nvidia_gpu_get_power_data(int chipid, int verbose, FILE *output)
     }
 }
 
-void nvidia_gpu_get_thermal_data(int chipid, int verbose, FILE *output)
+void nvidia_gpu_get_thermal_data(int chipid, int verbose, FILE *output,
+                                 const struct nvidia_gpu_snapshot *snap)
 {
     unsigned gpu_temp;
     int d;
@@ -131,8 +144,7 @@ void nvidia_gpu_get_thermal_data(int chipid, int verbose, FILE *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetTemperature(m_unit_devices_file_desc[d], NVML_TEMPERATURE_GPU,
-                                 &gpu_temp);
+        gpu_temp = snap->device[d].temp_gpu;
         if (verbose)
         {
 #ifdef LIBJUSTIFY_FOUND
@@ -174,7 +186,8 @@ void nvidia_gpu_get_thermal_data(int chipid, int verbose, FILE *output)
     /*!@todo: Print GPU memory temperature */
 }
 
-void nvidia_gpu_get_thermal_json(int chipid, json_t *output)
+void nvidia_gpu_get_thermal_json(int chipid, json_t *output,
+                                 const struct nvidia_gpu_snapshot *snap)
 {
     unsigned gpu_temp;
     int d;
@@ -197,8 +210,7 @@ void nvidia_gpu_get_thermal_json(int chipid, json_t *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetTemperature(m_unit_devices_file_desc[d], NVML_TEMPERATURE_GPU,
-                                 &gpu_temp);
+        gpu_temp = snap->device[d].temp_gpu;
 
         //set GPU device id and temperature in general GPU json object.
         char device_id[32];
@@ -207,28 +219,25 @@ void nvidia_gpu_get_thermal_json(int chipid, json_t *output)
     }
 }
 
-void nvidia_gpu_get_power_limits_data(int chipid, int verbose, FILE *output)
+void nvidia_gpu_get_power_limits_data(int chipid, int verbose, FILE *output,
+                                      const struct nvidia_gpu_snapshot *snap)
 {
-    unsigned int power_limit;
     double value = 0.0;
     int d;
     static int init_output = 0;
-    nvmlReturn_t result;
 
     /* Iterate over all GPU device handles populated at init and print GPU power limit */
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        result = nvmlDeviceGetEnforcedPowerLimit(m_unit_devices_file_desc[d],
-                 &power_limit);
-        if (result != NVML_SUCCESS)
+        if (snap->device[d].power_limit_ret != NVML_SUCCESS)
         {
             variorum_error_handler("Could not query GPU power limit\n",
                                    VARIORUM_ERROR_PLATFORM_ENV,
                                    getenv("HOSTNAME"), __FILE__, __FUNCTION__,
                                    __LINE__);
         }
-        value = (double) power_limit * 0.001f;
+        value = (double) snap->device[d].power_limit * 0.001f;
 
         if (verbose)
         {
@@ -273,7 +282,8 @@ void nvidia_gpu_get_power_limits_data(int chipid, int verbose, FILE *output)
     /*!@todo: Seperate interface for default power limits? */
 }
 
-void nvidia_gpu_get_clocks_data(int chipid, int verbose, FILE *output)
+void nvidia_gpu_get_clocks_data(int chipid, int verbose, FILE *output,
+                                const struct nvidia_gpu_snapshot *snap)
 {
     unsigned int gpu_clock;
     int d;
@@ -283,8 +293,7 @@ void nvidia_gpu_get_clocks_data(int chipid, int verbose, FILE *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetClock(m_unit_devices_file_desc[d], NVML_CLOCK_SM,
-                           NVML_CLOCK_ID_CURRENT, &gpu_clock);
+        gpu_clock = snap->device[d].sm_clock;
 
         if (verbose)
         {
@@ -325,7 +334,8 @@ void nvidia_gpu_get_clocks_data(int chipid, int verbose, FILE *output)
     }
 }
 
-void nvidia_gpu_get_clocks_json(int chipid, json_t *output)
+void nvidia_gpu_get_clocks_json(int chipid, json_t *output,
+                                const struct nvidia_gpu_snapshot *snap)
 {
     unsigned int gpu_clock;
     unsigned int mem_clock;
@@ -347,10 +357,8 @@ void nvidia_gpu_get_clocks_json(int chipid, json_t *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetClock(m_unit_devices_file_desc[d], NVML_CLOCK_SM,
-                           NVML_CLOCK_ID_CURRENT, &gpu_clock);
-        nvmlDeviceGetClock(m_unit_devices_file_desc[d], NVML_CLOCK_MEM,
-                           NVML_CLOCK_ID_CURRENT, &mem_clock);
+        gpu_clock = snap->device[d].sm_clock;
+        mem_clock = snap->device[d].mem_clock;
         char gpu_sm_clock_str[32];
         snprintf(gpu_sm_clock_str, 32, "gpu_%d_freq_mhz", d);
 
@@ -362,7 +370,8 @@ void nvidia_gpu_get_clocks_json(int chipid, json_t *output)
     }
 }
 
-void nvidia_gpu_get_gpu_utilization_data(int chipid, int verbose, FILE *output)
+void nvidia_gpu_get_gpu_utilization_data(int chipid, int verbose, FILE *output,
+                                         const struct nvidia_gpu_snapshot *snap)
 {
     nvmlUtilization_t util;
     int d;
@@ -372,7 +381,7 @@ void nvidia_gpu_get_gpu_utilization_data(int chipid, int verbose, FILE *output)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetUtilizationRates(m_unit_devices_file_desc[d], &util);
+        util = snap->device[d].util;
 
         if (verbose)
         {
@@ -415,39 +424,19 @@ void nvidia_gpu_get_gpu_utilization_data(int chipid, int verbose, FILE *output)
 #endif
 }
 
-void nvidia_get_gpu_utilization_json(int chipid, json_t *get_gpu_util_obj)
+void nvidia_get_gpu_utilization_json(int chipid, json_t *get_util_obj,
+                                     const struct nvidia_gpu_snapshot *snap)
 {
     nvmlUtilization_t util;
     int d;
     char socket_id[12];
     char device_id[12];
-    char hostname[1024];
-    struct timeval tv;
-    uint64_t ts;
-
-    gethostname(hostname, 1024);
-    gettimeofday(&tv, NULL);
-    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
 
-    json_t *get_host_util_obj = json_object_get(get_gpu_util_obj, hostname);
-    if (get_host_util_obj == NULL)
-    {
-        get_host_util_obj = json_object();
-        json_object_set_new(get_gpu_util_obj, hostname, get_host_util_obj);
-    }
-
-    json_t *timestamp_obj = json_object_get(get_host_util_obj, "timestamp");
-    if (timestamp_obj == NULL)
-    {
-        json_object_set_new(get_host_util_obj, "timestamp", json_integer(ts));
-    }
-    snprintf(socket_id, 12, "Socket_%d", chipid);
-
-    json_t *gpu_obj = json_object_get(get_host_util_obj, "GPU");
+    json_t *gpu_obj = json_object_get(get_util_obj, "GPU");
     if (gpu_obj == NULL)
     {
         gpu_obj = json_object();
-        json_object_set_new(get_host_util_obj, "GPU", gpu_obj);
+        json_object_set_new(get_util_obj, "GPU", gpu_obj);
     }
     snprintf(socket_id, 12, "Socket_%d", chipid);
 
@@ -462,34 +451,66 @@ void nvidia_get_gpu_utilization_json(int chipid, json_t *get_gpu_util_obj)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetUtilizationRates(m_unit_devices_file_desc[d], &util);
+        util = snap->device[d].util;
         snprintf(device_id, 12, "GPU%d_util%%", d);
         json_object_set_new(socket_obj, device_id, json_integer(util.gpu));
     }
 }
 
-void cap_each_gpu_power_limit(int chipid, unsigned int powerlimit)
+static int nvidia_gpu_get_power_limit(int gpu, unsigned int *limit_mw)
 {
-    unsigned int powerlimit_mwatts = powerlimit * 1000;
-    int d;
+    return nvmlDeviceGetPowerManagementLimit(m_unit_devices_file_desc[gpu],
+            limit_mw) == NVML_SUCCESS ? 0 : -1;
+}
 
-    //Iterate over all GPU device handles for this socket and print power
-    for (d = chipid * (int)m_gpus_per_socket;
-         d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
+static int nvidia_gpu_set_power_limit(int gpu, unsigned int limit_mw)
+{
+    return nvmlDeviceSetPowerManagementLimit(m_unit_devices_file_desc[gpu],
+            limit_mw) == NVML_SUCCESS ? 0 : -1;
+}
+
+int cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    static const struct variorum_gpu_cap_ops ops =
     {
-        if (NVML_SUCCESS != nvmlDeviceSetPowerManagementLimit(
-                m_unit_devices_file_desc[d], powerlimit_mwatts))
-        {
-            variorum_error_handler("Could not set the specified GPU power limit",
-                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
-                                   __LINE__);
-        }
+        nvidia_gpu_get_power_limit,
+        nvidia_gpu_set_power_limit,
+        0
+    };
+
+    if (ngpus != (int)m_total_unit_devices)
+    {
+        variorum_error_handler("Number of GPU power limits does not match the number of GPUs",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                               __LINE__);
+        return -1;
     }
+    return variorum_gpu_cap_apply(&ops, ngpus, gpu_power_limits);
 }
 
-void nvidia_gpu_get_power_json(int chipid, json_t *get_power_obj)
+int cap_each_gpu_power_limit(unsigned int powerlimit)
+{
+    int *limits;
+    int ret;
+    unsigned d;
+
+    limits = (int *) malloc(m_total_unit_devices * sizeof(int));
+    if (limits == NULL)
+    {
+        return -1;
+    }
+    for (d = 0; d < m_total_unit_devices; d++)
+    {
+        limits[d] = (int)powerlimit;
+    }
+    ret = cap_gpu_power_limits((int)m_total_unit_devices, limits);
+    free(limits);
+    return ret;
+}
+
+void nvidia_gpu_get_power_json(int chipid, json_t *get_power_obj,
+                               const struct nvidia_gpu_snapshot *snap)
 {
-    unsigned int gpu_power;
     double value = 0.0;
     double total_gpu_power = 0.0;
     int d;
@@ -516,8 +537,7 @@ void nvidia_gpu_get_power_json(int chipid, json_t *get_power_obj)
     for (d = chipid * (int)m_gpus_per_socket;
          d < (chipid + 1) * (int)m_gpus_per_socket; ++d)
     {
-        nvmlDeviceGetPowerUsage(m_unit_devices_file_desc[d], &gpu_power);
-        value = (double)gpu_power * 0.001f;
+        value = (double)snap->device[d].power * 0.001f;
         snprintf(devID, devIDlen, "GPU_%d", d);
         json_object_set_new(gpu_obj, devID, json_real(value));
         total_gpu_power += value;
@@ -540,3 +560,286 @@ void nvidia_gpu_get_power_json(int chipid, json_t *get_power_obj)
 
 }
 
+int nvidia_gpu_get_energy_data(const struct nvidia_gpu_snapshot *snap,
+                               struct variorum_gpu_energy *energy)
+{
+    static double *gpu_joules = NULL;
+    static unsigned ngpus = 0;
+    unsigned d;
+
+    if (gpu_joules == NULL || ngpus != snap->ndevices)
+    {
+        free(gpu_joules);
+        gpu_joules = (double *) calloc(snap->ndevices, sizeof(double));
+        if (gpu_joules == NULL)
+        {
+            ngpus = 0;
+            return -1;
+        }
+        ngpus = snap->ndevices;
+    }
+
+    for (d = 0; d < ngpus; d++)
+    {
+        if (snap->device[d].energy_ret != NVML_SUCCESS)
+        {
+            variorum_error_handler("Could not query GPU energy",
+                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                                   __LINE__);
+            return -1;
+        }
+        // NVML reports millijoules since the driver was loaded.
+        gpu_joules[d] = (double)snap->device[d].energy * 0.001;
+    }
+
+    energy->ngpus = (int)ngpus;
+    energy->gpus_per_socket = (int)m_gpus_per_socket;
+    energy->gpu_joules = gpu_joules;
+    return 0;
+}
+
+int nvidia_gpu_get_gpu_thermals(const struct nvidia_gpu_snapshot *snap,
+                                struct variorum_gpu_thermals *thermals)
+{
+    static double *celsius = NULL;
+    static unsigned ngpus = 0;
+    unsigned d;
+
+    if (celsius == NULL || ngpus != snap->ndevices)
+    {
+        free(celsius);
+        celsius = (double *) calloc(snap->ndevices, sizeof(double));
+        if (celsius == NULL)
+        {
+            ngpus = 0;
+            return -1;
+        }
+        ngpus = snap->ndevices;
+    }
+
+    for (d = 0; d < ngpus; d++)
+    {
+        if (snap->device[d].temp_gpu_ret != NVML_SUCCESS)
+        {
+            variorum_error_handler("Could not query GPU temperature",
+                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                                   __LINE__);
+            return -1;
+        }
+        celsius[d] = (double)snap->device[d].temp_gpu;
+    }
+
+    thermals->ngpus = (int)ngpus;
+    thermals->gpus_per_socket = (int)m_gpus_per_socket;
+    thermals->celsius = celsius;
+    return 0;
+}
+
+int nvidia_gpu_get_gpu_clocks(const struct nvidia_gpu_snapshot *snap,
+                              struct variorum_gpu_clocks *clocks)
+{
+    static double *sm_mhz = NULL;
+    static double *mem_mhz = NULL;
+    static unsigned ngpus = 0;
+    unsigned d;
+
+    if (sm_mhz == NULL || mem_mhz == NULL || ngpus != snap->ndevices)
+    {
+        free(sm_mhz);
+        free(mem_mhz);
+        sm_mhz = (double *) calloc(snap->ndevices, sizeof(double));
+        mem_mhz = (double *) calloc(snap->ndevices, sizeof(double));
+        if (sm_mhz == NULL || mem_mhz == NULL)
+        {
+            ngpus = 0;
+            return -1;
+        }
+        ngpus = snap->ndevices;
+    }
+
+    for (d = 0; d < ngpus; d++)
+    {
+        if (snap->device[d].sm_clock_ret != NVML_SUCCESS ||
+            snap->device[d].mem_clock_ret != NVML_SUCCESS)
+        {
+            variorum_error_handler("Could not query GPU clocks",
+                                   VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                                   __LINE__);
+            return -1;
+        }
+        sm_mhz[d] = (double)snap->device[d].sm_clock;
+        mem_mhz[d] = (double)snap->device[d].mem_clock;
+    }
+
+    clocks->ngpus = (int)ngpus;
+    clocks->gpus_per_socket = (int)m_gpus_per_socket;
+    clocks->sm_mhz = sm_mhz;
+    clocks->mem_mhz = mem_mhz;
+    return 0;
+}
+
+static unsigned int nvidia_gpu_throttle_reasons(unsigned long long nvml_reasons)
+{
+    unsigned int reasons = 0;
+
+    if (nvml_reasons & nvmlClocksThrottleReasonGpuIdle)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_IDLE;
+    }
+    if (nvml_reasons & nvmlClocksThrottleReasonApplicationsClocksSetting)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_APP_CLOCKS;
+    }
+    if (nvml_reasons & nvmlClocksThrottleReasonSwPowerCap)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_POWER_CAP;
+    }
+    if (nvml_reasons & nvmlClocksThrottleReasonHwSlowdown)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_HW_SLOWDOWN;
+    }
+#ifdef nvmlClocksThrottleReasonSwThermalSlowdown
+    if (nvml_reasons & nvmlClocksThrottleReasonSwThermalSlowdown)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_SW_THERMAL;
+    }
+#endif
+#ifdef nvmlClocksThrottleReasonHwThermalSlowdown
+    if (nvml_reasons & nvmlClocksThrottleReasonHwThermalSlowdown)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_HW_THERMAL;
+    }
+#endif
+#ifdef nvmlClocksThrottleReasonHwPowerBrakeSlowdown
+    if (nvml_reasons & nvmlClocksThrottleReasonHwPowerBrakeSlowdown)
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_HW_POWER_BRAKE;
+    }
+#endif
+    if (nvml_reasons & (nvmlClocksThrottleReasonSyncBoost
+#ifdef nvmlClocksThrottleReasonDisplayClockSetting
+                        | nvmlClocksThrottleReasonDisplayClockSetting
+#endif
+                       ))
+    {
+        reasons |= VARIORUM_GPU_THROTTLE_OTHER;
+    }
+    return reasons;
+}
+
+static double nvidia_gpu_violation_s(nvmlDevice_t dev,
+                                     nvmlPerfPolicyType_t policy)
+{
+    nvmlViolationTime_t violation;
+
+    if (nvmlDeviceGetViolationStatus(dev, policy, &violation) != NVML_SUCCESS)
+    {
+        return -1.0;
+    }
+    // NVML reports the violation time in nanoseconds.
+    return (double)violation.violationTime * 1e-9;
+}
+
+/* The monitor scans the GPUs in order, so the reasons of every device are
+ * sampled in one pass when GPU 0 is read and reused for the others.
+ * */
+static int nvidia_gpu_read_throttle(int gpu, unsigned int *reasons,
+                                    double *power_violation_s,
+                                    double *thermal_violation_s)
+{
+    static struct nvidia_gpu_snapshot *snap = NULL;
+    nvmlDevice_t dev = m_unit_devices_file_desc[gpu];
+
+    if ((gpu == 0 || snap == NULL) &&
+        nvidia_gpu_sample(NVIDIA_GPU_SAMPLE_THROTTLE, &snap) != 0)
+    {
+        snap = NULL;
+        return -1;
+    }
+    if ((unsigned)gpu >= snap->ndevices ||
+        snap->device[gpu].throttle_reasons_ret != NVML_SUCCESS)
+    {
+        return -1;
+    }
+    *reasons = nvidia_gpu_throttle_reasons(snap->device[gpu].throttle_reasons);
+    *power_violation_s = nvidia_gpu_violation_s(dev, NVML_PERF_POLICY_POWER);
+    *thermal_violation_s = nvidia_gpu_violation_s(dev, NVML_PERF_POLICY_THERMAL);
+    return 0;
+}
+
+/* Register every device that supports clock or P-state events, so the
+ * monitor wakes up early on most throttle changes. Clock events are only
+ * raised on Kepler, and a power cap that throttles within P0 changes neither,
+ * so the monitor still rescans every poll interval.
+ * */
+static void nvidia_gpu_register_throttle_events(void)
+{
+    unsigned long long supported;
+    unsigned long long wanted = nvmlEventTypeClock | nvmlEventTypePState;
+    int registered = 0;
+    unsigned d;
+
+    m_throttle_events_checked = 1;
+    if (nvmlEventSetCreate(&m_throttle_event_set) != NVML_SUCCESS)
+    {
+        m_throttle_event_set = NULL;
+        return;
+    }
+    for (d = 0; d < m_total_unit_devices; d++)
+    {
+        if (nvmlDeviceGetSupportedEventTypes(m_unit_devices_file_desc[d],
+                                             &supported) != NVML_SUCCESS ||
+            (supported & wanted) == 0)
+        {
+            continue;
+        }
+        if (nvmlDeviceRegisterEvents(m_unit_devices_file_desc[d],
+                                     supported & wanted, m_throttle_event_set) == NVML_SUCCESS)
+        {
+            registered++;
+        }
+    }
+    // Devices without events would never wake the monitor, so poll unless
+    // every device is registered.
+    if (registered < (int)m_total_unit_devices)
+    {
+        nvmlEventSetFree(m_throttle_event_set);
+        m_throttle_event_set = NULL;
+    }
+}
+
+static int nvidia_gpu_wait_throttle(int timeout_ms)
+{
+    nvmlEventData_t data;
+    nvmlReturn_t ret;
+
+    if (!m_throttle_events_checked)
+    {
+        nvidia_gpu_register_throttle_events();
+    }
+    if (m_throttle_event_set == NULL)
+    {
+        return -1;
+    }
+    ret = nvmlEventSetWait(m_throttle_event_set, &data, (unsigned)timeout_ms);
+    return (ret == NVML_SUCCESS || ret == NVML_ERROR_TIMEOUT) ? 0 : -1;
+}
+
+int nvidia_gpu_get_throttle_events(int timeout_ms,
+                                   struct variorum_gpu_throttle_event *events,
+                                   int max_events)
+{
+    static struct variorum_gpu_throttle_tracker tracker = {0, NULL};
+    static const struct variorum_gpu_throttle_ops ops =
+    {
+        nvidia_gpu_read_throttle,
+        nvidia_gpu_wait_throttle
+    };
+
+    if (m_unit_devices_file_desc == NULL)
+    {
+        return -1;
+    }
+    return variorum_gpu_throttle_poll(&tracker, &ops, (int)m_total_unit_devices,
+                                      timeout_ms, events, max_events);
+}
@@ -13,6 +13,10 @@
 #include <string.h>
 #include <sys/time.h>
 
+#include <config_architecture.h>
+#include <nvidia_gpu_sampler.h>
+#include <variorum.h>
+
 extern unsigned m_total_unit_devices;
 extern nvmlDevice_t *m_unit_devices_file_desc;
 extern unsigned m_gpus_per_socket;
@@ -29,57 +33,91 @@ void shutdownNVML(
 void nvidia_gpu_get_power_data(
     int chipid,
     int verbose,
-    FILE *output
+    FILE *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_gpu_get_thermal_data(
     int chipid,
     int verbose,
-    FILE *output
+    FILE *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_gpu_get_clocks_data(
     int chipid,
     int verbose,
-    FILE *output
+    FILE *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_gpu_get_power_limits_data(
     int chipid,
     int verbose,
-    FILE *output
+    FILE *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_gpu_get_gpu_utilization_data(
     int chipid,
     int verbose,
-    FILE *output
+    FILE *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
-void cap_each_gpu_power_limit(
-    int chipid,
+int cap_each_gpu_power_limit(
     unsigned int powerlimit
 );
 
+int cap_gpu_power_limits(
+    int ngpus,
+    const int *gpu_power_limits
+);
+
 void nvidia_gpu_get_thermal_json(
     int chipid,
-    json_t *output
+    json_t *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_gpu_get_clocks_json(
     int chipid,
-    json_t *output
+    json_t *output,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 void nvidia_get_gpu_utilization_json(
     int chipid,
-    json_t *get_gpu_util_obj
+    json_t *get_util_obj,
+    const struct nvidia_gpu_snapshot *snap
 );
 
 
 void nvidia_gpu_get_power_json(
     int chipid,
-    json_t *output
+    json_t *output,
+    const struct nvidia_gpu_snapshot *snap
+);
+
+int nvidia_gpu_get_energy_data(
+    const struct nvidia_gpu_snapshot *snap,
+    struct variorum_gpu_energy *energy
+);
+
+int nvidia_gpu_get_gpu_thermals(
+    const struct nvidia_gpu_snapshot *snap,
+    struct variorum_gpu_thermals *thermals
+);
+
+int nvidia_gpu_get_gpu_clocks(
+    const struct nvidia_gpu_snapshot *snap,
+    struct variorum_gpu_clocks *clocks
+);
+
+int nvidia_gpu_get_throttle_events(
+    int timeout_ms,
+    struct variorum_gpu_throttle_event *events,
+    int max_events
 );
 
 #endif
@@ -0,0 +1,242 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nvidia_gpu_power_features.h>
+
+#include "nvidia_gpu_sampler.h"
+
+/* Field values fetched in bulk. Older NVML headers do not define every ID,
+ * in which case the field is read with its own call.
+ * */
+#define MAX_BULK_FIELDS 2
+
+struct device_query
+{
+    unsigned device;
+    unsigned fields;
+    struct nvidia_gpu_sample *data;
+};
+
+static struct nvidia_gpu_snapshot g_snap;
+
+static unsigned long long field_value(const nvmlFieldValue_t *fv)
+{
+    switch (fv->valueType)
+    {
+        case NVML_VALUE_TYPE_DOUBLE:
+            return (unsigned long long)fv->value.dVal;
+        case NVML_VALUE_TYPE_UNSIGNED_INT:
+            return fv->value.uiVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG:
+            return fv->value.ulVal;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG:
+            return (unsigned long long)fv->value.sllVal;
+        default:
+            return fv->value.ullVal;
+    }
+}
+
+/* Issue one nvmlDeviceGetFieldValues() call for the bulk fields and store
+ * whatever succeeded. Fields left with an error are retried individually.
+ * */
+static void query_bulk_fields(nvmlDevice_t dev, unsigned fields,
+                              struct nvidia_gpu_sample *data)
+{
+    nvmlFieldValue_t values[MAX_BULK_FIELDS];
+    nvmlReturn_t ret;
+    int n = 0;
+    int i;
+
+    memset(values, 0, sizeof(values));
+#ifdef NVML_FI_DEV_POWER_INSTANT
+    if (fields & NVIDIA_GPU_SAMPLE_POWER)
+    {
+        values[n++].fieldId = NVML_FI_DEV_POWER_INSTANT;
+    }
+#endif
+#ifdef NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION
+    if (fields & NVIDIA_GPU_SAMPLE_ENERGY)
+    {
+        values[n++].fieldId = NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION;
+    }
+#endif
+    if (n == 0)
+    {
+        return;
+    }
+
+    ret = nvmlDeviceGetFieldValues(dev, n, values);
+    if (ret != NVML_SUCCESS)
+    {
+        return;
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (values[i].nvmlReturn != NVML_SUCCESS)
+        {
+            continue;
+        }
+        switch (values[i].fieldId)
+        {
+#ifdef NVML_FI_DEV_POWER_INSTANT
+            case NVML_FI_DEV_POWER_INSTANT:
+                data->power = (unsigned)field_value(&values[i]);
+                data->power_ret = NVML_SUCCESS;
+                break;
+#endif
+#ifdef NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION
+            case NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION:
+                data->energy = field_value(&values[i]);
+                data->energy_ret = NVML_SUCCESS;
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+}
+
+static void query_device(unsigned d, unsigned fields,
+                         struct nvidia_gpu_sample *data)
+{
+    nvmlDevice_t dev = m_unit_devices_file_desc[d];
+
+    if (fields & NVIDIA_GPU_SAMPLE_POWER)
+    {
+        data->power_ret = NVML_ERROR_NOT_SUPPORTED;
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_ENERGY)
+    {
+        data->energy_ret = NVML_ERROR_NOT_SUPPORTED;
+    }
+
+    query_bulk_fields(dev, fields, data);
+
+    if ((fields & NVIDIA_GPU_SAMPLE_POWER) && data->power_ret != NVML_SUCCESS)
+    {
+        data->power_ret = nvmlDeviceGetPowerUsage(dev, &data->power);
+    }
+    if ((fields & NVIDIA_GPU_SAMPLE_ENERGY) && data->energy_ret != NVML_SUCCESS)
+    {
+        data->energy_ret = nvmlDeviceGetTotalEnergyConsumption(dev, &data->energy);
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_TEMPERATURE)
+    {
+        data->temp_gpu_ret = nvmlDeviceGetTemperature(dev, NVML_TEMPERATURE_GPU,
+                             &data->temp_gpu);
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_CLOCKS)
+    {
+        data->sm_clock_ret = nvmlDeviceGetClock(dev, NVML_CLOCK_SM,
+                                                NVML_CLOCK_ID_CURRENT, &data->sm_clock);
+        data->mem_clock_ret = nvmlDeviceGetClock(dev, NVML_CLOCK_MEM,
+                              NVML_CLOCK_ID_CURRENT, &data->mem_clock);
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_UTILIZATION)
+    {
+        data->util_ret = nvmlDeviceGetUtilizationRates(dev, &data->util);
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_THROTTLE)
+    {
+        data->throttle_reasons_ret = nvmlDeviceGetCurrentClocksThrottleReasons(dev,
+                                     &data->throttle_reasons);
+    }
+    if (fields & NVIDIA_GPU_SAMPLE_POWER_LIMIT)
+    {
+        data->power_limit_ret = nvmlDeviceGetEnforcedPowerLimit(dev,
+                                &data->power_limit);
+    }
+}
+
+static void *query_device_thread(void *arg)
+{
+    struct device_query *q = (struct device_query *)arg;
+
+    query_device(q->device, q->fields, q->data);
+    return NULL;
+}
+
+static int use_device_threads(void)
+{
+    char *val = getenv("VARIORUM_NVIDIA_GPU_THREADS");
+
+    return val != NULL && atoi(val) != 0;
+}
+
+int nvidia_gpu_sample(unsigned fields, struct nvidia_gpu_snapshot **snap)
+{
+    struct device_query *queries;
+    pthread_t *threads;
+    unsigned ndevices = m_total_unit_devices;
+    unsigned d;
+
+    if (m_unit_devices_file_desc == NULL)
+    {
+        return -1;
+    }
+
+    if (g_snap.device == NULL || g_snap.ndevices != ndevices)
+    {
+        free(g_snap.device);
+        g_snap.device = (struct nvidia_gpu_sample *) calloc(ndevices,
+                        sizeof(struct nvidia_gpu_sample));
+        if (g_snap.device == NULL)
+        {
+            g_snap.ndevices = 0;
+            return -1;
+        }
+        g_snap.ndevices = ndevices;
+    }
+
+    gettimeofday(&g_snap.timestamp, NULL);
+
+    if (ndevices > 1 && use_device_threads())
+    {
+        queries = (struct device_query *) malloc(ndevices * sizeof(struct device_query));
+        threads = (pthread_t *) malloc(ndevices * sizeof(pthread_t));
+        if (queries == NULL || threads == NULL)
+        {
+            free(queries);
+            free(threads);
+            return -1;
+        }
+        for (d = 0; d < ndevices; d++)
+        {
+            queries[d].device = d;
+            queries[d].fields = fields;
+            queries[d].data = &g_snap.device[d];
+            if (pthread_create(&threads[d], NULL, query_device_thread, &queries[d]) != 0)
+            {
+                // Query this device inline if no thread is available.
+                query_device(d, fields, &g_snap.device[d]);
+                threads[d] = pthread_self();
+            }
+        }
+        for (d = 0; d < ndevices; d++)
+        {
+            if (!pthread_equal(threads[d], pthread_self()))
+            {
+                pthread_join(threads[d], NULL);
+            }
+        }
+        free(queries);
+        free(threads);
+    }
+    else
+    {
+        for (d = 0; d < ndevices; d++)
+        {
+            query_device(d, fields, &g_snap.device[d]);
+        }
+    }
+
+    *snap = &g_snap;
+    return 0;
+}
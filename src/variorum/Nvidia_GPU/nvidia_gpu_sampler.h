@@ -0,0 +1,84 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef NVIDIA_GPU_SAMPLER_H_INCLUDE
+#define NVIDIA_GPU_SAMPLER_H_INCLUDE
+
+#include <nvml.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+/// @brief Fields that can be requested from nvidia_gpu_sample().
+#define NVIDIA_GPU_SAMPLE_POWER       0x01
+#define NVIDIA_GPU_SAMPLE_ENERGY      0x02
+#define NVIDIA_GPU_SAMPLE_TEMPERATURE 0x04
+#define NVIDIA_GPU_SAMPLE_CLOCKS      0x08
+#define NVIDIA_GPU_SAMPLE_UTILIZATION 0x10
+#define NVIDIA_GPU_SAMPLE_THROTTLE    0x20
+#define NVIDIA_GPU_SAMPLE_POWER_LIMIT 0x40
+#define NVIDIA_GPU_SAMPLE_ALL         0x7f
+
+/// @brief NVML readings of one GPU. Each value has the NVML status of the
+/// query that produced it; a value is only meaningful if its status is
+/// NVML_SUCCESS.
+struct nvidia_gpu_sample
+{
+    /// @brief Board power (in milliwatts).
+    unsigned power;
+    nvmlReturn_t power_ret;
+    /// @brief Energy since the driver was loaded (in millijoules).
+    unsigned long long energy;
+    nvmlReturn_t energy_ret;
+    /// @brief GPU die temperature (in degrees C).
+    unsigned temp_gpu;
+    nvmlReturn_t temp_gpu_ret;
+    /// @brief Current SM clock (in MHz).
+    unsigned sm_clock;
+    nvmlReturn_t sm_clock_ret;
+    /// @brief Current memory clock (in MHz).
+    unsigned mem_clock;
+    nvmlReturn_t mem_clock_ret;
+    /// @brief SM and memory utilization (in percent).
+    nvmlUtilization_t util;
+    nvmlReturn_t util_ret;
+    /// @brief Bitmask of nvmlClocksThrottleReason* values.
+    unsigned long long throttle_reasons;
+    nvmlReturn_t throttle_reasons_ret;
+    /// @brief Enforced power limit (in milliwatts).
+    unsigned power_limit;
+    nvmlReturn_t power_limit_ret;
+};
+
+/// @brief Readings of all GPUs from one sampling pass.
+struct nvidia_gpu_snapshot
+{
+    /// @brief Time at which the pass started.
+    struct timeval timestamp;
+    /// @brief Number of entries in device.
+    unsigned ndevices;
+    /// @brief Per-device readings, indexed like m_unit_devices_file_desc.
+    struct nvidia_gpu_sample *device;
+};
+
+/// @brief Sample the requested fields on every GPU in one pass.
+///
+/// Power and energy are fetched with a single nvmlDeviceGetFieldValues()
+/// call per device; fields the driver does not report that way, or whose
+/// field value fails, are read with the matching nvmlDeviceGet*() call
+/// instead. Devices are sampled one after another. Set
+/// VARIORUM_NVIDIA_GPU_THREADS=1 to sample them on one thread each, so the
+/// driver round trips of different GPUs overlap.
+///
+/// @param [in] fields Bitmask of NVIDIA_GPU_SAMPLE_* fields.
+/// @param [out] snap Set to the sampler's snapshot, which stays valid until
+/// the next call. Fields that were not requested keep their previous values.
+///
+/// @return 0 if successful, otherwise -1
+int nvidia_gpu_sample(
+    unsigned fields,
+    struct nvidia_gpu_snapshot **snap
+);
+
+#endif
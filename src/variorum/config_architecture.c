@@ -37,6 +37,7 @@
 #endif
 
 #ifdef VARIORUM_WITH_ARM_CPU
+#include <arm_util.h>
 #include <config_arm.h>
 #endif
 
@@ -62,6 +63,41 @@ int P_MSR_CORE_IDX;
 
 struct platform g_platform[MAX_PLATFORMS];
 
+/* While a hold is taken (see variorum_open()), the state set up by the first
+ * variorum_enter() is reused instead of being rebuilt on every call.
+ * */
+static int g_platform_holds = 0;
+static int g_platform_ready = 0;
+
+static int platform_teardown(void)
+{
+    int err = 0;
+    int i;
+
+#ifdef VARIORUM_WITH_INTEL_CPU
+    err = finalize_msr();
+    if (err)
+    {
+        return err;
+    }
+#endif
+#ifdef VARIORUM_WITH_ARM_CPU
+    // Stops the hwmon sampler and closes the sensor files that init_arm()
+    // and the first reads set up.
+    shutdown_arm();
+#endif
+    // Vendor libraries (E-SMI, NVML, ROCm SMI, APMIDG) stay initialized
+    // until variorum_close() or process exit; see variorum_context.h.
+
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        free(g_platform[i].arch_id);
+        g_platform[i].arch_id = NULL;
+    }
+    g_platform_ready = 0;
+    return err;
+}
+
 int variorum_enter(const char *filename, const char *func_name, int line_num)
 {
     int err = 0;
@@ -74,6 +110,11 @@ int variorum_enter(const char *filename, const char *func_name, int line_num)
         printf("Number of registered platforms: %d\n", P_NUM_PLATFORMS);
     }
 
+    if (g_platform_ready)
+    {
+        return 0;
+    }
+
     variorum_init_func_ptrs();
 
     //Triggers initialization on first call.  Errors assert.
@@ -99,43 +140,41 @@ int variorum_enter(const char *filename, const char *func_name, int line_num)
                                __LINE__);
         return err;
     }
+    g_platform_ready = 1;
     return err;
 }
 
 int variorum_exit(const char *filename, const char *func_name, int line_num)
 {
-    int err = 0;
-    int i;
-
     char *val = getenv("VARIORUM_LOG");
     if (val != NULL && atoi(val) == 1)
     {
         printf("_LOG_VARIORUM_EXIT:%s:%s::%d\n", filename, func_name, line_num);
     }
 
-#ifdef VARIORUM_WITH_INTEL_CPU
-    err = finalize_msr();
-    if (err)
+    if (g_platform_holds > 0)
     {
-        return err;
+        return 0;
     }
-#endif
-#ifdef VARIORUM_WITH_AMD_CPU
-    esmi_exit();
-#endif
-#ifdef VARIORUM_WITH_NVIDIA_GPU
-    shutdownNVML();
-#endif
-#ifdef VARIORUM_WITH_INTEL_GPU
-    shutdownAPMIDG();
-#endif
+    return platform_teardown();
+}
 
-    for (i = 0; i < P_NUM_PLATFORMS; i++)
+void variorum_platform_hold(void)
+{
+    g_platform_holds++;
+}
+
+void variorum_platform_release(void)
+{
+    if (g_platform_holds == 0)
     {
-        free(g_platform[i].arch_id);
+        return;
+    }
+    g_platform_holds--;
+    if (g_platform_holds == 0 && g_platform_ready)
+    {
+        platform_teardown();
     }
-
-    return err;
 }
 
 int variorum_detect_arch(void)
@@ -344,6 +383,7 @@ void variorum_init_func_ptrs()
         g_platform[i].variorum_cap_each_core_frequency_limit = NULL;
         g_platform[i].variorum_print_available_frequencies = NULL;
         g_platform[i].variorum_cap_each_gpu_power_limit = NULL;
+        g_platform[i].variorum_cap_gpu_power_limits = NULL;
         g_platform[i].variorum_print_features = NULL;
         g_platform[i].variorum_print_thermals = NULL;
         g_platform[i].variorum_print_counters = NULL;
@@ -362,6 +402,21 @@ void variorum_init_func_ptrs()
         g_platform[i].variorum_get_thermals_json = NULL;
         g_platform[i].variorum_get_frequency_json = NULL;
         g_platform[i].variorum_get_energy_json = NULL;
+        g_platform[i].variorum_get_energy_attribution = NULL;
+        g_platform[i].variorum_get_sensor_id = NULL;
+        g_platform[i].variorum_read_sensors = NULL;
+        g_platform[i].variorum_get_core_energy = NULL;
+        g_platform[i].variorum_get_socket_energy = NULL;
+        g_platform[i].variorum_get_gpu_energy = NULL;
+        g_platform[i].variorum_get_core_frequency = NULL;
+        g_platform[i].variorum_get_socket_thermals = NULL;
+        g_platform[i].variorum_get_gpu_thermals = NULL;
+        g_platform[i].variorum_get_gpu_clocks = NULL;
+        g_platform[i].variorum_get_gpu_throttle_events = NULL;
+        g_platform[i].variorum_set_counter_events = NULL;
+        g_platform[i].variorum_get_thread_counters = NULL;
+        g_platform[i].variorum_get_uncore_counters = NULL;
+        g_platform[i].variorum_get_cstate_residency = NULL;
     }
 }
 
@@ -12,6 +12,8 @@
 
 #include <jansson.h>
 
+#include <variorum.h>
+
 /// @brief Create a mask from bit m to n (63 >= m >= n >= 0).
 ///
 /// Example: MASK_RANGE(4,2) --> (((1<<((4)-(2)+1))-1)<<(2))
@@ -117,6 +119,48 @@ enum supported_platforms_e
     P_NUM_PLATFORMS
 };
 
+/// @brief Package and core temperatures of each socket, read by the
+/// fixed-schema JSON writers. The arrays are owned by the platform and stay
+/// valid until its next call.
+struct variorum_socket_thermals
+{
+    /// @brief Number of entries in pkg_celsius.
+    int nsockets;
+    /// @brief Number of cores of each socket.
+    int cores_per_socket;
+    /// @brief Package temperature of each socket (in degrees C).
+    double *pkg_celsius;
+    /// @brief Temperature of each core, averaged over its hardware threads
+    /// and indexed socket * cores_per_socket + core (in degrees C).
+    double *core_celsius;
+};
+
+/// @brief Temperature of each GPU, read by the fixed-schema JSON writers.
+/// The array is owned by the platform and stays valid until its next call.
+struct variorum_gpu_thermals
+{
+    /// @brief Number of entries in celsius.
+    int ngpus;
+    /// @brief Number of GPUs attached to each socket.
+    int gpus_per_socket;
+    /// @brief Die temperature of each GPU (in degrees C).
+    double *celsius;
+};
+
+/// @brief Clocks of each GPU, read by the fixed-schema JSON writers. The
+/// arrays are owned by the platform and stay valid until its next call.
+struct variorum_gpu_clocks
+{
+    /// @brief Number of entries in each array.
+    int ngpus;
+    /// @brief Number of GPUs attached to each socket.
+    int gpus_per_socket;
+    /// @brief Current SM clock of each GPU (in MHz).
+    double *sm_mhz;
+    /// @brief Current memory clock of each GPU (in MHz).
+    double *mem_mhz;
+};
+
 /// @brief Platform-specific information.
 ///
 /// The intersection of all features on all platforms.
@@ -180,6 +224,16 @@ struct platform
     /// @return 0 if successful, otherwise -1
     int (*variorum_cap_each_gpu_power_limit)(unsigned int gpu_power_limit);
 
+    /// @brief Cap the power usage of each GPU on the node to its own limit,
+    /// restoring the previous limits if any GPU fails.
+    ///
+    /// @param [in] ngpus Number of GPUs on the node.
+    /// @param [in] gpu_power_limits Limit in watts for each GPU, 0 to leave
+    ///             a GPU unchanged.
+    ///
+    /// @return 0 if successful, otherwise -1
+    int (*variorum_cap_gpu_power_limits)(int ngpus, const int *gpu_power_limits);
+
     /// @brief Function pointer to print the feature set.
     ///
     /// @return Error code.
@@ -237,10 +291,11 @@ struct platform
     /// @return Error code.
     int (*variorum_print_gpu_utilization)(int long_ver);
 
-    /// @brief Function pointer to get JSON object for utilization
+    /// @brief Function pointer to add the utilization of the platform's
+    /// devices to the node's JSON object.
     ///
     /// @return Error code.
-    int (*variorum_get_utilization_json)(char **get_util_obj_str);
+    int (*variorum_get_utilization_json)(json_t *get_util_obj);
 
     /// @brief Function pointer to get JSON object for node power data.
     ///
@@ -283,6 +338,93 @@ struct platform
     /// @return Error code.
     int (*variorum_get_energy_json)(json_t *get_energy_obj);
 
+    /// @brief Function pointer to apportion package energy to processes or
+    /// cgroups.
+    ///
+    /// @return Error code.
+    int (*variorum_get_energy_attribution)(const char **targets, int ntargets,
+                                           struct variorum_energy_attribution *attr);
+
+    /// @brief Function pointer to look up a sensor ID by socket and name.
+    ///
+    /// @return Sensor ID, otherwise -1.
+    int (*variorum_get_sensor_id)(int socket, const char *name);
+
+    /// @brief Function pointer to read a batch of sensors by ID.
+    ///
+    /// @return Error code.
+    int (*variorum_read_sensors)(const int *ids, int n, double *out);
+
+    /// @brief Function pointer to get per-core and per-CCD energy.
+    ///
+    /// @return Error code.
+    int (*variorum_get_core_energy)(struct variorum_core_energy *energy);
+
+    /// @brief Function pointer to get the CPU and memory energy counters of
+    /// each socket.
+    ///
+    /// @return Error code.
+    int (*variorum_get_socket_energy)(struct variorum_socket_energy *energy);
+
+    /// @brief Function pointer to get the energy counter of each GPU.
+    ///
+    /// @return Error code.
+    int (*variorum_get_gpu_energy)(struct variorum_gpu_energy *energy);
+
+    /// @brief Function pointer to get the average frequency of each core.
+    ///
+    /// @return Error code.
+    int (*variorum_get_core_frequency)(struct variorum_core_frequency *freq);
+
+    /// @brief Function pointer to get the package and core temperatures of
+    /// each socket.
+    ///
+    /// @return Error code.
+    int (*variorum_get_socket_thermals)(struct variorum_socket_thermals
+                                        *thermals);
+
+    /// @brief Function pointer to get the temperature of each GPU.
+    ///
+    /// @return Error code.
+    int (*variorum_get_gpu_thermals)(struct variorum_gpu_thermals *thermals);
+
+    /// @brief Function pointer to get the SM and memory clocks of each GPU.
+    ///
+    /// @return Error code.
+    int (*variorum_get_gpu_clocks)(struct variorum_gpu_clocks *clocks);
+
+    /// @brief Function pointer to get the throttle reason changes of each
+    /// GPU.
+    ///
+    /// @return Number of records written, otherwise -1.
+    int (*variorum_get_gpu_throttle_events)(int timeout_ms,
+                                            struct variorum_gpu_throttle_event *events,
+                                            int max_events);
+
+    /// @brief Function pointer to choose the programmable counter events.
+    ///
+    /// @return Error code.
+    int (*variorum_set_counter_events)(const char **events, int nevents);
+
+    /// @brief Function pointer to sample the fixed and programmable counters
+    /// of each hardware thread.
+    ///
+    /// @return Error code.
+    int (*variorum_get_thread_counters)(struct variorum_thread_counters_sample
+                                        *sample);
+
+    /// @brief Function pointer to sample the uncore PCU, U-box and memory
+    /// counters of each socket.
+    ///
+    /// @return Error code.
+    int (*variorum_get_uncore_counters)(struct variorum_uncore_sample *sample);
+
+    /// @brief Function pointer to sample the package and core C-state
+    /// residency counters.
+    ///
+    /// @return Error code.
+    int (*variorum_get_cstate_residency)(struct variorum_cstate_sample *sample);
+
     /// @brief Identifier for architecture.
     uint64_t *arch_id;
     /// @brief Hostname.
@@ -323,6 +465,19 @@ int variorum_exit(
     int line_num
 );
 
+/// @brief Keep the platform state set up by variorum_enter() (function
+/// pointers, architecture IDs and MSR file descriptors) across calls, so that
+/// later variorum_enter()/variorum_exit() pairs are cheap. Holds nest.
+void variorum_platform_hold(
+    void
+);
+
+/// @brief Drop a hold taken by variorum_platform_hold(). The platform state
+/// is torn down when the last hold is dropped.
+void variorum_platform_release(
+    void
+);
+
 void variorum_get_topology(
     unsigned *nsockets,
     unsigned *ncores,
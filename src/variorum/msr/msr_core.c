@@ -3,13 +3,15 @@
 //
 // SPDX-License-Identifier: MIT
 
-// Necessary for pread & pwrite.
-#define _XOPEN_SOURCE 500
+// Necessary for pread & pwrite, and for pinning threads to CPUs.
+#define _GNU_SOURCE
 
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/ioctl.h>
 #include <linux/types.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -162,12 +164,224 @@ static int *core_fd(const unsigned dev_idx)
     return NULL;
 }
 
+/* Local-read mode: a worker thread pinned to each logical processor reads
+ * that processor's MSRs into its slots of the batch. The msr driver then
+ * executes each read on the calling CPU instead of sending it to the target
+ * CPU with an inter-processor interrupt, and all CPUs are read in parallel.
+ * The workers are started on first use, sleep between batches, and are
+ * stopped and joined by finalize_msr().
+ * */
+struct local_read_worker
+{
+    pthread_t tid;
+    unsigned cpu;
+    /* Last batch generation this worker has seen. */
+    unsigned long seen;
+};
+
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    struct local_read_worker *workers;
+    unsigned nworkers;
+    unsigned long generation;
+    unsigned pending;
+    int error;
+    int stop;
+    struct msr_batch_array *batch;
+} g_local_read =
+{
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, NULL, 0, 0, 0, 0, 0, NULL
+};
+
+static int local_read_enabled(void)
+{
+    char *val = getenv("VARIORUM_MSR_LOCAL_READ");
+    return val != NULL && atoi(val) == 1;
+}
+
+static void *local_read_worker(void *arg)
+{
+    struct local_read_worker *self = (struct local_read_worker *)arg;
+    unsigned cpu = self->cpu;
+    unsigned long seen = self->seen;
+    struct msr_batch_array *batch;
+    cpu_set_t set;
+    int *fd;
+    int err;
+    unsigned i;
+
+    // If pinning fails (e.g., the CPU is outside our cpuset), the reads
+    // below are still correct, they just go through a cross-CPU call.
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    pthread_mutex_lock(&g_local_read.lock);
+    while (1)
+    {
+        while (g_local_read.generation == seen && !g_local_read.stop)
+        {
+            pthread_cond_wait(&g_local_read.start, &g_local_read.lock);
+        }
+        if (g_local_read.stop)
+        {
+            break;
+        }
+        seen = g_local_read.generation;
+        batch = g_local_read.batch;
+        pthread_mutex_unlock(&g_local_read.lock);
+
+        err = 0;
+        fd = core_fd(cpu);
+        for (i = 0; fd != NULL && i < batch->numops; i++)
+        {
+            if (batch->ops[i].cpu != cpu)
+            {
+                continue;
+            }
+            if (pread(*fd, (void *)&batch->ops[i].msrdata, sizeof(uint64_t),
+                      batch->ops[i].msr) != sizeof(uint64_t))
+            {
+                batch->ops[i].err = errno;
+                err = -1;
+            }
+        }
+
+        pthread_mutex_lock(&g_local_read.lock);
+        if (err)
+        {
+            g_local_read.error = err;
+        }
+        if (--g_local_read.pending == 0)
+        {
+            pthread_cond_signal(&g_local_read.done);
+        }
+    }
+    pthread_mutex_unlock(&g_local_read.lock);
+    return NULL;
+}
+
+/* Must be called with g_local_read.lock held. */
+static int local_read_start_workers(void)
+{
+    unsigned nthreads = 0;
+    unsigned cpu;
+
+#ifdef VARIORUM_WITH_AMD_CPU
+    variorum_get_topology(NULL, NULL, &nthreads, P_MSR_CORE_IDX);
+#endif
+#ifdef VARIORUM_WITH_INTEL_CPU
+    variorum_get_topology(NULL, NULL, &nthreads, P_MSR_CORE_IDX);
+#endif
+    if (nthreads == 0)
+    {
+        return -1;
+    }
+    if (g_local_read.workers == NULL)
+    {
+        g_local_read.workers = (struct local_read_worker *) calloc(nthreads,
+                               sizeof(struct local_read_worker));
+        if (g_local_read.workers == NULL)
+        {
+            return -1;
+        }
+    }
+    for (cpu = g_local_read.nworkers; cpu < nthreads; cpu++)
+    {
+        // Only batches started after this worker exists are its to read.
+        g_local_read.workers[cpu].cpu = cpu;
+        g_local_read.workers[cpu].seen = g_local_read.generation;
+        if (pthread_create(&g_local_read.workers[cpu].tid, NULL,
+                           local_read_worker, &g_local_read.workers[cpu]) != 0)
+        {
+            break;
+        }
+        g_local_read.nworkers++;
+    }
+    return g_local_read.nworkers == nthreads ? 0 : -1;
+}
+
+/* Wake the local-read workers, tell them to exit, and join them. */
+static void local_read_stop_workers(void)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&g_local_read.lock);
+    if (g_local_read.workers == NULL)
+    {
+        pthread_mutex_unlock(&g_local_read.lock);
+        return;
+    }
+    g_local_read.stop = 1;
+    pthread_cond_broadcast(&g_local_read.start);
+    pthread_mutex_unlock(&g_local_read.lock);
+
+    for (i = 0; i < g_local_read.nworkers; i++)
+    {
+        pthread_join(g_local_read.workers[i].tid, NULL);
+    }
+
+    pthread_mutex_lock(&g_local_read.lock);
+    free(g_local_read.workers);
+    g_local_read.workers = NULL;
+    g_local_read.nworkers = 0;
+    g_local_read.stop = 0;
+    pthread_mutex_unlock(&g_local_read.lock);
+}
+
+static int local_read_batch(int batchnum)
+{
+    struct msr_batch_array *batch = NULL;
+    int err;
+
+    if (batch_storage(&batch, batchnum, NULL))
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_local_read.lock);
+    if (local_read_start_workers() != 0)
+    {
+        pthread_mutex_unlock(&g_local_read.lock);
+        variorum_error_handler("Could not start local MSR read threads",
+                               VARIORUM_ERROR_MSR_BATCH, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_local_read.batch = batch;
+    g_local_read.error = 0;
+    g_local_read.pending = g_local_read.nworkers;
+    g_local_read.generation++;
+    pthread_cond_broadcast(&g_local_read.start);
+    while (g_local_read.pending > 0)
+    {
+        pthread_cond_wait(&g_local_read.done, &g_local_read.lock);
+    }
+    err = g_local_read.error;
+    pthread_mutex_unlock(&g_local_read.lock);
+
+    if (err)
+    {
+        variorum_error_handler("Local MSR read failed", VARIORUM_ERROR_MSR_READ,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+    }
+    return err;
+}
+
 static int do_batch_op(int batchnum, int type)
 {
     static int batchfd = 0;
     struct msr_batch_array *batch = NULL;
     int res, i, j;
 
+    if (type == BATCH_READ && local_read_enabled())
+    {
+        return local_read_batch(batchnum);
+    }
     if (batchfd == 0)
     {
         if ((batchfd = open(MSR_BATCH_PATH, O_RDWR)) < 0)
@@ -406,6 +620,8 @@ int finalize_msr(void)
     variorum_get_topology(NULL, NULL, &nthreads, P_MSR_CORE_IDX);
 #endif
 
+    // The local-read workers use the file descriptors closed below.
+    local_read_stop_workers();
     for (dev_idx = 0; dev_idx < nthreads; dev_idx++)
     {
         file_descriptor = core_fd(dev_idx);
@@ -620,6 +836,22 @@ int allocate_batch(int batchnum, size_t bsize)
     return 0;
 }
 
+int free_batch(int batchnum)
+{
+    unsigned *size = NULL;
+    struct msr_batch_array *batch = NULL;
+
+    if (batch_storage(&batch, batchnum, &size))
+    {
+        return -1;
+    }
+    free(batch->ops);
+    batch->ops = NULL;
+    batch->numops = 0;
+    *size = 0;
+    return 0;
+}
+
 int load_socket_batch(off_t msr, uint64_t **val, int batchnum)
 {
     unsigned dev_idx, val_idx;
@@ -102,6 +102,11 @@ enum variorum_data_type_e
     TURBO_RATIO_LIMIT_CORES = 34,
     TDP_DEFS = 35,
     TDP_CONFIG = 36,
+    /// @brief Controls and filters for the uncore PCU, U-box and CHA
+    /// performance monitors.
+    UNCORE_PMON_CTRL = 37,
+    /// @brief Uncore PCU, U-box and CHA performance counter measurements.
+    UNCORE_PMON_DATA = 38,
 };
 
 /// @brief Enum encompassing batch operations.
@@ -397,6 +402,15 @@ int allocate_batch(
     size_t bsize
 );
 
+/// @brief Release the operations of a batch so it can be allocated again.
+///
+/// @param [in] batchnum Identify a unique batch.
+///
+/// @return 0 if successful, else -1 if batch handle is NULL.
+int free_batch(
+    int batchnum
+);
+
 /// @brief Read from a batched set of MSRs.
 ///
 /// @param [in] batchnum Identify a unique batch.
@@ -15,23 +15,21 @@
 
 #include <config_architecture.h>
 #include <variorum.h>
+#include <variorum_context.h>
 #include <variorum_error.h>
+#include <variorum_json.h>
+#include <variorum_topology.h>
+#include <variorum_utilization.h>
 
 #ifdef LIBJUSTIFY_FOUND
 #include <cprintf.h>
 #endif
 
-#define MEM_FILE "/proc/meminfo"
-#define CPU_FILE "/proc/stat"
-
-uint64_t last_sum = 0;
-uint64_t last_user_time = 0;
-uint64_t last_sys_time = 0;
-uint64_t last_idle = 0;
-int state = 0;
 int g_socket;
 int g_core;
-FILE *fp = 0;
+
+/* Sessions opened with variorum_open() and not closed yet. */
+static int g_open_sessions = 0;
 
 static void print_children(hwloc_topology_t topology, hwloc_obj_t obj,
                            int depth)
@@ -524,6 +522,44 @@ int variorum_cap_each_gpu_power_limit(int gpu_power_limit)
     return err;
 }
 
+int variorum_cap_gpu_power_limits(int ngpus, const int *gpu_power_limits)
+{
+    int err = 0;
+    int i;
+    int found = 0;
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_cap_gpu_power_limits == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_cap_gpu_power_limits(ngpus, gpu_power_limits);
+        if (err)
+        {
+            break;
+        }
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
 int variorum_print_features(void)
 {
     int err = 0;
@@ -1079,7 +1115,7 @@ int variorum_get_power_json(char **get_power_obj_str)
         }
     }
 
-    *get_power_obj_str = json_dumps(get_power_obj, JSON_INDENT(4));
+    *get_power_obj_str = variorum_json_dumps(get_power_obj);
     json_decref(get_power_obj);
 
     err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
@@ -1090,6 +1126,19 @@ int variorum_get_power_json(char **get_power_obj_str)
     return err;
 }
 
+static json_t *util_domain_json(const struct variorum_util_domain *u)
+{
+    json_t *obj = json_object();
+
+    json_object_set_new(obj, "total_util%", json_real(u->total));
+    json_object_set_new(obj, "user_util%", json_real(u->user));
+    json_object_set_new(obj, "system_util%", json_real(u->system));
+    json_object_set_new(obj, "iowait_util%", json_real(u->iowait));
+    json_object_set_new(obj, "irq_util%", json_real(u->irq));
+    json_object_set_new(obj, "steal_util%", json_real(u->steal));
+    return obj;
+}
+
 int variorum_get_utilization_json(char **get_util_obj_str)
 {
     int err = 0;
@@ -1105,217 +1154,105 @@ int variorum_get_utilization_json(char **get_util_obj_str)
     gethostname(hostname, 1024);
     gettimeofday(&tv, NULL);
     ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
-    char str[100];
-    const char d[2] = " ";
-    char *token, *s, *p;
-    int i = 0;
-    uint64_t sum = 0;
-    uint64_t idle = 0;
-    uint64_t user_time = 0;
-    uint64_t nice_time = 0;
-    uint64_t sum_user_time = 0;
-    uint64_t iowait = 0;
-    uint64_t sum_idle = 0;
-    double cpu_util = 0.0;
-    double user_util = 0.0;
-    double sys_util = 0.0;
-    double mem_util = 0.0;
-    int rc, j;
-    char lbuf[256];
-    char metric_name[256];
-    uint64_t metric_value;
-    uint64_t mem_total = 0;
-    uint64_t mem_free = 0;
-    uint64_t sys_time = 0;
-    int strcp;
-    int idx = -1;
-
-    json_t *get_util_obj = NULL;
-    json_t *get_cpu_util_obj = NULL;
-    json_t *get_timestamp_obj = NULL;
+    int i;
+    char domain_name[32];
+    struct variorum_util_sample *sample = NULL;
+    json_t *per_cpu_obj = NULL;
+    json_t *per_socket_obj = NULL;
+    json_t *per_numa_obj = NULL;
+
+    json_t *get_util_obj = json_object();
+    json_t *get_cpu_util_obj = json_object();
     json_t *cpu_util_obj = NULL;
+    json_object_set_new(get_util_obj, hostname, get_cpu_util_obj);
+    json_object_set_new(get_cpu_util_obj, "timestamp", json_integer(ts));
 
-    // Look for a GPU build and get an ID.
-    for (idx = 0; idx < P_NUM_PLATFORMS; idx++)
+    // GPU platforms add their devices to the same node object. CPU
+    // utilization comes from the OS on every build.
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
     {
-#ifdef VARIORUM_WITH_INTEL_GPU
-        idx = P_INTEL_GPU_IDX;
-        break;
-#endif
-#ifdef VARIORUM_WITH_NVIDIA_GPU
-        idx = P_NVIDIA_GPU_IDX;
-        break;
-#endif
-#ifdef VARIORUM_WITH_AMD_GPU
-        idx = P_AMD_GPU_IDX;
-        break;
-#endif
+        if (g_platform[i].variorum_get_utilization_json == NULL)
+        {
+            continue;
+        }
+        if (g_platform[i].variorum_get_utilization_json(get_cpu_util_obj) != 0)
+        {
+            // For the JSON functions, we return a -1 here, so users don't need
+            // to explicitly check for NULL strings.
+            json_decref(get_util_obj);
+            return -1;
+        }
     }
+    cpu_util_obj = json_object();
+    json_object_set_new(get_cpu_util_obj, "CPU", cpu_util_obj);
 
-    // If we have a GPU build, obtain the GPU object first.
-#if defined(VARIORUM_WITH_NVIDIA_GPU) || defined(VARIORUM_WITH_AMD_GPU) || defined(VARIORUM_WITH_INTEL_GPU)
-    int ret;
-    char *gpu_util_str = NULL;
-    // get gpu utilization
-    ret = g_platform[idx].variorum_get_utilization_json(&gpu_util_str);
-    if (ret != 0)
+    if (variorum_util_get_sample(&sample) != 0)
     {
-        printf("JSON get gpu utilization failed. Exiting.\n");
-        free(gpu_util_str);
+        json_decref(get_util_obj);
         return -1;
     }
 
-    /* Load the existing GPU string as a JSON object using Jansson */
-    get_util_obj = json_loads(gpu_util_str, JSON_DECODE_ANY, NULL);
-    get_cpu_util_obj = json_object_get(get_util_obj, hostname);
-    get_timestamp_obj = json_object_get(get_cpu_util_obj, "timestamp");
-    cpu_util_obj = json_object_get(get_cpu_util_obj, "CPU");
-#endif
-
-    //CPU-only build will have this object as NULL.
-    if (get_util_obj == NULL)
-    {
-        get_util_obj = json_object();
-        get_cpu_util_obj = json_object();
-        json_object_set_new(get_util_obj, hostname, get_cpu_util_obj);
-    }
-
-    if (get_timestamp_obj == NULL)
-    {
-        json_object_set_new(get_cpu_util_obj, "timestamp", json_integer(ts));
-    }
-
-    if (cpu_util_obj == NULL)
-    {
-        cpu_util_obj = json_object();
-        json_object_set_new(get_cpu_util_obj, "CPU", cpu_util_obj);
-    }
+    json_object_set_new(cpu_util_obj, "total_util%", json_real(sample->node.total));
+    json_object_set_new(cpu_util_obj, "user_util%", json_real(sample->node.user));
+    json_object_set_new(cpu_util_obj, "system_util%", json_real(sample->node.system));
+    json_object_set_new(cpu_util_obj, "iowait_util%", json_real(sample->node.iowait));
+    json_object_set_new(cpu_util_obj, "irq_util%", json_real(sample->node.irq));
+    json_object_set_new(cpu_util_obj, "steal_util%", json_real(sample->node.steal));
 
-    // read /proc/stat file
-    fp = fopen(CPU_FILE, "r");
-    if (fp == NULL)
-    {
-        return -1;
-    }
-    // read the first line (cpu)
-    if (fgets(str, 100, fp) == NULL)
-    {
-        return -1;
-    }
-    if (str != NULL)
+    per_cpu_obj = json_object();
+    json_object_set_new(cpu_util_obj, "per_cpu", per_cpu_obj);
+    for (i = 0; i < sample->ncpus; i++)
     {
-        token = strtok(str, d);
-        sum = 0;
-        // get required values to compute cpu utilizations
-        while (token != NULL)
+        if (!sample->cpu[i].valid)
         {
-            token = strtok(NULL, d);
-            if (token != NULL)
-            {
-                sum += strtol(token, &p, 10);
-                if (i == 3)
-                {
-                    idle = strtol(token, &p, 10);
-                }
-                if (i == 0)
-                {
-                    user_time = strtol(token, &p, 10);
-                }
-                if (i == 1)
-                {
-                    nice_time = strtol(token, &p, 10);
-                }
-                if (i == 2)
-                {
-                    sys_time = strtol(token, &p, 10);
-                }
-                if (i == 4)
-                {
-                    iowait = strtol(token, &p, 10);
-                }
-                sum_idle = idle + iowait;
-                sum_user_time = user_time + nice_time;
-                i++;
-            }
+            continue;
         }
+        snprintf(domain_name, sizeof(domain_name), "CPU_%d", i);
+        json_object_set_new(per_cpu_obj, domain_name,
+                            util_domain_json(&sample->cpu[i]));
     }
 
-    fclose(fp);
-    // make the utilization metrics 0 at the first sample
-    if (state)
-    {
-        user_util = ((sum_user_time - last_user_time) / (double)(sum - last_sum)) * 100;
-        sys_util = ((sys_time - last_sys_time) / (double)(sum - last_sum)) * 100;
-        cpu_util = (1 - ((sum_idle - last_idle) / (double)(sum - last_sum))) * 100;
-    }
-    else
-    {
-        user_util = 0.0;
-        sys_util = 0.0;
-        cpu_util = 0.0;
-    }
-
-    last_user_time = sum_user_time;
-    last_sum = sum;
-    last_sys_time = sys_time;
-    last_idle = sum_idle;
-
-    json_object_set_new(cpu_util_obj, "total_util%", json_real(cpu_util));
-    json_object_set_new(cpu_util_obj, "user_util%", json_real(user_util));
-    json_object_set_new(cpu_util_obj, "system_util%", json_real(sys_util));
-    fp = fopen(MEM_FILE, "r");
-    if (fp == NULL)
-    {
-        return -1;
-    }
-    fseek(fp, 0, SEEK_SET);
-    do
+    per_socket_obj = json_object();
+    json_object_set_new(cpu_util_obj, "per_socket", per_socket_obj);
+    for (i = 0; i < sample->nsockets; i++)
     {
-        s = fgets(lbuf, sizeof(lbuf), fp);
-        if (!s)
+        if (!sample->socket[i].valid)
         {
-            break;
+            continue;
         }
+        snprintf(domain_name, sizeof(domain_name), "Socket_%d", i);
+        json_object_set_new(per_socket_obj, domain_name,
+                            util_domain_json(&sample->socket[i]));
+    }
 
-        rc = sscanf(lbuf, "%s%" PRIu64, metric_name, &metric_value);
-        if (rc < 2)
-        {
-            break;
-        }
+    per_numa_obj = json_object();
+    json_object_set_new(cpu_util_obj, "per_numa_node", per_numa_obj);
+    for (i = 0; i < sample->nnuma; i++)
+    {
+        json_t *numa_obj;
 
-        /* Strip the colon from metric name if present */
-        j = strlen(metric_name);
-        if (i && metric_name[j - 1] == ':')
-        {
-            metric_name[j - 1] = '\0';
-        }
-        strcp = strcmp(metric_name, "MemTotal");
-        if (strcp == 0)
+        if (!sample->numa[i].valid && !sample->numa_mem[i].valid)
         {
-            mem_total = metric_value;
+            continue;
         }
-        strcp = strcmp(metric_name, "MemFree");
-        if (strcp == 0)
+        numa_obj = util_domain_json(&sample->numa[i]);
+        if (sample->numa_mem[i].valid)
         {
-            mem_free = metric_value;
+            json_object_set_new(numa_obj, "memory_util%",
+                                json_real(sample->numa_mem[i].util));
+            json_object_set_new(numa_obj, "memory_total_kB",
+                                json_integer(sample->numa_mem[i].total));
+            json_object_set_new(numa_obj, "memory_free_kB",
+                                json_integer(sample->numa_mem[i].free));
         }
-    }
-    while (s);
-
-    if (state)
-    {
-        mem_util = (1 - (double)(mem_free) / (mem_total)) * 100;
-    }
-    else
-    {
-        mem_util = 0.0;
+        snprintf(domain_name, sizeof(domain_name), "Node_%d", i);
+        json_object_set_new(per_numa_obj, domain_name, numa_obj);
     }
 
-    fclose(fp);
-    json_object_set_new(get_cpu_util_obj, "memory_util%", json_real(mem_util));
-    *get_util_obj_str = json_dumps(get_util_obj, JSON_INDENT(4));
+    json_object_set_new(get_cpu_util_obj, "memory_util%",
+                        json_real(sample->mem_util));
+    *get_util_obj_str = variorum_json_dumps(get_util_obj);
     json_decref(get_util_obj);
-    state = 1;
 
     err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
     if (err)
@@ -1429,7 +1366,7 @@ int variorum_get_thermals_json(char **get_thermal_obj_str)
         }
     }
 
-    *get_thermal_obj_str = json_dumps(get_thermal_obj, JSON_INDENT(4));
+    *get_thermal_obj_str = variorum_json_dumps(get_thermal_obj);
     json_decref(get_thermal_obj);
 
     err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
@@ -1480,7 +1417,7 @@ int variorum_get_frequency_json(char **get_frequency_obj_str)
         }
     }
 
-    *get_frequency_obj_str = json_dumps(get_frequency_obj, JSON_INDENT(4));
+    *get_frequency_obj_str = variorum_json_dumps(get_frequency_obj);
     json_decref(get_frequency_obj);
 
     err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
@@ -1691,12 +1628,54 @@ int variorum_print_verbose_energy(void)
     return err;
 }
 
+static void gpu_energy_json(const struct variorum_gpu_energy *energy,
+                            json_t *node_obj)
+{
+    char socket_id[24];
+    char device_id[24];
+    double total_gpu_energy = 0.0;
+    int d;
+
+    for (d = 0; d < energy->ngpus; d++)
+    {
+        snprintf(socket_id, sizeof(socket_id), "socket_%d",
+                 energy->gpus_per_socket > 0 ? d / energy->gpus_per_socket : 0);
+        json_t *socket_obj = json_object_get(node_obj, socket_id);
+        if (socket_obj == NULL)
+        {
+            socket_obj = json_object();
+            json_object_set_new(node_obj, socket_id, socket_obj);
+        }
+        json_t *gpu_obj = json_object_get(socket_obj, "energy_gpu_joules");
+        if (gpu_obj == NULL || !json_is_object(gpu_obj))
+        {
+            gpu_obj = json_object();
+            json_object_set_new(socket_obj, "energy_gpu_joules", gpu_obj);
+        }
+        snprintf(device_id, sizeof(device_id), "GPU_%d", d);
+        json_object_set_new(gpu_obj, device_id, json_real(energy->gpu_joules[d]));
+        total_gpu_energy += energy->gpu_joules[d];
+    }
+
+    // IBM Power9 reports node energy from PWRSYS, which already includes the
+    // GPUs.
+#ifndef VARIORUM_WITH_IBM_CPU
+    if (json_object_get(node_obj, "energy_node_joules") != NULL)
+    {
+        double energy_node;
+        energy_node = json_real_value(json_object_get(node_obj,
+                                      "energy_node_joules"));
+        json_object_set_new(node_obj, "energy_node_joules",
+                            json_real(energy_node + total_gpu_energy));
+    }
+#endif
+}
+
 int variorum_get_energy_json(char **get_energy_obj_str)
 {
+    struct variorum_gpu_energy gpu_energy;
     int err = 0;
     int i;
-    int has_cpu = 0;
-    int has_gpu = 0;
     char hostname[1024];
     uint64_t ts;
     struct timeval tv;
@@ -1716,49 +1695,40 @@ int variorum_get_energy_json(char **get_energy_obj_str)
     ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
     json_object_set_new(node_obj, "timestamp", json_integer(ts));
 
-    // If we have a GPU-only build, we should exit with a helpful message.
-    // If we have a CPU-only or CPU+GPU multi-platform build, we should print
-    // the node-level energy.
-    // First check if we have a CPU platform, then check for a GPU platform
-
-#if defined(VARIORUM_WITH_INTEL_CPU) || defined(VARIORUM_WITH_AMD_CPU) || defined(VARIORUM_WITH_IBM_CPU)
-    has_cpu = 1;
-#endif
-#if defined(VARIORUM_WITH_NVIDIA_GPU) || defined(VARIORUM_WITH_AMD_GPU) || defined(VARIORUM_WITH_INTEL_GPU)
-    has_gpu = 1;
-#endif
-
-    // CPU-only or multi-platform build
-    if ((has_cpu && has_gpu) || (has_cpu))
+    // CPU platforms come first in g_platform, so the GPU energy can be added
+    // to the node energy they report.
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
     {
-        for (i = 0; i < P_NUM_PLATFORMS; i++)
+        if (g_platform[i].variorum_get_energy_json != NULL)
         {
-            if (g_platform[i].variorum_get_energy_json == NULL)
-            {
-                variorum_error_handler("Feature not yet implemented or is not supported",
-                                       VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
-                                       getenv("HOSTNAME"), __FILE__,
-                                       __FUNCTION__, __LINE__);
-                return 0;
-            }
             err = g_platform[i].variorum_get_energy_json(node_obj);
-            if (err)
+        }
+        else if (g_platform[i].variorum_get_gpu_energy != NULL)
+        {
+            err = g_platform[i].variorum_get_gpu_energy(&gpu_energy);
+            if (!err)
             {
-                printf("Error with variorum get frequency json platform %d\n", i);
+                gpu_energy_json(&gpu_energy, node_obj);
             }
-            *get_energy_obj_str = json_dumps(get_energy_obj, JSON_INDENT(4));
         }
-    }
-    else
-    {
-        // We have a GPU-only build, currently doesn't support get_energy
-        variorum_error_handler("Feature not yet implemented or is not supported",
-                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED, getenv("HOSTNAME"), __FILE__,
-                               __FUNCTION__, __LINE__);
-        *get_energy_obj_str = json_dumps(get_energy_obj, JSON_INDENT(4));
-        return 0;
+        else
+        {
+            variorum_error_handler("Feature not yet implemented or is not supported",
+                                   VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                                   getenv("HOSTNAME"), __FILE__,
+                                   __FUNCTION__, __LINE__);
+            continue;
+        }
+        if (err)
+        {
+            // For the JSON functions, we return a -1 here, so users don't need
+            // to explicitly check for NULL strings.
+            json_decref(get_energy_obj);
+            return -1;
+        }
     }
 
+    *get_energy_obj_str = variorum_json_dumps(get_energy_obj);
     json_decref(get_energy_obj);
 
     err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
@@ -1769,6 +1739,1387 @@ int variorum_get_energy_json(char **get_energy_obj_str)
     return err;
 }
 
+static int check_json_buf(const char *buf, size_t size, int format)
+{
+    if ((buf == NULL && size > 0) ||
+        (format != VARIORUM_JSON_PRETTY && format != VARIORUM_JSON_COMPACT))
+    {
+        variorum_error_handler("Invalid JSON buffer or format", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    return 0;
+}
+
+/* Open the top-level object of a fixed-schema JSON string, keyed by the
+ * hostname, with the time stamp as its first member.
+ * */
+static void begin_node_json(struct variorum_json_writer *w, char *buf,
+                            size_t size, int format)
+{
+    char hostname[1024];
+    struct timeval tv;
+    uint64_t ts;
+
+    gethostname(hostname, 1024);
+    gettimeofday(&tv, NULL);
+    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+
+    variorum_json_writer_init(w, buf, size, format);
+    variorum_json_begin_object(w, NULL);
+    variorum_json_begin_object(w, hostname);
+    variorum_json_integer(w, "timestamp", ts);
+}
+
+static int end_node_json(struct variorum_json_writer *w)
+{
+    variorum_json_end_object(w);
+    variorum_json_end_object(w);
+    return (int)w->len;
+}
+
+/* Number of sockets to report GPUs under when no CPU platform reports any. */
+static int gpu_nsockets(int ngpus, int gpus_per_socket)
+{
+    if (gpus_per_socket > 0)
+    {
+        return (ngpus + gpus_per_socket - 1) / gpus_per_socket;
+    }
+    return 1;
+}
+
+static int gpu_socket(int gpu, int gpus_per_socket)
+{
+    return gpus_per_socket > 0 ? gpu / gpus_per_socket : 0;
+}
+
+/* Energy counters of the CPU and GPU platforms, read in one pass. */
+struct node_energy_sources
+{
+    struct variorum_socket_energy sockets;
+    struct variorum_gpu_energy gpus;
+    int have_sockets;
+    int have_gpus;
+    int nsockets;
+};
+
+static int read_node_energy_sources(struct node_energy_sources *src)
+{
+    int err = 0;
+    int i;
+
+    src->have_sockets = 0;
+    src->have_gpus = 0;
+    if (variorum_enter(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS && !err; i++)
+    {
+        if (!src->have_sockets && g_platform[i].variorum_get_socket_energy != NULL)
+        {
+            err = g_platform[i].variorum_get_socket_energy(&src->sockets);
+            src->have_sockets = !err;
+        }
+        if (!err && !src->have_gpus && g_platform[i].variorum_get_gpu_energy != NULL)
+        {
+            err = g_platform[i].variorum_get_gpu_energy(&src->gpus);
+            src->have_gpus = !err;
+        }
+    }
+    if (!err && !src->have_sockets && !src->have_gpus)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__) || err)
+    {
+        return -1;
+    }
+
+    if (src->have_sockets)
+    {
+        src->nsockets = src->sockets.nsockets;
+    }
+    else
+    {
+        src->nsockets = gpu_nsockets(src->gpus.ngpus, src->gpus.gpus_per_socket);
+    }
+    return 0;
+}
+
+/* Energy of one socket. The GPUs attached to the socket are summed, or taken
+ * from the socket's own sensors if there is no GPU platform.
+ * */
+static void socket_joules(const struct node_energy_sources *src, int socket,
+                          double *cpu, double *mem, double *gpu)
+{
+    int d;
+
+    *cpu = src->have_sockets ? src->sockets.cpu_joules[socket] : 0.0;
+    *mem = src->have_sockets ? src->sockets.mem_joules[socket] : 0.0;
+    *gpu = 0.0;
+    if (src->have_gpus)
+    {
+        for (d = 0; d < src->gpus.ngpus; d++)
+        {
+            if (gpu_socket(d, src->gpus.gpus_per_socket) == socket)
+            {
+                *gpu += src->gpus.gpu_joules[d];
+            }
+        }
+    }
+    else if (src->have_sockets)
+    {
+        *gpu = src->sockets.gpu_joules[socket];
+    }
+}
+
+int variorum_get_energy_json_buf(char *buf, size_t size, int format)
+{
+    struct node_energy_sources src;
+    struct variorum_json_writer w;
+    char socket_id[24];
+    int i;
+    double cpu, mem, gpu;
+    double node = 0.0;
+
+    if (check_json_buf(buf, size, format) || read_node_energy_sources(&src))
+    {
+        return -1;
+    }
+
+    begin_node_json(&w, buf, size, format);
+    for (i = 0; i < src.nsockets; i++)
+    {
+        socket_joules(&src, i, &cpu, &mem, &gpu);
+        node += cpu + mem + gpu;
+
+        snprintf(socket_id, sizeof(socket_id), "socket_%d", i);
+        variorum_json_begin_object(&w, socket_id);
+        variorum_json_real(&w, "energy_cpu_joules", cpu);
+        variorum_json_real(&w, "energy_mem_joules", mem);
+        variorum_json_real(&w, "energy_gpu_joules", gpu);
+        variorum_json_end_object(&w);
+    }
+    variorum_json_real(&w, "energy_node_joules", node);
+    return end_node_json(&w);
+}
+
+/* Convert the growth of an energy counter into average power. A counter that
+ * went backwards was reset, so the interval has no valid reading.
+ * */
+static double average_watts(double joules, double prev_joules, double seconds)
+{
+    if (seconds <= 0.0 || joules < prev_joules)
+    {
+        return 0.0;
+    }
+    return (joules - prev_joules) / seconds;
+}
+
+int variorum_get_power_json_buf(char *buf, size_t size, int format)
+{
+    /* Energy of each socket at the previous call, as cpu, mem, gpu. */
+    static double *prev = NULL;
+    static int prev_nsockets = 0;
+    static double prev_seconds = 0.0;
+    struct node_energy_sources src;
+    struct variorum_json_writer w;
+    struct timeval tv;
+    char socket_id[24];
+    double now;
+    double interval;
+    double *tmp;
+    int i;
+    double cpu, mem, gpu;
+    double cpu_w, mem_w, gpu_w;
+    double node = 0.0;
+
+    if (check_json_buf(buf, size, format) || read_node_energy_sources(&src))
+    {
+        return -1;
+    }
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+    // A different socket count means there is no usable previous reading.
+    interval = prev_nsockets == src.nsockets ? now - prev_seconds : 0.0;
+    if (prev_nsockets != src.nsockets)
+    {
+        tmp = (double *) realloc(prev, 3 * src.nsockets * sizeof(double));
+        if (tmp == NULL)
+        {
+            variorum_error_handler("Could not allocate previous power reading",
+                                   VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        prev = tmp;
+        prev_nsockets = src.nsockets;
+    }
+
+    begin_node_json(&w, buf, size, format);
+    for (i = 0; i < src.nsockets; i++)
+    {
+        socket_joules(&src, i, &cpu, &mem, &gpu);
+        cpu_w = average_watts(cpu, prev[3 * i], interval);
+        mem_w = average_watts(mem, prev[3 * i + 1], interval);
+        gpu_w = average_watts(gpu, prev[3 * i + 2], interval);
+        prev[3 * i] = cpu;
+        prev[3 * i + 1] = mem;
+        prev[3 * i + 2] = gpu;
+        node += cpu_w + mem_w + gpu_w;
+
+        snprintf(socket_id, sizeof(socket_id), "socket_%d", i);
+        variorum_json_begin_object(&w, socket_id);
+        variorum_json_real(&w, "power_cpu_watts", cpu_w);
+        variorum_json_real(&w, "power_mem_watts", mem_w);
+        variorum_json_real(&w, "power_gpu_watts", gpu_w);
+        variorum_json_end_object(&w);
+    }
+    variorum_json_real(&w, "power_node_watts", node);
+    prev_seconds = now;
+    return end_node_json(&w);
+}
+
+int variorum_get_thermals_json_buf(char *buf, size_t size, int format)
+{
+    struct variorum_socket_thermals cpu;
+    struct variorum_gpu_thermals gpu;
+    struct variorum_json_writer w;
+    char socket_id[24];
+    char key[48];
+    int have_cpu = 0;
+    int have_gpus = 0;
+    int nsockets;
+    int err = 0;
+    int i;
+    int c;
+    int d;
+
+    if (check_json_buf(buf, size, format) ||
+        variorum_enter(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS && !err; i++)
+    {
+        if (!have_cpu && g_platform[i].variorum_get_socket_thermals != NULL)
+        {
+            err = g_platform[i].variorum_get_socket_thermals(&cpu);
+            have_cpu = !err;
+        }
+        if (!err && !have_gpus && g_platform[i].variorum_get_gpu_thermals != NULL)
+        {
+            err = g_platform[i].variorum_get_gpu_thermals(&gpu);
+            have_gpus = !err;
+        }
+    }
+    if (!err && !have_cpu && !have_gpus)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__) || err)
+    {
+        return -1;
+    }
+
+    nsockets = have_cpu ? cpu.nsockets : gpu_nsockets(gpu.ngpus,
+               gpu.gpus_per_socket);
+    begin_node_json(&w, buf, size, format);
+    for (i = 0; i < nsockets; i++)
+    {
+        snprintf(socket_id, sizeof(socket_id), "socket_%d", i);
+        variorum_json_begin_object(&w, socket_id);
+        if (have_cpu)
+        {
+            variorum_json_real(&w, "temp_celsius_pkg", cpu.pkg_celsius[i]);
+            for (c = 0; c < cpu.cores_per_socket; c++)
+            {
+                snprintf(key, sizeof(key), "temp_celsius_core_%d", c);
+                variorum_json_real(&w, key,
+                                   cpu.core_celsius[i * cpu.cores_per_socket + c]);
+            }
+        }
+        for (d = 0; have_gpus && d < gpu.ngpus; d++)
+        {
+            if (gpu_socket(d, gpu.gpus_per_socket) == i)
+            {
+                snprintf(key, sizeof(key), "temp_celsius_gpu_%d", d);
+                variorum_json_real(&w, key, gpu.celsius[d]);
+            }
+        }
+        variorum_json_end_object(&w);
+    }
+    return end_node_json(&w);
+}
+
+int variorum_get_frequency_json_buf(char *buf, size_t size, int format)
+{
+    struct variorum_core_frequency cpu;
+    struct variorum_gpu_clocks gpu;
+    struct variorum_json_writer w;
+    char socket_id[24];
+    char key[48];
+    int have_cpu = 0;
+    int have_gpus = 0;
+    int nsockets = 0;
+    int cores_per_socket = 0;
+    int err = 0;
+    int i;
+    int c;
+    int d;
+    double avg;
+
+    if (check_json_buf(buf, size, format) ||
+        variorum_enter(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS && !err; i++)
+    {
+        if (!have_cpu && g_platform[i].variorum_get_core_frequency != NULL)
+        {
+            err = g_platform[i].variorum_get_core_frequency(&cpu);
+            have_cpu = !err;
+        }
+        if (!err && !have_gpus && g_platform[i].variorum_get_gpu_clocks != NULL)
+        {
+            err = g_platform[i].variorum_get_gpu_clocks(&gpu);
+            have_gpus = !err;
+        }
+    }
+    if (!err && !have_cpu && !have_gpus)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__) || err)
+    {
+        return -1;
+    }
+
+    if (have_cpu)
+    {
+        // Cores are numbered socket by socket.
+        nsockets = variorum_get_num_sockets();
+        if (nsockets <= 0 || cpu.ncores % nsockets != 0)
+        {
+            nsockets = 1;
+        }
+        cores_per_socket = cpu.ncores / nsockets;
+    }
+    else
+    {
+        nsockets = gpu_nsockets(gpu.ngpus, gpu.gpus_per_socket);
+    }
+    begin_node_json(&w, buf, size, format);
+    for (i = 0; i < nsockets; i++)
+    {
+        snprintf(socket_id, sizeof(socket_id), "socket_%d", i);
+        variorum_json_begin_object(&w, socket_id);
+        if (have_cpu)
+        {
+            avg = 0.0;
+            for (c = 0; c < cores_per_socket; c++)
+            {
+                avg += cpu.avg_mhz[i * cores_per_socket + c];
+            }
+            variorum_json_real(&w, "cpu_avg_freq_mhz",
+                               cores_per_socket > 0 ? avg / cores_per_socket : 0.0);
+            for (c = 0; c < cores_per_socket; c++)
+            {
+                snprintf(key, sizeof(key), "core_%d_avg_freq_mhz", c);
+                variorum_json_real(&w, key, cpu.avg_mhz[i * cores_per_socket + c]);
+            }
+        }
+        for (d = 0; have_gpus && d < gpu.ngpus; d++)
+        {
+            if (gpu_socket(d, gpu.gpus_per_socket) == i)
+            {
+                snprintf(key, sizeof(key), "gpu_%d_freq_mhz", d);
+                variorum_json_real(&w, key, gpu.sm_mhz[d]);
+                snprintf(key, sizeof(key), "gpu_%d_mem_freq_mhz", d);
+                variorum_json_real(&w, key, gpu.mem_mhz[d]);
+            }
+        }
+        variorum_json_end_object(&w);
+    }
+    return end_node_json(&w);
+}
+
+static int split_attribution_targets(const char *targets, char **buf,
+                                     const char ***list, int *ntargets)
+{
+    char *tok;
+    char *saveptr = NULL;
+    int cap = 0;
+    const char **tmp;
+
+    *list = NULL;
+    *ntargets = 0;
+    if (targets == NULL)
+    {
+        return -1;
+    }
+    *buf = strdup(targets);
+    if (*buf == NULL)
+    {
+        return -1;
+    }
+    for (tok = strtok_r(*buf, ",", &saveptr); tok != NULL;
+         tok = strtok_r(NULL, ",", &saveptr))
+    {
+        if (*ntargets == cap)
+        {
+            cap = cap ? cap * 2 : 8;
+            tmp = (const char **) realloc(*list, cap * sizeof(char *));
+            if (tmp == NULL)
+            {
+                return -1;
+            }
+            *list = tmp;
+        }
+        (*list)[(*ntargets)++] = tok;
+    }
+    return 0;
+}
+
+int variorum_get_energy_attribution(const char *targets,
+                                    struct variorum_energy_attribution *attr, int max_targets)
+{
+    int err = 0;
+    int i;
+    int ntargets;
+    int found = 0;
+    char *buf = NULL;
+    const char **list = NULL;
+
+    if (attr == NULL || split_attribution_targets(targets, &buf, &list, &ntargets)
+        || ntargets > max_targets)
+    {
+        variorum_error_handler("Invalid attribution targets", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        free(buf);
+        free(list);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        free(buf);
+        free(list);
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_energy_attribution == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_energy_attribution(list, ntargets, attr);
+        if (err)
+        {
+            break;
+        }
+    }
+    free(buf);
+    free(list);
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_energy_attribution_json(const char *targets,
+        char **get_attribution_obj_str)
+{
+    int err = 0;
+    int i;
+    int ntargets;
+    uint64_t ts;
+    char hostname[1024];
+    char *buf = NULL;
+    const char **list = NULL;
+    struct timeval tv;
+    struct variorum_energy_attribution *attr;
+
+    if (split_attribution_targets(targets, &buf, &list, &ntargets))
+    {
+        free(buf);
+        free(list);
+        return -1;
+    }
+    free(buf);
+    free(list);
+
+    // An empty target list has nothing to attribute, so report an empty
+    // object instead of querying the platform.
+    attr = NULL;
+    if (ntargets > 0)
+    {
+        attr = (struct variorum_energy_attribution *) malloc(ntargets * sizeof(
+                    struct variorum_energy_attribution));
+        if (attr == NULL)
+        {
+            return -1;
+        }
+        err = variorum_get_energy_attribution(targets, attr, ntargets);
+        if (err)
+        {
+            free(attr);
+            return -1;
+        }
+    }
+
+    gethostname(hostname, 1024);
+    gettimeofday(&tv, NULL);
+    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+
+    json_t *get_attribution_obj = json_object();
+    json_t *node_obj = json_object();
+    json_t *targets_obj = json_object();
+    json_object_set_new(get_attribution_obj, hostname, node_obj);
+    json_object_set_new(node_obj, "timestamp", json_integer(ts));
+    json_object_set_new(node_obj, "interval_seconds",
+                        json_real(ntargets > 0 ? attr[0].elapsed : 0.0));
+    json_object_set_new(node_obj, "energy_attribution", targets_obj);
+
+    for (i = 0; i < ntargets; i++)
+    {
+        json_t *target_obj = json_object();
+        json_object_set_new(targets_obj, attr[i].target, target_obj);
+        json_object_set_new(target_obj, "num_threads", json_integer(attr[i].nthreads));
+        json_object_set_new(target_obj, "cpu_seconds", json_real(attr[i].cpu_seconds));
+        json_object_set_new(target_obj, "cycles", json_real(attr[i].cycles));
+        json_object_set_new(target_obj, "instructions",
+                            json_real(attr[i].instructions));
+        json_object_set_new(target_obj, "energy_joules",
+                            json_real(attr[i].energy_joules));
+        json_object_set_new(target_obj, "total_energy_joules",
+                            json_real(attr[i].total_energy_joules));
+        json_object_set_new(target_obj, "power_watts",
+                            json_real(attr[i].elapsed > 0.0 ?
+                                      attr[i].energy_joules / attr[i].elapsed : 0.0));
+    }
+    free(attr);
+
+    *get_attribution_obj_str = variorum_json_dumps(get_attribution_obj);
+    json_decref(get_attribution_obj);
+    return 0;
+}
+
+int variorum_ibm_get_sensor_id(int socket, const char *name)
+{
+    int id = -1;
+    int i;
+    int found = 0;
+    int err = 0;
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_sensor_id == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        id = g_platform[i].variorum_get_sensor_id(socket, name);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+    }
+    err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    return id;
+}
+
+int variorum_ibm_read_sensors(const int *ids, int n, double *out)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (ids == NULL || out == NULL || n < 0)
+    {
+        variorum_error_handler("Invalid sensor list", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_read_sensors == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_read_sensors(ids, n, out);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_core_energy(struct variorum_core_energy *energy)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (energy == NULL)
+    {
+        variorum_error_handler("Invalid core energy pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_core_energy == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_core_energy(energy);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_core_energy_json(char **get_core_energy_obj_str)
+{
+    struct variorum_core_energy energy;
+    struct variorum_json_writer w;
+    char hostname[1024];
+    char key[32];
+    struct timeval tv;
+    uint64_t ts;
+    int i;
+
+    if (variorum_get_core_energy(&energy) != 0)
+    {
+        return -1;
+    }
+
+    gethostname(hostname, 1024);
+    gettimeofday(&tv, NULL);
+    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+
+    // Every value comes from the struct API, so format it directly instead
+    // of building a tree.
+    variorum_json_writer_init_alloc(&w, variorum_json_format());
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_begin_object(&w, hostname);
+    variorum_json_integer(&w, "timestamp", ts);
+    variorum_json_real(&w, "interval_seconds", energy.interval);
+    variorum_json_begin_object(&w, "per_core");
+    for (i = 0; i < energy.ncores; i++)
+    {
+        snprintf(key, sizeof(key), "Core_%d", i);
+        variorum_json_begin_object(&w, key);
+        variorum_json_real(&w, "energy_joules", energy.core_joules[i]);
+        variorum_json_real(&w, "power_watts", energy.core_watts[i]);
+        variorum_json_end_object(&w);
+    }
+    variorum_json_end_object(&w);
+    variorum_json_begin_object(&w, "per_ccd");
+    for (i = 0; i < energy.nccds; i++)
+    {
+        snprintf(key, sizeof(key), "CCD_%d", i);
+        variorum_json_begin_object(&w, key);
+        variorum_json_real(&w, "energy_joules", energy.ccd_joules[i]);
+        variorum_json_real(&w, "power_watts", energy.ccd_watts[i]);
+        variorum_json_end_object(&w);
+    }
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+
+    *get_core_energy_obj_str = variorum_json_writer_take(&w);
+    return *get_core_energy_obj_str != NULL ? 0 : -1;
+}
+
+int variorum_get_socket_energy(struct variorum_socket_energy *energy)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (energy == NULL)
+    {
+        variorum_error_handler("Invalid socket energy pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_socket_energy == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_socket_energy(energy);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_gpu_energy(struct variorum_gpu_energy *energy)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (energy == NULL)
+    {
+        variorum_error_handler("Invalid GPU energy pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_gpu_energy == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_gpu_energy(energy);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_node_energy(struct variorum_node_energy *energy)
+{
+    struct variorum_socket_energy socket_energy;
+    struct variorum_gpu_energy gpu_energy;
+    struct timeval tv;
+    double socket_gpu_joules = 0.0;
+    int found = 0;
+    int have_gpus = 0;
+    int err = 0;
+    int i;
+    int j;
+
+    memset(energy, 0, sizeof(*energy));
+    if (variorum_enter(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS && !err; i++)
+    {
+        if (g_platform[i].variorum_get_socket_energy != NULL)
+        {
+            found = 1;
+            err = g_platform[i].variorum_get_socket_energy(&socket_energy);
+            for (j = 0; !err && j < socket_energy.nsockets; j++)
+            {
+                energy->cpu_joules += socket_energy.cpu_joules[j];
+                energy->mem_joules += socket_energy.mem_joules[j];
+                socket_gpu_joules += socket_energy.gpu_joules[j];
+            }
+        }
+        if (!err && g_platform[i].variorum_get_gpu_energy != NULL)
+        {
+            found = 1;
+            have_gpus = 1;
+            err = g_platform[i].variorum_get_gpu_energy(&gpu_energy);
+            for (j = 0; !err && j < gpu_energy.ngpus; j++)
+            {
+                energy->gpu_joules += gpu_energy.gpu_joules[j];
+            }
+        }
+    }
+    if (!have_gpus)
+    {
+        energy->gpu_joules = socket_gpu_joules;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+
+    gettimeofday(&tv, NULL);
+    energy->seconds = tv.tv_sec + tv.tv_usec / 1000000.0;
+    return err ? -1 : 0;
+}
+
+int variorum_get_core_frequency(struct variorum_core_frequency *freq)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (freq == NULL)
+    {
+        variorum_error_handler("Invalid core frequency pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_core_frequency == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_core_frequency(freq);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_gpu_throttle_events(int timeout_ms,
+                                     struct variorum_gpu_throttle_event *events,
+                                     int max_events)
+{
+    int i;
+    int found = 0;
+    int ret = 0;
+
+    if (events == NULL || max_events <= 0 || timeout_ms < 0)
+    {
+        variorum_error_handler("Invalid GPU throttle event buffer",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    if (variorum_enter(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_gpu_throttle_events == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        ret = g_platform[i].variorum_get_gpu_throttle_events(timeout_ms, events,
+                max_events);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        ret = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return ret < 0 ? -1 : ret;
+}
+
+int variorum_set_counter_events(const char *events)
+{
+    int err = 0;
+    int i;
+    int nevents = 0;
+    int found = 0;
+    char *buf = NULL;
+    const char **list = NULL;
+
+    if (events != NULL && events[0] != '\0' &&
+        split_attribution_targets(events, &buf, &list, &nevents))
+    {
+        variorum_error_handler("Invalid counter events", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        free(buf);
+        free(list);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        free(buf);
+        free(list);
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_set_counter_events == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_set_counter_events(list, nevents);
+        break;
+    }
+    free(buf);
+    free(list);
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_thread_counters(struct variorum_thread_counters_sample
+                                 *sample)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (sample == NULL)
+    {
+        variorum_error_handler("Invalid counters sample pointer",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_thread_counters == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_thread_counters(sample);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_thread_counters_json(char **get_counters_obj_str)
+{
+    struct variorum_thread_counters_sample sample;
+    struct variorum_thread_counters *t;
+    struct variorum_json_writer w;
+    char hostname[1024];
+    char key[32];
+    int i, e;
+
+    if (variorum_get_thread_counters(&sample) != 0)
+    {
+        return -1;
+    }
+
+    gethostname(hostname, 1024);
+
+    variorum_json_writer_init_alloc(&w, variorum_json_format());
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_begin_object(&w, hostname);
+    variorum_json_integer(&w, "timestamp", (uint64_t)(sample.seconds * 1000000.0));
+    variorum_json_real(&w, "interval_seconds", sample.interval);
+    variorum_json_integer(&w, "num_event_groups", sample.ngroups);
+    variorum_json_begin_object(&w, "per_thread");
+    for (i = 0; i < sample.nthreads; i++)
+    {
+        t = &sample.threads[i];
+        snprintf(key, sizeof(key), "Thread_%d", t->cpu);
+        variorum_json_begin_object(&w, key);
+        variorum_json_real(&w, "instructions", t->instructions);
+        variorum_json_real(&w, "cycles", t->cycles);
+        variorum_json_real(&w, "ref_cycles", t->ref_cycles);
+        variorum_json_real(&w, "ipc", t->ipc);
+        variorum_json_real(&w, "frequency_mhz", t->freq_mhz);
+        variorum_json_real(&w, "mem_bound_ratio", t->mem_bound_ratio);
+        for (e = 0; e < sample.nevents; e++)
+        {
+            variorum_json_real(&w, sample.event_names[e], t->events[e]);
+        }
+        variorum_json_end_object(&w);
+    }
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+
+    *get_counters_obj_str = variorum_json_writer_take(&w);
+    return *get_counters_obj_str != NULL ? 0 : -1;
+}
+
+int variorum_get_uncore_counters(struct variorum_uncore_sample *sample)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (sample == NULL)
+    {
+        variorum_error_handler("Invalid uncore sample pointer",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_uncore_counters == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_uncore_counters(sample);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_uncore_counters_json(char **get_uncore_obj_str)
+{
+    struct variorum_uncore_sample sample;
+    struct variorum_uncore_socket *u;
+    struct variorum_json_writer w;
+    char hostname[1024];
+    char key[32];
+    int i, b;
+
+    if (variorum_get_uncore_counters(&sample) != 0)
+    {
+        return -1;
+    }
+
+    gethostname(hostname, 1024);
+
+    variorum_json_writer_init_alloc(&w, variorum_json_format());
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_begin_object(&w, hostname);
+    variorum_json_integer(&w, "timestamp", (uint64_t)(sample.seconds * 1000000.0));
+    variorum_json_real(&w, "interval_seconds", sample.interval);
+    variorum_json_integer(&w, "num_event_groups", sample.ngroups);
+    for (i = 0; i < sample.nsockets; i++)
+    {
+        u = &sample.sockets[i];
+        snprintf(key, sizeof(key), "Socket_%d", i);
+        variorum_json_begin_object(&w, key);
+        variorum_json_real(&w, "uncore_frequency_mhz", u->uncore_freq_mhz);
+        variorum_json_real(&w, "pcu_cycles", u->pcu_cycles);
+        for (b = 0; b < VARIORUM_UNCORE_FREQ_BANDS; b++)
+        {
+            snprintf(key, sizeof(key), "freq_band_%d", b);
+            variorum_json_begin_object(&w, key);
+            variorum_json_real(&w, "threshold_mhz", u->band_mhz[b]);
+            variorum_json_real(&w, "residency", u->band_residency[b]);
+            variorum_json_end_object(&w);
+        }
+        variorum_json_real(&w, "power_limit_cycles", u->power_limit_cycles);
+        variorum_json_real(&w, "thermal_limit_cycles", u->thermal_limit_cycles);
+        variorum_json_real(&w, "mem_read_bytes_per_sec", u->mem_read_bytes_per_sec);
+        variorum_json_real(&w, "mem_write_bytes_per_sec",
+                           u->mem_write_bytes_per_sec);
+        variorum_json_end_object(&w);
+    }
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+
+    *get_uncore_obj_str = variorum_json_writer_take(&w);
+    return *get_uncore_obj_str != NULL ? 0 : -1;
+}
+
+int variorum_get_cstate_residency(struct variorum_cstate_sample *sample)
+{
+    int i;
+    int found = 0;
+    int err = 0;
+
+    if (sample == NULL)
+    {
+        variorum_error_handler("Invalid C-state sample pointer",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_cstate_residency == NULL)
+        {
+            continue;
+        }
+        found = 1;
+        err = g_platform[i].variorum_get_cstate_residency(sample);
+        break;
+    }
+    if (!found)
+    {
+        variorum_error_handler("Feature not yet implemented or is not supported",
+                               VARIORUM_ERROR_FEATURE_NOT_IMPLEMENTED,
+                               getenv("HOSTNAME"), __FILE__,
+                               __FUNCTION__, __LINE__);
+        err = -1;
+    }
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err ? -1 : 0;
+}
+
+int variorum_get_cstate_residency_json(char **get_cstate_obj_str)
+{
+    struct variorum_cstate_sample sample;
+    struct variorum_json_writer w;
+    char hostname[1024];
+    char key[32];
+    int cores_per_socket;
+    int i, j, k;
+
+    if (variorum_get_cstate_residency(&sample) != 0)
+    {
+        return -1;
+    }
+
+    gethostname(hostname, 1024);
+    cores_per_socket = sample.nsockets > 0 ? sample.ncores / sample.nsockets : 0;
+
+    variorum_json_writer_init_alloc(&w, variorum_json_format());
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_begin_object(&w, hostname);
+    variorum_json_integer(&w, "timestamp", (uint64_t)(sample.seconds * 1000000.0));
+    variorum_json_real(&w, "interval_seconds", sample.interval);
+    for (i = 0; i < sample.nsockets; i++)
+    {
+        snprintf(key, sizeof(key), "Socket_%d", sample.sockets[i].id);
+        variorum_json_begin_object(&w, key);
+        for (k = 0; k < sample.npkg_cstates; k++)
+        {
+            snprintf(key, sizeof(key), "PC%d_percent", sample.pkg_cstates[k]);
+            variorum_json_real(&w, key, sample.sockets[i].percent[k]);
+        }
+        // Cores are numbered consecutively within a socket.
+        for (j = i * cores_per_socket; j < (i + 1) * cores_per_socket; j++)
+        {
+            snprintf(key, sizeof(key), "Core_%d", sample.cores[j].id);
+            variorum_json_begin_object(&w, key);
+            for (k = 0; k < sample.ncore_cstates; k++)
+            {
+                snprintf(key, sizeof(key), "CC%d_percent", sample.core_cstates[k]);
+                variorum_json_real(&w, key, sample.cores[j].percent[k]);
+            }
+            variorum_json_end_object(&w);
+        }
+        variorum_json_end_object(&w);
+    }
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+
+    *get_cstate_obj_str = variorum_json_writer_take(&w);
+    return *get_cstate_obj_str != NULL ? 0 : -1;
+}
+
+int variorum_open(void)
+{
+    int err = 0;
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    variorum_context_acquire_all();
+    variorum_platform_hold();
+    g_open_sessions++;
+    err = variorum_exit(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+    return err;
+}
+
+int variorum_close(void)
+{
+    if (g_open_sessions == 0)
+    {
+        variorum_error_handler("No open session", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_open_sessions--;
+    variorum_platform_release();
+    variorum_context_release_all();
+    if (g_open_sessions == 0)
+    {
+        variorum_context_put_default();
+    }
+    return 0;
+}
+
 char *variorum_get_current_version()
 {
     return QuoteMacro(VARIORUM_VERSION);
@@ -10,6 +10,58 @@ module variorum
     use, intrinsic :: iso_c_binding
     implicit none
 
+    !-------------------------------------------------------------------------
+    ! Interoperable copies of the structs filled by the typed sampling
+    ! functions. Pointer members refer to arrays owned by Variorum; the
+    ! variorum_sample_* procedures below copy them into Fortran arrays.
+    !-------------------------------------------------------------------------
+
+    type, bind(C) :: variorum_socket_energy
+        integer(kind=c_int) :: nsockets
+        type(C_PTR) :: cpu_joules
+        type(C_PTR) :: mem_joules
+        type(C_PTR) :: gpu_joules
+    end type variorum_socket_energy
+
+    type, bind(C) :: variorum_gpu_energy
+        integer(kind=c_int) :: ngpus
+        integer(kind=c_int) :: gpus_per_socket
+        type(C_PTR) :: gpu_joules
+    end type variorum_gpu_energy
+
+    type, bind(C) :: variorum_node_energy
+        real(kind=c_double) :: seconds
+        real(kind=c_double) :: cpu_joules
+        real(kind=c_double) :: mem_joules
+        real(kind=c_double) :: gpu_joules
+    end type variorum_node_energy
+
+    type, bind(C) :: variorum_core_frequency
+        integer(kind=c_int) :: ncores
+        real(kind=c_double) :: interval
+        type(C_PTR) :: avg_mhz
+    end type variorum_core_frequency
+
+    type, bind(C) :: variorum_region_energy
+        integer(kind=c_long) :: count
+        real(kind=c_double) :: seconds
+        real(kind=c_double) :: cpu_joules
+        real(kind=c_double) :: mem_joules
+        real(kind=c_double) :: gpu_joules
+    end type variorum_region_energy
+
+    ! Formats accepted by variorum_set_json_format() and the
+    ! variorum_get_*_json_buf() functions.
+    integer(kind=c_int), parameter :: VARIORUM_JSON_PRETTY = 0
+    integer(kind=c_int), parameter :: VARIORUM_JSON_COMPACT = 1
+
+    ! Previous reading of variorum_sample_socket_power().
+    real(kind=c_double), allocatable, private :: prev_cpu_joules(:)
+    real(kind=c_double), allocatable, private :: prev_mem_joules(:)
+    integer(kind=c_int64_t), private :: prev_clock = -1
+
+    private :: copy_doubles
+
     !-------------------------------------------------------------------------
     interface
     !-------------------------------------------------------------------------
@@ -212,10 +264,285 @@ module variorum
         implicit none
     end function variorum_disable_turbo
 
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_socket_energy(energy) &
+            bind(C)
+        import
+        implicit none
+        type(variorum_socket_energy), intent(out) ::energy
+    end function variorum_get_socket_energy
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_gpu_energy(energy) &
+            bind(C)
+        import
+        implicit none
+        type(variorum_gpu_energy), intent(out) ::energy
+    end function variorum_get_gpu_energy
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_node_energy(energy) &
+            bind(C)
+        import
+        implicit none
+        type(variorum_node_energy), intent(out) ::energy
+    end function variorum_get_node_energy
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_core_frequency(freq) &
+            bind(C)
+        import
+        implicit none
+        type(variorum_core_frequency), intent(out) ::freq
+    end function variorum_get_core_frequency
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_set_json_format(format) &
+            bind(C)
+        import
+        implicit none
+        integer(kind=c_int), value, intent(in) ::format
+    end function variorum_set_json_format
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_energy_json(json) &
+            bind(C)
+        import
+        implicit none
+        type(C_PTR), intent(out) ::json
+    end function variorum_get_energy_json
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_energy_json_buf(buf, size, format) &
+            bind(C)
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(out) ::buf
+        integer(kind=c_size_t), value, intent(in) ::size
+        integer(kind=c_int), value, intent(in) ::format
+    end function variorum_get_energy_json_buf
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_power_json_buf(buf, size, format) &
+            bind(C)
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(out) ::buf
+        integer(kind=c_size_t), value, intent(in) ::size
+        integer(kind=c_int), value, intent(in) ::format
+    end function variorum_get_power_json_buf
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_thermals_json_buf(buf, size, format) &
+            bind(C)
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(out) ::buf
+        integer(kind=c_size_t), value, intent(in) ::size
+        integer(kind=c_int), value, intent(in) ::format
+    end function variorum_get_thermals_json_buf
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_frequency_json_buf(buf, size, format) &
+            bind(C)
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(out) ::buf
+        integer(kind=c_size_t), value, intent(in) ::size
+        integer(kind=c_int), value, intent(in) ::format
+    end function variorum_get_frequency_json_buf
+
+    !-------------------------------------------------------------------------
+    subroutine variorum_free_json(json) &
+            bind(C)
+        import
+        implicit none
+        type(C_PTR), value, intent(in) ::json
+    end subroutine variorum_free_json
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_region_begin_c(name) &
+            bind(C, name="variorum_region_begin")
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(in) ::name
+    end function variorum_region_begin_c
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_region_end_c(name) &
+            bind(C, name="variorum_region_end")
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(in) ::name
+    end function variorum_region_end_c
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_region_energy_c(name, energy) &
+            bind(C, name="variorum_get_region_energy")
+        import
+        implicit none
+        character(kind=c_char), dimension(*), intent(in) ::name
+        type(variorum_region_energy), intent(out) ::energy
+    end function variorum_get_region_energy_c
+
     !-------------------------------------------------------------------------
     end interface
     !-------------------------------------------------------------------------
 
+contains
+
+    ! The procedures below copy Variorum-owned arrays into arrays supplied by
+    ! the caller. At most size(array) entries are copied; the count returned
+    ! is the number the platform reports, so a short array can be detected.
+    ! Each returns 0 if successful, otherwise -1.
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_sample_socket_energy(cpu_joules, mem_joules, &
+                                                   nsockets)
+        implicit none
+        real(kind=c_double), intent(out) ::cpu_joules(:)
+        real(kind=c_double), intent(out) ::mem_joules(:)
+        integer, intent(out) ::nsockets
+        type(variorum_socket_energy) ::energy
+
+        nsockets = 0
+        variorum_sample_socket_energy = variorum_get_socket_energy(energy)
+        if (variorum_sample_socket_energy .ne. 0) return
+        nsockets = energy%nsockets
+        call copy_doubles(energy%cpu_joules, nsockets, cpu_joules)
+        call copy_doubles(energy%mem_joules, nsockets, mem_joules)
+    end function variorum_sample_socket_energy
+
+    !-------------------------------------------------------------------------
+    ! Average processor and memory power of each socket since the previous
+    ! call, from the socket energy counters. The first call reports 0 Watts.
+    integer(kind=c_int) &
+            function variorum_sample_socket_power(cpu_watts, mem_watts, &
+                                                  nsockets)
+        implicit none
+        real(kind=c_double), intent(out) ::cpu_watts(:)
+        real(kind=c_double), intent(out) ::mem_watts(:)
+        integer, intent(out) ::nsockets
+        real(kind=c_double), allocatable ::cpu_joules(:)
+        real(kind=c_double), allocatable ::mem_joules(:)
+        type(variorum_socket_energy) ::energy
+        integer(kind=c_int64_t) ::clock, rate
+        real(kind=c_double) ::interval
+        integer ::n
+
+        nsockets = 0
+        cpu_watts = 0.0_c_double
+        mem_watts = 0.0_c_double
+        variorum_sample_socket_power = variorum_get_socket_energy(energy)
+        if (variorum_sample_socket_power .ne. 0) return
+        call system_clock(clock, rate)
+        nsockets = energy%nsockets
+        allocate(cpu_joules(nsockets), mem_joules(nsockets))
+        call copy_doubles(energy%cpu_joules, nsockets, cpu_joules)
+        call copy_doubles(energy%mem_joules, nsockets, mem_joules)
+
+        if (prev_clock .ge. 0 .and. allocated(prev_cpu_joules)) then
+            if (size(prev_cpu_joules) .eq. nsockets .and. clock .gt. prev_clock) then
+                interval = real(clock - prev_clock, c_double) / real(rate, c_double)
+                n = min(nsockets, size(cpu_watts), size(mem_watts))
+                cpu_watts(1:n) = (cpu_joules(1:n) - prev_cpu_joules(1:n)) / interval
+                mem_watts(1:n) = (mem_joules(1:n) - prev_mem_joules(1:n)) / interval
+            end if
+        end if
+        call move_alloc(cpu_joules, prev_cpu_joules)
+        call move_alloc(mem_joules, prev_mem_joules)
+        prev_clock = clock
+    end function variorum_sample_socket_power
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_sample_gpu_energy(gpu_joules, ngpus)
+        implicit none
+        real(kind=c_double), intent(out) ::gpu_joules(:)
+        integer, intent(out) ::ngpus
+        type(variorum_gpu_energy) ::energy
+
+        ngpus = 0
+        variorum_sample_gpu_energy = variorum_get_gpu_energy(energy)
+        if (variorum_sample_gpu_energy .ne. 0) return
+        ngpus = energy%ngpus
+        call copy_doubles(energy%gpu_joules, ngpus, gpu_joules)
+    end function variorum_sample_gpu_energy
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_sample_core_frequency(avg_mhz, ncores)
+        implicit none
+        real(kind=c_double), intent(out) ::avg_mhz(:)
+        integer, intent(out) ::ncores
+        type(variorum_core_frequency) ::freq
+
+        ncores = 0
+        variorum_sample_core_frequency = variorum_get_core_frequency(freq)
+        if (variorum_sample_core_frequency .ne. 0) return
+        ncores = freq%ncores
+        call copy_doubles(freq%avg_mhz, ncores, avg_mhz)
+    end function variorum_sample_core_frequency
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_region_begin(name)
+        implicit none
+        character(len=*), intent(in) ::name
+
+        variorum_region_begin = variorum_region_begin_c(trim(name) // c_null_char)
+    end function variorum_region_begin
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_region_end(name)
+        implicit none
+        character(len=*), intent(in) ::name
+
+        variorum_region_end = variorum_region_end_c(trim(name) // c_null_char)
+    end function variorum_region_end
+
+    !-------------------------------------------------------------------------
+    integer(kind=c_int) &
+            function variorum_get_region_energy(name, energy)
+        implicit none
+        character(len=*), intent(in) ::name
+        type(variorum_region_energy), intent(out) ::energy
+
+        variorum_get_region_energy = &
+            variorum_get_region_energy_c(trim(name) // c_null_char, energy)
+    end function variorum_get_region_energy
+
+    !-------------------------------------------------------------------------
+    subroutine copy_doubles(src, n, dest)
+        implicit none
+        type(C_PTR), intent(in) ::src
+        integer, intent(in) ::n
+        real(kind=c_double), intent(out) ::dest(:)
+        real(kind=c_double), pointer ::values(:)
+        integer ::m
+
+        dest = 0.0_c_double
+        m = min(n, size(dest))
+        if (m .le. 0 .or. .not. c_associated(src)) return
+        call c_f_pointer(src, values, [n])
+        dest(1:m) = values(1:m)
+    end subroutine copy_doubles
+
 !-----------------------------------------------------------------------------
 end module variorum
 !-----------------------------------------------------------------------------
@@ -156,6 +156,26 @@ int variorum_cap_socket_frequency_limit(int socketid, int socket_freq_mhz);
 /// @return 0 if successful, otherwise -1
 int variorum_cap_each_gpu_power_limit(int gpu_power_limit);
 
+/// @brief Cap the power usage of each GPU on the node to its own limit.
+///
+/// Each limit is written and read back, allowing for devices that round it.
+/// If any GPU does not take its limit, the previous limits of all GPUs are
+/// restored. The GPUs are capped one after another by default; set
+/// VARIORUM_GPU_CAP_THREADS=1 to cap them concurrently.
+///
+/// @supparch
+/// - NVIDIA Volta, Ampere
+/// - AMD Instinct (MI-50 onwards)
+/// - Intel Discrete GPU
+///
+/// @param [in] ngpus Number of GPUs on the node.
+/// @param [in] gpu_power_limits Desired power limit in watts for each GPU,
+///             indexed by node-wide GPU ID. A limit of 0 leaves that GPU
+///             unchanged.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_cap_gpu_power_limits(int ngpus, const int *gpu_power_limits);
+
 /*******************/
 /* Print Functions */
 /*******************/
@@ -538,6 +558,27 @@ int variorum_disable_turbo(void);
 /****************/
 /* JSON Support */
 /****************/
+/// @brief Indented output, four spaces per level (the default).
+#define VARIORUM_JSON_PRETTY  0
+/// @brief Output without any whitespace.
+#define VARIORUM_JSON_COMPACT 1
+
+/// @brief Select how the JSON APIs that return an allocated string format
+/// it. Compact output is about half the size of indented output and faster
+/// to produce and to parse.
+///
+/// @param [in] format VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_set_json_format(int format);
+
+/// @brief Release a string returned by one of the JSON APIs. Callers that do
+/// not share Variorum's C allocator (e.g., Python or Fortran) must use this
+/// rather than their own free.
+///
+/// @param [in] json String to release, may be NULL.
+void variorum_free_json(char *json);
+
 /// @brief Populate a string in JSON format with total node power, socket-level,
 /// memory-level and GPU-level power.
 ///
@@ -566,6 +607,42 @@ int variorum_disable_turbo(void);
 /// check for NULL strings.
 int variorum_get_power_json(char **get_power_obj_str);
 
+/// @brief Format the node power as JSON directly into a buffer owned by the
+/// caller.
+///
+/// Unlike variorum_get_power_json(), no JSON tree is built, so a poller can
+/// reuse one buffer for every sample. Power is averaged over the interval
+/// since the previous call, from the same energy counters as
+/// variorum_get_energy_json_buf(), so short bursts between two calls are
+/// included. The first call has no interval and reports 0. The schema is
+/// fixed and the same on every platform; members are always present and 0
+/// where a platform does not report a domain:
+///
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "socket_<n>": {
+///             "power_cpu_watts": power,
+///             "power_mem_watts": power,
+///             "power_gpu_watts": power
+///         },
+///         "power_node_watts": power
+///     }
+/// }
+///
+/// @supparch
+/// - Same as variorum_get_node_energy()
+///
+/// @param [out] buf Buffer for the NUL-terminated string. Output that does
+///              not fit is truncated.
+/// @param [in] size Capacity of buf.
+/// @param [in] format VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+///
+/// @return Length of the complete string, excluding the NUL, as with
+/// snprintf(). A result of size or more means buf was too small. -1 on
+/// error.
+int variorum_get_power_json_buf(char *buf, size_t size, int format);
+
 /// @brief Populate a string in JSON format with total CPU node utilization, user
 /// CPU utilization, kernel CPU utilization, total node memory utilization, and GPU
 /// utilization.
@@ -577,6 +654,23 @@ int variorum_get_power_json(char **get_power_obj_str);
 ///             "total_util%": total_CPU_utilization,
 ///             "user_util%": user_utilization,
 ///             "system_util%": system_utilization,
+///             "iowait_util%": iowait_utilization,
+///             "irq_util%": irq_and_softirq_utilization,
+///             "steal_util%": steal_utilization,
+///             "per_cpu": {
+///                 "CPU_c": { <same six *_util% fields> }
+///             },
+///             "per_socket": {
+///                 "Socket_n": { <same six *_util% fields> }
+///             },
+///             "per_numa_node": {
+///                 "Node_k": {
+///                     <same six *_util% fields>,
+///                     "memory_util%": node_memory_utilization,
+///                     "memory_total_kB": node_memory_total,
+///                     "memory_free_kB": node_memory_free
+///                 }
+///             }
 ///         },
 ///         "GPU": {
 ///             Socket_n : {
@@ -585,7 +679,10 @@ int variorum_get_power_json(char **get_power_obj_str);
 ///         "memory_util%": total_memory_utilization,
 ///         "timestamp" : timestamp
 /// }
-/// where n is the socket number and m is the GPU id.
+/// where n is the socket number, m is the GPU id, c is the OS CPU number and
+/// k is the NUMA node. Sockets and NUMA nodes are aggregated from the logical
+/// CPUs with the hwloc topology. CPU utilization is measured since the
+/// previous call and is reported as 0 on the first call.
 ///
 /// @supparch
 /// - AMD Radeon Instinct GPUs (MI50 onwards)
@@ -677,6 +774,46 @@ int variorum_get_node_power_domain_info_json(char **get_domain_obj_str);
 /// check for NULL strings.
 int variorum_get_thermals_json(char **get_thermal_obj_str);
 
+/// @brief Format the node temperatures as JSON directly into a buffer owned
+/// by the caller.
+///
+/// Unlike variorum_get_thermals_json(), no JSON tree is built, so a poller
+/// can reuse one buffer for every sample. The schema is fixed; the CPU
+/// members are present where a CPU platform reports temperatures, and one
+/// GPU member per GPU attached to the socket:
+///
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "socket_<n>": {
+///             "temp_celsius_pkg": temperature,
+///             "temp_celsius_core_<c>": temperature,
+///             "temp_celsius_gpu_<d>": temperature
+///         }
+///     }
+/// }
+///
+/// where c is the core number within the socket and d the GPU number.
+///
+/// @supparch
+/// - Intel Sandy Bridge
+/// - Intel Ivy Bridge
+/// - Intel Haswell
+/// - Intel Broadwell
+/// - Intel Skylake
+/// - Intel Kaby Lake
+/// - NVIDIA Volta
+///
+/// @param [out] buf Buffer for the NUL-terminated string. Output that does
+///              not fit is truncated.
+/// @param [in] size Capacity of buf.
+/// @param [in] format VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+///
+/// @return Length of the complete string, excluding the NUL, as with
+/// snprintf(). A result of size or more means buf was too small. -1 on
+/// error.
+int variorum_get_thermals_json_buf(char *buf, size_t size, int format);
+
 /// @brief Populate a string in JSON format with node level frequency information
 ///
 /// @supparch
@@ -698,8 +835,50 @@ int variorum_get_thermals_json(char **get_thermal_obj_str);
 /// check for NULL strings.
 int variorum_get_frequency_json(char **get_frequency_obj_str);
 
+/// @brief Format the node frequencies as JSON directly into a buffer owned
+/// by the caller.
+///
+/// Unlike variorum_get_frequency_json(), no JSON tree is built, so a poller
+/// can reuse one buffer for every sample. Core frequencies are averaged over
+/// the interval since the previous call, as with
+/// variorum_get_core_frequency(); GPU clocks are current values. The schema
+/// is fixed; the CPU members are present where a CPU platform reports core
+/// frequencies, and two GPU members per GPU attached to the socket:
+///
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "socket_<n>": {
+///             "cpu_avg_freq_mhz": frequency,
+///             "core_<c>_avg_freq_mhz": frequency,
+///             "gpu_<d>_freq_mhz": frequency,
+///             "gpu_<d>_mem_freq_mhz": frequency
+///         }
+///     }
+/// }
+///
+/// where c is the core number within the socket and d the GPU number.
+///
+/// @supparch
+/// - Same as variorum_get_core_frequency()
+/// - NVIDIA Volta
+///
+/// @param [out] buf Buffer for the NUL-terminated string. Output that does
+///              not fit is truncated.
+/// @param [in] size Capacity of buf.
+/// @param [in] format VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+///
+/// @return Length of the complete string, excluding the NUL, as with
+/// snprintf(). A result of size or more means buf was too small. -1 on
+/// error.
+int variorum_get_frequency_json_buf(char *buf, size_t size, int format);
+
 /// @brief Populate a string in JSON format with node level energy information
 ///
+/// GPU energy counters are reported per socket under "energy_gpu_joules" and,
+/// except on IBM Power9 where the node sensor already includes the GPUs,
+/// added to "energy_node_joules".
+///
 /// @supparch
 /// - IBM Power9
 /// - Intel Sandy Bridge
@@ -710,6 +889,9 @@ int variorum_get_frequency_json(char **get_frequency_obj_str);
 /// - Intel Kaby Lake
 /// - Intel Cascade Lake
 /// - Intel Cooper Lake
+/// - NVIDIA Volta, Ampere
+/// - AMD Instinct (MI-50 onwards)
+/// - Intel Discrete GPU
 ///
 /// @param [out] get_energy_obj_str String (passed by reference) containing
 /// the node-level energy information.
@@ -719,6 +901,819 @@ int variorum_get_frequency_json(char **get_frequency_obj_str);
 /// check for NULL strings.
 int variorum_get_energy_json(char **get_energy_obj_str);
 
+/// @brief Format the node energy counters as JSON directly into a buffer
+/// owned by the caller.
+///
+/// Unlike variorum_get_energy_json(), no JSON tree is built and nothing is
+/// allocated, so a poller can reuse one buffer for every sample. The schema
+/// is fixed and the same on every platform; members are always present and
+/// 0 where a platform does not report a domain:
+///
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "socket_<n>": {
+///             "energy_cpu_joules": energy,
+///             "energy_mem_joules": energy,
+///             "energy_gpu_joules": energy
+///         },
+///         "energy_node_joules": energy
+///     }
+/// }
+///
+/// "energy_gpu_joules" sums the GPUs attached to the socket, or comes from
+/// the socket's own sensors on IBM Power9.
+///
+/// @supparch
+/// - Same as variorum_get_node_energy()
+///
+/// @param [out] buf Buffer for the NUL-terminated string. Output that does
+///              not fit is truncated.
+/// @param [in] size Capacity of buf.
+/// @param [in] format VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+///
+/// @return Length of the complete string, excluding the NUL, as with
+/// snprintf(). A result of size or more means buf was too small. -1 on
+/// error.
+int variorum_get_energy_json_buf(char *buf, size_t size, int format);
+
+/// @brief Maximum length of an energy attribution target, including the
+/// terminating NUL.
+#define VARIORUM_ATTRIBUTION_TARGET_LEN 256
+
+/// @brief Package energy and activity attributed to one process or cgroup
+/// over the interval since the previous call.
+struct variorum_energy_attribution
+{
+    /// @brief PID or cgroup directory, as passed in.
+    char target[VARIORUM_ATTRIBUTION_TARGET_LEN];
+    /// @brief Number of threads found for the target.
+    int nthreads;
+    /// @brief Length of the interval (in seconds).
+    double elapsed;
+    /// @brief CPU time used by the target during the interval (in seconds).
+    double cpu_seconds;
+    /// @brief Estimated core cycles used by the target during the interval.
+    double cycles;
+    /// @brief Estimated instructions retired by the target during the
+    /// interval.
+    double instructions;
+    /// @brief Package energy attributed during the interval (in Joules).
+    double energy_joules;
+    /// @brief Package energy attributed since the target was first sampled
+    /// (in Joules). A target left out of a call is forgotten, and its total
+    /// restarts from zero if it is requested again.
+    double total_energy_joules;
+};
+
+/// @brief Apportion package energy used since the previous call to a set of
+/// processes or cgroups. Each CPU's share of its package energy follows the
+/// active cycles it ran (APERF), and each target is charged for the cycles its
+/// threads used (from /proc/<tid>/stat and APERF/MPERF). The first call
+/// establishes a baseline and reports zero energy.
+///
+/// @supparch
+/// - Intel Haswell
+/// - Intel Broadwell
+/// - Intel Skylake
+/// - Intel Cascade Lake
+/// - Intel Cooper Lake
+///
+/// @param [in] targets Comma-separated list of PIDs and/or cgroup directories
+/// (e.g., "1234,/sys/fs/cgroup/slurm/job_42").
+/// @param [out] attr Array with one entry per target, in the same order.
+/// @param [in] max_targets Number of entries in attr.
+///
+/// @return 0 if successful, otherwise -1. Note that feature not implemented
+/// returns a -1 so that users don't read an unpopulated array.
+int variorum_get_energy_attribution(const char *targets,
+                                    struct variorum_energy_attribution *attr, int max_targets);
+
+/// @brief Populate a string in JSON format with package energy apportioned to
+/// a set of processes or cgroups (see variorum_get_energy_attribution()).
+///
+/// Format:
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "interval_seconds": elapsed,
+///         "energy_attribution": {
+///             target: {
+///                 "num_threads": n,
+///                 "cpu_seconds": cpu_seconds,
+///                 "cycles": cycles,
+///                 "instructions": instructions,
+///                 "energy_joules": interval energy,
+///                 "total_energy_joules": cumulative energy,
+///                 "power_watts": average power over the interval
+///             }
+///         }
+///     }
+/// }
+///
+/// @supparch
+/// - Intel Haswell
+/// - Intel Broadwell
+/// - Intel Skylake
+/// - Intel Cascade Lake
+/// - Intel Cooper Lake
+///
+/// @param [in] targets Comma-separated list of PIDs and/or cgroup directories.
+/// @param [out] get_attribution_obj_str String (passed by reference) that
+/// contains the per-target energy.
+///
+/// @return 0 if successful, otherwise -1. Note that feature not implemented
+/// returns a -1 for the JSON APIs so that users don't have to explicitly
+/// check for NULL strings.
+int variorum_get_energy_attribution_json(const char *targets,
+        char **get_attribution_obj_str);
+
+/// @brief Look up an OCC sensor by name (e.g., "PWRSYS", "TEMPPROCTHRMC3")
+/// on one socket. The names block of each OCC data block is indexed once, so
+/// the returned ID can be reused for any number of reads.
+///
+/// @supparch
+/// - IBM Power9
+///
+/// @param [in] socket Socket (OCC) to search.
+/// @param [in] name Sensor name as listed in the OCC names block.
+///
+/// @return Opaque sensor ID, otherwise -1.
+int variorum_ibm_get_sensor_id(int socket, const char *name);
+
+/// @brief Read a batch of OCC sensors by ID. Every value is the scaled sample
+/// from the newer of the ping and pong buffers, and each socket's data block
+/// is read at most once per call.
+///
+/// @supparch
+/// - IBM Power9
+///
+/// @param [in] ids Sensor IDs from variorum_ibm_get_sensor_id().
+/// @param [in] n Number of IDs.
+/// @param [out] out Array of n sensor values, in the sensors' units.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_ibm_read_sensors(const int *ids, int n, double *out);
+
+/// @brief Energy and power of each core and CCD. The arrays are owned by
+/// Variorum and stay valid until the next call to
+/// variorum_get_core_energy().
+struct variorum_core_energy
+{
+    /// @brief Number of entries in core_joules and core_watts.
+    int ncores;
+    /// @brief Number of entries in ccd_joules and ccd_watts.
+    int nccds;
+    /// @brief Length of the interval since the previous call (in seconds).
+    double interval;
+    /// @brief Energy counter of each core, extended to 64 bits (in Joules).
+    double *core_joules;
+    /// @brief Average power of each core over the interval (in Watts).
+    double *core_watts;
+    /// @brief Sum of core_joules over the cores of each CCD (in Joules).
+    double *ccd_joules;
+    /// @brief Sum of core_watts over the cores of each CCD (in Watts).
+    double *ccd_watts;
+};
+
+/// @brief Sample the energy counter of every core with one batched MSR read.
+/// The 32-bit hardware counters are extended to 64 bits across wraps, so
+/// energy stays correct as long as each counter is read at least once per
+/// wrap period. Cores are grouped into CCDs by the L3 cache they share. The
+/// first call establishes the baseline and reports zero power.
+///
+/// @supparch
+/// - AMD EPYC Milan
+/// - AMD EPYC Genoa
+///
+/// @param [out] energy Filled with pointers to the per-core and per-CCD
+/// values.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_core_energy(struct variorum_core_energy *energy);
+
+/// @brief Populate a string in JSON format with per-core and per-CCD energy
+/// and power (see variorum_get_core_energy()).
+///
+/// Format:
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "interval_seconds": elapsed,
+///         "per_core": {
+///             "Core_<n>": {
+///                 "energy_joules": energy,
+///                 "power_watts": power
+///             }
+///         },
+///         "per_ccd": {
+///             "CCD_<n>": {
+///                 "energy_joules": energy,
+///                 "power_watts": power
+///             }
+///         }
+///     }
+/// }
+///
+/// @supparch
+/// - AMD EPYC Milan
+/// - AMD EPYC Genoa
+///
+/// @param [out] get_core_energy_obj_str String (passed by reference) that
+/// contains the per-core and per-CCD energy.
+///
+/// @return 0 if successful, otherwise -1. Note that feature not implemented
+/// returns a -1 for the JSON APIs so that users don't have to explicitly
+/// check for NULL strings.
+int variorum_get_core_energy_json(char **get_core_energy_obj_str);
+
+/// @brief Energy of each socket. The arrays are owned by Variorum and stay
+/// valid until the next call to variorum_get_socket_energy().
+struct variorum_socket_energy
+{
+    /// @brief Number of entries in each array.
+    int nsockets;
+    /// @brief Processor (package) energy counter of each socket (in Joules).
+    double *cpu_joules;
+    /// @brief Memory energy counter of each socket (in Joules), 0 if the
+    /// platform does not report it.
+    double *mem_joules;
+    /// @brief Energy of the GPUs measured by the socket's own power sensors
+    /// (in Joules), 0 if the platform does not report it. Only IBM Power9
+    /// reports GPU energy this way; use variorum_get_gpu_energy() elsewhere.
+    double *gpu_joules;
+};
+
+/// @brief Get the energy counters of each socket with one batched read. The
+/// counters only grow, so the energy used between two calls is the
+/// difference of the two readings.
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake
+/// - AMD EPYC Milan, Genoa
+/// - IBM Power9
+///
+/// @param [out] energy Filled with pointers to the per-socket energy.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_socket_energy(struct variorum_socket_energy *energy);
+
+/// @brief Energy of each GPU. The array is owned by Variorum and stays valid
+/// until the next call to variorum_get_gpu_energy().
+struct variorum_gpu_energy
+{
+    /// @brief Number of entries in gpu_joules.
+    int ngpus;
+    /// @brief Number of GPUs attached to each socket. GPU d belongs to socket
+    /// d / gpus_per_socket.
+    int gpus_per_socket;
+    /// @brief Energy counter of each GPU (in Joules). The counters only grow,
+    /// so the energy used between two calls is the difference of the two
+    /// readings.
+    double *gpu_joules;
+};
+
+/// @brief Read the hardware energy counter of every GPU. Unlike integrating
+/// sampled power, the counters include every short burst between two reads.
+/// NVIDIA and Intel GPUs report 64-bit counters; AMD GPU counters are
+/// extended to 64 bits across wraps, as long as each counter is read at
+/// least once per wrap period.
+///
+/// @supparch
+/// - NVIDIA Volta, Ampere
+/// - AMD Instinct (MI-50 onwards)
+/// - Intel Discrete GPU
+///
+/// @param [out] energy Filled with a pointer to the per-GPU energy.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_gpu_energy(struct variorum_gpu_energy *energy);
+
+/// @brief Energy counters of the whole node at one point in time.
+struct variorum_node_energy
+{
+    /// @brief Time of the reading (in seconds since the epoch).
+    double seconds;
+    /// @brief Processor energy counter summed over sockets (in Joules).
+    double cpu_joules;
+    /// @brief Memory energy counter summed over sockets (in Joules).
+    double mem_joules;
+    /// @brief GPU energy counter summed over GPUs (in Joules).
+    double gpu_joules;
+};
+
+/// @brief Read the energy counters of every platform on the node once and
+/// sum them. GPU energy comes from the GPU platforms when there are any,
+/// otherwise from the socket sensors (IBM Power9), so that it is not counted
+/// twice.
+///
+/// @supparch
+/// - Same as variorum_get_socket_energy() and variorum_get_gpu_energy()
+///
+/// @param [out] energy Node-wide energy counters.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_node_energy(struct variorum_node_energy *energy);
+
+/// @brief Average frequency of each core. The array is owned by Variorum and
+/// stays valid until the next call to variorum_get_core_frequency().
+struct variorum_core_frequency
+{
+    /// @brief Number of entries in avg_mhz.
+    int ncores;
+    /// @brief Length of the interval since the previous call (in seconds).
+    double interval;
+    /// @brief Average frequency of each core while it was not halted during
+    /// the interval (in MHz), or 0 if the core was halted throughout.
+    double *avg_mhz;
+};
+
+/// @brief Sample the APERF and MPERF counters of every hardware thread with
+/// one batched MSR read, and compute the average frequency of each core over
+/// the interval since the previous call. The frequency of a core is the mean
+/// over its hardware threads that were active in the interval. The first
+/// call reports the average since the counters were last reset.
+///
+/// @supparch
+/// - Intel Sandy Bridge, Ivy Bridge, Haswell, Broadwell, Skylake/Cascade
+///   Lake, Kaby Lake
+///
+/// @param [out] freq Filled with a pointer to the per-core frequency.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_core_frequency(struct variorum_core_frequency *freq);
+
+/// @brief Reasons a GPU runs below its requested clocks, reported as a bit
+/// mask in struct variorum_gpu_throttle_event.
+#define VARIORUM_GPU_THROTTLE_IDLE              0x01
+#define VARIORUM_GPU_THROTTLE_APP_CLOCKS        0x02
+#define VARIORUM_GPU_THROTTLE_POWER_CAP         0x04
+#define VARIORUM_GPU_THROTTLE_HW_SLOWDOWN       0x08
+#define VARIORUM_GPU_THROTTLE_SW_THERMAL        0x10
+#define VARIORUM_GPU_THROTTLE_HW_THERMAL        0x20
+#define VARIORUM_GPU_THROTTLE_HW_POWER_BRAKE    0x40
+#define VARIORUM_GPU_THROTTLE_OTHER             0x80
+
+/// @brief A change in the throttle reasons of one GPU.
+struct variorum_gpu_throttle_event
+{
+    /// @brief Time the change was observed (in microseconds since the
+    /// epoch).
+    unsigned long long timestamp_us;
+    /// @brief Node-wide GPU ID.
+    int gpu;
+    /// @brief Throttle reasons before the change (VARIORUM_GPU_THROTTLE_*).
+    unsigned int previous_reasons;
+    /// @brief Throttle reasons after the change (VARIORUM_GPU_THROTTLE_*).
+    unsigned int reasons;
+    /// @brief Cumulative time the GPU was held below its clocks by its power
+    /// limit (in seconds), or -1 if not reported.
+    double power_violation_s;
+    /// @brief Cumulative time the GPU was held below its clocks by thermal
+    /// limits (in seconds), or -1 if not reported.
+    double thermal_violation_s;
+};
+
+/// @brief Report GPUs whose throttle reasons changed since the previous
+/// call. The first call compares against an unthrottled GPU, so GPUs that
+/// are already throttled are reported once.
+///
+/// If nothing has changed, the call waits up to timeout_ms for a change,
+/// rereading the GPUs every VARIORUM_GPU_THROTTLE_POLL_MS milliseconds
+/// (default 250). Where the vendor library delivers events (NVML event sets),
+/// a clock or performance state change wakes the wait before the interval
+/// ends.
+///
+/// @supparch
+/// - NVIDIA Volta, Ampere
+/// - AMD Instinct (MI-50 onwards)
+///
+/// @param [in] timeout_ms Longest time to wait for a change, 0 to return
+///             immediately.
+/// @param [out] events Filled with one record per change.
+/// @param [in] max_events Capacity of events. Changes that do not fit are
+///             reported by the next call.
+///
+/// @return Number of records written, otherwise -1
+int variorum_get_gpu_throttle_events(int timeout_ms,
+                                     struct variorum_gpu_throttle_event *events,
+                                     int max_events);
+
+/// @brief Maximum number of programmable events sampled at once by
+/// variorum_get_thread_counters().
+#define VARIORUM_MAX_COUNTER_EVENTS 32
+
+/// @brief Counter deltas of one hardware thread over the interval since the
+/// previous call to variorum_get_thread_counters().
+struct variorum_thread_counters
+{
+    /// @brief Logical CPU (OS numbering).
+    int cpu;
+    /// @brief Instructions retired (fixed counter 0).
+    double instructions;
+    /// @brief Core cycles while not halted (fixed counter 1).
+    double cycles;
+    /// @brief Reference cycles at the base frequency while not halted (fixed
+    /// counter 2).
+    double ref_cycles;
+    /// @brief Instructions per cycle, or 0 if the thread was halted
+    /// throughout.
+    double ipc;
+    /// @brief Average frequency while not halted (in MHz).
+    double freq_mhz;
+    /// @brief Fraction of cycles stalled on memory, or 0 if the model's
+    /// memory stall event is not in the event list.
+    double mem_bound_ratio;
+    /// @brief Scaled count of each programmable event, in the order of
+    /// event_names in struct variorum_thread_counters_sample.
+    double *events;
+};
+
+/// @brief One sample of the fixed and programmable counters of every
+/// hardware thread. The arrays are owned by Variorum and stay valid until
+/// the next call to variorum_get_thread_counters() or
+/// variorum_set_counter_events().
+struct variorum_thread_counters_sample
+{
+    /// @brief Time of the reading (in seconds since the epoch).
+    double seconds;
+    /// @brief Length of the interval since the previous call (in seconds).
+    double interval;
+    /// @brief Number of entries in threads.
+    int nthreads;
+    /// @brief Number of programmable events.
+    int nevents;
+    /// @brief Number of event groups the events are multiplexed over. Events
+    /// of groups that were not counting during the interval are extrapolated
+    /// from the last interval in which they were.
+    int ngroups;
+    /// @brief Names of the programmable events.
+    const char **event_names;
+    /// @brief Counters of each hardware thread.
+    struct variorum_thread_counters *threads;
+};
+
+/// @brief Choose the programmable events sampled by
+/// variorum_get_thread_counters(). Events are named as in the Intel SDM
+/// (e.g., "LONGEST_LAT_CACHE.MISS") and looked up in the event table of the
+/// running model. If there are more events than general-purpose counters,
+/// they are split into groups that take turns on the counters, one group
+/// per call to variorum_get_thread_counters().
+///
+/// Without a call to this function, the model's memory stall event is
+/// sampled, so that mem_bound_ratio is available.
+///
+/// The sampler and variorum_print_counters() program the same
+/// general-purpose counters, so only the first of the two used in a process
+/// gets them; the other fails from then on.
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake
+///
+/// @param [in] events Comma-separated list of event names, or NULL or an
+///             empty string for the default list.
+///
+/// @return 0 if successful, otherwise -1 (including for unknown events)
+int variorum_set_counter_events(const char *events);
+
+/// @brief Read the fixed counters, the general-purpose counters and the
+/// timestamp of every hardware thread with batched MSR reads, and compute
+/// per-thread deltas, IPC, frequency and memory-bound ratio over the
+/// interval since the previous call. The first call only establishes the
+/// baseline and reports zero deltas.
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake
+///
+/// @param [out] sample Filled with the per-thread counters.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_thread_counters(struct variorum_thread_counters_sample
+                                 *sample);
+
+/// @brief Populate a string in JSON format with one sample of the per-thread
+/// counters (see variorum_get_thread_counters()).
+///
+/// Format:
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "interval_seconds": interval,
+///         "num_event_groups": ngroups,
+///         "per_thread": {
+///             "Thread_<n>": {
+///                 "instructions": instructions,
+///                 "cycles": cycles,
+///                 "ref_cycles": ref_cycles,
+///                 "ipc": ipc,
+///                 "frequency_mhz": freq_mhz,
+///                 "mem_bound_ratio": mem_bound_ratio,
+///                 "<event name>": scaled count
+///             }
+///         }
+///     }
+/// }
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake
+///
+/// @param [out] get_counters_obj_str String (passed by reference) that
+/// contains the per-thread counters.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_thread_counters_json(char **get_counters_obj_str);
+
+/// @brief Number of core frequency bands tracked by the uncore power
+/// control unit (PCU).
+#define VARIORUM_UNCORE_FREQ_BANDS 4
+
+/// @brief Uncore activity of one socket over the interval since the
+/// previous call to variorum_get_uncore_counters().
+struct variorum_uncore_socket
+{
+    /// @brief Average uncore clock frequency (in MHz).
+    double uncore_freq_mhz;
+    /// @brief PCU clock cycles in the interval.
+    double pcu_cycles;
+    /// @brief Core frequency threshold of each band (in MHz).
+    double band_mhz[VARIORUM_UNCORE_FREQ_BANDS];
+    /// @brief Fraction of PCU cycles in which the cores ran at or above
+    /// band_mhz.
+    double band_residency[VARIORUM_UNCORE_FREQ_BANDS];
+    /// @brief PCU cycles in which the package power limit capped the core
+    /// frequency.
+    double power_limit_cycles;
+    /// @brief PCU cycles in which a thermal limit capped the core frequency.
+    double thermal_limit_cycles;
+    /// @brief Memory read bandwidth (in bytes per second), or 0 if the
+    /// model has no MSR-based memory counters or the kernel's uncore PMU
+    /// driver, which reports the number of CHAs, is not loaded.
+    double mem_read_bytes_per_sec;
+    /// @brief Memory write bandwidth (in bytes per second), or 0 if the
+    /// model has no MSR-based memory counters or the kernel's uncore PMU
+    /// driver, which reports the number of CHAs, is not loaded.
+    double mem_write_bytes_per_sec;
+};
+
+/// @brief One sample of the uncore counters of every socket. The array is
+/// owned by Variorum and stays valid until the next call to
+/// variorum_get_uncore_counters().
+struct variorum_uncore_sample
+{
+    /// @brief Time of the reading (in seconds since the epoch).
+    double seconds;
+    /// @brief Length of the interval since the previous call (in seconds).
+    double interval;
+    /// @brief Number of entries in sockets.
+    int nsockets;
+    /// @brief Number of PCU event groups multiplexed over the PCU counters.
+    int ngroups;
+    /// @brief Uncore activity of each socket.
+    struct variorum_uncore_socket *sockets;
+};
+
+/// @brief Read the uncore counters of every socket with one batched MSR
+/// read, and compute uncore frequency, core frequency band residency,
+/// power and thermal limit cycles and memory bandwidth over the interval
+/// since the previous call.
+///
+/// The PCU events are taken from the event table of the running model.
+/// They do not all fit on the four PCU counters, so they are split into
+/// groups that take turns, one group per call. Each group also counts PCU
+/// clock cycles, so residencies are exact ratios within the interval the
+/// group was counting. The band thresholds are the maximum efficiency
+/// frequency, the midpoint to the base frequency, the base frequency and the
+/// first turbo bin. The first call only establishes the baseline and
+/// reports zeros.
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake (memory bandwidth on
+///   Skylake/Cascade Lake only)
+///
+/// @param [out] sample Filled with the per-socket uncore activity.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_uncore_counters(struct variorum_uncore_sample *sample);
+
+/// @brief Populate a string in JSON format with one sample of the uncore
+/// counters (see variorum_get_uncore_counters()).
+///
+/// Format:
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "interval_seconds": interval,
+///         "num_event_groups": ngroups,
+///         "Socket_<n>": {
+///             "uncore_frequency_mhz": uncore_freq_mhz,
+///             "pcu_cycles": pcu_cycles,
+///             "freq_band_<i>": {
+///                 "threshold_mhz": band_mhz,
+///                 "residency": band_residency
+///             },
+///             "power_limit_cycles": power_limit_cycles,
+///             "thermal_limit_cycles": thermal_limit_cycles,
+///             "mem_read_bytes_per_sec": mem_read_bytes_per_sec,
+///             "mem_write_bytes_per_sec": mem_write_bytes_per_sec
+///         }
+///     }
+/// }
+///
+/// @supparch
+/// - Same as variorum_get_uncore_counters()
+///
+/// @param [out] get_uncore_obj_str String (passed by reference) that
+/// contains the per-socket uncore activity.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_uncore_counters_json(char **get_uncore_obj_str);
+
+/// @brief Largest number of package or core C-states tracked by
+/// variorum_get_cstate_residency().
+#define VARIORUM_MAX_CSTATES 8
+
+/// @brief C-state residency of one package or core over the interval since
+/// the previous call to variorum_get_cstate_residency().
+struct variorum_cstate_residency
+{
+    /// @brief Socket or core ID.
+    int id;
+    /// @brief Percentage of the interval spent in each C-state, in the order
+    /// of pkg_cstates or core_cstates in the sample.
+    double percent[VARIORUM_MAX_CSTATES];
+};
+
+/// @brief One sample of the package and core C-state residency counters.
+/// The arrays are owned by Variorum and stay valid until the next call to
+/// variorum_get_cstate_residency().
+struct variorum_cstate_sample
+{
+    /// @brief Time of the reading (in seconds since the epoch).
+    double seconds;
+    /// @brief Length of the interval since the previous call (in seconds).
+    double interval;
+    /// @brief Number of package C-states with a residency counter.
+    int npkg_cstates;
+    /// @brief Number of each package C-state (e.g., 6 for PC6).
+    int pkg_cstates[VARIORUM_MAX_CSTATES];
+    /// @brief Number of core C-states with a residency counter.
+    int ncore_cstates;
+    /// @brief Number of each core C-state (e.g., 6 for CC6).
+    int core_cstates[VARIORUM_MAX_CSTATES];
+    /// @brief Number of entries in sockets.
+    int nsockets;
+    /// @brief Package C-state residency of each socket.
+    struct variorum_cstate_residency *sockets;
+    /// @brief Number of entries in cores.
+    int ncores;
+    /// @brief Core C-state residency of each core.
+    struct variorum_cstate_residency *cores;
+};
+
+/// @brief Read the package and core C-state residency counters, together
+/// with the time stamp counter of the same CPU, with one batched MSR read per
+/// domain, and compute the percentage of the interval since the previous call
+/// spent in each C-state. The residency counters tick at the time stamp
+/// counter rate, so each percentage is the ratio of the two deltas. The first
+/// call has no interval yet, so it reports 0 for every C-state.
+///
+/// @supparch
+/// - Intel Sandy Bridge, Ivy Bridge, Haswell, Broadwell, Skylake/Cascade
+///   Lake, Kaby Lake
+///
+/// @param [out] sample Filled with the per-socket and per-core residency.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_cstate_residency(struct variorum_cstate_sample *sample);
+
+/// @brief Populate a string in JSON format with one sample of the C-state
+/// residency counters (see variorum_get_cstate_residency()).
+///
+/// Format:
+/// {
+///     "hostname": {
+///         "timestamp": timestamp,
+///         "interval_seconds": interval,
+///         "Socket_<n>": {
+///             "PC<x>_percent": residency,
+///             "Core_<m>": {
+///                 "CC<y>_percent": residency
+///             }
+///         }
+///     }
+/// }
+///
+/// @supparch
+/// - Same as variorum_get_cstate_residency()
+///
+/// @param [out] get_cstate_obj_str String (passed by reference) that
+/// contains the per-socket and per-core C-state residency.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_cstate_residency_json(char **get_cstate_obj_str);
+
+/// @brief Accumulated energy of one named region.
+struct variorum_region_energy
+{
+    /// @brief Number of completed (outermost) instances of the region.
+    unsigned long count;
+    /// @brief Time spent in the region (in seconds).
+    double seconds;
+    /// @brief Processor energy used in the region (in Joules).
+    double cpu_joules;
+    /// @brief Memory energy used in the region (in Joules).
+    double mem_joules;
+    /// @brief GPU energy used in the region (in Joules).
+    double gpu_joules;
+};
+
+/// @brief Mark the start of a named region.
+///
+/// The CPU, memory and GPU energy counters of the node are read once, and
+/// the difference to the matching variorum_region_end() is added to the
+/// region's totals. Regions may be nested, and each thread keeps its own
+/// nesting. A region entered again by the same thread before it has ended is
+/// only accounted for by its outermost instance on that thread. Instances
+/// open on different threads are each counted. Energy is measured for the
+/// whole node, not for the calling thread, so overlapping instances on
+/// different threads each include the other threads' energy.
+///
+/// The counters are read under a lock, so concurrent calls from several
+/// threads are serialized. The first call opens a session (see
+/// variorum_open()) that stays open until the process exits, so later calls
+/// skip the platform setup.
+///
+/// @supparch
+/// - Intel Haswell, Broadwell, Skylake/Cascade Lake
+/// - AMD EPYC Milan, Genoa
+/// - IBM Power9
+/// - NVIDIA Volta, Ampere
+/// - AMD Instinct (MI-50 onwards)
+/// - Intel Discrete GPU
+///
+/// @param [in] name Region name.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_region_begin(const char *name);
+
+/// @brief Mark the end of the innermost region opened by this thread.
+///
+/// @param [in] name Region name, which must match the innermost open region
+///             of the calling thread.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_region_end(const char *name);
+
+/// @brief Get the accumulated energy of a named region.
+///
+/// @param [in] name Region name.
+/// @param [out] energy Totals of the region.
+///
+/// @return 0 if successful, otherwise -1 (including if the region has never
+/// been entered)
+int variorum_get_region_energy(const char *name,
+                               struct variorum_region_energy *energy);
+
+/// @brief Get the accumulated energy of every region as a JSON object.
+///
+/// @supparch
+/// - Same as variorum_region_begin()
+///
+/// @param [out] get_region_energy_obj_str String (passed by reference) that
+/// contains the count, time and CPU, memory, GPU and node energy of each
+/// region.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_get_region_energy_json(char **get_region_energy_obj_str);
+
+/// @brief Open a Variorum session.
+///
+/// Vendor libraries (NVML, ROCm SMI, E-SMI, APMIDG) are initialized on first
+/// use and stay initialized across API calls, which lets tools sample GPUs
+/// at high rates. A session keeps them initialized until the matching
+/// variorum_close(). Sessions may be nested.
+///
+/// Within a session, the platform setup done on entry to every API call
+/// (architecture detection, function pointers and MSR file descriptors) is
+/// also done once and reused, so each call only pays for its own reads.
+///
+/// @supparch
+/// - All architectures
+///
+/// @return 0 if successful, otherwise -1
+int variorum_open(void);
+
+/// @brief Close a session opened by variorum_open(). Once the last session
+/// is closed, the platform state is released and the vendor libraries are
+/// shut down, and the next API call initializes them again. Without a
+/// session, they are shut down at process exit.
+///
+/// @supparch
+/// - All architectures
+///
+/// @return 0 if successful, otherwise -1
+int variorum_close(void);
+
 /// @brief Returns Variorum version as a constant string.
 ///
 /// @supparch
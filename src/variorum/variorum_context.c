@@ -0,0 +1,206 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <variorum_config.h>
+#include <variorum_context.h>
+
+#ifdef VARIORUM_WITH_NVIDIA_GPU
+#include <nvidia_gpu_power_features.h>
+#endif
+
+#ifdef VARIORUM_WITH_AMD_GPU
+#include <rocm_smi/rocm_smi.h>
+#endif
+
+#ifdef VARIORUM_WITH_AMD_CPU
+#include <e_smi/e_smi.h>
+#endif
+
+#ifdef VARIORUM_WITH_INTEL_GPU
+#include <intel_gpu_power_features.h>
+#endif
+
+/* Every reference is either the process-wide one (default_held) or one of
+ * the nested session references (sessions).
+ * */
+struct context
+{
+    int refcount;
+    int default_held;
+    int sessions;
+};
+
+static struct context g_context[VARIORUM_CONTEXT_NUM_LIBS];
+static pthread_mutex_t g_context_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_atexit_registered = 0;
+
+/* Initialize a library. Libraries that are not part of this build report
+ * -1, so that nothing holds a reference on them.
+ * */
+static int lib_init(enum variorum_context_lib lib)
+{
+    switch (lib)
+    {
+#ifdef VARIORUM_WITH_NVIDIA_GPU
+        case VARIORUM_CONTEXT_NVML:
+            initNVML();
+            return 0;
+#endif
+#ifdef VARIORUM_WITH_AMD_GPU
+        case VARIORUM_CONTEXT_RSMI:
+            return rsmi_init(0);
+#endif
+#ifdef VARIORUM_WITH_AMD_CPU
+        case VARIORUM_CONTEXT_ESMI:
+            return esmi_init();
+#endif
+#ifdef VARIORUM_WITH_INTEL_GPU
+        case VARIORUM_CONTEXT_APMIDG:
+            initAPMIDG();
+            return 0;
+#endif
+        default:
+            return -1;
+    }
+}
+
+static void lib_shutdown(enum variorum_context_lib lib)
+{
+    switch (lib)
+    {
+#ifdef VARIORUM_WITH_NVIDIA_GPU
+        case VARIORUM_CONTEXT_NVML:
+            shutdownNVML();
+            break;
+#endif
+#ifdef VARIORUM_WITH_AMD_GPU
+        case VARIORUM_CONTEXT_RSMI:
+            rsmi_shut_down();
+            break;
+#endif
+#ifdef VARIORUM_WITH_AMD_CPU
+        case VARIORUM_CONTEXT_ESMI:
+            esmi_exit();
+            break;
+#endif
+#ifdef VARIORUM_WITH_INTEL_GPU
+        case VARIORUM_CONTEXT_APMIDG:
+            shutdownAPMIDG();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/* Must be called with g_context_lock held. */
+static int acquire_locked(enum variorum_context_lib lib)
+{
+    int ret = 0;
+
+    if (g_context[lib].refcount == 0)
+    {
+        ret = lib_init(lib);
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+    g_context[lib].refcount++;
+    return 0;
+}
+
+/* Must be called with g_context_lock held. */
+static void release_locked(enum variorum_context_lib lib)
+{
+    if (g_context[lib].refcount == 0)
+    {
+        return;
+    }
+    g_context[lib].refcount--;
+    if (g_context[lib].refcount == 0)
+    {
+        lib_shutdown(lib);
+    }
+}
+
+static void put_default_at_exit(void)
+{
+    variorum_context_put_default();
+}
+
+int variorum_context_get(enum variorum_context_lib lib)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&g_context_lock);
+    if (!g_context[lib].default_held)
+    {
+        ret = acquire_locked(lib);
+        if (ret == 0)
+        {
+            g_context[lib].default_held = 1;
+            if (!g_atexit_registered)
+            {
+                atexit(put_default_at_exit);
+                g_atexit_registered = 1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_context_lock);
+    return ret;
+}
+
+void variorum_context_acquire_all(void)
+{
+    int lib;
+
+    pthread_mutex_lock(&g_context_lock);
+    for (lib = 0; lib < VARIORUM_CONTEXT_NUM_LIBS; lib++)
+    {
+        // Libraries that are not built in, or fail to initialize, are skipped
+        // here and reported by the platform that needs them.
+        if (acquire_locked((enum variorum_context_lib)lib) == 0)
+        {
+            g_context[lib].sessions++;
+        }
+    }
+    pthread_mutex_unlock(&g_context_lock);
+}
+
+void variorum_context_release_all(void)
+{
+    int lib;
+
+    pthread_mutex_lock(&g_context_lock);
+    for (lib = 0; lib < VARIORUM_CONTEXT_NUM_LIBS; lib++)
+    {
+        if (g_context[lib].sessions > 0)
+        {
+            g_context[lib].sessions--;
+            release_locked((enum variorum_context_lib)lib);
+        }
+    }
+    pthread_mutex_unlock(&g_context_lock);
+}
+
+void variorum_context_put_default(void)
+{
+    int lib;
+
+    pthread_mutex_lock(&g_context_lock);
+    for (lib = 0; lib < VARIORUM_CONTEXT_NUM_LIBS; lib++)
+    {
+        if (g_context[lib].default_held)
+        {
+            g_context[lib].default_held = 0;
+            release_locked((enum variorum_context_lib)lib);
+        }
+    }
+    pthread_mutex_unlock(&g_context_lock);
+}
@@ -0,0 +1,53 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_CONTEXT_H_INCLUDE
+#define VARIORUM_CONTEXT_H_INCLUDE
+
+/// @brief Vendor libraries whose initialization is shared across API calls.
+enum variorum_context_lib
+{
+    VARIORUM_CONTEXT_NVML,
+    VARIORUM_CONTEXT_RSMI,
+    VARIORUM_CONTEXT_ESMI,
+    VARIORUM_CONTEXT_APMIDG,
+    VARIORUM_CONTEXT_NUM_LIBS
+};
+
+/// @brief Return the initialization status of a vendor library, initializing
+/// it on first use.
+///
+/// The first call takes a process-wide reference that keeps the library
+/// initialized across API calls. That reference is dropped by
+/// variorum_context_put_default() or at process exit.
+///
+/// @param [in] lib Library to initialize.
+///
+/// @return 0 if the library is initialized, otherwise the status returned by
+/// its init routine.
+int variorum_context_get(
+    enum variorum_context_lib lib
+);
+
+/// @brief Take a session reference on every vendor library in this build
+/// that initializes successfully.
+void variorum_context_acquire_all(
+    void
+);
+
+/// @brief Drop the session references taken by the matching
+/// variorum_context_acquire_all(). A library is shut down when its last
+/// reference is dropped.
+void variorum_context_release_all(
+    void
+);
+
+/// @brief Drop the process-wide references taken by variorum_context_get().
+/// The next variorum_context_get() takes them again.
+void variorum_context_put_default(
+    void
+);
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <variorum_error.h>
+#include <variorum_gpu_cap.h>
+
+enum cap_status
+{
+    CAP_UNCHANGED,
+    CAP_OK,
+    CAP_READ_FAILED,
+    CAP_SET_FAILED,
+    CAP_VERIFY_FAILED
+};
+
+struct cap_job
+{
+    const struct variorum_gpu_cap_ops *ops;
+    int gpu;
+    unsigned int target_mw;
+    unsigned int saved_mw;
+    enum cap_status status;
+};
+
+static void apply_job(struct cap_job *job)
+{
+    unsigned int actual_mw = 0;
+
+    if (job->ops->get_limit(job->gpu, &job->saved_mw) != 0)
+    {
+        job->status = CAP_READ_FAILED;
+        return;
+    }
+    if (job->ops->set_limit(job->gpu, job->target_mw) != 0)
+    {
+        job->status = CAP_SET_FAILED;
+        return;
+    }
+    // Devices may round the limit, e.g. to whole watts, so only a
+    // difference beyond their granularity is a failure.
+    if (job->ops->get_limit(job->gpu, &actual_mw) != 0 ||
+        (actual_mw > job->target_mw ? actual_mw - job->target_mw :
+         job->target_mw - actual_mw) > job->ops->granularity_mw)
+    {
+        job->status = CAP_VERIFY_FAILED;
+        return;
+    }
+    job->status = CAP_OK;
+}
+
+static void rollback_job(struct cap_job *job)
+{
+    // A failed write may still have reached the device, so restore every GPU
+    // whose saved limit is known.
+    if (job->status == CAP_OK || job->status == CAP_SET_FAILED ||
+        job->status == CAP_VERIFY_FAILED)
+    {
+        job->ops->set_limit(job->gpu, job->saved_mw);
+    }
+}
+
+static void *apply_job_thread(void *arg)
+{
+    apply_job((struct cap_job *)arg);
+    return NULL;
+}
+
+static void *rollback_job_thread(void *arg)
+{
+    rollback_job((struct cap_job *)arg);
+    return NULL;
+}
+
+static int use_cap_threads(void)
+{
+    char *val = getenv("VARIORUM_GPU_CAP_THREADS");
+
+    return val != NULL && atoi(val) != 0;
+}
+
+/* Run fn on every job that changes a limit, one thread per GPU if enabled. */
+static void run_jobs(struct cap_job *jobs, int njobs, void *(*fn)(void *))
+{
+    pthread_t *threads = NULL;
+    int *spawned = NULL;
+    int i;
+
+    if (njobs > 1 && use_cap_threads())
+    {
+        threads = (pthread_t *) malloc(njobs * sizeof(pthread_t));
+        spawned = (int *) calloc(njobs, sizeof(int));
+    }
+    if (threads == NULL || spawned == NULL)
+    {
+        free(threads);
+        free(spawned);
+        for (i = 0; i < njobs; i++)
+        {
+            fn(&jobs[i]);
+        }
+        return;
+    }
+
+    for (i = 0; i < njobs; i++)
+    {
+        if (pthread_create(&threads[i], NULL, fn, &jobs[i]) == 0)
+        {
+            spawned[i] = 1;
+        }
+        else
+        {
+            // Handle this GPU inline if no thread is available.
+            fn(&jobs[i]);
+        }
+    }
+    for (i = 0; i < njobs; i++)
+    {
+        if (spawned[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    free(threads);
+    free(spawned);
+}
+
+int variorum_gpu_cap_apply(const struct variorum_gpu_cap_ops *ops, int ngpus,
+                           const int *gpu_power_limits)
+{
+    struct cap_job *jobs;
+    int njobs = 0;
+    int failed = 0;
+    int i;
+    char msg[128];
+
+    if (ngpus <= 0 || gpu_power_limits == NULL)
+    {
+        variorum_error_handler("Invalid GPU power limits", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                               __LINE__);
+        return -1;
+    }
+    for (i = 0; i < ngpus; i++)
+    {
+        if (gpu_power_limits[i] < 0)
+        {
+            variorum_error_handler("GPU power limit cannot be negative",
+                                   VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        if ((unsigned int)gpu_power_limits[i] > UINT_MAX / 1000)
+        {
+            variorum_error_handler("GPU power limit is out of range",
+                                   VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+    }
+
+    jobs = (struct cap_job *) calloc(ngpus, sizeof(struct cap_job));
+    if (jobs == NULL)
+    {
+        variorum_error_handler("Could not allocate GPU capping state",
+                               VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    for (i = 0; i < ngpus; i++)
+    {
+        if (gpu_power_limits[i] == 0)
+        {
+            continue;
+        }
+        jobs[njobs].ops = ops;
+        jobs[njobs].gpu = i;
+        jobs[njobs].target_mw = (unsigned int)gpu_power_limits[i] * 1000;
+        jobs[njobs].status = CAP_UNCHANGED;
+        njobs++;
+    }
+
+    run_jobs(jobs, njobs, apply_job_thread);
+
+    for (i = 0; i < njobs; i++)
+    {
+        if (jobs[i].status == CAP_OK)
+        {
+            continue;
+        }
+        failed = 1;
+        if (jobs[i].status == CAP_READ_FAILED)
+        {
+            snprintf(msg, sizeof(msg),
+                     "Could not read the current power limit of GPU %d",
+                     jobs[i].gpu);
+        }
+        else
+        {
+            snprintf(msg, sizeof(msg), "Could not %s a %u mW power limit on GPU %d",
+                     jobs[i].status == CAP_SET_FAILED ? "set" : "verify",
+                     jobs[i].target_mw, jobs[i].gpu);
+        }
+        variorum_error_handler(msg, VARIORUM_ERROR_PLATFORM_ENV,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__,
+                               __LINE__);
+    }
+
+    if (failed)
+    {
+        run_jobs(jobs, njobs, rollback_job_thread);
+        variorum_error_handler("Restored the previous GPU power limits",
+                               VARIORUM_ERROR_PLATFORM_ENV, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+    }
+    free(jobs);
+    return failed ? -1 : 0;
+}
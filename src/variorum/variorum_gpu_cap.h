@@ -0,0 +1,45 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_GPU_CAP_H_INCLUDE
+#define VARIORUM_GPU_CAP_H_INCLUDE
+
+/// @brief Vendor hooks used by the GPU capping engine. Both take the node-wide
+/// GPU index and a limit in milliwatts, and return 0 on success.
+struct variorum_gpu_cap_ops
+{
+    /// @brief Read the power limit currently enforced on a GPU.
+    int (*get_limit)(int gpu, unsigned int *limit_mw);
+    /// @brief Request a new power limit on a GPU.
+    int (*set_limit)(int gpu, unsigned int limit_mw);
+    /// @brief Largest difference, in milliwatts, between a requested limit
+    /// and the one the device reports back after rounding it (0 if the
+    /// device keeps the exact value).
+    unsigned int granularity_mw;
+};
+
+/// @brief Apply a power limit to every GPU on the node as one transaction.
+///
+/// For each GPU, its current limit is saved, the new limit is written and
+/// then read back, which must match within ops->granularity_mw. If any GPU
+/// fails to take its limit, every GPU that was changed is restored to its
+/// saved limit. The GPUs are handled one after another; set
+/// ``VARIORUM_GPU_CAP_THREADS=1`` to handle each GPU on its own thread.
+///
+/// @param [in] ops Vendor hooks.
+/// @param [in] ngpus Number of GPUs on the node.
+/// @param [in] gpu_power_limits Limit in watts for each GPU, indexed by GPU.
+///             GPUs with a limit of 0 are left unchanged. Negative limits and
+///             limits too large to express in milliwatts are rejected.
+///
+/// @return 0 if every limit was applied and verified, otherwise -1 after
+/// the previous limits have been restored.
+int variorum_gpu_cap_apply(
+    const struct variorum_gpu_cap_ops *ops,
+    int ngpus,
+    const int *gpu_power_limits
+);
+
+#endif
@@ -0,0 +1,126 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <variorum_error.h>
+#include <variorum_gpu_throttle.h>
+
+#define DEFAULT_POLL_MS 250
+
+static unsigned long long now_us(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (unsigned long long)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static int poll_interval_ms(void)
+{
+    char *val = getenv("VARIORUM_GPU_THROTTLE_POLL_MS");
+
+    if (val == NULL || atoi(val) <= 0)
+    {
+        return DEFAULT_POLL_MS;
+    }
+    return atoi(val);
+}
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+/* Compare every GPU against the reasons last reported. A GPU whose change
+ * does not fit into events keeps its old reasons, so the next call reports
+ * it.
+ * */
+static int scan(struct variorum_gpu_throttle_tracker *tracker,
+                const struct variorum_gpu_throttle_ops *ops,
+                struct variorum_gpu_throttle_event *events, int max_events)
+{
+    unsigned int reasons;
+    double power_violation_s;
+    double thermal_violation_s;
+    int nevents = 0;
+    int d;
+
+    for (d = 0; d < tracker->ngpus && nevents < max_events; d++)
+    {
+        if (ops->read(d, &reasons, &power_violation_s, &thermal_violation_s) != 0)
+        {
+            continue;
+        }
+        if (reasons == tracker->reasons[d])
+        {
+            continue;
+        }
+        events[nevents].timestamp_us = now_us();
+        events[nevents].gpu = d;
+        events[nevents].previous_reasons = tracker->reasons[d];
+        events[nevents].reasons = reasons;
+        events[nevents].power_violation_s = power_violation_s;
+        events[nevents].thermal_violation_s = thermal_violation_s;
+        tracker->reasons[d] = reasons;
+        nevents++;
+    }
+    return nevents;
+}
+
+int variorum_gpu_throttle_poll(struct variorum_gpu_throttle_tracker *tracker,
+                               const struct variorum_gpu_throttle_ops *ops,
+                               int ngpus, int timeout_ms,
+                               struct variorum_gpu_throttle_event *events,
+                               int max_events)
+{
+    unsigned long long deadline_us;
+    unsigned long long t;
+    int remaining_ms;
+    int wait_ms;
+    int nevents;
+
+    if (tracker->reasons == NULL || tracker->ngpus != ngpus)
+    {
+        free(tracker->reasons);
+        tracker->reasons = (unsigned int *) calloc(ngpus, sizeof(unsigned int));
+        if (tracker->reasons == NULL)
+        {
+            tracker->ngpus = 0;
+            variorum_error_handler("Could not allocate GPU throttle state",
+                                   VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        tracker->ngpus = ngpus;
+    }
+
+    deadline_us = now_us() + (unsigned long long)timeout_ms * 1000ULL;
+    while (1)
+    {
+        nevents = scan(tracker, ops, events, max_events);
+        t = now_us();
+        if (nevents > 0 || t >= deadline_us)
+        {
+            return nevents;
+        }
+        remaining_ms = (int)((deadline_us - t + 999) / 1000);
+        // Not every change raises an event, so rescan at least once per
+        // poll interval even while waiting for one.
+        wait_ms = remaining_ms < poll_interval_ms() ? remaining_ms :
+                  poll_interval_ms();
+        if (ops->wait != NULL && ops->wait(wait_ms) == 0)
+        {
+            continue;
+        }
+        sleep_ms(wait_ms);
+    }
+}
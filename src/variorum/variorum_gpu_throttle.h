@@ -0,0 +1,53 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_GPU_THROTTLE_H_INCLUDE
+#define VARIORUM_GPU_THROTTLE_H_INCLUDE
+
+#include <variorum.h>
+
+/// @brief Vendor hooks used by the GPU throttle monitor.
+struct variorum_gpu_throttle_ops
+{
+    /// @brief Read the throttle reasons (VARIORUM_GPU_THROTTLE_*) of a GPU and
+    /// its cumulative power and thermal violation time in seconds (-1 if not
+    /// reported). Returns 0 on success.
+    int (*read)(int gpu, unsigned int *reasons, double *power_violation_s,
+                double *thermal_violation_s);
+    /// @brief Optional. Block until the vendor library signals an event that
+    /// may change the throttle reasons, or until timeout_ms has passed.
+    /// Returns 0 in both cases, or -1 if events are not available, in which
+    /// case the monitor polls.
+    int (*wait)(int timeout_ms);
+};
+
+/// @brief Last throttle reasons reported for each GPU of one backend.
+struct variorum_gpu_throttle_tracker
+{
+    int ngpus;
+    unsigned int *reasons;
+};
+
+/// @brief Record the GPUs whose throttle reasons changed since the previous
+/// call with the same tracker, waiting up to timeout_ms for a change.
+///
+/// @param [in,out] tracker Reasons last reported by this backend.
+/// @param [in] ops Vendor hooks.
+/// @param [in] ngpus Number of GPUs on the node.
+/// @param [in] timeout_ms Longest time to wait for a change.
+/// @param [out] events Filled with one record per change.
+/// @param [in] max_events Capacity of events.
+///
+/// @return Number of records written, otherwise -1
+int variorum_gpu_throttle_poll(
+    struct variorum_gpu_throttle_tracker *tracker,
+    const struct variorum_gpu_throttle_ops *ops,
+    int ngpus,
+    int timeout_ms,
+    struct variorum_gpu_throttle_event *events,
+    int max_events
+);
+
+#endif
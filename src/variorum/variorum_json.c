@@ -0,0 +1,321 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <variorum.h>
+#include <variorum_error.h>
+#include <variorum_json.h>
+
+#define JSON_INDENT_WIDTH 4
+
+static int g_json_format = VARIORUM_JSON_PRETTY;
+
+/* Make room for n more bytes plus the terminator. A fixed buffer never
+ * grows; what does not fit is only counted.
+ * */
+static int reserve(struct variorum_json_writer *w, size_t n)
+{
+    size_t size;
+    char *buf;
+
+    if (w->len + n < w->size)
+    {
+        return 1;
+    }
+    if (!w->growable || w->failed)
+    {
+        return 0;
+    }
+    size = w->size ? w->size : 256;
+    while (w->len + n >= size)
+    {
+        size *= 2;
+    }
+    buf = (char *) realloc(w->buf, size);
+    if (buf == NULL)
+    {
+        w->failed = 1;
+        return 0;
+    }
+    w->buf = buf;
+    w->size = size;
+    return 1;
+}
+
+static void put(struct variorum_json_writer *w, const char *s, size_t n)
+{
+    if (reserve(w, n))
+    {
+        memcpy(w->buf + w->len, s, n);
+        w->buf[w->len + n] = '\0';
+    }
+    else if (w->len < w->size)
+    {
+        // Keep a fixed buffer terminated at the last byte that fits.
+        memcpy(w->buf + w->len, s, w->size - w->len - 1);
+        w->buf[w->size - 1] = '\0';
+    }
+    w->len += n;
+}
+
+static void put_char(struct variorum_json_writer *w, char c)
+{
+    put(w, &c, 1);
+}
+
+static void put_string(struct variorum_json_writer *w, const char *s)
+{
+    char esc[8];
+    const char *run = s;
+
+    put_char(w, '"');
+    for (; *s; s++)
+    {
+        unsigned char c = (unsigned char) * s;
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        put(w, run, s - run);
+        switch (c)
+        {
+            case '"':
+                put(w, "\\\"", 2);
+                break;
+            case '\\':
+                put(w, "\\\\", 2);
+                break;
+            case '\b':
+                put(w, "\\b", 2);
+                break;
+            case '\f':
+                put(w, "\\f", 2);
+                break;
+            case '\n':
+                put(w, "\\n", 2);
+                break;
+            case '\r':
+                put(w, "\\r", 2);
+                break;
+            case '\t':
+                put(w, "\\t", 2);
+                break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04X", c);
+                put(w, esc, 6);
+                break;
+        }
+        run = s + 1;
+    }
+    put(w, run, s - run);
+    put_char(w, '"');
+}
+
+static void newline(struct variorum_json_writer *w)
+{
+    static const char spaces[] = "                                ";
+    size_t chunk;
+    int n;
+
+    if (w->format != VARIORUM_JSON_PRETTY)
+    {
+        return;
+    }
+    put_char(w, '\n');
+    for (n = w->depth * JSON_INDENT_WIDTH; n > 0; n -= (int)chunk)
+    {
+        chunk = sizeof(spaces) - 1;
+        if ((size_t)n < chunk)
+        {
+            chunk = n;
+        }
+        put(w, spaces, chunk);
+    }
+}
+
+/* Separator, indentation and key in front of a member of the innermost
+ * object, matching the layout of json_dumps().
+ * */
+static void member(struct variorum_json_writer *w, const char *key)
+{
+    if (w->depth == 0 || key == NULL)
+    {
+        return;
+    }
+    if (w->nmembers[w->depth - 1]++ > 0)
+    {
+        put_char(w, ',');
+    }
+    newline(w);
+    put_string(w, key);
+    if (w->format == VARIORUM_JSON_PRETTY)
+    {
+        put(w, ": ", 2);
+    }
+    else
+    {
+        put_char(w, ':');
+    }
+}
+
+void variorum_json_writer_init(struct variorum_json_writer *w, char *buf,
+                               size_t size, int format)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->size = buf != NULL ? size : 0;
+    w->format = format;
+    if (w->size > 0)
+    {
+        w->buf[0] = '\0';
+    }
+}
+
+void variorum_json_writer_init_alloc(struct variorum_json_writer *w,
+                                     int format)
+{
+    variorum_json_writer_init(w, NULL, 0, format);
+    w->growable = 1;
+}
+
+void variorum_json_begin_object(struct variorum_json_writer *w,
+                                const char *key)
+{
+    member(w, key);
+    put_char(w, '{');
+    if (w->depth < VARIORUM_JSON_MAX_DEPTH)
+    {
+        w->nmembers[w->depth] = 0;
+    }
+    w->depth++;
+}
+
+void variorum_json_end_object(struct variorum_json_writer *w)
+{
+    int empty;
+
+    if (w->depth == 0)
+    {
+        return;
+    }
+    empty = w->depth <= VARIORUM_JSON_MAX_DEPTH &&
+            w->nmembers[w->depth - 1] == 0;
+    w->depth--;
+    if (!empty)
+    {
+        newline(w);
+    }
+    put_char(w, '}');
+}
+
+void variorum_json_integer(struct variorum_json_writer *w, const char *key,
+                           uint64_t value)
+{
+    char num[24];
+    int n;
+
+    member(w, key);
+    n = snprintf(num, sizeof(num), "%" PRIu64, value);
+    put(w, num, n);
+}
+
+void variorum_json_real(struct variorum_json_writer *w, const char *key,
+                        double value)
+{
+    char num[32];
+    char *exp;
+    char *digits;
+    char *skip;
+    int n;
+
+    member(w, key);
+    if (!isfinite(value))
+    {
+        put(w, "null", 4);
+        return;
+    }
+    n = snprintf(num, sizeof(num), "%.17g", value);
+    // Match Jansson: no '+' or leading zeros in the exponent, and reals
+    // always distinguishable from integers.
+    exp = strchr(num, 'e');
+    if (exp != NULL)
+    {
+        digits = exp + 1;
+        if (*digits == '-')
+        {
+            digits++;
+        }
+        skip = digits;
+        if (*skip == '+')
+        {
+            skip++;
+        }
+        while (*skip == '0' && skip[1] != '\0')
+        {
+            skip++;
+        }
+        memmove(digits, skip, strlen(skip) + 1);
+        n = strlen(num);
+    }
+    put(w, num, n);
+    if (strpbrk(num, ".e") == NULL)
+    {
+        put(w, ".0", 2);
+    }
+}
+
+char *variorum_json_writer_take(struct variorum_json_writer *w)
+{
+    char *s;
+
+    if (!w->growable || w->failed || !reserve(w, 0))
+    {
+        free(w->buf);
+        w->buf = NULL;
+        return NULL;
+    }
+    w->buf[w->len] = '\0';
+    s = w->buf;
+    w->buf = NULL;
+    w->size = w->len = 0;
+    return s;
+}
+
+int variorum_json_format(void)
+{
+    return g_json_format;
+}
+
+char *variorum_json_dumps(const json_t *obj)
+{
+    if (g_json_format == VARIORUM_JSON_COMPACT)
+    {
+        return json_dumps(obj, JSON_COMPACT);
+    }
+    return json_dumps(obj, JSON_INDENT(JSON_INDENT_WIDTH));
+}
+
+int variorum_set_json_format(int format)
+{
+    if (format != VARIORUM_JSON_PRETTY && format != VARIORUM_JSON_COMPACT)
+    {
+        variorum_error_handler("Invalid JSON format", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    g_json_format = format;
+    return 0;
+}
+
+void variorum_free_json(char *json)
+{
+    free(json);
+}
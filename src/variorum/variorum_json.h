@@ -0,0 +1,104 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_JSON_H_INCLUDE
+#define VARIORUM_JSON_H_INCLUDE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <jansson.h>
+
+/// @brief Deepest nesting the writer tracks.
+#define VARIORUM_JSON_MAX_DEPTH 16
+
+/// @brief Streaming JSON writer. Values are formatted straight into the
+/// output, with no intermediate tree.
+///
+/// A writer either formats into a fixed buffer owned by the caller, where
+/// output that does not fit is counted but dropped (as with snprintf()), or
+/// into a buffer it grows with realloc().
+struct variorum_json_writer
+{
+    /// @brief Output buffer.
+    char *buf;
+    /// @brief Capacity of buf.
+    size_t size;
+    /// @brief Length of the complete output, which may exceed size.
+    size_t len;
+    /// @brief 1 if buf is grown by the writer.
+    int growable;
+    /// @brief 1 if an allocation failed.
+    int failed;
+    /// @brief VARIORUM_JSON_PRETTY or VARIORUM_JSON_COMPACT.
+    int format;
+    /// @brief Number of open objects.
+    int depth;
+    /// @brief Number of members written so far in each open object.
+    int nmembers[VARIORUM_JSON_MAX_DEPTH];
+};
+
+/// @brief Start writing into a caller-provided buffer.
+void variorum_json_writer_init(
+    struct variorum_json_writer *w,
+    char *buf,
+    size_t size,
+    int format
+);
+
+/// @brief Start writing into a buffer grown by the writer. The result is
+/// taken with variorum_json_writer_take().
+void variorum_json_writer_init_alloc(
+    struct variorum_json_writer *w,
+    int format
+);
+
+/// @brief Open an object, as a member named key, or as the top-level value
+/// if key is NULL.
+void variorum_json_begin_object(
+    struct variorum_json_writer *w,
+    const char *key
+);
+
+/// @brief Close the innermost open object.
+void variorum_json_end_object(
+    struct variorum_json_writer *w
+);
+
+/// @brief Write an integer member.
+void variorum_json_integer(
+    struct variorum_json_writer *w,
+    const char *key,
+    uint64_t value
+);
+
+/// @brief Write a real member, formatted as Jansson does. Values that are
+/// not finite are written as null.
+void variorum_json_real(
+    struct variorum_json_writer *w,
+    const char *key,
+    double value
+);
+
+/// @brief Finish a grown buffer and hand it to the caller, who releases it
+/// with variorum_free_json().
+///
+/// @return The string, or NULL if an allocation failed.
+char *variorum_json_writer_take(
+    struct variorum_json_writer *w
+);
+
+/// @brief Format selected with variorum_set_json_format().
+int variorum_json_format(
+    void
+);
+
+/// @brief Serialize a Jansson tree in the format selected with
+/// variorum_set_json_format().
+char *variorum_json_dumps(
+    const json_t *obj
+);
+
+#endif
@@ -0,0 +1,339 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <config_architecture.h>
+#include <variorum.h>
+#include <variorum_context.h>
+#include <variorum_error.h>
+#include <variorum_json.h>
+
+#define REGION_TABLE_MIN_SIZE 64
+
+struct region
+{
+    char *name;
+    struct variorum_region_energy total;
+};
+
+struct region_frame
+{
+    struct region *region;
+    struct variorum_node_energy start;
+};
+
+/* Open-addressing hash table of regions, guarded by g_region_lock. Regions
+ * are never removed, so a pointer into the table stays valid.
+ * */
+static struct region **g_regions = NULL;
+static size_t g_regions_size = 0;
+static size_t g_regions_used = 0;
+static pthread_mutex_t g_region_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Serializes the node energy reads, which go through the non-thread-safe
+ * platform setup and MSR batches, and guards g_region_hold.
+ * */
+static pthread_mutex_t g_read_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Set once the first region has taken the platform hold kept for the rest
+ * of the process.
+ * */
+static int g_region_hold = 0;
+
+/* Stack of regions opened by the calling thread. */
+static __thread struct region_frame *t_frames = NULL;
+static __thread int t_nframes = 0;
+static __thread int t_frames_size = 0;
+
+/* Read the node energy counters, taking the region hold on the platform on
+ * first use so that later reads skip the platform setup. The hold is kept
+ * apart from the sessions of variorum_open(), so variorum_close() cannot
+ * drop it while a region is active.
+ * */
+static int read_node_energy(struct variorum_node_energy *energy)
+{
+    int err;
+
+    pthread_mutex_lock(&g_read_lock);
+    if (!g_region_hold &&
+        variorum_enter(__FILE__, __FUNCTION__, __LINE__) == 0)
+    {
+        variorum_context_acquire_all();
+        variorum_platform_hold();
+        g_region_hold = 1;
+        variorum_exit(__FILE__, __FUNCTION__, __LINE__);
+    }
+    err = variorum_get_node_energy(energy);
+    pthread_mutex_unlock(&g_read_lock);
+    return err;
+}
+
+/* Number of instances of region open on the calling thread. */
+static int thread_depth(const struct region *region)
+{
+    int depth = 0;
+    int i;
+
+    for (i = 0; i < t_nframes; i++)
+    {
+        if (t_frames[i].region == region)
+        {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+static uint64_t hash_name(const char *name)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+
+    while (*name)
+    {
+        h ^= (unsigned char) * name++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Must be called with g_region_lock held. */
+static struct region **find_slot(struct region **table, size_t size,
+                                 const char *name)
+{
+    size_t i = (size_t)hash_name(name) & (size - 1);
+
+    while (table[i] != NULL && strcmp(table[i]->name, name) != 0)
+    {
+        i = (i + 1) & (size - 1);
+    }
+    return &table[i];
+}
+
+/* Must be called with g_region_lock held. */
+static int grow_table(void)
+{
+    size_t size = g_regions_size ? g_regions_size * 2 : REGION_TABLE_MIN_SIZE;
+    struct region **table;
+    size_t i;
+
+    table = (struct region **) calloc(size, sizeof(struct region *));
+    if (table == NULL)
+    {
+        return -1;
+    }
+    for (i = 0; i < g_regions_size; i++)
+    {
+        if (g_regions[i] != NULL)
+        {
+            *find_slot(table, size, g_regions[i]->name) = g_regions[i];
+        }
+    }
+    free(g_regions);
+    g_regions = table;
+    g_regions_size = size;
+    return 0;
+}
+
+/* Must be called with g_region_lock held. */
+static struct region *lookup_region(const char *name, int create)
+{
+    struct region **slot;
+
+    if (g_regions_size == 0)
+    {
+        if (!create || grow_table() != 0)
+        {
+            return NULL;
+        }
+    }
+    slot = find_slot(g_regions, g_regions_size, name);
+    if (*slot != NULL || !create)
+    {
+        return *slot;
+    }
+
+    // Keep the load factor below 3/4 so that probes stay short.
+    if ((g_regions_used + 1) * 4 > g_regions_size * 3)
+    {
+        if (grow_table() != 0)
+        {
+            return NULL;
+        }
+        slot = find_slot(g_regions, g_regions_size, name);
+    }
+    *slot = (struct region *) calloc(1, sizeof(struct region));
+    if (*slot == NULL)
+    {
+        return NULL;
+    }
+    (*slot)->name = strdup(name);
+    if ((*slot)->name == NULL)
+    {
+        free(*slot);
+        *slot = NULL;
+        return NULL;
+    }
+    g_regions_used++;
+    return *slot;
+}
+
+int variorum_region_begin(const char *name)
+{
+    struct region *region;
+    struct region_frame *frames;
+    int size;
+
+    if (name == NULL)
+    {
+        variorum_error_handler("Invalid region name", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (t_nframes == t_frames_size)
+    {
+        size = t_frames_size ? t_frames_size * 2 : 16;
+        frames = (struct region_frame *) realloc(t_frames,
+                 size * sizeof(struct region_frame));
+        if (frames == NULL)
+        {
+            return -1;
+        }
+        t_frames = frames;
+        t_frames_size = size;
+    }
+
+    pthread_mutex_lock(&g_region_lock);
+    region = lookup_region(name, 1);
+    pthread_mutex_unlock(&g_region_lock);
+    if (region == NULL)
+    {
+        variorum_error_handler("Could not allocate region", VARIORUM_ERROR_RUNTIME,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    if (read_node_energy(&t_frames[t_nframes].start) != 0)
+    {
+        return -1;
+    }
+    t_frames[t_nframes].region = region;
+    t_nframes++;
+    return 0;
+}
+
+int variorum_region_end(const char *name)
+{
+    struct region_frame *frame;
+    struct variorum_node_energy end;
+    struct variorum_region_energy *total;
+
+    if (name == NULL || t_nframes == 0 ||
+        strcmp(t_frames[t_nframes - 1].region->name, name) != 0)
+    {
+        variorum_error_handler("Region does not match the innermost open region",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    frame = &t_frames[t_nframes - 1];
+
+    if (read_node_energy(&end) != 0)
+    {
+        return -1;
+    }
+    t_nframes--;
+
+    // Only the outermost instance on this thread is counted, so recursion
+    // does not count the same interval twice.
+    if (thread_depth(frame->region) > 0)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&g_region_lock);
+    total = &frame->region->total;
+    total->count++;
+    total->seconds += end.seconds - frame->start.seconds;
+    total->cpu_joules += end.cpu_joules - frame->start.cpu_joules;
+    total->mem_joules += end.mem_joules - frame->start.mem_joules;
+    total->gpu_joules += end.gpu_joules - frame->start.gpu_joules;
+    pthread_mutex_unlock(&g_region_lock);
+    return 0;
+}
+
+int variorum_get_region_energy(const char *name,
+                               struct variorum_region_energy *energy)
+{
+    struct region *region;
+
+    if (name == NULL || energy == NULL)
+    {
+        variorum_error_handler("Invalid region arguments", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_region_lock);
+    region = lookup_region(name, 0);
+    if (region != NULL)
+    {
+        *energy = region->total;
+    }
+    pthread_mutex_unlock(&g_region_lock);
+    return region != NULL ? 0 : -1;
+}
+
+int variorum_get_region_energy_json(char **get_region_energy_obj_str)
+{
+    struct variorum_region_energy *total;
+    struct variorum_json_writer w;
+    char hostname[1024];
+    struct timeval tv;
+    uint64_t ts;
+    size_t i;
+
+    gethostname(hostname, 1024);
+    gettimeofday(&tv, NULL);
+    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+
+    variorum_json_writer_init_alloc(&w, variorum_json_format());
+    variorum_json_begin_object(&w, NULL);
+    variorum_json_begin_object(&w, hostname);
+    variorum_json_integer(&w, "timestamp", ts);
+    variorum_json_begin_object(&w, "regions");
+
+    pthread_mutex_lock(&g_region_lock);
+    for (i = 0; i < g_regions_size; i++)
+    {
+        if (g_regions[i] == NULL)
+        {
+            continue;
+        }
+        total = &g_regions[i]->total;
+        variorum_json_begin_object(&w, g_regions[i]->name);
+        variorum_json_integer(&w, "count", total->count);
+        variorum_json_real(&w, "time_seconds", total->seconds);
+        variorum_json_real(&w, "energy_cpu_joules", total->cpu_joules);
+        variorum_json_real(&w, "energy_mem_joules", total->mem_joules);
+        variorum_json_real(&w, "energy_gpu_joules", total->gpu_joules);
+        variorum_json_real(&w, "energy_node_joules",
+                           total->cpu_joules + total->mem_joules + total->gpu_joules);
+        variorum_json_end_object(&w);
+    }
+    pthread_mutex_unlock(&g_region_lock);
+
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+    variorum_json_end_object(&w);
+
+    *get_region_energy_obj_str = variorum_json_writer_take(&w);
+    return *get_region_energy_obj_str != NULL ? 0 : -1;
+}
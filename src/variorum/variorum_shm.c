@@ -0,0 +1,418 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <errno.h>
+#include <fcntl.h>
+#include <jansson.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <config_architecture.h>
+#include <variorum_error.h>
+#include <variorum_shm.h>
+
+/* Readers give up after this many torn reads in a row. */
+#define SHM_READ_RETRIES 1000
+
+static struct variorum_shm_layout *g_shm_seg = NULL;
+static char g_shm_name[256];
+
+/* Names and values gathered for one sample before they are published. */
+struct shm_staging
+{
+    int nmetrics;
+    char names[VARIORUM_SHM_MAX_METRICS][VARIORUM_SHM_NAME_LEN];
+    double value[VARIORUM_SHM_MAX_METRICS];
+};
+
+static int flatten_json(struct shm_staging *stage, const char *prefix,
+                        json_t *obj)
+{
+    const char *key;
+    json_t *value;
+    char name[VARIORUM_SHM_NAME_LEN];
+    int len;
+
+    json_object_foreach(obj, key, value)
+    {
+        len = snprintf(name, sizeof(name), "%s.%s", prefix, key);
+        if (len < 0 || len >= (int)sizeof(name))
+        {
+            variorum_error_handler("Metric name does not fit in the segment",
+                                   VARIORUM_ERROR_ARRAY_BOUNDS, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            return -1;
+        }
+        if (json_is_object(value))
+        {
+            if (flatten_json(stage, name, value) != 0)
+            {
+                return -1;
+            }
+        }
+        else if (json_is_number(value))
+        {
+            if (stage->nmetrics >= VARIORUM_SHM_MAX_METRICS)
+            {
+                variorum_error_handler("Too many metrics for the segment",
+                                       VARIORUM_ERROR_ARRAY_BOUNDS, getenv("HOSTNAME"),
+                                       __FILE__, __FUNCTION__, __LINE__);
+                return -1;
+            }
+            strcpy(stage->names[stage->nmetrics], name);
+            stage->value[stage->nmetrics] = json_number_value(value);
+            stage->nmetrics++;
+        }
+    }
+    return 0;
+}
+
+static int shm_map(const char *name)
+{
+    int fd;
+    struct variorum_shm_layout *seg;
+
+    /* Only a segment created here is initialized, so a segment that is
+     * already in use by another publisher or reader is never wiped. */
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0)
+    {
+        variorum_error_handler(errno == EEXIST ?
+                               "Shared memory segment already exists" :
+                               "Unable to open shared memory segment",
+                               VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(struct variorum_shm_layout)) != 0)
+    {
+        variorum_error_handler("Unable to size shared memory segment",
+                               VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    seg = mmap(NULL, sizeof(struct variorum_shm_layout), PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED)
+    {
+        variorum_error_handler("Unable to map shared memory segment",
+                               VARIORUM_ERROR_RUNTIME, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        shm_unlink(name);
+        return -1;
+    }
+
+    /* A new segment is zero-filled by ftruncate(). */
+    seg->version = VARIORUM_SHM_VERSION;
+    seg->header_size = offsetof(struct variorum_shm_layout, names);
+    seg->max_metrics = VARIORUM_SHM_MAX_METRICS;
+    seg->name_len = VARIORUM_SHM_NAME_LEN;
+    seg->history_len = VARIORUM_SHM_HISTORY_LEN;
+    gethostname(seg->hostname, sizeof(seg->hostname) - 1);
+    /* Publish the magic last so readers never see a half-built header. */
+    __atomic_store_n(&seg->magic, VARIORUM_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    g_shm_seg = seg;
+    snprintf(g_shm_name, sizeof(g_shm_name), "%s", name);
+    return 0;
+}
+
+static void shm_write(struct variorum_shm_layout *seg,
+                      const struct shm_staging *stage, uint64_t ts)
+{
+    struct variorum_shm_sample *slot;
+    uint64_t seq = seg->seq;
+    int i;
+
+    __atomic_store_n(&seg->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (seg->nmetrics != (uint32_t)stage->nmetrics ||
+        memcmp(seg->names, stage->names,
+               stage->nmetrics * VARIORUM_SHM_NAME_LEN) != 0)
+    {
+        /* The set of metrics changed, so old history no longer lines up. */
+        memcpy(seg->names, stage->names, sizeof(stage->names));
+        seg->nmetrics = stage->nmetrics;
+        seg->generation++;
+        seg->nsamples = 0;
+    }
+
+    slot = &seg->sample[seg->nsamples % VARIORUM_SHM_HISTORY_LEN];
+    slot->timestamp = ts;
+    for (i = 0; i < stage->nmetrics; i++)
+    {
+        slot->value[i] = stage->value[i];
+    }
+    seg->nsamples++;
+
+    __atomic_store_n(&seg->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+int variorum_shm_publish(const char *name)
+{
+    int err = 0;
+    int i;
+    uint64_t ts;
+    struct timeval tv;
+    struct shm_staging *stage;
+    json_t *power_obj;
+    json_t *thermal_obj;
+    json_t *frequency_obj;
+
+    if (name == NULL)
+    {
+        name = VARIORUM_SHM_DEFAULT_NAME;
+    }
+    if (g_shm_seg != NULL && strcmp(g_shm_name, name) != 0)
+    {
+        variorum_error_handler("Already publishing to another segment",
+                               VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                               __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (g_shm_seg == NULL && shm_map(name) != 0)
+    {
+        return -1;
+    }
+
+    err = variorum_enter(__FILE__, __FUNCTION__, __LINE__);
+    if (err)
+    {
+        return -1;
+    }
+
+    power_obj = json_object();
+    thermal_obj = json_object();
+    frequency_obj = json_object();
+
+    gettimeofday(&tv, NULL);
+    ts = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+
+    for (i = 0; i < P_NUM_PLATFORMS; i++)
+    {
+        if (g_platform[i].variorum_get_power_json != NULL &&
+            g_platform[i].variorum_get_power_json(power_obj) != 0)
+        {
+            err = -1;
+        }
+        if (g_platform[i].variorum_get_thermals_json != NULL &&
+            g_platform[i].variorum_get_thermals_json(thermal_obj) != 0)
+        {
+            err = -1;
+        }
+        if (g_platform[i].variorum_get_frequency_json != NULL &&
+            g_platform[i].variorum_get_frequency_json(frequency_obj) != 0)
+        {
+            err = -1;
+        }
+    }
+
+    if (!err)
+    {
+        stage = calloc(1, sizeof(struct shm_staging));
+        if (stage == NULL)
+        {
+            err = -1;
+        }
+        else
+        {
+            if (flatten_json(stage, "power", power_obj) != 0 ||
+                flatten_json(stage, "thermals", thermal_obj) != 0 ||
+                flatten_json(stage, "frequency", frequency_obj) != 0)
+            {
+                err = -1;
+            }
+            else
+            {
+                shm_write(g_shm_seg, stage, ts);
+            }
+            free(stage);
+        }
+    }
+
+    json_decref(power_obj);
+    json_decref(thermal_obj);
+    json_decref(frequency_obj);
+
+    if (variorum_exit(__FILE__, __FUNCTION__, __LINE__))
+    {
+        return -1;
+    }
+    return err;
+}
+
+int variorum_shm_close(void)
+{
+    int err = 0;
+
+    if (g_shm_seg == NULL)
+    {
+        return 0;
+    }
+    munmap(g_shm_seg, sizeof(struct variorum_shm_layout));
+    g_shm_seg = NULL;
+    if (shm_unlink(g_shm_name) != 0)
+    {
+        err = -1;
+    }
+    g_shm_name[0] = '\0';
+    return err;
+}
+
+int variorum_shm_attach(const char *name,
+                        const struct variorum_shm_layout **seg)
+{
+    int fd;
+    struct stat st;
+    struct variorum_shm_layout *map;
+
+    if (seg == NULL)
+    {
+        return -1;
+    }
+    if (name == NULL)
+    {
+        name = VARIORUM_SHM_DEFAULT_NAME;
+    }
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 ||
+        st.st_size < (off_t)sizeof(struct variorum_shm_layout))
+    {
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, sizeof(struct variorum_shm_layout), PROT_READ, MAP_SHARED,
+               fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return -1;
+    }
+    if (__atomic_load_n(&map->magic, __ATOMIC_ACQUIRE) != VARIORUM_SHM_MAGIC ||
+        map->version != VARIORUM_SHM_VERSION)
+    {
+        munmap(map, sizeof(struct variorum_shm_layout));
+        return -1;
+    }
+    *seg = map;
+    return 0;
+}
+
+int variorum_shm_detach(const struct variorum_shm_layout *seg)
+{
+    if (seg == NULL)
+    {
+        return -1;
+    }
+    return munmap((void *)seg, sizeof(struct variorum_shm_layout));
+}
+
+static int shm_read(const struct variorum_shm_layout *seg,
+                    struct variorum_shm_sample *samples, int max_samples,
+                    uint32_t *generation)
+{
+    uint64_t seq0;
+    uint64_t seq1;
+    uint64_t nsamples;
+    uint32_t gen;
+    int count;
+    int i;
+    int tries;
+
+    if (seg == NULL || samples == NULL || max_samples <= 0)
+    {
+        return -1;
+    }
+
+    for (tries = 0; tries < SHM_READ_RETRIES; tries++)
+    {
+        seq0 = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1)
+        {
+            continue;
+        }
+
+        gen = seg->generation;
+        nsamples = seg->nsamples;
+        count = nsamples < VARIORUM_SHM_HISTORY_LEN ? (int)nsamples :
+                VARIORUM_SHM_HISTORY_LEN;
+        if (count > max_samples)
+        {
+            count = max_samples;
+        }
+        for (i = 0; i < count; i++)
+        {
+            memcpy(&samples[i],
+                   &seg->sample[(nsamples - 1 - i) % VARIORUM_SHM_HISTORY_LEN],
+                   sizeof(struct variorum_shm_sample));
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq1 = __atomic_load_n(&seg->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1)
+        {
+            if (generation != NULL)
+            {
+                *generation = gen;
+            }
+            return count;
+        }
+    }
+    return -1;
+}
+
+int variorum_shm_read_latest(const struct variorum_shm_layout *seg,
+                             struct variorum_shm_sample *sample,
+                             uint32_t *generation)
+{
+    if (shm_read(seg, sample, 1, generation) != 1)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int variorum_shm_read_history(const struct variorum_shm_layout *seg,
+                              struct variorum_shm_sample *samples,
+                              int max_samples)
+{
+    return shm_read(seg, samples, max_samples, NULL);
+}
+
+int variorum_shm_metric_index(const struct variorum_shm_layout *seg,
+                              const char *metric)
+{
+    uint32_t i;
+    uint32_t nmetrics;
+
+    if (seg == NULL || metric == NULL)
+    {
+        return -1;
+    }
+    nmetrics = seg->nmetrics;
+    for (i = 0; i < nmetrics && i < VARIORUM_SHM_MAX_METRICS; i++)
+    {
+        if (strncmp(seg->names[i], metric, VARIORUM_SHM_NAME_LEN) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
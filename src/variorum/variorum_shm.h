@@ -0,0 +1,157 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_SHM_H_INCLUDE
+#define VARIORUM_SHM_H_INCLUDE
+
+#include <stdint.h>
+
+/// @brief Identifies a variorum telemetry segment ("VRMS").
+#define VARIORUM_SHM_MAGIC 0x56524d53
+/// @brief Layout version, bumped on any incompatible change to the structs
+/// below.
+#define VARIORUM_SHM_VERSION 1
+/// @brief Segment name used when NULL is passed (/dev/shm/variorum).
+#define VARIORUM_SHM_DEFAULT_NAME "/variorum"
+/// @brief Maximum number of metrics held in one sample.
+#define VARIORUM_SHM_MAX_METRICS 512
+/// @brief Maximum length of a metric name, including the terminating NUL.
+#define VARIORUM_SHM_NAME_LEN 48
+/// @brief Number of samples kept in the history ring.
+#define VARIORUM_SHM_HISTORY_LEN 32
+
+/// @brief One published sample. Values are indexed the same way as the
+/// names table of the segment.
+struct variorum_shm_sample
+{
+    /// @brief Sample time in microseconds since the epoch.
+    uint64_t timestamp;
+    /// @brief Metric values (watts, degrees C, MHz, ...).
+    double value[VARIORUM_SHM_MAX_METRICS];
+};
+
+/// @brief Fixed layout of the shared-memory segment.
+///
+/// The segment is written by a single publisher and protected by a sequence
+/// lock: seq is odd while an update is in progress, and readers retry if seq
+/// changed while they were copying. All offsets are fixed for a given
+/// version so that non-C readers (e.g., pyVariorum) can map the file
+/// directly.
+struct variorum_shm_layout
+{
+    /// @brief VARIORUM_SHM_MAGIC.
+    uint32_t magic;
+    /// @brief VARIORUM_SHM_VERSION.
+    uint32_t version;
+    /// @brief Byte offset of the names table (size of the header).
+    uint32_t header_size;
+    /// @brief VARIORUM_SHM_MAX_METRICS.
+    uint32_t max_metrics;
+    /// @brief VARIORUM_SHM_NAME_LEN.
+    uint32_t name_len;
+    /// @brief VARIORUM_SHM_HISTORY_LEN.
+    uint32_t history_len;
+    /// @brief Number of valid entries in the names table.
+    uint32_t nmetrics;
+    /// @brief Incremented whenever the names table changes.
+    uint32_t generation;
+    /// @brief Sequence lock counter.
+    uint64_t seq;
+    /// @brief Samples published since the last generation change. The latest
+    /// sample is sample[(nsamples - 1) % history_len].
+    uint64_t nsamples;
+    /// @brief Hostname of the publisher.
+    char hostname[64];
+    /// @brief Metric names, e.g. "power.socket_0.power_cpu_watts".
+    char names[VARIORUM_SHM_MAX_METRICS][VARIORUM_SHM_NAME_LEN];
+    /// @brief History ring of samples.
+    struct variorum_shm_sample sample[VARIORUM_SHM_HISTORY_LEN];
+};
+
+/// @brief Take one node-level sample of power, thermals and frequency, and
+/// publish it into the shared-memory segment. The segment is created on the
+/// first call and stays mapped until variorum_shm_close(). The first call
+/// fails if a segment of that name already exists, e.g., one left behind by
+/// a publisher that did not call variorum_shm_close().
+///
+/// A sample is not published, and -1 is returned, if a metric name needs
+/// more than VARIORUM_SHM_NAME_LEN characters or the node has more than
+/// VARIORUM_SHM_MAX_METRICS metrics.
+///
+/// @param [in] name Segment name (e.g., "/variorum"), or NULL for
+/// VARIORUM_SHM_DEFAULT_NAME.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_shm_publish(
+    const char *name
+);
+
+/// @brief Unmap and remove the segment created by variorum_shm_publish().
+///
+/// @return 0 if successful, otherwise -1
+int variorum_shm_close(
+    void
+);
+
+/// @brief Map an existing segment read-only.
+///
+/// @param [in] name Segment name, or NULL for VARIORUM_SHM_DEFAULT_NAME.
+/// @param [out] seg Pointer to the mapped segment.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_shm_attach(
+    const char *name,
+    const struct variorum_shm_layout **seg
+);
+
+/// @brief Unmap a segment returned by variorum_shm_attach().
+///
+/// @param [in] seg Mapped segment.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_shm_detach(
+    const struct variorum_shm_layout *seg
+);
+
+/// @brief Copy a consistent view of the most recent sample. Does not enter
+/// the kernel.
+///
+/// @param [in] seg Mapped segment.
+/// @param [out] sample Latest sample.
+/// @param [out] generation Names table generation the sample belongs to
+/// (may be NULL).
+///
+/// @return 0 if successful, otherwise -1 (e.g., nothing published yet)
+int variorum_shm_read_latest(
+    const struct variorum_shm_layout *seg,
+    struct variorum_shm_sample *sample,
+    uint32_t *generation
+);
+
+/// @brief Copy up to max_samples of the most recent samples, newest first.
+///
+/// @param [in] seg Mapped segment.
+/// @param [out] samples Array of at least max_samples entries.
+/// @param [in] max_samples Capacity of samples.
+///
+/// @return Number of samples copied, otherwise -1
+int variorum_shm_read_history(
+    const struct variorum_shm_layout *seg,
+    struct variorum_shm_sample *samples,
+    int max_samples
+);
+
+/// @brief Look up the index of a metric by name.
+///
+/// @param [in] seg Mapped segment.
+/// @param [in] metric Metric name, e.g. "power.power_node_watts".
+///
+/// @return Index into variorum_shm_sample.value, otherwise -1
+int variorum_shm_metric_index(
+    const struct variorum_shm_layout *seg,
+    const char *metric
+);
+
+#endif
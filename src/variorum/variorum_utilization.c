@@ -0,0 +1,608 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <errno.h>
+#include <fcntl.h>
+#include <hwloc.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <variorum_topology.h>
+#include <variorum_utilization.h>
+
+#define MEM_FILE "/proc/meminfo"
+#define CPU_FILE "/proc/stat"
+#define NODE_MEM_FILE "/sys/devices/system/node/node%u/meminfo"
+
+/* Large enough for /proc/stat on a few hundred CPUs; grown on demand. */
+#define UTIL_BUF_INIT 16384
+
+static int g_stat_fd = -1;
+static int g_meminfo_fd = -1;
+static char *g_buf = NULL;
+static size_t g_buf_size = 0;
+
+/* Counters from the previous and current reads of /proc/stat. */
+static struct variorum_cpu_times g_node_prev;
+static struct variorum_cpu_times g_node_cur;
+static struct variorum_cpu_times *g_cpu_prev = NULL;
+static struct variorum_cpu_times *g_cpu_cur = NULL;
+static char *g_cpu_seen_prev = NULL;
+static char *g_cpu_seen_cur = NULL;
+static int g_cpu_alloc = 0;
+static int g_have_prev = 0;
+
+/* NUMA node and socket of each OS CPU number, from hwloc. */
+static int *g_cpu_numa = NULL;
+static int *g_cpu_socket = NULL;
+static struct variorum_cpu_times *g_numa_delta = NULL;
+static struct variorum_cpu_times *g_socket_delta = NULL;
+static int *g_numa_mem_fd = NULL;
+
+static struct variorum_util_sample g_sample;
+
+static int read_file(int fd, size_t *len)
+{
+    ssize_t n;
+    char *tmp;
+
+    *len = 0;
+    while (1)
+    {
+        if (*len + 1 >= g_buf_size)
+        {
+            tmp = (char *) realloc(g_buf, g_buf_size ? g_buf_size * 2 : UTIL_BUF_INIT);
+            if (tmp == NULL)
+            {
+                return -1;
+            }
+            g_buf = tmp;
+            g_buf_size = g_buf_size ? g_buf_size * 2 : UTIL_BUF_INIT;
+        }
+        n = pread(fd, g_buf + *len, g_buf_size - *len - 1, *len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        *len += n;
+    }
+    g_buf[*len] = '\0';
+    return 0;
+}
+
+static const char *scan_u64(const char *p, uint64_t *val)
+{
+    uint64_t v = 0;
+
+    while (*p == ' ')
+    {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9')
+    {
+        v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    *val = v;
+    return p;
+}
+
+static const char *next_line(const char *p)
+{
+    while (*p != '\0' && *p != '\n')
+    {
+        p++;
+    }
+    return *p == '\n' ? p + 1 : p;
+}
+
+static const char *scan_cpu_times(const char *p, struct variorum_cpu_times *t)
+{
+    p = scan_u64(p, &t->user);
+    p = scan_u64(p, &t->nice);
+    p = scan_u64(p, &t->system);
+    p = scan_u64(p, &t->idle);
+    p = scan_u64(p, &t->iowait);
+    p = scan_u64(p, &t->irq);
+    p = scan_u64(p, &t->softirq);
+    p = scan_u64(p, &t->steal);
+    return p;
+}
+
+static uint64_t delta(uint64_t cur, uint64_t prev)
+{
+    // Counters of a CPU that went offline and came back may restart.
+    return cur > prev ? cur - prev : 0;
+}
+
+static void times_delta(const struct variorum_cpu_times *cur,
+                        const struct variorum_cpu_times *prev,
+                        struct variorum_cpu_times *d)
+{
+    d->user = delta(cur->user, prev->user);
+    d->nice = delta(cur->nice, prev->nice);
+    d->system = delta(cur->system, prev->system);
+    d->idle = delta(cur->idle, prev->idle);
+    d->iowait = delta(cur->iowait, prev->iowait);
+    d->irq = delta(cur->irq, prev->irq);
+    d->softirq = delta(cur->softirq, prev->softirq);
+    d->steal = delta(cur->steal, prev->steal);
+}
+
+static void times_add(struct variorum_cpu_times *acc,
+                      const struct variorum_cpu_times *d)
+{
+    acc->user += d->user;
+    acc->nice += d->nice;
+    acc->system += d->system;
+    acc->idle += d->idle;
+    acc->iowait += d->iowait;
+    acc->irq += d->irq;
+    acc->softirq += d->softirq;
+    acc->steal += d->steal;
+}
+
+static void times_to_util(const struct variorum_cpu_times *d,
+                          struct variorum_util_domain *u)
+{
+    uint64_t sum = d->user + d->nice + d->system + d->idle + d->iowait + d->irq +
+                   d->softirq + d->steal;
+
+    u->valid = 1;
+    if (sum == 0)
+    {
+        u->total = 0.0;
+        u->user = 0.0;
+        u->system = 0.0;
+        u->iowait = 0.0;
+        u->irq = 0.0;
+        u->steal = 0.0;
+        return;
+    }
+    u->total = (1 - (d->idle + d->iowait) / (double)sum) * 100;
+    u->user = ((d->user + d->nice) / (double)sum) * 100;
+    u->system = (d->system / (double)sum) * 100;
+    u->iowait = (d->iowait / (double)sum) * 100;
+    u->irq = ((d->irq + d->softirq) / (double)sum) * 100;
+    u->steal = (d->steal / (double)sum) * 100;
+}
+
+/* Fill cpu_map with the logical index of the object of the given type
+ * that contains each OS CPU, and return the number of such objects. CPUs
+ * that hwloc does not place are charged to the first object. */
+static int map_cpus(hwloc_obj_type_t type, int *cpu_map)
+{
+    int i;
+    int n;
+    int pu;
+    hwloc_obj_t obj;
+
+    for (i = 0; i < g_cpu_alloc; i++)
+    {
+        cpu_map[i] = 0;
+    }
+    n = hwloc_get_nbobjs_by_type(topology, type);
+    for (i = 0; i < n; i++)
+    {
+        obj = hwloc_get_obj_by_type(topology, type, i);
+        hwloc_bitmap_foreach_begin(pu, obj->cpuset)
+        {
+            if (pu < g_cpu_alloc)
+            {
+                cpu_map[pu] = i;
+            }
+        }
+        hwloc_bitmap_foreach_end();
+    }
+    return n > 0 ? n : 1;
+}
+
+static void close_numa_mem(void)
+{
+    int i;
+
+    for (i = 0; g_numa_mem_fd != NULL && i < g_sample.nnuma; i++)
+    {
+        if (g_numa_mem_fd[i] >= 0)
+        {
+            close(g_numa_mem_fd[i]);
+        }
+    }
+    free(g_numa_mem_fd);
+    g_numa_mem_fd = NULL;
+}
+
+static int map_topology(void)
+{
+    int i;
+    int n;
+    char path[128];
+    hwloc_obj_t obj;
+    void *tmp;
+
+    variorum_init_topology();
+    close_numa_mem();
+
+    n = map_cpus(HWLOC_OBJ_NUMANODE, g_cpu_numa);
+    tmp = realloc(g_numa_delta, n * sizeof(struct variorum_cpu_times));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_numa_delta = (struct variorum_cpu_times *) tmp;
+    tmp = realloc(g_sample.numa, n * sizeof(struct variorum_util_domain));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_sample.numa = (struct variorum_util_domain *) tmp;
+    tmp = realloc(g_sample.numa_mem, n * sizeof(struct variorum_util_memory));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_sample.numa_mem = (struct variorum_util_memory *) tmp;
+    g_numa_mem_fd = (int *) malloc(n * sizeof(int));
+    if (g_numa_mem_fd == NULL)
+    {
+        return -1;
+    }
+    g_sample.nnuma = n;
+
+    // A node without a meminfo file (e.g., no NUMA support) is left invalid.
+    for (i = 0; i < n; i++)
+    {
+        obj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, i);
+        snprintf(path, sizeof(path), NODE_MEM_FILE, obj ? obj->os_index : 0);
+        g_numa_mem_fd[i] = open(path, O_RDONLY);
+    }
+
+    n = map_cpus(HWLOC_OBJ_SOCKET, g_cpu_socket);
+    tmp = realloc(g_socket_delta, n * sizeof(struct variorum_cpu_times));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_socket_delta = (struct variorum_cpu_times *) tmp;
+    tmp = realloc(g_sample.socket, n * sizeof(struct variorum_util_domain));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_sample.socket = (struct variorum_util_domain *) tmp;
+    g_sample.nsockets = n;
+    return 0;
+}
+
+static int grow_cpus(int ncpus)
+{
+    void *tmp;
+    int old = g_cpu_alloc;
+
+    tmp = realloc(g_cpu_prev, ncpus * sizeof(struct variorum_cpu_times));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_prev = (struct variorum_cpu_times *) tmp;
+    tmp = realloc(g_cpu_cur, ncpus * sizeof(struct variorum_cpu_times));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_cur = (struct variorum_cpu_times *) tmp;
+    tmp = realloc(g_cpu_seen_prev, ncpus);
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_seen_prev = (char *) tmp;
+    tmp = realloc(g_cpu_seen_cur, ncpus);
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_seen_cur = (char *) tmp;
+    tmp = realloc(g_cpu_numa, ncpus * sizeof(int));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_numa = (int *) tmp;
+    tmp = realloc(g_cpu_socket, ncpus * sizeof(int));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_cpu_socket = (int *) tmp;
+    tmp = realloc(g_sample.cpu, ncpus * sizeof(struct variorum_util_domain));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+    g_sample.cpu = (struct variorum_util_domain *) tmp;
+
+    memset(g_cpu_seen_prev + old, 0, ncpus - old);
+    memset(g_cpu_seen_cur + old, 0, ncpus - old);
+    g_cpu_alloc = ncpus;
+    return map_topology();
+}
+
+static int parse_stat(void)
+{
+    const char *p;
+    uint64_t id;
+    size_t len;
+    struct variorum_cpu_times t;
+
+    if (read_file(g_stat_fd, &len) != 0)
+    {
+        return -1;
+    }
+    memset(g_cpu_seen_cur, 0, g_cpu_alloc);
+
+    // The cpu lines come first; stop at the first line that is not one.
+    p = g_buf;
+    while (strncmp(p, "cpu", 3) == 0)
+    {
+        p += 3;
+        if (*p == ' ')
+        {
+            p = scan_cpu_times(p, &g_node_cur);
+        }
+        else
+        {
+            p = scan_u64(p, &id);
+            p = scan_cpu_times(p, &t);
+            if ((int)id >= g_cpu_alloc && grow_cpus(id + 1) != 0)
+            {
+                return -1;
+            }
+            g_cpu_cur[id] = t;
+            g_cpu_seen_cur[id] = 1;
+        }
+        p = next_line(p);
+    }
+    return 0;
+}
+
+static int parse_meminfo(void)
+{
+    const char *p;
+    size_t len;
+    int found = 0;
+
+    if (read_file(g_meminfo_fd, &len) != 0)
+    {
+        return -1;
+    }
+    p = g_buf;
+    while (*p != '\0' && found < 2)
+    {
+        if (strncmp(p, "MemTotal:", 9) == 0)
+        {
+            scan_u64(p + 9, &g_sample.mem_total);
+            found++;
+        }
+        else if (strncmp(p, "MemFree:", 8) == 0)
+        {
+            scan_u64(p + 8, &g_sample.mem_free);
+            found++;
+        }
+        p = next_line(p);
+    }
+    return found == 2 ? 0 : -1;
+}
+
+/* Per-node meminfo lines look like "Node 0 MemTotal:   16384 kB". */
+static int parse_node_meminfo(int fd, struct variorum_util_memory *mem)
+{
+    const char *p;
+    size_t len;
+    int found = 0;
+
+    mem->valid = 0;
+    if (fd < 0 || read_file(fd, &len) != 0)
+    {
+        return -1;
+    }
+    p = g_buf;
+    while (*p != '\0' && found < 2)
+    {
+        const char *field = p;
+
+        if (strncmp(field, "Node ", 5) == 0)
+        {
+            field += 5;
+            while ((*field >= '0' && *field <= '9') || *field == ' ')
+            {
+                field++;
+            }
+        }
+        if (strncmp(field, "MemTotal:", 9) == 0)
+        {
+            scan_u64(field + 9, &mem->total);
+            found++;
+        }
+        else if (strncmp(field, "MemFree:", 8) == 0)
+        {
+            scan_u64(field + 8, &mem->free);
+            found++;
+        }
+        p = next_line(p);
+    }
+    if (found != 2)
+    {
+        return -1;
+    }
+    mem->util = mem->total ? (1 - (double)mem->free / mem->total) * 100 : 0.0;
+    mem->valid = 1;
+    return 0;
+}
+
+static int util_open(void)
+{
+    long ncpus;
+
+    g_stat_fd = open(CPU_FILE, O_RDONLY);
+    if (g_stat_fd < 0)
+    {
+        return -1;
+    }
+    g_meminfo_fd = open(MEM_FILE, O_RDONLY);
+    if (g_meminfo_fd < 0)
+    {
+        variorum_util_close();
+        return -1;
+    }
+    ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (grow_cpus(ncpus > 0 ? (int)ncpus : 1) != 0)
+    {
+        variorum_util_close();
+        return -1;
+    }
+    return 0;
+}
+
+int variorum_util_get_sample(struct variorum_util_sample **sample)
+{
+    int i;
+    struct variorum_cpu_times d;
+    void *tmp;
+
+    if (g_stat_fd < 0 && util_open() != 0)
+    {
+        return -1;
+    }
+    if (parse_stat() != 0 || parse_meminfo() != 0)
+    {
+        return -1;
+    }
+
+    memset(g_sample.cpu, 0, g_cpu_alloc * sizeof(struct variorum_util_domain));
+    memset(g_numa_delta, 0, g_sample.nnuma * sizeof(struct variorum_cpu_times));
+    memset(g_sample.numa, 0, g_sample.nnuma * sizeof(struct variorum_util_domain));
+    memset(g_socket_delta, 0, g_sample.nsockets * sizeof(struct variorum_cpu_times));
+    memset(g_sample.socket, 0,
+           g_sample.nsockets * sizeof(struct variorum_util_domain));
+    g_sample.ncpus = g_cpu_alloc;
+
+    // Make the utilization metrics 0 at the first sample.
+    if (!g_have_prev)
+    {
+        g_sample.node.valid = 0;
+        g_sample.node.total = 0.0;
+        g_sample.node.user = 0.0;
+        g_sample.node.system = 0.0;
+        g_sample.node.iowait = 0.0;
+        g_sample.node.irq = 0.0;
+        g_sample.node.steal = 0.0;
+    }
+    else
+    {
+        times_delta(&g_node_cur, &g_node_prev, &d);
+        times_to_util(&d, &g_sample.node);
+
+        for (i = 0; i < g_cpu_alloc; i++)
+        {
+            if (!g_cpu_seen_cur[i] || !g_cpu_seen_prev[i])
+            {
+                continue;
+            }
+            times_delta(&g_cpu_cur[i], &g_cpu_prev[i], &d);
+            times_to_util(&d, &g_sample.cpu[i]);
+            times_add(&g_numa_delta[g_cpu_numa[i]], &d);
+            g_sample.numa[g_cpu_numa[i]].valid = 1;
+            times_add(&g_socket_delta[g_cpu_socket[i]], &d);
+            g_sample.socket[g_cpu_socket[i]].valid = 1;
+        }
+        for (i = 0; i < g_sample.nnuma; i++)
+        {
+            if (g_sample.numa[i].valid)
+            {
+                times_to_util(&g_numa_delta[i], &g_sample.numa[i]);
+            }
+        }
+        for (i = 0; i < g_sample.nsockets; i++)
+        {
+            if (g_sample.socket[i].valid)
+            {
+                times_to_util(&g_socket_delta[i], &g_sample.socket[i]);
+            }
+        }
+    }
+
+    for (i = 0; i < g_sample.nnuma; i++)
+    {
+        parse_node_meminfo(g_numa_mem_fd[i], &g_sample.numa_mem[i]);
+    }
+
+    g_sample.mem_util = g_sample.mem_total ?
+                        (1 - (double)g_sample.mem_free / g_sample.mem_total) * 100 : 0.0;
+
+    // The current counters become the baseline of the next interval.
+    g_node_prev = g_node_cur;
+    tmp = g_cpu_prev;
+    g_cpu_prev = g_cpu_cur;
+    g_cpu_cur = (struct variorum_cpu_times *) tmp;
+    tmp = g_cpu_seen_prev;
+    g_cpu_seen_prev = g_cpu_seen_cur;
+    g_cpu_seen_cur = (char *) tmp;
+    g_have_prev = 1;
+
+    *sample = &g_sample;
+    return 0;
+}
+
+void variorum_util_close(void)
+{
+    if (g_stat_fd >= 0)
+    {
+        close(g_stat_fd);
+        g_stat_fd = -1;
+    }
+    if (g_meminfo_fd >= 0)
+    {
+        close(g_meminfo_fd);
+        g_meminfo_fd = -1;
+    }
+    close_numa_mem();
+    free(g_buf);
+    free(g_cpu_prev);
+    free(g_cpu_cur);
+    free(g_cpu_seen_prev);
+    free(g_cpu_seen_cur);
+    free(g_cpu_numa);
+    free(g_cpu_socket);
+    free(g_numa_delta);
+    free(g_socket_delta);
+    free(g_sample.cpu);
+    free(g_sample.numa);
+    free(g_sample.numa_mem);
+    free(g_sample.socket);
+    g_buf = NULL;
+    g_buf_size = 0;
+    g_cpu_prev = NULL;
+    g_cpu_cur = NULL;
+    g_cpu_seen_prev = NULL;
+    g_cpu_seen_cur = NULL;
+    g_cpu_numa = NULL;
+    g_cpu_socket = NULL;
+    g_numa_delta = NULL;
+    g_socket_delta = NULL;
+    g_cpu_alloc = 0;
+    g_have_prev = 0;
+    memset(&g_sample, 0, sizeof(g_sample));
+}
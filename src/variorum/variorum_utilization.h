@@ -0,0 +1,109 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_UTILIZATION_H_INCLUDE
+#define VARIORUM_UTILIZATION_H_INCLUDE
+
+#include <stdint.h>
+
+/// @brief Cumulative CPU time from one cpu line of /proc/stat, in clock
+/// ticks.
+struct variorum_cpu_times
+{
+    uint64_t user;
+    uint64_t nice;
+    uint64_t system;
+    uint64_t idle;
+    uint64_t iowait;
+    uint64_t irq;
+    uint64_t softirq;
+    uint64_t steal;
+};
+
+/// @brief Utilization of a set of CPUs over the last interval, in percent.
+struct variorum_util_domain
+{
+    /// @brief 1 if the domain was sampled in both this and the previous call.
+    int valid;
+    /// @brief Non-idle time (everything except idle and iowait).
+    double total;
+    /// @brief User and nice time.
+    double user;
+    /// @brief System time.
+    double system;
+    /// @brief Time spent idle waiting for I/O.
+    double iowait;
+    /// @brief Hard and soft interrupt time.
+    double irq;
+    /// @brief Time stolen by the hypervisor.
+    double steal;
+};
+
+/// @brief Memory of one NUMA node, from
+/// /sys/devices/system/node/node<k>/meminfo.
+struct variorum_util_memory
+{
+    /// @brief 1 if the node's meminfo could be read.
+    int valid;
+    /// @brief MemTotal of the node, in kB.
+    uint64_t total;
+    /// @brief MemFree of the node, in kB.
+    uint64_t free;
+    /// @brief Used memory in percent.
+    double util;
+};
+
+/// @brief One utilization sample. All arrays are owned by the engine and
+/// stay valid until the next call to variorum_util_get_sample() or
+/// variorum_util_close().
+struct variorum_util_sample
+{
+    /// @brief Whole node (aggregate cpu line).
+    struct variorum_util_domain node;
+    /// @brief Number of entries in cpu.
+    int ncpus;
+    /// @brief Per logical CPU, indexed by OS CPU number. Offline CPUs are
+    /// not valid.
+    struct variorum_util_domain *cpu;
+    /// @brief Number of entries in numa.
+    int nnuma;
+    /// @brief Per NUMA node, indexed by hwloc logical index.
+    struct variorum_util_domain *numa;
+    /// @brief Memory per NUMA node, indexed like numa.
+    struct variorum_util_memory *numa_mem;
+    /// @brief Number of entries in socket.
+    int nsockets;
+    /// @brief Per socket, indexed by hwloc logical index.
+    struct variorum_util_domain *socket;
+    /// @brief MemTotal from /proc/meminfo, in kB.
+    uint64_t mem_total;
+    /// @brief MemFree from /proc/meminfo, in kB.
+    uint64_t mem_free;
+    /// @brief Used memory in percent.
+    double mem_util;
+};
+
+/// @brief Take a utilization sample since the previous call.
+///
+/// /proc/stat, /proc/meminfo and the per-node meminfo files are opened once
+/// and re-read with pread() into a reusable buffer, so repeated sampling
+/// does not allocate or reopen files. Logical CPUs are aggregated into
+/// sockets and NUMA nodes with the hwloc topology. The first call
+/// establishes the baseline and reports zero CPU utilization.
+///
+/// @param [out] sample Set to the engine's sample buffer.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_util_get_sample(
+    struct variorum_util_sample **sample
+);
+
+/// @brief Close the files and free the buffers held by the utilization
+/// engine. The next sample starts a new baseline.
+void variorum_util_close(
+    void
+);
+
+#endif
@@ -0,0 +1,377 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <variorum.h>
+#include <variorum_error.h>
+#include <variorum_mpi.h>
+
+#define NUM_STATS (2 * VARIORUM_MPI_NUM_DOMAINS)
+
+/* Layout of the reduction buffers: energy of each domain, then power of each
+ * domain. The sum buffer carries one extra slot counting the nodes that
+ * contributed.
+ * */
+#define STAT_ENERGY(d) (d)
+#define STAT_POWER(d)  (VARIORUM_MPI_NUM_DOMAINS + (d))
+#define STAT_NNODES    NUM_STATS
+
+struct variorum_mpi
+{
+    MPI_Comm comm;
+    /* One communicator per node, and one over the node leaders. Ranks that
+     * are not leaders hold MPI_COMM_NULL in leader_comm.
+     * */
+    MPI_Comm node_comm;
+    MPI_Comm leader_comm;
+    int rank;
+    char hostname[1024];
+
+    /* Readings taken at open and at the previous sample. */
+    int have_baseline;
+    struct variorum_node_energy baseline;
+    struct variorum_node_energy last;
+    double last_seconds;
+
+    struct variorum_node_energy *timeline;
+    int nsamples;
+    int timeline_size;
+
+    int pending;
+    MPI_Request requests[3];
+    double send_sum[NUM_STATS + 1];
+    double send_min[NUM_STATS];
+    double send_max[NUM_STATS];
+    double recv_sum[NUM_STATS + 1];
+    double recv_min[NUM_STATS];
+    double recv_max[NUM_STATS];
+};
+
+static void node_domains(const struct variorum_node_energy *e,
+                         double *domains)
+{
+    domains[VARIORUM_MPI_DOMAIN_CPU] = e->cpu_joules;
+    domains[VARIORUM_MPI_DOMAIN_MEM] = e->mem_joules;
+    domains[VARIORUM_MPI_DOMAIN_GPU] = e->gpu_joules;
+    domains[VARIORUM_MPI_DOMAIN_NODE] = e->cpu_joules + e->mem_joules +
+                                        e->gpu_joules;
+}
+
+static int append_sample(struct variorum_mpi *vm,
+                         const struct variorum_node_energy *e)
+{
+    struct variorum_node_energy *timeline;
+    int size;
+
+    if (vm->nsamples == vm->timeline_size)
+    {
+        size = vm->timeline_size ? vm->timeline_size * 2 : 64;
+        timeline = (struct variorum_node_energy *) realloc(vm->timeline,
+                   size * sizeof(struct variorum_node_energy));
+        if (timeline == NULL)
+        {
+            return -1;
+        }
+        vm->timeline = timeline;
+        vm->timeline_size = size;
+    }
+    vm->timeline[vm->nsamples++] = *e;
+    return 0;
+}
+
+int variorum_mpi_open(MPI_Comm comm,
+                      struct variorum_mpi **vm)
+{
+    struct variorum_mpi *v;
+    int node_rank;
+
+    if (vm == NULL)
+    {
+        variorum_error_handler("Invalid session pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    *vm = NULL;
+
+    v = (struct variorum_mpi *) calloc(1, sizeof(struct variorum_mpi));
+    if (v == NULL)
+    {
+        return -1;
+    }
+    gethostname(v->hostname, sizeof(v->hostname) - 1);
+
+    // Keep our collectives apart from the application's traffic on comm.
+    MPI_Comm_dup(comm, &v->comm);
+    MPI_Comm_rank(v->comm, &v->rank);
+
+    // Ranks are ordered by their rank in comm, so rank 0 of comm leads its
+    // node and is rank 0 among the leaders.
+    MPI_Comm_split_type(v->comm, MPI_COMM_TYPE_SHARED, v->rank, MPI_INFO_NULL,
+                        &v->node_comm);
+    MPI_Comm_rank(v->node_comm, &node_rank);
+    MPI_Comm_split(v->comm, node_rank == 0 ? 0 : MPI_UNDEFINED, v->rank,
+                   &v->leader_comm);
+
+    if (v->leader_comm != MPI_COMM_NULL)
+    {
+        v->have_baseline = (variorum_get_node_energy(&v->baseline) == 0);
+        v->last = v->baseline;
+    }
+
+    *vm = v;
+    return 0;
+}
+
+int variorum_mpi_sample(struct variorum_mpi *vm)
+{
+    struct variorum_node_energy e;
+    double energy[VARIORUM_MPI_NUM_DOMAINS];
+    double prev[VARIORUM_MPI_NUM_DOMAINS];
+    double first[VARIORUM_MPI_NUM_DOMAINS];
+    double interval;
+    int ok = 0;
+    int err = 0;
+    int d;
+
+    if (vm == NULL)
+    {
+        variorum_error_handler("Invalid session pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (vm->leader_comm == MPI_COMM_NULL)
+    {
+        return 0;
+    }
+    if (variorum_mpi_wait(vm, NULL) != 0)
+    {
+        return -1;
+    }
+
+    if (vm->have_baseline && variorum_get_node_energy(&e) == 0)
+    {
+        ok = 1;
+        node_domains(&e, energy);
+        node_domains(&vm->last, prev);
+        node_domains(&vm->baseline, first);
+        // The counters only grow, so a decrease means a bad reading; the node
+        // is left out of this sample rather than lowering the job totals.
+        for (d = 0; d < VARIORUM_MPI_NUM_DOMAINS; d++)
+        {
+            if (energy[d] < first[d] || energy[d] < prev[d])
+            {
+                ok = 0;
+            }
+        }
+        if (!ok)
+        {
+            variorum_error_handler("Node energy decreased since the previous sample",
+                                   VARIORUM_ERROR_INVAL, getenv("HOSTNAME"),
+                                   __FILE__, __FUNCTION__, __LINE__);
+            err = -1;
+        }
+        else if (append_sample(vm, &e) != 0)
+        {
+            err = -1;
+        }
+    }
+    else
+    {
+        err = -1;
+    }
+
+    // A node whose reading failed still takes part in the reductions, with
+    // values that leave the sum, min and max unchanged.
+    for (d = 0; d < NUM_STATS; d++)
+    {
+        vm->send_sum[d] = 0.0;
+        vm->send_min[d] = DBL_MAX;
+        vm->send_max[d] = -DBL_MAX;
+    }
+    vm->send_sum[STAT_NNODES] = ok;
+    if (ok)
+    {
+        interval = e.seconds - vm->last.seconds;
+        for (d = 0; d < VARIORUM_MPI_NUM_DOMAINS; d++)
+        {
+            vm->send_sum[STAT_ENERGY(d)] = energy[d] - first[d];
+            vm->send_sum[STAT_POWER(d)] = interval > 0.0 ?
+                                          (energy[d] - prev[d]) / interval : 0.0;
+        }
+        memcpy(vm->send_min, vm->send_sum, sizeof(vm->send_min));
+        memcpy(vm->send_max, vm->send_sum, sizeof(vm->send_max));
+        vm->last = e;
+        vm->last_seconds = e.seconds - vm->baseline.seconds;
+    }
+
+    MPI_Ireduce(vm->send_sum, vm->recv_sum, NUM_STATS + 1, MPI_DOUBLE, MPI_SUM,
+                0, vm->leader_comm, &vm->requests[0]);
+    MPI_Ireduce(vm->send_min, vm->recv_min, NUM_STATS, MPI_DOUBLE, MPI_MIN,
+                0, vm->leader_comm, &vm->requests[1]);
+    MPI_Ireduce(vm->send_max, vm->recv_max, NUM_STATS, MPI_DOUBLE, MPI_MAX,
+                0, vm->leader_comm, &vm->requests[2]);
+    vm->pending = 1;
+    return err;
+}
+
+int variorum_mpi_wait(struct variorum_mpi *vm,
+                      struct variorum_mpi_job_power *job)
+{
+    int d;
+
+    if (vm == NULL)
+    {
+        variorum_error_handler("Invalid session pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (job != NULL)
+    {
+        memset(job, 0, sizeof(*job));
+    }
+    if (!vm->pending)
+    {
+        return 0;
+    }
+    if (MPI_Waitall(3, vm->requests, MPI_STATUSES_IGNORE) != MPI_SUCCESS)
+    {
+        return -1;
+    }
+    vm->pending = 0;
+
+    if (job == NULL || vm->rank != 0)
+    {
+        return 0;
+    }
+    job->nnodes = (int)vm->recv_sum[STAT_NNODES];
+    if (job->nnodes == 0)
+    {
+        return 0;
+    }
+    job->seconds = vm->last_seconds;
+    for (d = 0; d < VARIORUM_MPI_NUM_DOMAINS; d++)
+    {
+        job->energy_joules[d].sum = vm->recv_sum[STAT_ENERGY(d)];
+        job->energy_joules[d].min = vm->recv_min[STAT_ENERGY(d)];
+        job->energy_joules[d].max = vm->recv_max[STAT_ENERGY(d)];
+        job->power_watts[d].sum = vm->recv_sum[STAT_POWER(d)];
+        job->power_watts[d].min = vm->recv_min[STAT_POWER(d)];
+        job->power_watts[d].max = vm->recv_max[STAT_POWER(d)];
+    }
+    return 0;
+}
+
+int variorum_mpi_write_timelines(struct variorum_mpi *vm,
+                                 const char *path)
+{
+    static const char header[] =
+        "hostname,timestamp,cpu_joules,mem_joules,gpu_joules\n";
+    MPI_File fh;
+    MPI_Offset offset = 0;
+    long long len = 0;
+    long long prefix = 0;
+    char *buf = NULL;
+    size_t size;
+    int leader_rank;
+    int err = 0;
+    int n;
+    int i;
+
+    if (vm == NULL || path == NULL)
+    {
+        variorum_error_handler("Invalid session or path", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    if (vm->leader_comm == MPI_COMM_NULL)
+    {
+        return 0;
+    }
+    MPI_Comm_rank(vm->leader_comm, &leader_rank);
+
+    // Each line fits in a host name plus four formatted doubles.
+    size = sizeof(header) + (size_t)vm->nsamples * (strlen(vm->hostname) + 128);
+    buf = (char *) malloc(size);
+    if (buf == NULL)
+    {
+        // Still take part in the collectives below with nothing to write.
+        err = -1;
+    }
+    else
+    {
+        if (leader_rank == 0)
+        {
+            len = snprintf(buf, size, "%s", header);
+        }
+        for (i = 0; i < vm->nsamples; i++)
+        {
+            n = snprintf(buf + len, size - len, "%s,%.6f,%.6f,%.6f,%.6f\n",
+                         vm->hostname, vm->timeline[i].seconds,
+                         vm->timeline[i].cpu_joules, vm->timeline[i].mem_joules,
+                         vm->timeline[i].gpu_joules);
+            if (n < 0 || (size_t)n >= size - len)
+            {
+                err = -1;
+                break;
+            }
+            len += n;
+        }
+    }
+
+    MPI_Exscan(&len, &prefix, 1, MPI_LONG_LONG, MPI_SUM, vm->leader_comm);
+    if (leader_rank != 0)
+    {
+        offset = (MPI_Offset)prefix;
+    }
+
+    if (MPI_File_open(vm->leader_comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+    {
+        variorum_error_handler("Could not open timeline file", VARIORUM_ERROR_RUNTIME,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        free(buf);
+        return -1;
+    }
+    MPI_File_set_size(fh, 0);
+    if (MPI_File_write_at_all(fh, offset, buf, (int)len, MPI_CHAR,
+                              MPI_STATUS_IGNORE) != MPI_SUCCESS)
+    {
+        err = -1;
+    }
+    MPI_File_close(&fh);
+    free(buf);
+    return err;
+}
+
+int variorum_mpi_close(struct variorum_mpi **vm)
+{
+    struct variorum_mpi *v;
+    int err;
+
+    if (vm == NULL || *vm == NULL)
+    {
+        variorum_error_handler("Invalid session pointer", VARIORUM_ERROR_INVAL,
+                               getenv("HOSTNAME"), __FILE__, __FUNCTION__, __LINE__);
+        return -1;
+    }
+    v = *vm;
+
+    err = variorum_mpi_wait(v, NULL);
+    if (v->leader_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_free(&v->leader_comm);
+    }
+    MPI_Comm_free(&v->node_comm);
+    MPI_Comm_free(&v->comm);
+    free(v->timeline);
+    free(v);
+    *vm = NULL;
+    return err;
+}
@@ -0,0 +1,108 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef VARIORUM_MPI_H_INCLUDE
+#define VARIORUM_MPI_H_INCLUDE
+
+#include <mpi.h>
+
+/// @brief Power domains reduced across the job.
+enum variorum_mpi_domain
+{
+    VARIORUM_MPI_DOMAIN_CPU,
+    VARIORUM_MPI_DOMAIN_MEM,
+    VARIORUM_MPI_DOMAIN_GPU,
+    VARIORUM_MPI_DOMAIN_NODE,
+    VARIORUM_MPI_NUM_DOMAINS
+};
+
+/// @brief Sum, minimum and maximum of one value over the nodes of the job.
+struct variorum_mpi_stats
+{
+    double sum;
+    double min;
+    double max;
+};
+
+/// @brief Job-wide power and energy, reduced from one sample per node.
+struct variorum_mpi_job_power
+{
+    /// @brief Number of nodes that contributed a sample.
+    int nnodes;
+    /// @brief Time since variorum_mpi_open() (in seconds), as seen by the
+    /// first node.
+    double seconds;
+    /// @brief Energy used since variorum_mpi_open() (in Joules), indexed by
+    /// enum variorum_mpi_domain.
+    struct variorum_mpi_stats energy_joules[VARIORUM_MPI_NUM_DOMAINS];
+    /// @brief Average power since the previous sample (in Watts), indexed by
+    /// enum variorum_mpi_domain.
+    struct variorum_mpi_stats power_watts[VARIORUM_MPI_NUM_DOMAINS];
+};
+
+/// @brief State of one MPI sampling session.
+struct variorum_mpi;
+
+/// @brief Start a sampling session over a communicator.
+///
+/// The ranks of comm are grouped by shared-memory node, and the lowest rank
+/// of each node becomes its leader. Only leaders read the hardware, so each
+/// node is read once per sample no matter how many ranks it runs. Collective
+/// over comm.
+///
+/// @param [in] comm Communicator of the job (e.g., MPI_COMM_WORLD).
+/// @param [out] vm Session handle.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_mpi_open(MPI_Comm comm,
+                      struct variorum_mpi **vm);
+
+/// @brief Take one sample on every node and start reducing it.
+///
+/// Leaders read the node energy counters, append the reading to the node's
+/// timeline, and post non-blocking reductions of the per-domain energy and
+/// power to rank 0 of comm. The call returns without waiting for the
+/// reductions; complete them with variorum_mpi_wait(). A pending reduction
+/// from the previous sample is completed first. Must be called by every
+/// rank of comm; ranks that are not leaders return immediately.
+///
+/// @param [in] vm Session handle.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_mpi_sample(struct variorum_mpi *vm);
+
+/// @brief Complete the reductions started by the last variorum_mpi_sample().
+///
+/// @param [in] vm Session handle.
+/// @param [out] job Job-wide totals. Only filled on rank 0 of comm; other
+///              ranks get nnodes set to 0. May be NULL.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_mpi_wait(struct variorum_mpi *vm,
+                      struct variorum_mpi_job_power *job);
+
+/// @brief Write the per-node timelines to one shared CSV file.
+///
+/// Every leader formats its own samples and writes them at its own offset
+/// with collective MPI-IO, so the file is produced in one pass regardless of
+/// job size. Each line holds the host name, the timestamp and the cumulative
+/// CPU, memory and GPU energy of one sample. Collective over comm.
+///
+/// @param [in] vm Session handle.
+/// @param [in] path Output file name.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_mpi_write_timelines(struct variorum_mpi *vm,
+                                 const char *path);
+
+/// @brief End a sampling session and free its resources. Collective over
+/// comm.
+///
+/// @param [in,out] vm Session handle, set to NULL.
+///
+/// @return 0 if successful, otherwise -1
+int variorum_mpi_close(struct variorum_mpi **vm);
+
+#endif
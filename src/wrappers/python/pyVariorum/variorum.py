@@ -3,7 +3,7 @@
 #
 # SPDX-License-Identifier: MIT
 
-from ctypes import c_int, c_char_p, CDLL, POINTER
+from ctypes import byref, c_int, c_char_p, c_void_p, CDLL, POINTER, string_at
 
 
 class variorum:
@@ -189,3 +189,32 @@ class variorum:
         # Get Number of Threads
         self.variorum_get_num_threads = self.variorum_c.variorum_get_num_threads
         self.variorum_get_num_threads.restype = c_int
+
+        # Release the strings allocated by the JSON APIs
+        self.variorum_free_json = self.variorum_c.variorum_free_json
+        self.variorum_free_json.argtypes = [c_void_p]
+        self.variorum_free_json.restype = None
+
+        # Select compact or indented output for the JSON APIs
+        self.variorum_set_json_format = self.variorum_c.variorum_set_json_format
+        self.variorum_set_json_format.argtypes = [c_int]
+        self.variorum_set_json_format.restype = c_int
+
+    def get_json(self, name, *args):
+        """
+        Call a JSON API, e.g. get_json("variorum_get_power_json"), and return
+        its output as a Python string. Unlike calling the API directly with a
+        c_char_p, the buffer allocated by the library is released.
+        """
+        func = self.variorum_c[name]
+        func.restype = c_int
+        out = c_void_p()
+        ret = func(*args, byref(out))
+        if ret != 0 or not out.value:
+            if out.value:
+                self.variorum_free_json(out)
+            raise RuntimeError("%s failed" % name)
+        try:
+            return string_at(out).decode("utf-8")
+        finally:
+            self.variorum_free_json(out)
@@ -0,0 +1,507 @@
+// Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+// Variorum Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <variorum.h>
+
+typedef struct
+{
+    PyObject_HEAD
+    int open;
+} SessionObject;
+
+static PyObject *g_variorum_error = NULL;
+
+static PyObject *api_error(const char *api)
+{
+    PyErr_Format(g_variorum_error, "%s failed", api);
+    return NULL;
+}
+
+static PyObject *double_list(const double *values, int n)
+{
+    PyObject *list = PyList_New(n);
+    int i;
+
+    if (list == NULL)
+    {
+        return NULL;
+    }
+    for (i = 0; i < n; i++)
+    {
+        PyObject *v = PyFloat_FromDouble(values[i]);
+        if (v == NULL)
+        {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, v);
+    }
+    return list;
+}
+
+static int check_open(SessionObject *self)
+{
+    if (!self->open)
+    {
+        PyErr_SetString(PyExc_ValueError, "session is closed");
+        return -1;
+    }
+    return 0;
+}
+
+static int session_init(SessionObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist))
+    {
+        return -1;
+    }
+    if (self->open)
+    {
+        return 0;
+    }
+    if (variorum_open() != 0)
+    {
+        api_error("variorum_open");
+        return -1;
+    }
+    self->open = 1;
+    return 0;
+}
+
+static void session_dealloc(SessionObject *self)
+{
+    if (self->open)
+    {
+        variorum_close();
+        self->open = 0;
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *session_close(SessionObject *self, PyObject *Py_UNUSED(args))
+{
+    if (self->open)
+    {
+        self->open = 0;
+        if (variorum_close() != 0)
+        {
+            return api_error("variorum_close");
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *session_enter(SessionObject *self, PyObject *Py_UNUSED(args))
+{
+    if (check_open(self))
+    {
+        return NULL;
+    }
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *session_exit(SessionObject *self, PyObject *Py_UNUSED(args))
+{
+    return session_close(self, NULL);
+}
+
+static PyObject *session_node_energy(SessionObject *self,
+                                     PyObject *Py_UNUSED(args))
+{
+    struct variorum_node_energy e;
+
+    if (check_open(self))
+    {
+        return NULL;
+    }
+    if (variorum_get_node_energy(&e) != 0)
+    {
+        return api_error("variorum_get_node_energy");
+    }
+    return Py_BuildValue("{s:d,s:d,s:d,s:d}",
+                         "timestamp", e.seconds,
+                         "cpu_joules", e.cpu_joules,
+                         "mem_joules", e.mem_joules,
+                         "gpu_joules", e.gpu_joules);
+}
+
+static PyObject *session_socket_energy(SessionObject *self,
+                                       PyObject *Py_UNUSED(args))
+{
+    struct variorum_socket_energy e;
+
+    if (check_open(self))
+    {
+        return NULL;
+    }
+    if (variorum_get_socket_energy(&e) != 0)
+    {
+        return api_error("variorum_get_socket_energy");
+    }
+    return Py_BuildValue("{s:N,s:N,s:N}",
+                         "cpu_joules", double_list(e.cpu_joules, e.nsockets),
+                         "mem_joules", double_list(e.mem_joules, e.nsockets),
+                         "gpu_joules", double_list(e.gpu_joules, e.nsockets));
+}
+
+static PyObject *session_gpu_energy(SessionObject *self,
+                                    PyObject *Py_UNUSED(args))
+{
+    struct variorum_gpu_energy e;
+
+    if (check_open(self))
+    {
+        return NULL;
+    }
+    if (variorum_get_gpu_energy(&e) != 0)
+    {
+        return api_error("variorum_get_gpu_energy");
+    }
+    return Py_BuildValue("{s:i,s:N}",
+                         "gpus_per_socket", e.gpus_per_socket,
+                         "gpu_joules", double_list(e.gpu_joules, e.ngpus));
+}
+
+static PyObject *session_core_energy(SessionObject *self,
+                                     PyObject *Py_UNUSED(args))
+{
+    struct variorum_core_energy e;
+
+    if (check_open(self))
+    {
+        return NULL;
+    }
+    if (variorum_get_core_energy(&e) != 0)
+    {
+        return api_error("variorum_get_core_energy");
+    }
+    return Py_BuildValue("{s:d,s:N,s:N,s:N,s:N}",
+                         "interval", e.interval,
+                         "core_joules", double_list(e.core_joules, e.ncores),
+                         "core_watts", double_list(e.core_watts, e.ncores),
+                         "ccd_joules", double_list(e.ccd_joules, e.nccds),
+                         "ccd_watts", double_list(e.ccd_watts, e.nccds));
+}
+
+static PyObject *session_energy_attribution(SessionObject *self,
+        PyObject *args)
+{
+    struct variorum_energy_attribution *attr;
+    const char *targets;
+    const char *c;
+    PyObject *list;
+    int max_targets = 1;
+    int i;
+
+    if (check_open(self) || !PyArg_ParseTuple(args, "s", &targets))
+    {
+        return NULL;
+    }
+    for (c = targets; *c; c++)
+    {
+        max_targets += (*c == ',');
+    }
+    attr = (struct variorum_energy_attribution *) calloc(max_targets,
+            sizeof(struct variorum_energy_attribution));
+    if (attr == NULL)
+    {
+        return PyErr_NoMemory();
+    }
+    if (variorum_get_energy_attribution(targets, attr, max_targets) != 0)
+    {
+        free(attr);
+        return api_error("variorum_get_energy_attribution");
+    }
+
+    list = PyList_New(max_targets);
+    for (i = 0; list != NULL && i < max_targets; i++)
+    {
+        PyObject *d = Py_BuildValue("{s:s,s:i,s:d,s:d,s:d,s:d,s:d,s:d}",
+                                    "target", attr[i].target,
+                                    "num_threads", attr[i].nthreads,
+                                    "interval_seconds", attr[i].elapsed,
+                                    "cpu_seconds", attr[i].cpu_seconds,
+                                    "cycles", attr[i].cycles,
+                                    "instructions", attr[i].instructions,
+                                    "energy_joules", attr[i].energy_joules,
+                                    "total_energy_joules", attr[i].total_energy_joules);
+        if (d == NULL)
+        {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, d);
+    }
+    free(attr);
+    return list;
+}
+
+static PyObject *session_gpu_throttle_events(SessionObject *self,
+        PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"timeout_ms", "max_events", NULL};
+    struct variorum_gpu_throttle_event *events;
+    PyObject *list;
+    int timeout_ms = 0;
+    int max_events = 64;
+    int n;
+    int i;
+
+    if (check_open(self) ||
+        !PyArg_ParseTupleAndKeywords(args, kwds, "|ii", kwlist, &timeout_ms,
+                                     &max_events))
+    {
+        return NULL;
+    }
+    if (max_events <= 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "max_events must be positive");
+        return NULL;
+    }
+    events = (struct variorum_gpu_throttle_event *) calloc(max_events,
+             sizeof(struct variorum_gpu_throttle_event));
+    if (events == NULL)
+    {
+        return PyErr_NoMemory();
+    }
+    n = variorum_get_gpu_throttle_events(timeout_ms, events, max_events);
+    if (n < 0)
+    {
+        free(events);
+        return api_error("variorum_get_gpu_throttle_events");
+    }
+
+    list = PyList_New(n);
+    for (i = 0; list != NULL && i < n; i++)
+    {
+        PyObject *d = Py_BuildValue("{s:K,s:i,s:I,s:I,s:d,s:d}",
+                                    "timestamp", events[i].timestamp_us,
+                                    "gpu", events[i].gpu,
+                                    "previous_reasons", events[i].previous_reasons,
+                                    "reasons", events[i].reasons,
+                                    "power_violation_seconds", events[i].power_violation_s,
+                                    "thermal_violation_seconds", events[i].thermal_violation_s);
+        if (d == NULL)
+        {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, d);
+    }
+    free(events);
+    return list;
+}
+
+static PyObject *session_region_begin(SessionObject *self, PyObject *args)
+{
+    const char *name;
+
+    if (check_open(self) || !PyArg_ParseTuple(args, "s", &name))
+    {
+        return NULL;
+    }
+    if (variorum_region_begin(name) != 0)
+    {
+        return api_error("variorum_region_begin");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *session_region_end(SessionObject *self, PyObject *args)
+{
+    const char *name;
+
+    if (check_open(self) || !PyArg_ParseTuple(args, "s", &name))
+    {
+        return NULL;
+    }
+    if (variorum_region_end(name) != 0)
+    {
+        return api_error("variorum_region_end");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *session_region_energy(SessionObject *self, PyObject *args)
+{
+    struct variorum_region_energy e;
+    const char *name;
+
+    if (check_open(self) || !PyArg_ParseTuple(args, "s", &name))
+    {
+        return NULL;
+    }
+    if (variorum_get_region_energy(name, &e) != 0)
+    {
+        return api_error("variorum_get_region_energy");
+    }
+    return Py_BuildValue("{s:k,s:d,s:d,s:d,s:d}",
+                         "count", e.count,
+                         "time_seconds", e.seconds,
+                         "cpu_joules", e.cpu_joules,
+                         "mem_joules", e.mem_joules,
+                         "gpu_joules", e.gpu_joules);
+}
+
+/* JSON APIs reachable through Session.json(), for data that has no struct
+ * API yet. The buffer returned by the library is released here.
+ * */
+static const struct
+{
+    const char *kind;
+    int (*get)(char **);
+} g_json_apis[] =
+{
+    {"power", variorum_get_power_json},
+    {"utilization", variorum_get_utilization_json},
+    {"node_power_domain_info", variorum_get_node_power_domain_info_json},
+    {"thermals", variorum_get_thermals_json},
+    {"frequency", variorum_get_frequency_json},
+    {"energy", variorum_get_energy_json},
+    {"core_energy", variorum_get_core_energy_json},
+    {"region_energy", variorum_get_region_energy_json},
+};
+
+static PyObject *session_json(SessionObject *self, PyObject *args)
+{
+    const char *kind;
+    char *s = NULL;
+    PyObject *str;
+    size_t i;
+
+    if (check_open(self) || !PyArg_ParseTuple(args, "s", &kind))
+    {
+        return NULL;
+    }
+    for (i = 0; i < sizeof(g_json_apis) / sizeof(g_json_apis[0]); i++)
+    {
+        if (strcmp(g_json_apis[i].kind, kind) != 0)
+        {
+            continue;
+        }
+        if (g_json_apis[i].get(&s) != 0 || s == NULL)
+        {
+            variorum_free_json(s);
+            return api_error(kind);
+        }
+        str = PyUnicode_FromString(s);
+        variorum_free_json(s);
+        return str;
+    }
+    PyErr_Format(PyExc_ValueError, "unknown JSON API '%s'", kind);
+    return NULL;
+}
+
+static PyMethodDef session_methods[] =
+{
+    {"close", (PyCFunction)session_close, METH_NOARGS, "Close the session."},
+    {"__enter__", (PyCFunction)session_enter, METH_NOARGS, NULL},
+    {"__exit__", (PyCFunction)session_exit, METH_VARARGS, NULL},
+    {
+        "node_energy", (PyCFunction)session_node_energy, METH_NOARGS,
+        "Node-wide CPU, memory and GPU energy counters (Joules)."
+    },
+    {
+        "socket_energy", (PyCFunction)session_socket_energy, METH_NOARGS,
+        "Per-socket CPU, memory and GPU energy counters (Joules)."
+    },
+    {
+        "gpu_energy", (PyCFunction)session_gpu_energy, METH_NOARGS,
+        "Per-GPU energy counters (Joules)."
+    },
+    {
+        "core_energy", (PyCFunction)session_core_energy, METH_NOARGS,
+        "Per-core and per-CCD energy and power."
+    },
+    {
+        "energy_attribution", (PyCFunction)session_energy_attribution,
+        METH_VARARGS,
+        "Package energy apportioned to a comma-separated list of PIDs or cgroups."
+    },
+    {
+        "gpu_throttle_events", (PyCFunction)(void (*)(void))session_gpu_throttle_events,
+        METH_VARARGS | METH_KEYWORDS,
+        "GPU throttle reason changes since the previous call."
+    },
+    {
+        "region_begin", (PyCFunction)session_region_begin, METH_VARARGS,
+        "Mark the start of a named region."
+    },
+    {
+        "region_end", (PyCFunction)session_region_end, METH_VARARGS,
+        "Mark the end of the innermost open region."
+    },
+    {
+        "region_energy", (PyCFunction)session_region_energy, METH_VARARGS,
+        "Accumulated time and energy of a named region."
+    },
+    {
+        "json", (PyCFunction)session_json, METH_VARARGS,
+        "Output of a JSON API (e.g., 'power', 'thermals') as a string."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject SessionType =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pyVariorum.variorum_session.Session",
+    .tp_doc = "A Variorum session. Vendor libraries and platform state stay "
+    "initialized until the session is closed.",
+    .tp_basicsize = sizeof(SessionObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)session_init,
+    .tp_dealloc = (destructor)session_dealloc,
+    .tp_methods = session_methods,
+};
+
+static struct PyModuleDef variorum_session_module =
+{
+    PyModuleDef_HEAD_INIT,
+    .m_name = "variorum_session",
+    .m_doc = "Native bindings to libvariorum that return Python objects.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_variorum_session(void)
+{
+    PyObject *m;
+
+    if (PyType_Ready(&SessionType) < 0)
+    {
+        return NULL;
+    }
+    m = PyModule_Create(&variorum_session_module);
+    if (m == NULL)
+    {
+        return NULL;
+    }
+    g_variorum_error = PyErr_NewException("pyVariorum.variorum_session.VariorumError",
+                                          PyExc_RuntimeError, NULL);
+    Py_INCREF(g_variorum_error);
+    if (PyModule_AddObject(m, "VariorumError", g_variorum_error) < 0)
+    {
+        Py_DECREF(g_variorum_error);
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(&SessionType);
+    if (PyModule_AddObject(m, "Session", (PyObject *)&SessionType) < 0)
+    {
+        Py_DECREF(&SessionType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,149 @@
+# Copyright 2019-2023 Lawrence Livermore National Security, LLC and other
+# Variorum Project Developers. See the top-level LICENSE file for details.
+#
+# SPDX-License-Identifier: MIT
+
+import mmap
+import os
+import struct
+
+# Must match variorum_shm.h
+VARIORUM_SHM_MAGIC = 0x56524D53
+VARIORUM_SHM_VERSION = 1
+VARIORUM_SHM_DEFAULT_NAME = "/variorum"
+
+# magic, version, header_size, max_metrics, name_len, history_len, nmetrics,
+# generation, seq, nsamples, hostname
+_HEADER = struct.Struct("=8I2Q64s")
+_SEQ_OFFSET = 32
+_READ_RETRIES = 1000
+
+
+class variorum_shm:
+    """
+    Read-only view of a segment published with variorum_shm_publish() (for
+    example by `var_monitor -s /variorum`). After the segment is mapped,
+    reads are plain memory accesses and do not touch the MSR driver.
+    """
+
+    def __init__(self, name=VARIORUM_SHM_DEFAULT_NAME):
+        path = "/dev/shm/" + name.lstrip("/")
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            self.buf = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+
+        hdr = _HEADER.unpack_from(self.buf, 0)
+        if hdr[0] != VARIORUM_SHM_MAGIC or hdr[1] != VARIORUM_SHM_VERSION:
+            self.buf.close()
+            raise ValueError("%s is not a variorum telemetry segment" % path)
+
+        header_size, self.max_metrics, self.name_len, self.history_len = hdr[2:6]
+        self.hostname = hdr[10].split(b"\0", 1)[0].decode("utf-8")
+        self.names_offset = header_size
+        self.samples_offset = header_size + self.max_metrics * self.name_len
+        self.sample_size = 8 + 8 * self.max_metrics
+        self.generation = None
+        self.names = []
+
+    def close(self):
+        self.buf.close()
+
+    def _seq(self):
+        return struct.unpack_from("=Q", self.buf, _SEQ_OFFSET)[0]
+
+    def _load_names(self, nmetrics):
+        names = []
+        for i in range(nmetrics):
+            off = self.names_offset + i * self.name_len
+            raw = self.buf[off : off + self.name_len]
+            names.append(raw.split(b"\0", 1)[0].decode("utf-8"))
+        return names
+
+    def _unpack_sample(self, index, nmetrics):
+        off = self.samples_offset + index * self.sample_size
+        ts = struct.unpack_from("=Q", self.buf, off)[0]
+        values = struct.unpack_from("=%dd" % nmetrics, self.buf, off + 8)
+        return ts, values
+
+    def history(self, max_samples=None):
+        """
+        Return up to max_samples of the most recent samples, newest first, as
+        a list of dicts mapping metric name to value, plus a "timestamp" key
+        (microseconds).
+        """
+        if max_samples is None:
+            max_samples = self.history_len
+
+        for _ in range(_READ_RETRIES):
+            seq0 = self._seq()
+            if seq0 & 1:
+                continue
+            hdr = _HEADER.unpack_from(self.buf, 0)
+            nmetrics, generation, nsamples = hdr[6], hdr[7], hdr[9]
+            if generation != self.generation:
+                names = self._load_names(nmetrics)
+            else:
+                names = self.names
+            count = min(nsamples, self.history_len, max_samples)
+            raw = [
+                self._unpack_sample((nsamples - 1 - i) % self.history_len, nmetrics)
+                for i in range(count)
+            ]
+            if self._seq() != seq0:
+                continue
+
+            self.generation = generation
+            self.names = names
+            samples = []
+            for ts, values in raw:
+                sample = dict(zip(names, values))
+                sample["timestamp"] = ts
+                samples.append(sample)
+            return samples
+        raise RuntimeError("Unable to get a consistent read of the segment")
+
+    def history_array(self):
+        """
+        Return the history ring as a zero-copy NumPy structured array with
+        fields "timestamp" (uint64, microseconds) and "value" (float64 array
+        of max_metrics entries), one row per ring slot, plus the index of the
+        latest row (or None if nothing was published). Columns are named by
+        metric_names().
+
+        The array is a read-only view of the shared memory, so it always shows
+        the publisher's current data without copying. Rows are updated in
+        place; use history() when a consistent snapshot is needed.
+        """
+        import numpy
+
+        dtype = numpy.dtype(
+            [("timestamp", "<u8"), ("value", "<f8", (self.max_metrics,))]
+        )
+        ring = numpy.frombuffer(
+            self.buf, dtype=dtype, count=self.history_len, offset=self.samples_offset
+        )
+        nsamples = _HEADER.unpack_from(self.buf, 0)[9]
+        if nsamples == 0:
+            return ring, None
+        return ring, (nsamples - 1) % self.history_len
+
+    def metric_names(self):
+        """
+        Return the names of the metrics currently published, in column order.
+        """
+        hdr = _HEADER.unpack_from(self.buf, 0)
+        if hdr[7] != self.generation:
+            self.names = self._load_names(hdr[6])
+            self.generation = hdr[7]
+        return self.names
+
+    def read(self):
+        """
+        Return the latest sample as a dict, or None if nothing was published.
+        """
+        samples = self.history(1)
+        if not samples:
+            return None
+        return samples[0]
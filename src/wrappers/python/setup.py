@@ -3,7 +3,30 @@
 #
 # SPDX-License-Identifier: MIT
 
-from setuptools import setup
+import os
+
+from setuptools import Extension, setup
+
+# Set VARIORUM_DIR to the Variorum install prefix when it is not in the
+# default compiler and linker search paths.
+variorum_dir = os.environ.get("VARIORUM_DIR")
+include_dirs = []
+library_dirs = []
+if variorum_dir:
+    include_dirs.append(os.path.join(variorum_dir, "include"))
+    library_dirs.append(os.path.join(variorum_dir, "lib"))
+
+# The native session module is optional: if libvariorum cannot be found at
+# build time, pyVariorum is installed with the ctypes wrappers only.
+variorum_session = Extension(
+    "pyVariorum.variorum_session",
+    sources=["pyVariorum/variorum_session.c"],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    runtime_library_dirs=library_dirs,
+    libraries=["variorum"],
+    optional=True,
+)
 
 setup(
     name="pyVariorum",
@@ -14,5 +37,6 @@ setup(
     author_email="brink2@llnl.gov, marathe1@llnl.gov, patki1@llnl.gov, rountree@llnl.gov",
     license="MIT",
     packages=["pyVariorum"],
+    ext_modules=[variorum_session],
     zip_safe=False,
 )